@@ -27,6 +27,7 @@
 #include "raycast/include/ScreenBuffer.h"
 #include "raycast/include/STLLoader.h"
 #include "raycast/include/DataFormat.h"
+#include "raycast/include/ResultSet.h"
 #include "raycast/include/BSPTree.h"
 #include "raycast/include/Plot3DVtk.h"
 #include "PaintWidget.h"
@@ -95,8 +96,6 @@ std::vector<BSPNode> nodes;
 
 
 ///#include "enable_memleak.h"
-const int CutAABSkipedSize = CutAAB::getSkipedSizeInFile();
-const int RenderFromPositionSkipedSize = RenderFromPosition::getSkipedSizeInFile();
 
 #define PLATE_HEIGHT 20./stngs.SCALE_COEF
 extern QApplication * app;
@@ -127,6 +126,7 @@ DreamCaster::DreamCaster(QWidget *parent, Qt::WindowFlags flags)
 	CutFigParametersChangedOFF = false;
 	scrBuffer = new ScreenBuffer( stngs.RFRAME_W, stngs.RFRAME_H );
 	tracer = 0;
+	resultSet = new ResultSetReader;
 	cuda_avpl_buff = 0;
 	cuda_dipang_buff = 0;
 	
@@ -525,6 +525,7 @@ DreamCaster::~DreamCaster()
 	ClearPrevData();//plotData,rotations,plotColumnData
 	delete scrBuffer;
 	delete cutFigList;
+	delete resultSet;
 	delete [] cuda_avpl_buff;
 	delete [] cuda_dipang_buff;
 	///
@@ -677,33 +678,32 @@ void DreamCaster::RenderViewsSlot()
 	float deltaX = (maxValX-minValX)/cntX;
 	float deltaY = 2*M_PI/cntY;
 	float deltaZ = (maxValZ-minValZ)/cntZ;
-	//open file for writing in binary mode and write header
-	FILE *fptr = 0;
-	fptr = fopen(setFileName.toLatin1().constData(),"wb");
-	if(!fptr)
-	{
-		log("Error! Cannot open set file for writing.");
-		return;
-	}
-	float cur_minValX = ui.sb_min_x->value()/DEG_IN_PI;
-	float cur_minValZ = ui.sb_min_z->value()/DEG_IN_PI;
-	float cur_maxValX = ui.sb_max_x->value()/DEG_IN_PI;
-	float cur_maxValZ = ui.sb_max_z->value()/DEG_IN_PI;
-	fwrite(&cntX, sizeof(cntX), 1, fptr);
-	fwrite(&cur_minValX, sizeof(cur_minValX), 1, fptr);
-	fwrite(&cur_maxValX, sizeof(cur_maxValX), 1, fptr);
-
-	fwrite(&cntY, sizeof(cntY), 1, fptr);
-
-	fwrite(&cntZ, sizeof(cntZ), 1, fptr);
-	fwrite(&cur_minValZ, sizeof(cur_minValZ), 1, fptr);
-	fwrite(&cur_maxValZ, sizeof(cur_maxValZ), 1, fptr);
-
+	//open set file for writing and write header
+	ResultSetHeader setHeader;
+	setHeader.cntX = cntX;
+	setHeader.cntY = cntY;
+	setHeader.cntZ = cntZ;
+	setHeader.minValX = ui.sb_min_x->value()/DEG_IN_PI;
+	setHeader.minValZ = ui.sb_min_z->value()/DEG_IN_PI;
+	setHeader.maxValX = ui.sb_max_x->value()/DEG_IN_PI;
+	setHeader.maxValZ = ui.sb_max_z->value()/DEG_IN_PI;
 	int aabCount = cutFigList->count();
-	fwrite(&aabCount, sizeof(aabCount), 1, fptr);
 	for (int i=0; i<aabCount; i++)
 	{
-		cutFigList->item(i)->Write2File(fptr);
+		CutAAB * cutAAB = cutFigList->item(i);
+		ResultSetHeader::CutBox cutBox;
+		cutBox.box[0] = cutAAB->box.x1; cutBox.box[1] = cutAAB->box.x2;
+		cutBox.box[2] = cutAAB->box.y1; cutBox.box[3] = cutAAB->box.y2;
+		cutBox.box[4] = cutAAB->box.z1; cutBox.box[5] = cutAAB->box.z2;
+		memcpy(cutBox.slidersValues, cutAAB->slidersValues, sizeof(cutBox.slidersValues));
+		setHeader.cutBoxes.push_back(cutBox);
+	}
+	resultSet->close();//set file is about to be overwritten
+	ResultSetWriter setWriter;
+	if(!setWriter.open(setFileName, setHeader, stngs.COMPRESS_RESULTS != 0))
+	{
+		log("Error! "+setWriter.lastError());
+		return;
 	}
 	//
 	int totalTime=0;
@@ -765,7 +765,8 @@ void DreamCaster::RenderViewsSlot()
 					tracer->curRender.avDipAngle = 0.f;
 					tracer->curRender.badAreaPercentage = placementsParams[x][z].badAreaPercentage;
 					//write data to file
-					tracer->curRender.write2BinaryFile(fptr, ui.cb_saveAdditionalData->isChecked());
+					if(!setWriter.writeRender(x, y, z, tracer->curRender, ui.cb_saveAdditionalData->isChecked()))
+						log(setWriter.lastError());
 					//show progress and calculation time
 					totalTime = totalQTime.elapsed();//GetTickCount() - totalStart;
 					char t2[] = "00:00.000";
@@ -898,7 +899,8 @@ void DreamCaster::RenderViewsSlot()
 					//remember bad area percentage
 					tracer->curBatchRenders[batch].badAreaPercentage = placementsParams[ xs[batch] ][ zs[batch] ].badAreaPercentage;
 					//write data to file
-					tracer->curBatchRenders[batch].write2BinaryFile(fptr, ui.cb_saveAdditionalData->isChecked());
+					if(!setWriter.writeRender(xs[batch], ys[batch], zs[batch], tracer->curBatchRenders[batch], ui.cb_saveAdditionalData->isChecked()))
+						log(setWriter.lastError());
 					//					
 					rotationsParams[ xs[batch] ][ ys[batch] ][ zs[batch] ].avPenLen = tracer->curBatchRenders[batch].avPenetrLen;
 					rotationsParams[ xs[batch] ][ ys[batch] ][ zs[batch] ].avDipAng = tracer->curBatchRenders[batch].avDipAngle;
@@ -1023,7 +1025,8 @@ void DreamCaster::RenderViewsSlot()
 					//remember bad area percentage
 					tracer->curRender.badAreaPercentage = placementsParams[x][z].badAreaPercentage;
 					//write data to file
-					tracer->curRender.write2BinaryFile(fptr, ui.cb_saveAdditionalData->isChecked());
+					if(!setWriter.writeRender(x, y, z, tracer->curRender, ui.cb_saveAdditionalData->isChecked()))
+						log(setWriter.lastError());
 					//
 					/*float cur_param;// = tracer->curRender.m_avPenetrLen;
 					switch(paramIndex)
@@ -1205,7 +1208,8 @@ void DreamCaster::RenderViewsSlot()
 	SensitivityChangedSlot();
 	UpdateSlot();*/
 //	mat->Delete();
-	fclose(fptr);
+	if(!setWriter.close())
+		log(setWriter.lastError());
 	UpdatePlotSlot();
 }
 
@@ -1360,116 +1364,28 @@ void DreamCaster::SaveSlot()
 	qWarning( "DCForm::SaveSlot()" );
 }
 
-void DreamCaster::readRenderFromBinaryFile(unsigned int x, unsigned int y, unsigned int z, RenderFromPosition *rend)
+bool DreamCaster::openResultSet()
 {
-	FILE *fptr = fopen(setFileName.toLatin1().constData(),"rb");
-	if(!fptr)
+	if(resultSet->isOpen() && resultSet->fileName() == setFileName)
+		return true;
+	if(!resultSet->open(setFileName))
 	{
-		log("Error! Cannot open set file for reading.");
-		return;
+		log("Error! "+resultSet->lastError());
+		return false;
 	}
+	if(resultSet->isLegacy())
+		log("Set file has the old format without index, it was indexed on opening. Render the set again to store it in the indexed format.");
+	return true;
+}
 
-	int cntX, cntY, cntZ;
-	float minValX, maxValX, minValZ, maxValZ;
-	if (fread(&cntX, sizeof(cntX), 1, fptr) != 1 ||
-		fread(&minValX, sizeof(minValX), 1, fptr) != 1 ||
-		fread(&maxValX, sizeof(maxValX), 1, fptr) != 1 ||
-		fread(&cntY, sizeof(cntY), 1, fptr) != 1 ||
-		fread(&cntZ, sizeof(cntZ), 1, fptr) != 1 ||
-		fread(&minValZ, sizeof(minValZ), 1, fptr) != 1 ||
-		fread(&maxValZ, sizeof(maxValZ), 1, fptr) != 1)
-	{
-		fclose(fptr);
-		log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
-		return;
-	}
-	
-		setRangeSB( minValX, maxValX, minValZ, maxValZ );
-	int cutAABCount;
-	//skip cut AAB data
-	if (fread(&cutAABCount, sizeof(cutAABCount), 1, fptr) != 1)
-	{
-		fclose(fptr);
-		log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
-		return;
-	}
-	for (int i=0; i<cutAABCount; i++)
-	{
-		if( fseek(fptr, CutAABSkipedSize, SEEK_CUR)!=0 )
-			this->log("fseek error in readRenderFromBinaryFile!");
-	}
-	//
-	if(x>=(unsigned int)cntX || y>=(unsigned int)cntY || z>=(unsigned int)cntZ)
-	{
-		log("Error! Set reading. Invalid index.");
-		fclose(fptr);
-		return;
-	}
-	int curRend = cntZ*cntY*x + y + cntY*z;//cntX*y + x;
-	unsigned int raysSize;
-	unsigned int intersectionsSize;
-	for(int i=0; i<curRend; i++)
-	{
-		if( fseek(fptr, RenderFromPositionSkipedSize, SEEK_CUR)!=0 )//skip rotx, roty, rotz, avpenlen, avdipangle, maxpenlen, badAreaPercentage, position//20+4*3
-			this->log("fseek error in readRenderFromBinaryFile!");
-		if( fread(&raysSize, sizeof(raysSize), 1, fptr)<1 ) 
-			this->log("fread error in readRenderFromBinaryFile!");
-		if( fread(&intersectionsSize, sizeof(intersectionsSize), 1, fptr)<1 )
-			this->log("fread error in readRenderFromBinaryFile!");
-	}
-	//now reading part =)
-	if (fread(&rend->rotX, sizeof(rend->rotX), 1, fptr) != 1 ||
-		fread(&rend->rotY, sizeof(rend->rotY), 1, fptr) != 1 ||
-		fread(&rend->rotZ, sizeof(rend->rotY), 1, fptr) != 1 ||
-		fread(rend->pos, sizeof(rend->pos), 1, fptr) != 1 ||
-		fread(&rend->avPenetrLen, sizeof(rend->avPenetrLen), 1, fptr) != 1 ||
-		fread(&rend->avDipAngle, sizeof(rend->avDipAngle), 1, fptr) != 1 ||
-		fread(&rend->maxPenetrLen, sizeof(rend->maxPenetrLen), 1, fptr) != 1 ||
-		fread(&rend->badAreaPercentage, sizeof(rend->badAreaPercentage), 1, fptr) != 1 ||
-		fread(&rend->raysSize, sizeof(rend->raysSize), 1, fptr) != 1)
-	{
-		fclose(fptr);
-		log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
-		return;
-	}
-	//NOTE: let this code stay, saving additional data it is not used, but who knows 
-	int rx,ry;
-	float rtpl, avpl;
-	unsigned int psize;
-	for (unsigned int i=0; i<rend->raysSize; i++)
-	{
-		if (fread(&rx, sizeof(rx), 1, fptr) != 1 ||
-			fread(&ry, sizeof(ry), 1, fptr) != 1 ||
-			fread(&rtpl, sizeof(rtpl), 1, fptr) != 1 ||
-			fread(&avpl, sizeof(avpl), 1, fptr) != 1 ||
-			fread(&psize, sizeof(psize), 1, fptr) != 1)
-		{
-			fclose(fptr);
-			log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
-			return;
-		}
-		rend->rays.push_back(new RayPenetration(rx,ry,rtpl,avpl));
-	}
-	if (fread(&rend->intersectionsSize, sizeof(rend->intersectionsSize), 1, fptr) != 1)
-	{
-		log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
+void DreamCaster::readRenderFromBinaryFile(unsigned int x, unsigned int y, unsigned int z, RenderFromPosition *rend)
+{
+	if(!openResultSet())
 		return;
-	}
-	int tri_index;
-	float cos_ang;
-	for (unsigned int i=0; i<rend->intersectionsSize; i++)
-	{
-		if (fread(&tri_index, sizeof(tri_index), 1, fptr) != 1 ||
-			fread(&cos_ang, sizeof(cos_ang), 1, fptr) != 1)
-		{
-			fclose(fptr);
-			log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
-			return;
-		}
-		rend->intersections.push_back(new Intersection(tri_index, cos_ang));
-	}
-	//that's all, folks
-	fclose(fptr);
+	ResultSetHeader const & setHeader = resultSet->header();
+	setRangeSB( setHeader.minValX, setHeader.maxValX, setHeader.minValZ, setHeader.maxValZ );
+	if(!resultSet->readRender(x, y, z, rend))
+		log(resultSet->lastError());
 }
 void DreamCaster::closeEvent ( QCloseEvent * event ) 
 {
@@ -1880,52 +1796,27 @@ void DreamCaster::pbGrab3DSlot()
 
 void DreamCaster::UpdatePlotSlot()
 {
-	FILE *fptr = fopen(setFileName.toLatin1().constData(),"rb");
-	if(!fptr)
-	{
-		log("Error! Cannot open set file for reading.");
+	resultSet->close();//set file might have been rewritten since it was opened
+	if(!openResultSet())
 		return;
-	}
 	//delete prev data
 	ClearPrevData();//plotData,rotations,plotColumnData
 	//
-	float minValX, maxValX, minValZ, maxValZ;
-
-	if (fread(&cntX, sizeof(cntX), 1, fptr) != 1 ||
-		fread(&minValX, sizeof(minValX), 1, fptr) != 1 ||
-		fread(&maxValX, sizeof(maxValX), 1, fptr) != 1 ||
-		fread(&cntY, sizeof(cntY), 1, fptr) != 1 ||
-		fread(&cntZ, sizeof(cntZ), 1, fptr) != 1 ||
-		fread(&minValZ, sizeof(minValZ), 1, fptr) != 1 ||
-		fread(&maxValZ, sizeof(maxValZ), 1, fptr) != 1)
-	{
-		fclose(fptr);
-		log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
-		return;
-	}
-
-	setRangeSB( minValX, maxValX, minValZ, maxValZ );
+	ResultSetHeader const & setHeader = resultSet->header();
+	cntX = setHeader.cntX;
+	cntY = setHeader.cntY;
+	cntZ = setHeader.cntZ;
+	setRangeSB( setHeader.minValX, setHeader.maxValX, setHeader.minValZ, setHeader.maxValZ );
 	//read cut AABs
 	cutFigList->clear();
 	ui.listCutFig->clear();
-	int aabSize;
-	aabb box;
-	if (fread(&aabSize, sizeof(aabSize), 1, fptr) != 1)
-	{
-		fclose(fptr);
-		log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
-		return;
-	}
+	int aabSize = (int)setHeader.cutBoxes.size();
 	for (int i=0; i<aabSize; i++)
 	{
 		CutAAB *newCutAAB = new CutAAB("BOX"+QString::number(i));
-		if (fread(&newCutAAB->box, sizeof(aabb), 1, fptr) != 1 ||
-			fread(newCutAAB->slidersValues, sizeof(int)* 6, 1, fptr) != 1)
-		{
-			fclose(fptr);
-			log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
-			return;
-		}
+		ResultSetHeader::CutBox const & cutBox = setHeader.cutBoxes[i];
+		newCutAAB->box.setData(cutBox.box[0], cutBox.box[1], cutBox.box[2], cutBox.box[3], cutBox.box[4], cutBox.box[5]);
+		memcpy(newCutAAB->slidersValues, cutBox.slidersValues, sizeof(newCutAAB->slidersValues));
 		int index = cutFigList->add(newCutAAB);
 		cutFigList->SetCurIndex(index);
 		ui.listCutFig->insertItem( ui.listCutFig->count(), newCutAAB->name()+": "+newCutAAB->GetDimString());
@@ -1957,8 +1848,7 @@ void DreamCaster::UpdatePlotSlot()
 	memset(viewsBuffer, 0, s*sizeof(viewsBuffer[0]));
 
 	AllocateData();//plotData, rotations, plotColumnData
-	unsigned int raysSize;
-	unsigned int isecSize;
+	RenderSummary renderSummary;
 	float avpl;
 	float avang;
 	float maxpl;
@@ -1976,40 +1866,20 @@ void DreamCaster::UpdatePlotSlot()
 	for (int z=0; z<cntZ; z++)
 	for (int y=0; y<cntY; y++)
 	{
-		if (fread(&rotations[x][y][z].rotX, sizeof(rotations[x][y][z].rotX), 1, fptr) != 1)
-		{
-			fclose(fptr);
-			log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
-			return;
-		}
-		rotations[x][y][z].rotX/=M_PI;
-		if (fread(&rotations[x][y][z].rotY, sizeof(rotations[x][y][z].rotY), 1, fptr) != 1)
-		{
-			fclose(fptr);
-			log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
-			return;
-		}
-		rotations[x][y][z].rotY/=M_PI;
-		if (fread(&rotations[x][y][z].rotZ, sizeof(rotations[x][y][z].rotZ), 1, fptr) != 1)
-		{
-			fclose(fptr);
-			log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
-			return;
-		}
-		rotations[x][y][z].rotZ/=M_PI;
-		if (fread(&set_pos[0], sizeof(float), 1, fptr) != 1 ||
-			fread(&set_pos[1], sizeof(float), 1, fptr) != 1 ||
-			fread(&set_pos[2], sizeof(float), 1, fptr) != 1 ||
-			//fseek(fptr, 4*3, SEEK_CUR);//skip postition
-			fread(&avpl, sizeof(avpl), 1, fptr) != 1 ||
-			fread(&avang, sizeof(avang), 1, fptr) != 1 ||
-			fread(&maxpl, sizeof(maxpl), 1, fptr) != 1 ||
-			fread(&badArPrcnt, sizeof(badArPrcnt), 1, fptr) != 1)
+		if (!resultSet->summary(x, y, z, renderSummary))
 		{
-			fclose(fptr);
-			log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
+			log("Reading file failed - set file contains no data for rendering ("+QString::number(x)+", "+QString::number(y)+", "+QString::number(z)+").");
 			return;
 		}
+		rotations[x][y][z].rotX = renderSummary.rotX/M_PI;
+		rotations[x][y][z].rotY = renderSummary.rotY/M_PI;
+		rotations[x][y][z].rotZ = renderSummary.rotZ/M_PI;
+		for (int i=0; i<3; i++)
+			set_pos[i] = renderSummary.pos[i];
+		avpl = renderSummary.avPenetrLen;
+		avang = renderSummary.avDipAngle;
+		maxpl = renderSummary.maxPenetrLen;
+		badArPrcnt = renderSummary.badAreaPercentage;
 		/*switch(paramIndex)
 		{
 		case 0:
@@ -2052,14 +1922,6 @@ void DreamCaster::UpdatePlotSlot()
 		if(rotationsParams[x][y][z].maxPenLen > placementsParams[x][z].maxPenLen)
 			placementsParams[x][z].maxPenLen = rotationsParams[x][y][z].maxPenLen;
 		placementsParams[x][z].badAreaPercentage = rotationsParams[x][y][z].badAreaPercentage;
-		
-		if (fread(&raysSize, sizeof(raysSize), 1, fptr) != 1 ||
-			fread(&isecSize, sizeof(isecSize), 1, fptr) != 1)
-		{
-			fclose(fptr);
-			log("Reading file failed - expected number of bytes read does not match actual number of bytes read.");
-			return;
-		}
 	}
 	for (int x=0; x<cntX; x++)
 	for (int z=0; z<cntZ; z++)
@@ -2182,7 +2044,6 @@ void DreamCaster::UpdatePlotSlot()
 	//plot->updateGL();
 	UpdateSlot();
 	//that's all, folks
-	fclose(fptr);
 }
 
 void DreamCaster::SaveTree()
@@ -30,6 +30,7 @@
 #include "raycast/include/common.h"
 
 class RenderFromPosition;
+class ResultSetReader;
 //VTK
 class vtkPolyDataMapper;
 class vtkDataSetMapper;
@@ -138,6 +139,7 @@ private:
 	///Plot *plot;					///< 3D plot item. For average parameter value func.
 	QString modelFileName;		///< filename of .stl file containing object
 	QString setFileName;		///< filename of file containing current set of renderings
+	ResultSetReader * resultSet;	///< random access to the renderings of the current set
 	//VTK classes instances for interactive 3D view
 	vtkPolyDataMapper *mapper, *originMapper, *planeMapper, *raysMapper, *raysProjMapper, *plateMapper, *cutAABMapper;
 	vtkActor *actor, *originActor, *planeActor, *raysActor, *raysProjActor, *plateActor, *cutAABActor;
@@ -193,6 +195,11 @@ private:
 	*/
 	void fillParamBuffer(unsigned int* dest, int paramInd);
 	/**
+	* Opens the current renderings file (setFileName) for reading, if not already open.
+	* @return true if the file is open
+	*/
+	bool openResultSet();
+	/**
 	* Reads single render data from current renderings file by indices.
 	* @param x x-index of render
 	* @param y y-index of render
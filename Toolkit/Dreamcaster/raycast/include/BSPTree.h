@@ -539,7 +539,7 @@ public:
 	* @param[out] intersections vector where obtained intersections are placed.
 	* @return 1 if intersect tree AABB , 0 - otherwise
 	*/
-	int GetIntersectionsNR(Ray & ray, std::vector<intersection*>& intersections, traverse_stack * tr_stack) const
+	int GetIntersectionsNR(Ray & ray, std::vector<intersection>& intersections, traverse_stack * tr_stack) const
 	{
 		iAVec3 ro, rd;
 		float tmin=0, tmax=100000.f, t=tmin;
@@ -564,7 +564,7 @@ public:
 					if ((*m_triangles)[tri_ind[cur_node->tri_start()+i]]->Intersect( ray, a_Dist )) 
 					{
 						//iAVec3 isec = ray.GetOrigin()+ray.GetDirection()*a_Dist;			
-						intersections.push_back(new intersection((*m_triangles)[tri_ind[cur_node->tri_start()+i]], a_Dist));//checked
+						intersections.push_back(intersection((*m_triangles)[tri_ind[cur_node->tri_start()+i]], a_Dist));//checked
 					}
 				}
 			}
@@ -0,0 +1,78 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#pragma once
+
+#include <vector>
+
+class Ray;
+class TriPrim;
+struct intersection;
+
+/**	\class BVH.
+	\brief Bounding volume hierarchy over the scene's triangles, used as alternative to the kd-tree on the CPU.
+
+	Built as a binary tree using the surface area heuristic (SAH) over binned centroids
+	and then collapsed into nodes with up to four children, whose bounding boxes are stored
+	as structure of arrays so that one ray is tested against all of them with a single SIMD operation.
+	Traversal is done for packets of coherent rays (neighbouring pixels of the viewport),
+	which share the node fetches; rays drop out of a subtree as soon as they miss its box.
+*/
+class BVH
+{
+public:
+	//! maximum number of rays in a packet (one bit per ray in the activity masks)
+	static const int MAX_PACKET_SIZE = 32;
+	//! width and height (in pixels) of the ray packets used for rendering the viewport grid
+	static const int PACKET_DIM = 4;
+	BVH();
+	/**
+	* Builds the hierarchy over the given triangles.
+	* @param tris scene's triangles; the pointers have to stay valid as long as the hierarchy is used.
+	*/
+	void Build( std::vector<TriPrim*> const & tris );
+	/**
+	* Finds all intersections of a packet of rays with the scene.
+	* @param rays the rays of the packet.
+	* @param count number of rays in the packet (at most MAX_PACKET_SIZE).
+	* @param activeMask bit i is set if rays[i] should be traced.
+	* @param hits [out] hits[i] receives the (unsorted) intersections of rays[i]; the buffers are appended to, not cleared.
+	*/
+	void IntersectPacket( Ray * rays, int count, unsigned int activeMask, std::vector<intersection> * hits ) const;
+	//! number of (4-wide) nodes in the hierarchy
+	unsigned int GetNodeCount() const { return (unsigned int)m_nodes.size(); }
+private:
+	static const int WIDTH = 4;
+	struct Node
+	{
+		float bmin[3][WIDTH];	///< children's box minima, per axis
+		float bmax[3][WIDTH];	///< children's box maxima, per axis
+		int child[WIDTH];		///< index of child node, or of the first triangle for leaf children
+		int triCount[WIDTH];	///< number of triangles of leaf children, 0 for inner children
+		int childCount;
+	};
+	struct BuildNode;
+	struct PrimInfo;
+	int BuildRecursive( std::vector<PrimInfo> & prims, int start, int end, int depth, std::vector<BuildNode> & buildNodes );
+	int Collapse( std::vector<BuildNode> const & buildNodes, int binaryNode );
+
+	std::vector<Node> m_nodes;		///< collapsed nodes, root at index 0
+	std::vector<TriPrim*> m_tris;	///< triangles, ordered so that each leaf references a contiguous range
+};
@@ -0,0 +1,176 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#pragma once
+
+#include <QFile>
+#include <QString>
+
+#include <vector>
+
+class RenderFromPosition;
+
+/**	\struct ResultSetHeader.
+	\brief Parameters of a set of renderings: ranges of the placements and the cut boxes used.
+*/
+struct ResultSetHeader
+{
+	/**	\struct CutBox.
+		\brief Cut box as stored in a result set (see CutAAB).
+	*/
+	struct CutBox
+	{
+		float box[6];			///< bounds as in aabb: x1, x2, y1, y2, z1, z2
+		int slidersValues[6];	///< corresponding values of sliders
+	};
+	ResultSetHeader();
+	int cntX;		///< number of renderings by X axis
+	int cntY;		///< number of renderings by Y axis
+	int cntZ;		///< number of renderings by Z axis
+	float minValX;	///< minimum rotation about X axis, in units of pi
+	float maxValX;	///< maximum rotation about X axis, in units of pi
+	float minValZ;	///< minimum rotation about Z axis, in units of pi
+	float maxValZ;	///< maximum rotation about Z axis, in units of pi
+	std::vector<CutBox> cutBoxes;
+	//! total number of renderings in the set
+	int renderCount() const { return cntX*cntY*cntZ; }
+	//! position of render (x, y, z) in the set, same order in which the renderings are computed
+	int renderIndex(int x, int y, int z) const { return cntZ*cntY*x + y + cntY*z; }
+};
+
+/**	\struct RenderSummary.
+	\brief Scalar results of a single render; everything of RenderFromPosition except rays' and intersections' data.
+*/
+struct RenderSummary
+{
+	float rotX;		///< rotation about X axis
+	float rotY;		///< rotation about Y axis
+	float rotZ;		///< rotation about Z axis
+	float pos[3];	///< object's position
+	float avPenetrLen;	///< average penetration length
+	float avDipAngle;	///< average dip angle cos
+	float maxPenetrLen;	///< maximum penetration length in rendering
+	float badAreaPercentage;	///< percentage of bad surface area corresponding to radon space analysis
+	quint32 raysSize;			///< number of stored rays
+	quint32 intersectionsSize;	///< number of stored intersections
+};
+
+/**	\struct ResultSetIndexEntry.
+	\brief Entry of a result set's offset index table, one per render.
+*/
+struct ResultSetIndexEntry
+{
+	RenderSummary summary;
+	quint64 offset;		///< file position of the render's ray and intersection data
+	quint32 storedSize;	///< number of bytes stored at offset (compressed size if compressed)
+	quint32 flags;		///< combination of ResultSetIndexFlags
+};
+
+enum ResultSetIndexFlags
+{
+	ResultSetRenderPresent = 1,	///< render has been written (sets whose computation was stopped are incomplete)
+	ResultSetRenderCompressed = 2	///< ray and intersection data are compressed with qCompress
+};
+
+/**	\class ResultSetWriter.
+	\brief Writes a set of renderings in the indexed result set format.
+
+	Layout: magic "DCRS", format version, flags, the ResultSetHeader, an index table with one ResultSetIndexEntry
+	per render (ordered by ResultSetHeader::renderIndex), followed by the per-render data. The data of a render
+	is stored column-wise: all rays' x coordinates, y coordinates, total penetration lengths, average dip angles
+	and penetration counts, then all intersections' triangle indices and dip angles.
+	The index table is written when the writer is closed; renders may be written in any order.
+*/
+class ResultSetWriter
+{
+public:
+	ResultSetWriter();
+	//! closes the file, writing the index table of the renders written so far
+	~ResultSetWriter();
+	/**
+	* Creates the result set file and writes its header.
+	* @param compress compress each render's rays and intersections data.
+	* @return true on success, see lastError() otherwise
+	*/
+	bool open(QString const & fileName, ResultSetHeader const & header, bool compress);
+	/**
+	* Appends the data of a render and records it in the index.
+	* @param saveAdditionalData store rays' and intersections' data, not just the render's summary.
+	*/
+	bool writeRender(int x, int y, int z, RenderFromPosition const & rend, bool saveAdditionalData);
+	//! writes the index table and closes the file
+	bool close();
+	QString const & lastError() const { return m_lastError; }
+private:
+	QFile m_file;
+	ResultSetHeader m_header;
+	std::vector<ResultSetIndexEntry> m_index;
+	qint64 m_indexOffset;
+	qint64 m_dataEnd;	///< end of the data written so far
+	bool m_compress;
+	QString m_lastError;
+};
+
+/**	\class ResultSetReader.
+	\brief Random access to the renderings of a result set.
+
+	The file is memory-mapped if possible, so that opening any render costs a lookup in the index table.
+	Files in the old sequential format (without index) are indexed once when opening them.
+*/
+class ResultSetReader
+{
+public:
+	ResultSetReader();
+	~ResultSetReader();
+	/**
+	* Opens a result set in the indexed or the old sequential format.
+	* @return true on success, see lastError() otherwise
+	*/
+	bool open(QString const & fileName);
+	void close();
+	bool isOpen() const { return m_file.isOpen(); }
+	//! true if the opened file is in the old format without index table
+	bool isLegacy() const { return m_legacy; }
+	QString fileName() const { return m_file.fileName(); }
+	ResultSetHeader const & header() const { return m_header; }
+	/**
+	* Retrieves the summary of render (x, y, z).
+	* @return false if the index is invalid or the render has not been written.
+	*/
+	bool summary(int x, int y, int z, RenderSummary & result) const;
+	/**
+	* Reads the complete data of render (x, y, z), including stored rays and intersections.
+	* @param[out] rend rendering for data storing.
+	*/
+	bool readRender(int x, int y, int z, RenderFromPosition * rend);
+	QString const & lastError() const { return m_lastError; }
+private:
+	bool readBytes(qint64 offset, void * dest, qint64 size);
+	bool readHeader(qint64 & pos);
+	bool buildLegacyIndex(qint64 pos);
+	ResultSetIndexEntry const * entry(int x, int y, int z) const;
+	QFile m_file;
+	uchar * m_map;		///< mapped file content, 0 if mapping was not possible
+	qint64 m_size;
+	bool m_legacy;
+	ResultSetHeader m_header;
+	std::vector<ResultSetIndexEntry> m_index;
+	QString m_lastError;
+};
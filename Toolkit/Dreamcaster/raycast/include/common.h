@@ -79,6 +79,8 @@ inline float Rand( float a_Range );
 			BATCH_SIZE = 10;
 			MIN_TRI_PER_NODE = 1;
 			USE_SAH = 0;
+			USE_BVH = 1;
+			COMPRESS_RESULTS = 0;
 		}
 		float EPSILON;
 		int TRACEDEPTH;
@@ -132,6 +134,10 @@ inline float Rand( float a_Range );
 		unsigned int MIN_TRI_PER_NODE;
 		//Use SAH when building kd-tree or not
 		unsigned int USE_SAH;
+		//Use packet-traced BVH instead of kd-tree for rendering on CPU
+		unsigned int USE_BVH;
+		//Compress rays' and intersections' data of every rendering in result set files
+		unsigned int COMPRESS_RESULTS;
 		//#define SQRDISTANCE(A,B) ((A.x-B.x)*(A.x-B.x)+(A.y-B.y)*(A.y-B.y)+(A.z-B.z)*(A.z-B.z))
 	};
 	/**
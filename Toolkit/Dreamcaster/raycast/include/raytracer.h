@@ -27,6 +27,7 @@
 #include "DataFormat.h"
 
 #include "cl_common.h"
+#include "BVH.h"
 
 /**	\class Ray.
 	\brief Class representing ray in 3D.
@@ -49,6 +50,23 @@ private:
 };
 
 
+/**	\struct intersection.
+	\brief Structure representing intersection data.
+
+	Contains data about primitive.	
+*/
+class TriPrim;
+struct intersection
+{
+	TriPrim* tri;
+	float dist;
+	intersection(TriPrim* a_tri, float a_dist)
+	{
+		tri = a_tri;
+		dist = a_dist;
+	}
+};
+
 class Scene;
 class RaycastingThread;
 struct traverse_stack;
@@ -79,7 +97,17 @@ public:
 	* Raytrace single ray. 
 	* @note not used (using thread->DepthRaytrace(...) instead)
 	*/
-	int DepthRaytrace ( Ray& a_Ray, iAVec3& a_Acc, int a_Depth, float a_RIndex, float& a_Dist, RayPenetration * ray_p, std::vector<Intersection*> &vecIntersections, traverse_stack * stack, bool dipAsColor=false ); 
+	int DepthRaytrace ( Ray& a_Ray, iAVec3& a_Acc, int a_Depth, float a_RIndex, float& a_Dist, RayPenetration * ray_p, std::vector<Intersection*> &vecIntersections, traverse_stack * stack, std::vector<intersection> & hits, bool dipAsColor=false ); 
+	/**
+	* Evaluates the intersections found along a ray: sorts them, computes penetration lengths and dip angles, and the resulting pixel color.
+	* @param hits intersections of the ray, reordered in place.
+	* @return 1 if the ray hit the specimen, 0 otherwise
+	*/
+	int ProcessIntersections( Ray & a_Ray, iAVec3& a_Acc, RayPenetration * ray_p, std::vector<Intersection*> &vecIntersections, std::vector<intersection> & hits, bool dipAsColor );
+	/**
+	* Checks whether ray passes through at least one of the cut AABBs (always true if no cut AABBs are set).
+	*/
+	bool IntersectsCutAABBs( Ray & a_Ray ) const;
 	/**
 	* Initializes the renderer, by resetting render parameters and precalculating some values.
 	* Prepares transformation matrix which is applied to origin and screen plane.
@@ -316,11 +344,18 @@ public:
 	int rayCount;  ///< number of casted rays
 	bool dipAsColor;  ///< image colored corresponding to dip angles
 private: 
+	//! initially reserved number of intersections per ray buffer
+	static const int INTERSECTION_BUFFER_CAPACITY = 64;
+	/**
+	* Writes the color of a pixel into the engine's image buffer.
+	*/
+	void writePixel(int x, int y, iAVec3 const & acc);
 	const iAVec3 *m_o; ///< rays' origin point
 	const iAVec3 *m_vp_corners;///< plane's corners in 3d
 	const iAVec3 *m_vp_delta;///< plane's x and y axes' directions in 3D
 	Engine* e; ///< parent Engine 
 	RayPenetration * rays; ///< rays' penetrations data
 	std::vector<Intersection*> intersections; ///< intersections data
+	std::vector<intersection> m_hits[BVH::MAX_PACKET_SIZE]; ///< per-ray intersection buffers, reused across rays and renders
 	volatile bool stopped; 
 }; //Thread
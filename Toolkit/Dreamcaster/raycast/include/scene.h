@@ -27,23 +27,6 @@
 #define MISS	 0		// Ray missed primitive
 #define INPRIM	-1		// Ray started inside primitive
 
-/**	\struct intersection.
-	\brief Structure representing intersection data.
-
-	Contains data about primitive.	
-*/
-class TriPrim;
-struct intersection
-{
-	TriPrim* tri;
-	float dist;
-	intersection(TriPrim* a_tri, float a_dist)
-	{
-		tri = a_tri;
-		dist = a_dist;
-	}
-};
-
 /**
 * Ray-AABB intersection routine.
 * @param ray ray class.
@@ -282,10 +265,11 @@ private:
 	Also list of all primitives is available.
 */
 class BSPTree;
+class BVH;
 class Scene
 {
 public:
-	Scene(){};
+	Scene(): m_bsp(0), m_bvh(0) {};
 	~Scene();
 	/**
 	* Inits scene. BSP tree is created and build on current loaded mesh's data.
@@ -304,10 +288,15 @@ public:
 	*/
 	BSPTree* getBSPTree(void){return m_bsp;}
 	/**
+	* Get scene's BVH, 0 if it is not used (see SETTINGS::USE_BVH).
+	*/
+	BVH* getBVH(void){return m_bvh;}
+	/**
 	* recalculate d coefficient when translation vector is given for every triangle
 	*/
 	void recalculateD( iAVec3 *translate );
 private:
 	std::vector<TriPrim*> m_tris;///< list of all scene's primitives
 	BSPTree *m_bsp;///< scene's BSP-tree
+	BVH *m_bvh;///< scene's bounding volume hierarchy, used for CPU rendering
 };
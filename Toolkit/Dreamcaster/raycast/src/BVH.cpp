@@ -0,0 +1,407 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#include "../include/common.h"
+#include "../include/scene.h"
+#include "../include/BVH.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define BVH_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+	const int BinCount = 16;			// number of centroid bins evaluated per axis for the SAH
+	const int MaxForcedLeafSize = 16;	// leaves with more triangles are split even if SAH prefers not to
+	const int MaxDepth = 64;			// maximum depth of the binary tree; bounds the traversal stack
+	const float TraversalCost = 1.0f;	// SAH cost of a node visit, relative to a triangle test
+	const float MaxRayDist = 1000000.0f;// same as the initial distance used for triangle tests
+
+	struct Bounds
+	{
+		float mn[3], mx[3];
+		Bounds() { reset(); }
+		void reset()
+		{
+			for (int a = 0; a < 3; ++a)
+			{
+				mn[a] = FLT_MAX;
+				mx[a] = -FLT_MAX;
+			}
+		}
+		void grow(Bounds const & b)
+		{
+			for (int a = 0; a < 3; ++a)
+			{
+				mn[a] = std::min(mn[a], b.mn[a]);
+				mx[a] = std::max(mx[a], b.mx[a]);
+			}
+		}
+		void grow(const float p[3])
+		{
+			for (int a = 0; a < 3; ++a)
+			{
+				mn[a] = std::min(mn[a], p[a]);
+				mx[a] = std::max(mx[a], p[a]);
+			}
+		}
+		float area() const
+		{
+			float d[3] = { mx[0] - mn[0], mx[1] - mn[1], mx[2] - mn[2] };
+			if (d[0] < 0 || d[1] < 0 || d[2] < 0)
+				return 0.0f;
+			return 2.0f * (d[0] * d[1] + d[1] * d[2] + d[2] * d[0]);
+		}
+	};
+
+	float safeInverse(float d)
+	{
+		const float Eps = 1e-20f;
+		if (std::fabs(d) < Eps)
+			d = (d < 0) ? -Eps : Eps;
+		return 1.0f / d;
+	}
+}
+
+struct BVH::PrimInfo
+{
+	Bounds box;
+	float centroid[3];
+	int tri;
+};
+
+struct BVH::BuildNode
+{
+	Bounds box;
+	int left, right;	///< children; left < 0 for leaves
+	int start, count;	///< range of triangles of a leaf
+};
+
+BVH::BVH()
+{}
+
+void BVH::Build( std::vector<TriPrim*> const & tris )
+{
+	m_nodes.clear();
+	m_tris.clear();
+	if (tris.empty())
+		return;
+	std::vector<PrimInfo> prims(tris.size());
+	for (size_t i = 0; i < tris.size(); ++i)
+	{
+		PrimInfo & p = prims[i];
+		p.box.mn[0] = tris[i]->getMinX(); p.box.mx[0] = tris[i]->getMaxX();
+		p.box.mn[1] = tris[i]->getMinY(); p.box.mx[1] = tris[i]->getMaxY();
+		p.box.mn[2] = tris[i]->getMinZ(); p.box.mx[2] = tris[i]->getMaxZ();
+		for (int a = 0; a < 3; ++a)
+			p.centroid[a] = 0.5f * (p.box.mn[a] + p.box.mx[a]);
+		p.tri = (int)i;
+	}
+	std::vector<BuildNode> buildNodes;
+	buildNodes.reserve(2 * prims.size());
+	int root = BuildRecursive(prims, 0, (int)prims.size(), 0, buildNodes);
+	m_tris.reserve(prims.size());
+	for (size_t i = 0; i < prims.size(); ++i)
+		m_tris.push_back(tris[prims[i].tri]);
+	m_nodes.reserve(buildNodes.size() / 2 + 1);
+	Collapse(buildNodes, root);
+}
+
+int BVH::BuildRecursive( std::vector<PrimInfo> & prims, int start, int end, int depth, std::vector<BuildNode> & buildNodes )
+{
+	int nodeIdx = (int)buildNodes.size();
+	buildNodes.push_back(BuildNode());
+	Bounds box, centroidBox;
+	for (int i = start; i < end; ++i)
+	{
+		box.grow(prims[i].box);
+		centroidBox.grow(prims[i].centroid);
+	}
+	buildNodes[nodeIdx].box = box;
+	buildNodes[nodeIdx].left = buildNodes[nodeIdx].right = -1;
+	buildNodes[nodeIdx].start = start;
+	buildNodes[nodeIdx].count = end - start;
+	int count = end - start;
+	if (count <= 1 || depth >= MaxDepth)
+		return nodeIdx;
+
+	// binned SAH: evaluate the split planes between BinCount centroid bins on each axis
+	float bestCost = FLT_MAX;
+	int bestAxis = -1, bestSplit = -1;
+	for (int a = 0; a < 3; ++a)
+	{
+		float extent = centroidBox.mx[a] - centroidBox.mn[a];
+		if (extent <= 0)
+			continue;
+		float binScale = BinCount / extent;
+		Bounds binBox[BinCount];
+		int binCount[BinCount] = { 0 };
+		for (int i = start; i < end; ++i)
+		{
+			int b = std::min(BinCount - 1, (int)((prims[i].centroid[a] - centroidBox.mn[a]) * binScale));
+			binBox[b].grow(prims[i].box);
+			++binCount[b];
+		}
+		float rightArea[BinCount];
+		int rightCount[BinCount];
+		Bounds acc;
+		int accCount = 0;
+		for (int b = BinCount - 1; b > 0; --b)
+		{
+			acc.grow(binBox[b]);
+			accCount += binCount[b];
+			rightArea[b] = acc.area();
+			rightCount[b] = accCount;
+		}
+		acc.reset();
+		accCount = 0;
+		for (int b = 0; b < BinCount - 1; ++b)
+		{
+			acc.grow(binBox[b]);
+			accCount += binCount[b];
+			if (accCount == 0 || rightCount[b + 1] == 0)
+				continue;
+			float cost = acc.area() * accCount + rightArea[b + 1] * rightCount[b + 1];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = a;
+				bestSplit = b;
+			}
+		}
+	}
+	int mid;
+	if (bestAxis >= 0)
+	{
+		float boxArea = box.area();
+		float splitCost = TraversalCost + ((boxArea > 0) ? bestCost / boxArea : (float)count);
+		if (splitCost >= count && count <= MaxForcedLeafSize)
+			return nodeIdx;
+		float cmin = centroidBox.mn[bestAxis];
+		float binScale = BinCount / (centroidBox.mx[bestAxis] - cmin);
+		mid = (int)(std::partition(prims.begin() + start, prims.begin() + end,
+			[bestAxis, bestSplit, cmin, binScale](PrimInfo const & p)
+			{
+				return std::min(BinCount - 1, (int)((p.centroid[bestAxis] - cmin) * binScale)) <= bestSplit;
+			}) - prims.begin());
+	}
+	else
+	{
+		// all centroids coincide; SAH cannot separate the triangles
+		if (count <= MaxForcedLeafSize)
+			return nodeIdx;
+		mid = start + count / 2;
+	}
+	int left = BuildRecursive(prims, start, mid, depth + 1, buildNodes);
+	int right = BuildRecursive(prims, mid, end, depth + 1, buildNodes);
+	buildNodes[nodeIdx].left = left;
+	buildNodes[nodeIdx].right = right;
+	return nodeIdx;
+}
+
+int BVH::Collapse( std::vector<BuildNode> const & buildNodes, int binaryNode )
+{
+	// pull up the grandchildren with the largest surface until the node has WIDTH children
+	int slots[WIDTH];
+	int n = 0;
+	BuildNode const & bn = buildNodes[binaryNode];
+	if (bn.left < 0)
+		slots[n++] = binaryNode;
+	else
+	{
+		slots[n++] = bn.left;
+		slots[n++] = bn.right;
+	}
+	while (n < WIDTH)
+	{
+		int best = -1;
+		float bestArea = -1.0f;
+		for (int i = 0; i < n; ++i)
+		{
+			BuildNode const & c = buildNodes[slots[i]];
+			if (c.left >= 0 && c.box.area() > bestArea)
+			{
+				bestArea = c.box.area();
+				best = i;
+			}
+		}
+		if (best < 0)
+			break;
+		int split = slots[best];
+		slots[best] = buildNodes[split].left;
+		slots[n++] = buildNodes[split].right;
+	}
+	int nodeIdx = (int)m_nodes.size();
+	m_nodes.push_back(Node());
+	Node & node = m_nodes[nodeIdx];
+	node.childCount = n;
+	for (int i = 0; i < WIDTH; ++i)
+	{
+		for (int a = 0; a < 3; ++a)
+		{	// empty box for unused slots, never hit
+			node.bmin[a][i] = FLT_MAX;
+			node.bmax[a][i] = -FLT_MAX;
+		}
+		node.child[i] = -1;
+		node.triCount[i] = 0;
+	}
+	for (int i = 0; i < n; ++i)
+	{
+		BuildNode const & c = buildNodes[slots[i]];
+		for (int a = 0; a < 3; ++a)
+		{
+			m_nodes[nodeIdx].bmin[a][i] = c.box.mn[a];
+			m_nodes[nodeIdx].bmax[a][i] = c.box.mx[a];
+		}
+		if (c.left < 0)
+		{
+			m_nodes[nodeIdx].child[i] = c.start;
+			m_nodes[nodeIdx].triCount[i] = c.count;
+		}
+		else
+		{	// m_nodes may be reallocated by the recursion, so no reference is held across it
+			int childIdx = Collapse(buildNodes, slots[i]);
+			m_nodes[nodeIdx].child[i] = childIdx;
+		}
+	}
+	return nodeIdx;
+}
+
+void BVH::IntersectPacket( Ray * rays, int count, unsigned int activeMask, std::vector<intersection> * hits ) const
+{
+	assert(count <= MAX_PACKET_SIZE);
+	if (m_nodes.empty() || !activeMask)
+		return;
+	// per-ray origin and inverse direction, broadcast to all lanes
+#ifdef BVH_USE_SSE
+	__m128 org[MAX_PACKET_SIZE][3], inv[MAX_PACKET_SIZE][3];
+#else
+	float org[MAX_PACKET_SIZE][3], inv[MAX_PACKET_SIZE][3];
+#endif
+	for (int r = 0; r < count; ++r)
+	{
+		if (!(activeMask & (1u << r)))
+			continue;
+		const iAVec3 & o = rays[r].GetOrigin();
+		const iAVec3 & d = rays[r].GetDirection();
+		for (int a = 0; a < 3; ++a)
+		{
+#ifdef BVH_USE_SSE
+			org[r][a] = _mm_set1_ps(o[a]);
+			inv[r][a] = _mm_set1_ps(safeInverse(d[a]));
+#else
+			org[r][a] = o[a];
+			inv[r][a] = safeInverse(d[a]);
+#endif
+		}
+	}
+	struct StackEntry
+	{
+		int node;
+		unsigned int mask;	///< rays still active in this subtree
+	};
+	StackEntry stack[(WIDTH - 1) * MaxDepth + WIDTH];
+	int sp = 0;
+	stack[sp].node = 0;
+	stack[sp].mask = activeMask;
+	++sp;
+	while (sp > 0)
+	{
+		--sp;
+		Node const & node = m_nodes[stack[sp].node];
+		unsigned int mask = stack[sp].mask;
+		unsigned int childMask[WIDTH] = { 0 };
+#ifdef BVH_USE_SSE
+		__m128 bmin[3], bmax[3];
+		for (int a = 0; a < 3; ++a)
+		{
+			bmin[a] = _mm_loadu_ps(node.bmin[a]);
+			bmax[a] = _mm_loadu_ps(node.bmax[a]);
+		}
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 maxDist = _mm_set1_ps(MaxRayDist);
+#endif
+		for (int r = 0; r < count; ++r)
+		{
+			if (!(mask & (1u << r)))
+				continue;
+#ifdef BVH_USE_SSE
+			// slab test of one ray against all four children at once
+			__m128 tNear = zero, tFar = maxDist;
+			for (int a = 0; a < 3; ++a)
+			{
+				__m128 t0 = _mm_mul_ps(_mm_sub_ps(bmin[a], org[r][a]), inv[r][a]);
+				__m128 t1 = _mm_mul_ps(_mm_sub_ps(bmax[a], org[r][a]), inv[r][a]);
+				tNear = _mm_max_ps(tNear, _mm_min_ps(t0, t1));
+				tFar = _mm_min_ps(tFar, _mm_max_ps(t0, t1));
+			}
+			int hitBits = _mm_movemask_ps(_mm_cmple_ps(tNear, tFar));
+#else
+			int hitBits = 0;
+			for (int c = 0; c < WIDTH; ++c)
+			{
+				float tNear = 0, tFar = MaxRayDist;
+				for (int a = 0; a < 3; ++a)
+				{
+					float t0 = (node.bmin[a][c] - org[r][a]) * inv[r][a];
+					float t1 = (node.bmax[a][c] - org[r][a]) * inv[r][a];
+					tNear = std::max(tNear, std::min(t0, t1));
+					tFar = std::min(tFar, std::max(t0, t1));
+				}
+				if (tNear <= tFar)
+					hitBits |= 1 << c;
+			}
+#endif
+			for (int c = 0; c < node.childCount; ++c)
+				if (hitBits & (1 << c))
+					childMask[c] |= 1u << r;
+		}
+		for (int c = 0; c < node.childCount; ++c)
+		{
+			if (!childMask[c])
+				continue;
+			if (node.triCount[c] == 0)
+			{
+				stack[sp].node = node.child[c];
+				stack[sp].mask = childMask[c];
+				++sp;
+				continue;
+			}
+			int triEnd = node.child[c] + node.triCount[c];
+			for (int r = 0; r < count; ++r)
+			{
+				if (!(childMask[c] & (1u << r)))
+					continue;
+				for (int t = node.child[c]; t < triEnd; ++t)
+				{
+					float dist = MaxRayDist;
+					if (m_tris[t]->Intersect(rays[r], dist))
+						hits[r].push_back(intersection(m_tris[t], dist));
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,498 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#include "../include/ResultSet.h"
+#include "../include/DataFormat.h"
+
+#include <QByteArray>
+
+#include <cstring>
+
+namespace
+{
+	const char Magic[4] = { 'D', 'C', 'R', 'S' };
+	const quint32 FormatVersion = 2;
+	const quint32 FileFlagCompressed = 1;
+
+	// sizes of the records in the old sequential format
+	const qint64 LegacyRenderHeaderSize = 10 * sizeof(float) + sizeof(quint32);	// rotations, position, 4 parameters, raysSize
+	const qint64 LegacyRaySize = 2 * sizeof(int) + 2 * sizeof(float) + sizeof(unsigned int);
+	const qint64 LegacyIntersectionSize = sizeof(unsigned int) + sizeof(float);
+
+	// per element size of the column-wise render data
+	const qint64 RayColumnsSize = 2 * sizeof(qint32) + 2 * sizeof(float) + sizeof(quint32);
+	const qint64 IntersectionColumnsSize = sizeof(quint32) + sizeof(float);
+
+	template <typename T>
+	void appendColumn(QByteArray & dest, std::vector<T> const & column)
+	{
+		if (!column.empty())
+			dest.append(reinterpret_cast<const char*>(&column[0]), (int)(column.size() * sizeof(T)));
+	}
+
+	template <typename T>
+	const uchar * readColumn(const uchar * src, T * dest, size_t count)
+	{
+		memcpy(dest, src, count * sizeof(T));
+		return src + count * sizeof(T);
+	}
+}
+
+ResultSetHeader::ResultSetHeader():
+	cntX(0), cntY(0), cntZ(0),
+	minValX(0), maxValX(0), minValZ(0), maxValZ(0)
+{}
+
+// ResultSetWriter
+
+ResultSetWriter::ResultSetWriter():
+	m_indexOffset(0),
+	m_dataEnd(0),
+	m_compress(false)
+{}
+
+ResultSetWriter::~ResultSetWriter()
+{
+	close();
+}
+
+bool ResultSetWriter::open(QString const & fileName, ResultSetHeader const & header, bool compress)
+{
+	close();
+	m_file.setFileName(fileName);
+	if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		m_lastError = "Cannot open set file for writing: " + m_file.errorString();
+		return false;
+	}
+	m_header = header;
+	m_compress = compress;
+	quint32 flags = compress ? FileFlagCompressed : 0;
+	qint32 cutBoxCount = (qint32)header.cutBoxes.size();
+	m_file.write(Magic, sizeof(Magic));
+	m_file.write(reinterpret_cast<const char*>(&FormatVersion), sizeof(FormatVersion));
+	m_file.write(reinterpret_cast<const char*>(&flags), sizeof(flags));
+	m_file.write(reinterpret_cast<const char*>(&header.cntX), sizeof(header.cntX));
+	m_file.write(reinterpret_cast<const char*>(&header.minValX), sizeof(header.minValX));
+	m_file.write(reinterpret_cast<const char*>(&header.maxValX), sizeof(header.maxValX));
+	m_file.write(reinterpret_cast<const char*>(&header.cntY), sizeof(header.cntY));
+	m_file.write(reinterpret_cast<const char*>(&header.cntZ), sizeof(header.cntZ));
+	m_file.write(reinterpret_cast<const char*>(&header.minValZ), sizeof(header.minValZ));
+	m_file.write(reinterpret_cast<const char*>(&header.maxValZ), sizeof(header.maxValZ));
+	m_file.write(reinterpret_cast<const char*>(&cutBoxCount), sizeof(cutBoxCount));
+	for (size_t i = 0; i < header.cutBoxes.size(); ++i)
+		m_file.write(reinterpret_cast<const char*>(&header.cutBoxes[i]), sizeof(ResultSetHeader::CutBox));
+	m_indexOffset = m_file.pos();
+	// reserve space for the index table, it is filled in on close
+	ResultSetIndexEntry emptyEntry;
+	memset(&emptyEntry, 0, sizeof(emptyEntry));
+	m_index.assign(header.renderCount(), emptyEntry);
+	if (!m_index.empty() && m_file.write(reinterpret_cast<const char*>(&m_index[0]), (qint64)(m_index.size() * sizeof(ResultSetIndexEntry))) < 0)
+	{
+		m_lastError = "Writing set file header failed: " + m_file.errorString();
+		m_file.close();
+		return false;
+	}
+	m_dataEnd = m_file.pos();
+	return true;
+}
+
+bool ResultSetWriter::writeRender(int x, int y, int z, RenderFromPosition const & rend, bool saveAdditionalData)
+{
+	if (!m_file.isOpen())
+	{
+		m_lastError = "Set file is not open for writing.";
+		return false;
+	}
+	if (x < 0 || x >= m_header.cntX || y < 0 || y >= m_header.cntY || z < 0 || z >= m_header.cntZ)
+	{
+		m_lastError = "Invalid render index.";
+		return false;
+	}
+	ResultSetIndexEntry & e = m_index[m_header.renderIndex(x, y, z)];
+	RenderSummary & s = e.summary;
+	s.rotX = rend.rotX;
+	s.rotY = rend.rotY;
+	s.rotZ = rend.rotZ;
+	for (int i = 0; i < 3; ++i)
+		s.pos[i] = rend.pos[i];
+	s.avPenetrLen = rend.avPenetrLen;
+	s.avDipAngle = rend.avDipAngle;
+	s.maxPenetrLen = rend.maxPenetrLen;
+	s.badAreaPercentage = rend.badAreaPercentage;
+	s.raysSize = saveAdditionalData ? rend.raysSize : 0;
+	s.intersectionsSize = saveAdditionalData ? rend.intersectionsSize : 0;
+	e.offset = m_dataEnd;
+	e.storedSize = 0;
+	e.flags = ResultSetRenderPresent;
+	if (s.raysSize == 0 && s.intersectionsSize == 0)
+		return true;
+
+	std::vector<qint32> rx(s.raysSize), ry(s.raysSize);
+	std::vector<float> totalPenetrLen(s.raysSize), avDipAng(s.raysSize);
+	std::vector<quint32> penetrationsSize(s.raysSize);
+	for (quint32 i = 0; i < s.raysSize; ++i)
+	{
+		RayPenetration const * ray = rend.rays[i];
+		rx[i] = ray->m_X;
+		ry[i] = ray->m_Y;
+		totalPenetrLen[i] = ray->totalPenetrLen;
+		avDipAng[i] = ray->avDipAng;
+		penetrationsSize[i] = ray->penetrationsSize;
+	}
+	std::vector<quint32> triIndex(s.intersectionsSize);
+	std::vector<float> dipAngle(s.intersectionsSize);
+	for (quint32 i = 0; i < s.intersectionsSize; ++i)
+	{
+		triIndex[i] = rend.intersections[i]->tri_index;
+		dipAngle[i] = rend.intersections[i]->dip_angle;
+	}
+	QByteArray data;
+	data.reserve((int)(s.raysSize * RayColumnsSize + s.intersectionsSize * IntersectionColumnsSize));
+	appendColumn(data, rx);
+	appendColumn(data, ry);
+	appendColumn(data, totalPenetrLen);
+	appendColumn(data, avDipAng);
+	appendColumn(data, penetrationsSize);
+	appendColumn(data, triIndex);
+	appendColumn(data, dipAngle);
+	if (m_compress)
+	{
+		data = qCompress(data);
+		e.flags |= ResultSetRenderCompressed;
+	}
+	m_file.seek(e.offset);
+	if (m_file.write(data) != data.size())
+	{
+		m_lastError = "Writing render data failed: " + m_file.errorString();
+		e.flags = 0;
+		return false;
+	}
+	e.storedSize = (quint32)data.size();
+	m_dataEnd += data.size();
+	return true;
+}
+
+bool ResultSetWriter::close()
+{
+	if (!m_file.isOpen())
+		return true;
+	bool result = m_file.seek(m_indexOffset) &&
+		(m_index.empty() || m_file.write(reinterpret_cast<const char*>(&m_index[0]), (qint64)(m_index.size() * sizeof(ResultSetIndexEntry))) >= 0);
+	if (!result)
+		m_lastError = "Writing set file index failed: " + m_file.errorString();
+	m_file.close();
+	m_index.clear();
+	return result;
+}
+
+// ResultSetReader
+
+ResultSetReader::ResultSetReader():
+	m_map(0),
+	m_size(0),
+	m_legacy(false)
+{}
+
+ResultSetReader::~ResultSetReader()
+{
+	close();
+}
+
+void ResultSetReader::close()
+{
+	if (m_map)
+	{
+		m_file.unmap(m_map);
+		m_map = 0;
+	}
+	if (m_file.isOpen())
+		m_file.close();
+	m_size = 0;
+	m_legacy = false;
+	m_header = ResultSetHeader();
+	m_index.clear();
+}
+
+bool ResultSetReader::readBytes(qint64 offset, void * dest, qint64 size)
+{
+	if (offset < 0 || size < 0 || offset + size > m_size)
+		return false;
+	if (m_map)
+	{
+		memcpy(dest, m_map + offset, size);
+		return true;
+	}
+	return m_file.seek(offset) && m_file.read(static_cast<char*>(dest), size) == size;
+}
+
+bool ResultSetReader::open(QString const & fileName)
+{
+	close();
+	m_file.setFileName(fileName);
+	if (!m_file.open(QIODevice::ReadOnly))
+	{
+		m_lastError = "Cannot open set file for reading: " + m_file.errorString();
+		return false;
+	}
+	m_size = m_file.size();
+	m_map = m_file.map(0, m_size);	// falls back to reading through m_file if mapping is not possible
+	char magic[4];
+	if (!readBytes(0, magic, sizeof(magic)))
+	{
+		m_lastError = "Set file is too short.";
+		close();
+		return false;
+	}
+	qint64 pos = 0;
+	quint32 flags = 0;
+	m_legacy = memcmp(magic, Magic, sizeof(Magic)) != 0;
+	if (!m_legacy)
+	{
+		quint32 version;
+		if (!readBytes(sizeof(Magic), &version, sizeof(version)) ||
+			!readBytes(sizeof(Magic) + sizeof(version), &flags, sizeof(flags)))
+		{
+			m_lastError = "Set file is too short.";
+			close();
+			return false;
+		}
+		if (version != FormatVersion)
+		{
+			m_lastError = QString("Unsupported set file version %1.").arg(version);
+			close();
+			return false;
+		}
+		pos = sizeof(Magic) + sizeof(version) + sizeof(flags);
+	}
+	if (!readHeader(pos))
+	{
+		close();
+		return false;
+	}
+	if (m_legacy)
+	{
+		if (!buildLegacyIndex(pos))
+		{
+			close();
+			return false;
+		}
+		return true;
+	}
+	m_index.resize(m_header.renderCount());
+	if (!m_index.empty() && !readBytes(pos, &m_index[0], (qint64)(m_index.size() * sizeof(ResultSetIndexEntry))))
+	{
+		m_lastError = "Reading set file index failed.";
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool ResultSetReader::readHeader(qint64 & pos)
+{
+	ResultSetHeader & h = m_header;
+	qint32 cutBoxCount;
+	struct { void * dest; qint64 size; } fields[] = {
+		{ &h.cntX, sizeof(h.cntX) }, { &h.minValX, sizeof(h.minValX) }, { &h.maxValX, sizeof(h.maxValX) },
+		{ &h.cntY, sizeof(h.cntY) },
+		{ &h.cntZ, sizeof(h.cntZ) }, { &h.minValZ, sizeof(h.minValZ) }, { &h.maxValZ, sizeof(h.maxValZ) },
+		{ &cutBoxCount, sizeof(cutBoxCount) }
+	};
+	for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); ++i)
+	{
+		if (!readBytes(pos, fields[i].dest, fields[i].size))
+		{
+			m_lastError = "Reading file failed - expected number of bytes read does not match actual number of bytes read.";
+			return false;
+		}
+		pos += fields[i].size;
+	}
+	if (h.cntX < 0 || h.cntY < 0 || h.cntZ < 0 || cutBoxCount < 0 ||
+		(qint64)h.cntX * h.cntY * h.cntZ * (qint64)sizeof(float) > m_size)
+	{
+		m_lastError = "Invalid set file header.";
+		return false;
+	}
+	h.cutBoxes.resize(cutBoxCount);
+	if (cutBoxCount > 0 && !readBytes(pos, &h.cutBoxes[0], cutBoxCount * (qint64)sizeof(ResultSetHeader::CutBox)))
+	{
+		m_lastError = "Reading file failed - expected number of bytes read does not match actual number of bytes read.";
+		return false;
+	}
+	pos += cutBoxCount * (qint64)sizeof(ResultSetHeader::CutBox);
+	return true;
+}
+
+bool ResultSetReader::buildLegacyIndex(qint64 pos)
+{
+	// the old format has no index; walk once over the render headers, skipping the ray and intersection records
+	m_index.resize(m_header.renderCount());
+	for (size_t i = 0; i < m_index.size(); ++i)
+	{
+		ResultSetIndexEntry & e = m_index[i];
+		memset(&e, 0, sizeof(e));
+		if (pos == m_size)	// computation of the set was stopped
+			continue;
+		if (!readBytes(pos, &e.summary, LegacyRenderHeaderSize))
+		{
+			m_lastError = "Reading file failed - expected number of bytes read does not match actual number of bytes read.";
+			return false;
+		}
+		pos += LegacyRenderHeaderSize;
+		e.offset = pos;
+		pos += e.summary.raysSize * LegacyRaySize;
+		if (!readBytes(pos, &e.summary.intersectionsSize, sizeof(e.summary.intersectionsSize)))
+		{
+			m_lastError = "Reading file failed - expected number of bytes read does not match actual number of bytes read.";
+			return false;
+		}
+		pos += sizeof(e.summary.intersectionsSize) + e.summary.intersectionsSize * LegacyIntersectionSize;
+		e.storedSize = (quint32)(pos - e.offset);
+		e.flags = ResultSetRenderPresent;
+	}
+	return true;
+}
+
+ResultSetIndexEntry const * ResultSetReader::entry(int x, int y, int z) const
+{
+	if (x < 0 || x >= m_header.cntX || y < 0 || y >= m_header.cntY || z < 0 || z >= m_header.cntZ)
+		return 0;
+	ResultSetIndexEntry const & e = m_index[m_header.renderIndex(x, y, z)];
+	return (e.flags & ResultSetRenderPresent) ? &e : 0;
+}
+
+bool ResultSetReader::summary(int x, int y, int z, RenderSummary & result) const
+{
+	ResultSetIndexEntry const * e = entry(x, y, z);
+	if (!e)
+		return false;
+	result = e->summary;
+	return true;
+}
+
+bool ResultSetReader::readRender(int x, int y, int z, RenderFromPosition * rend)
+{
+	ResultSetIndexEntry const * e = entry(x, y, z);
+	if (!e)
+	{
+		m_lastError = "Error! Set reading. Invalid index.";
+		return false;
+	}
+	RenderSummary const & s = e->summary;
+	rend->rotX = s.rotX;
+	rend->rotY = s.rotY;
+	rend->rotZ = s.rotZ;
+	for (int i = 0; i < 3; ++i)
+		rend->pos[i] = s.pos[i];
+	rend->avPenetrLen = s.avPenetrLen;
+	rend->avDipAngle = s.avDipAngle;
+	rend->maxPenetrLen = s.maxPenetrLen;
+	rend->badAreaPercentage = s.badAreaPercentage;
+	rend->raysSize = s.raysSize;
+	rend->intersectionsSize = s.intersectionsSize;
+	if (e->storedSize == 0)
+		return true;
+
+	QByteArray buffer;
+	const uchar * data = 0;
+	if (m_map && e->offset + e->storedSize <= (quint64)m_size)
+		data = m_map + e->offset;
+	else
+	{
+		buffer.resize(e->storedSize);
+		if (!readBytes(e->offset, buffer.data(), e->storedSize))
+		{
+			m_lastError = "Reading file failed - expected number of bytes read does not match actual number of bytes read.";
+			return false;
+		}
+		data = reinterpret_cast<const uchar*>(buffer.constData());
+	}
+	qint64 expectedSize = m_legacy ?
+		s.raysSize * LegacyRaySize + sizeof(quint32) + s.intersectionsSize * LegacyIntersectionSize :
+		s.raysSize * RayColumnsSize + s.intersectionsSize * IntersectionColumnsSize;
+	if (e->flags & ResultSetRenderCompressed)
+	{
+		buffer = qUncompress(data, (int)e->storedSize);
+		data = reinterpret_cast<const uchar*>(buffer.constData());
+		if (buffer.size() != expectedSize)
+		{
+			m_lastError = "Decompressing render data failed.";
+			return false;
+		}
+	}
+	else if (e->storedSize != expectedSize)
+	{
+		m_lastError = "Invalid render data size.";
+		return false;
+	}
+	// rays are allocated as one block, owned by rawPtrRaysVec as for computed renderings
+	RayPenetration * rays = s.raysSize ? new RayPenetration[s.raysSize] : 0;
+	if (rays)
+		rend->rawPtrRaysVec.push_back(rays);
+	rend->intersections.reserve(rend->intersections.size() + s.intersectionsSize);
+	if (m_legacy)
+	{	// interleaved records: rays, intersection count, intersections
+		for (quint32 i = 0; i < s.raysSize; ++i)
+		{
+			data = readColumn(data, &rays[i].m_X, 1);
+			data = readColumn(data, &rays[i].m_Y, 1);
+			data = readColumn(data, &rays[i].totalPenetrLen, 1);
+			data = readColumn(data, &rays[i].avDipAng, 1);
+			data = readColumn(data, &rays[i].penetrationsSize, 1);
+			rend->rays.push_back(&rays[i]);
+		}
+		data += sizeof(quint32);
+		for (quint32 i = 0; i < s.intersectionsSize; ++i)
+		{
+			quint32 triIndex;
+			float dipAngle;
+			data = readColumn(data, &triIndex, 1);
+			data = readColumn(data, &dipAngle, 1);
+			rend->intersections.push_back(new Intersection(triIndex, dipAngle));
+		}
+		return true;
+	}
+	const uchar * rx = data;
+	const uchar * ry = rx + s.raysSize * sizeof(qint32);
+	const uchar * totalPenetrLen = ry + s.raysSize * sizeof(qint32);
+	const uchar * avDipAng = totalPenetrLen + s.raysSize * sizeof(float);
+	const uchar * penetrationsSize = avDipAng + s.raysSize * sizeof(float);
+	const uchar * triIndex = penetrationsSize + s.raysSize * sizeof(quint32);
+	const uchar * dipAngle = triIndex + s.intersectionsSize * sizeof(quint32);
+	for (quint32 i = 0; i < s.raysSize; ++i)
+	{
+		rx = readColumn(rx, &rays[i].m_X, 1);
+		ry = readColumn(ry, &rays[i].m_Y, 1);
+		totalPenetrLen = readColumn(totalPenetrLen, &rays[i].totalPenetrLen, 1);
+		avDipAng = readColumn(avDipAng, &rays[i].avDipAng, 1);
+		penetrationsSize = readColumn(penetrationsSize, &rays[i].penetrationsSize, 1);
+		rend->rays.push_back(&rays[i]);
+	}
+	for (quint32 i = 0; i < s.intersectionsSize; ++i)
+	{
+		quint32 tri;
+		float dip;
+		triIndex = readColumn(triIndex, &tri, 1);
+		dipAngle = readColumn(dipAngle, &dip, 1);
+		rend->intersections.push_back(new Intersection(tri, dip));
+	}
+	return true;
+}
@@ -66,6 +66,8 @@ inline float Rand( float a_Range ) { return ((float)rand() / RAND_MAX) * a_Range
 		s->COL_RANGE_MAX_G = settings.value( "COL_RANGE_MAX_G", s->COL_RANGE_MAX_G ).toInt();
 		s->COL_RANGE_MAX_B = settings.value( "COL_RANGE_MAX_B", s->COL_RANGE_MAX_B ).toInt();
 		s->USE_SAH = settings.value( "USE_SAH", s->USE_SAH ).toInt();
+		s->USE_BVH = settings.value( "USE_BVH", s->USE_BVH ).toInt();
+		s->COMPRESS_RESULTS = settings.value( "COMPRESS_RESULTS", s->COMPRESS_RESULTS ).toInt();
 		s->BATCH_SIZE = settings.value( "BATCH_SIZE", s->BATCH_SIZE ).toInt();
 		
 		s->COL_RANGE_DR = s->COL_RANGE_MAX_R - s->COL_RANGE_MIN_R;
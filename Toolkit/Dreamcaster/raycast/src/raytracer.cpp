@@ -22,6 +22,7 @@
 #include "../include/scene.h"
 #include "../include/common.h"
 #include "../include/BSPTree.h"
+#include "../include/BVH.h"
 #include <algorithm>
 #include <vector>
 #include <QFile>
@@ -111,69 +112,56 @@ void Engine::SetTarget( unsigned int* a_Dest)
 // Naive ray tracing: Intersects the ray with every primitive
 // in the scene to determine the closest intersection
 // -----------------------------------------------------------
-bool intersectionCompare( intersection *e1, intersection *e2 )
+bool intersectionCompare( intersection const & e1, intersection const & e2 )
 {
-	return e1->dist < e2->dist;
+	return e1.dist < e2.dist;
 }
 
-int Engine::DepthRaytrace( Ray& a_Ray, iAVec3& a_Acc, int a_Depth, float a_RIndex, float& a_Dist, RayPenetration * ray_p, std::vector<Intersection*> &vecIntersections, traverse_stack * stack, bool dipAsColor )
+bool sameTriangle( intersection const & e1, intersection const & e2 )
+{
+	return e1.tri->GetIndex() == e2.tri->GetIndex();
+}
+
+bool Engine::IntersectsCutAABBs( Ray & a_Ray ) const
+{
+	if(!m_cutAABBList || !m_cutAABBListSize)
+		return true;
+	for (unsigned int i=0; i<m_cutAABBListSize; i++)
+	{
+		float a,b;
+		//if(IntersectCyl(a_Ray, *((*m_cutAABBList)[i]), a, b, 1)) 
+		if(IntersectAABB(a_Ray, *((*m_cutAABBList)[i]), a, b)) 
+			return true;
+	}
+	return false;
+}
+
+int Engine::DepthRaytrace( Ray& a_Ray, iAVec3& a_Acc, int a_Depth, float a_RIndex, float& a_Dist, RayPenetration * ray_p, std::vector<Intersection*> &vecIntersections, traverse_stack * stack, std::vector<intersection> & hits, bool dipAsColor )
 {
 	if (a_Depth > s->TRACEDEPTH) return 0;
 	// trace primary ray
 	a_Dist = 1000000.0f;
-	iAVec3 pi;
-	std::vector<intersection*> intersections;
 	// find intersections
-	unsigned int cutAABBListSize;
-	if(m_cutAABBList)
-		cutAABBListSize = m_cutAABBListSize;
-	else 
-		cutAABBListSize = 0;
-	if(cutAABBListSize)
-	{
-		bool intersects = false;
-		for (unsigned int i=0; i<cutAABBListSize; i++)
-		{
-			float a,b;
-			//if(IntersectCyl(a_Ray, *((*m_cutAABBList)[i]), a, b, 1)) 
-			if(IntersectAABB(a_Ray, *((*m_cutAABBList)[i]), a, b)) 
-			{
-				intersects = true;
-				break;
-			}
-		}
-		if(!intersects)
-			return 0;
-	}
-	m_Scene->getBSPTree()->GetIntersectionsNR(a_Ray, intersections,stack);
-	if(intersections.size()==0)
+	if(!IntersectsCutAABBs(a_Ray))
+		return 0;
+	hits.clear();
+	m_Scene->getBSPTree()->GetIntersectionsNR(a_Ray, hits, stack);
+	return ProcessIntersections(a_Ray, a_Acc, ray_p, vecIntersections, hits, dipAsColor);
+}
+
+int Engine::ProcessIntersections( Ray & a_Ray, iAVec3& a_Acc, RayPenetration * ray_p, std::vector<Intersection*> &vecIntersections, std::vector<intersection> & hits, bool dipAsColor )
+{
+	if(hits.size()==0)
 		return 0;
-	std::sort(intersections.begin(), intersections.end(), intersectionCompare);
+	std::sort(hits.begin(), hits.end(), intersectionCompare);
 	//delete coincident intersections
 	//it happens when ray hits common edge of 2 neighboring triangles
+	//or a triangle is referenced by several kd-tree leaves
+	hits.erase(std::unique(hits.begin(), hits.end(), sameTriangle), hits.end());
 	ray_p->penetrationsSize=0;
 	ray_p->avDipAng=0;
-	for (int i=0; i<(int)intersections.size()-1; ) 
-	{
-		/*if( intersections[i+1]->dist == intersections[i]->dist )
-		{
-			delete intersections[i]; // Remove the object
-			intersections[i]=0;
-			intersections.erase(intersections.begin() + i);
-		} 
-		else */
-		//TODO: no triangles repeated?
-		if( intersections[i+1]->tri->GetIndex() == intersections[i]->tri->GetIndex() )
-		{
-			delete intersections[i]; // Remove the object
-			intersections[i]=0;
-			intersections.erase(intersections.begin() + i);
-		} 
-		else 
-			++i;
-	}
 	//
-	unsigned int intetsectSize = (unsigned int) intersections.size();
+	unsigned int intetsectSize = (unsigned int) hits.size();
 	float penetrationDepth = 0;
 	//Sometimes it happens, yet lets have this workaround
 	if(intetsectSize%2 == 0)//TODO: temporary workaround
@@ -181,23 +169,21 @@ int Engine::DepthRaytrace( Ray& a_Ray, iAVec3& a_Acc, int a_Depth, float a_RInde
 	{
 		if(i%2==1)
 		{
-			float dist = intersections[i]->dist - intersections[i-1]->dist;
+			float dist = hits[i].dist - hits[i-1].dist;
 			penetrationDepth += dist; 
 			//ray_p->penetrations[ray_p->penetrationsSize] = dist;
 			ray_p->penetrationsSize++;
 			ray_p->totalPenetrLen += dist;
 		}
 		//add intersection in intersections vector
-		TriPrim* tri = intersections[i]->tri;
+		TriPrim* tri = hits[i].tri;
 		Intersection *isec = new Intersection(tri->GetIndex(), tri->GetAngleCos(a_Ray));
 		vecIntersections.push_back(isec);
 		ray_p->avDipAng+=fabs(isec->dip_angle);
 	}
-	ray_p->avDipAng/=intersections.size();
+	ray_p->avDipAng/=hits.size();
 
 	//rayPenetr->totalPenetrLen/=(rayPenetr->penetrations.size());
-	for (unsigned int i=0; i<intersections.size(); i++)
-		delete intersections[i];
 	float coef = penetrationDepth*s->COLORING_COEF;
 	if(dipAsColor)
 	{
@@ -796,12 +782,73 @@ void Engine::raycast_single(
 //////////////////////////////////////////////////////////////////////////
 //RaycastingThread implementation
 //////////////////////////////////////////////////////////////////////////
+void RaycastingThread::writePixel(int x, int y, iAVec3 const & acc)
+{
+	int red = (int)(acc[0] * 255);
+	int green = (int)(acc[1] * 255);
+	int blue = (int)(acc[2] * 255);
+	if (red > 255) red = 255;
+	if (green > 255) green = 255;
+	if (blue > 255) blue = 255;
+
+	//e->destMutex.lock();
+	//invert by y axis
+	e->m_Dest[y*e->m_Width+(e->m_Width-x-1)] = (red << 16) + (green << 8) + blue;
+	//e->destMutex.unlock();
+}
+
 void RaycastingThread::run()
 {
-	traverse_stack * tr_stack = new traverse_stack(e->GetScene()->getBSPTree()->splitLevel+1);
 	rayCount = (x2-x1)*(y2-y1);
 	delete [] rays;
 	rays = new RayPenetration[rayCount];
+	// intersection buffers are reused for all rays of this thread
+	for (int i=0; i<BVH::MAX_PACKET_SIZE; i++)
+	{
+		m_hits[i].clear();
+		m_hits[i].reserve(INTERSECTION_BUFFER_CAPACITY);
+	}
+	const BVH * bvh = e->GetScene()->getBVH();
+	if(bvh)
+	{
+		// trace packets of PACKET_DIM x PACKET_DIM neighbouring pixels together
+		Ray packet[BVH::MAX_PACKET_SIZE];
+		int px[BVH::MAX_PACKET_SIZE], py[BVH::MAX_PACKET_SIZE];
+		for(int x0=x1; x0<x2; x0+=BVH::PACKET_DIM)
+			for(int y0=y1; y0<y2; y0+=BVH::PACKET_DIM)
+			{
+				int count = 0;
+				unsigned int activeMask = 0;
+				int xEnd = std::min(x0+BVH::PACKET_DIM, x2);
+				int yEnd = std::min(y0+BVH::PACKET_DIM, y2);
+				for(int x=x0; x<xEnd; x++)
+					for(int y=y0; y<yEnd; y++)
+					{
+						iAVec3 dir = (m_vp_corners[0] + x*m_vp_delta[0] + y*m_vp_delta[1]) - (*m_o);
+						normalize( dir );
+						packet[count] = Ray( m_o, dir );
+						px[count] = x;
+						py[count] = y;
+						m_hits[count].clear();
+						if(e->IntersectsCutAABBs(packet[count]))
+							activeMask |= 1u << count;
+						count++;
+					}
+				bvh->IntersectPacket(packet, count, activeMask, m_hits);
+				for (int i=0; i<count; i++)
+				{
+					unsigned int rayInd = (px[i]-x1)*(y2-y1) + (py[i]-y1);
+					rays[rayInd].m_X=px[i];
+					rays[rayInd].m_Y=py[i];
+					rays[rayInd].totalPenetrLen=0.0f;
+					iAVec3 acc( 0, 0, 0 );
+					e->ProcessIntersections( packet[i], acc, &rays[rayInd], intersections, m_hits[i], dipAsColor );
+					writePixel(px[i], py[i], acc);
+				}
+			}
+		return;
+	}
+	traverse_stack * tr_stack = new traverse_stack(e->GetScene()->getBSPTree()->splitLevel+1);
 	unsigned int rayInd=0;
 	for(int x=x1; x<x2; x++)
 		for(int y=y1; y<y2; y++)
@@ -815,18 +862,8 @@ void RaycastingThread::run()
 			normalize( dir );
 			Ray r( m_o, dir );
 			float dist;
-			e->DepthRaytrace( r, acc, 1, 1.0f, dist, &rays[rayInd], intersections, tr_stack, dipAsColor );
-			int red = (int)(acc[0] * 255);
-			int green = (int)(acc[1] * 255);
-			int blue = (int)(acc[2] * 255);
-			if (red > 255) red = 255;
-			if (green > 255) green = 255;
-			if (blue > 255) blue = 255;
-
-			//e->destMutex.lock();
-			//invert by y axis
-			e->m_Dest[y*e->m_Width+(e->m_Width-x-1)] = (red << 16) + (green << 8) + blue;
-			//e->destMutex.unlock();
+			e->DepthRaytrace( r, acc, 1, 1.0f, dist, &rays[rayInd], intersections, tr_stack, m_hits[0], dipAsColor );
+			writePixel(x, y, acc);
 			rayInd++;
 		}
 	if(tr_stack)
@@ -23,6 +23,7 @@
 #include "../include/scene.h"
 #include "../include/raytracer.h"
 #include "../include/BSPTree.h"
+#include "../include/BVH.h"
 
 #include <vector>
 #include "../include/STLLoader.h"
@@ -227,6 +228,8 @@ Scene::~Scene()
 	}
 	if(m_bsp)
 		delete m_bsp;
+	if(m_bvh)
+		delete m_bvh;
 }
 
 int Scene::initScene(ModelData & mdata, SETTINGS * s, const char * filename)
@@ -238,6 +241,14 @@ int Scene::initScene(ModelData & mdata, SETTINGS * s, const char * filename)
 		pr = new TriPrim(mdata.stlMesh[i], i);
 		m_tris.push_back(pr);
 	}/**/
+	if(s->USE_BVH)
+	{
+		dcast->log("Building BVH...............");
+		delete m_bvh;
+		m_bvh = new BVH;
+		m_bvh->Build(m_tris);
+		dcast->log("done ("+QString::number(m_bvh->GetNodeCount())+" nodes)",true);
+	}
 	m_bsp = new BSPTree;
 	if(filename==0)
 	{
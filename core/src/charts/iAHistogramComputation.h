@@ -0,0 +1,248 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#pragma once
+
+#include "iAImageInfo.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+//! Histogram of a value array, together with its basic statistics.
+struct iAHistogramResult
+{
+	std::vector<double> bins;  //!< the frequency of each bin
+	double minBound, maxBound; //!< the value range covered by the bins
+	iAImageInfo info;          //!< voxel count, min, max, mean and standard deviation
+};
+
+namespace iAHistogramDetail
+{
+	//! the width of a single bin; slightly enlarged to put the maximum value into the last bin
+	inline double BinWidth(double min, double max, size_t binCount)
+	{
+		const double RangeEnlargeFactor = 1 + 1e-10;
+		return (max - min) * RangeEnlargeFactor / binCount;
+	}
+
+	//! the bin of a (finite) value; values outside of the range are put into the first / last bin
+	inline size_t BinIndex(double value, double min, double binWidth, size_t binCount)
+	{
+		if (binWidth <= 0)
+			return 0;
+		double index = std::min(std::max((value - min) / binWidth, 0.0), static_cast<double>(binCount - 1));
+		return static_cast<size_t>(index);
+	}
+
+	inline size_t AdaptBinCount(size_t binCount, double min, double max, bool isInteger)
+	{
+		binCount = std::max(binCount, static_cast<size_t>(1));
+		return isInteger ? std::min(binCount, static_cast<size_t>(max - min + 1)) : binCount;
+	}
+
+	inline iAImageInfo Statistics(size_t count, double min, double max, double sum, double sumSq)
+	{
+		if (count == 0)
+			return iAImageInfo();
+		double mean = sum / count;
+		double variance = (count > 1) ? std::max(0.0, (sumSq - sum * mean) / (count - 1)) : 0.0;
+		return iAImageInfo(count, min, max, mean, std::sqrt(variance));
+	}
+
+	//! for 8 and 16 bit integer types: count every possible value in one pass,
+	//! then derive range, statistics and histogram from these counts
+	template <typename T>
+	void Compute(T const * data, size_t count, size_t stride, size_t binCount, iAHistogramResult & result, std::true_type)
+	{
+		const size_t ValueCount = static_cast<size_t>(std::numeric_limits<T>::max()) - std::numeric_limits<T>::min() + 1;
+		const long long Offset = std::numeric_limits<T>::min();
+		std::vector<unsigned long long> counts(ValueCount, 0);
+		const long long n = static_cast<long long>(count);
+#pragma omp parallel
+		{
+			std::vector<unsigned long long> localCounts(ValueCount, 0);
+#pragma omp for
+			for (long long i = 0; i < n; ++i)
+				++localCounts[static_cast<size_t>(data[i * stride] - Offset)];
+#pragma omp critical
+			for (size_t v = 0; v < ValueCount; ++v)
+				counts[v] += localCounts[v];
+		}
+		size_t first = 0, last = ValueCount - 1;
+		while (first < ValueCount && counts[first] == 0)
+			++first;
+		if (first == ValueCount)
+		{
+			result.bins.assign(1, 0);
+			result.minBound = result.maxBound = 0;
+			result.info = iAImageInfo();
+			return;
+		}
+		while (counts[last] == 0)
+			--last;
+		double min = static_cast<double>(static_cast<long long>(first) + Offset);
+		double max = static_cast<double>(static_cast<long long>(last) + Offset);
+		binCount = AdaptBinCount(binCount, min, max, true);
+		double binWidth = BinWidth(min, max, binCount);
+		result.bins.assign(binCount, 0);
+		double sum = 0, sumSq = 0;
+		for (size_t v = first; v <= last; ++v)
+		{
+			if (counts[v] == 0)
+				continue;
+			double value = static_cast<double>(static_cast<long long>(v) + Offset);
+			double c = static_cast<double>(counts[v]);
+			sum += c * value;
+			sumSq += c * value * value;
+			result.bins[BinIndex(value, min, binWidth, binCount)] += c;
+		}
+		result.minBound = min;
+		result.maxBound = max;
+		result.info = Statistics(count, min, max, sum, sumSq);
+	}
+
+	//! for all other types: one pass for range and statistics, one for the histogram
+	template <typename T>
+	void Compute(T const * data, size_t count, size_t stride, size_t binCount, iAHistogramResult & result, std::false_type)
+	{
+		const long long n = static_cast<long long>(count);
+		double min = std::numeric_limits<double>::max(), max = std::numeric_limits<double>::lowest();
+		double sum = 0, sumSq = 0;
+		size_t finiteCount = 0;
+#pragma omp parallel
+		{
+			double localMin = std::numeric_limits<double>::max(), localMax = std::numeric_limits<double>::lowest();
+			double localSum = 0, localSumSq = 0;
+			size_t localCount = 0;
+#pragma omp for
+			for (long long i = 0; i < n; ++i)
+			{
+				double value = static_cast<double>(data[i * stride]);
+				if (!std::isfinite(value))	// NaN and infinite values are not considered
+					continue;
+				localMin = std::min(localMin, value);
+				localMax = std::max(localMax, value);
+				localSum += value;
+				localSumSq += value * value;
+				++localCount;
+			}
+#pragma omp critical
+			{
+				min = std::min(min, localMin);
+				max = std::max(max, localMax);
+				sum += localSum;
+				sumSq += localSumSq;
+				finiteCount += localCount;
+			}
+		}
+		if (finiteCount == 0)
+		{
+			result.bins.assign(1, 0);
+			result.minBound = result.maxBound = 0;
+			result.info = iAImageInfo();
+			return;
+		}
+		binCount = AdaptBinCount(binCount, min, max, std::is_integral<T>::value);
+		double binWidth = BinWidth(min, max, binCount);
+		result.bins.assign(binCount, 0);
+#pragma omp parallel
+		{
+			std::vector<double> localBins(binCount, 0);
+#pragma omp for
+			for (long long i = 0; i < n; ++i)
+			{
+				double value = static_cast<double>(data[i * stride]);
+				if (std::isfinite(value))
+					++localBins[BinIndex(value, min, binWidth, binCount)];
+			}
+#pragma omp critical
+			for (size_t b = 0; b < binCount; ++b)
+				result.bins[b] += localBins[b];
+		}
+		result.minBound = min;
+		result.maxBound = max;
+		result.info = Statistics(finiteCount, min, max, sum, sumSq);
+	}
+}
+
+//! Computes histogram, value range, mean and standard deviation of an array in parallel,
+//! with one histogram per thread which are merged at the end.
+//! For 8 and 16 bit integer types this requires a single pass over the data, for all other types two.
+//! The bins span the range from minimum to maximum value (the maximum is put in the last bin).
+//! For integer types, the bin count is reduced to the number of values in that range if it is larger.
+//! Non-finite values (NaN, infinity) are skipped; they are neither in the histogram nor in the statistics.
+//! @param data pointer to the first value
+//! @param count the number of values to consider
+//! @param stride the distance between two consecutive values (e.g. the number of components
+//!     to consider only the first component of a multi-component image)
+//! @param binCount the (maximum) number of bins
+//! @param result receives histogram and statistics
+template <typename T>
+void ComputeHistogram(T const * data, size_t count, size_t stride, size_t binCount, iAHistogramResult & result)
+{
+	iAHistogramDetail::Compute(data, count, stride, binCount, result,
+		std::integral_constant<bool, std::is_integral<T>::value && sizeof(T) <= 2>());
+}
+
+//! Adds the values of an array to given bins evenly dividing the range starting at min.
+//! Values outside of that range are put into the first or last bin, non-finite values are skipped.
+//! Runs on the calling thread only, so that many arrays can be processed in parallel.
+//! The bin indices are computed block-wise without branches, so that the compiler can vectorize that loop.
+//! @param data pointer to the first value
+//! @param count the number of values to consider
+//! @param stride the distance between two consecutive values
+//! @param min the start of the first bin
+//! @param binWidth the width of a bin; if it is not positive, all values are put into the first bin
+//! @param binCount the number of bins
+//! @param bins the bins to add to (binCount values)
+//! @param leftOpenBins whether a value on the border of two bins is put into the lower bin, i.e. bins
+//!     are (a, b] (the first bin also contains min), instead of [a, b)
+template <typename T, typename BinT>
+void AddToHistogram(T const * data, size_t count, size_t stride, double min, double binWidth, size_t binCount,
+	BinT * bins, bool leftOpenBins = false)
+{
+	if (binCount == 0)
+		return;
+	const size_t BlockSize = 1024;
+	size_t binIdx[BlockSize];
+	BinT valid[BlockSize];
+	const double width = (binWidth > 0) ? binWidth : std::numeric_limits<double>::infinity();
+	const double maxIdx = static_cast<double>(binCount - 1);
+	for (size_t blockStart = 0; blockStart < count; blockStart += BlockSize)
+	{
+		const size_t blockSize = std::min(BlockSize, count - blockStart);
+		T const * block = data + blockStart * stride;
+		for (size_t i = 0; i < blockSize; ++i)
+		{
+			double value = static_cast<double>(block[i * stride]);
+			bool finite = (value - value) == 0;	// false for NaN and infinity
+			double bin = (value - min) / width;
+			bin = leftOpenBins ? std::ceil(bin) - 1 : bin;
+			bin = finite ? std::min(std::max(bin, 0.0), maxIdx) : 0.0;
+			binIdx[i] = static_cast<size_t>(bin);
+			valid[i] = finite ? 1 : 0;
+		}
+		for (size_t i = 0; i < blockSize; ++i)
+			bins[binIdx[i]] += valid[i];
+	}
+}
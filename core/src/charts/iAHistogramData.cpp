@@ -21,12 +21,11 @@
 #include "pch.h"
 #include "iAHistogramData.h"
 
+#include "iAHistogramComputation.h"
 #include "iAImageInfo.h"
-#include "iAVtkDataTypeMapper.h"
 #include "iAToolsVTK.h"
+#include "iATypedCallHelper.h"
 
-#include <vtkImageAccumulate.h>
-#include <vtkImageCast.h>
 #include <vtkImageData.h>
 
 
@@ -58,54 +57,44 @@ iAHistogramData::DataType const * iAHistogramData::GetRawData() const
 }
 
 
+namespace
+{
+	template <typename T>
+	void ComputeImageHistogram(vtkImageData* img, size_t binCount, iAHistogramResult & result)
+	{
+		ComputeHistogram(static_cast<T const *>(img->GetScalarPointer()),
+			static_cast<size_t>(img->GetNumberOfPoints()),
+			static_cast<size_t>(img->GetNumberOfScalarComponents()),
+			binCount, result);
+	}
+}
+
 QSharedPointer<iAHistogramData> iAHistogramData::Create(vtkImageData* img, size_t binCount,
 	iAImageInfo* info)
 {
 	auto result = QSharedPointer<iAHistogramData>(new iAHistogramData);
-	auto accumulate = vtkSmartPointer<vtkImageAccumulate>::New();
-	accumulate->ReleaseDataFlagOn();
-	accumulate->SetInputData(img);
-	accumulate->SetComponentOrigin(img->GetScalarRange()[0], 0.0, 0.0);
-	double * const scalarRange = img->GetScalarRange();
-	if (isVtkIntegerType(static_cast<vtkImageData*>(accumulate->GetInput())->GetScalarType()))
-		binCount = std::min(binCount, static_cast<size_t>(scalarRange[1] - scalarRange[0] + 1));
-
-	accumulate->SetComponentExtent(0, binCount - 1, 0, 0, 0, 0);
-	const double RangeEnlargeFactor = 1 + 1e-10;  // to put max values in max bin (as vtkImageAccumulate otherwise would cut off with < max)
-	accumulate->SetComponentSpacing(((scalarRange[1] - scalarRange[0]) * RangeEnlargeFactor) / binCount, 0.0, 0.0);
-	accumulate->Update();
-
-	int extent[6];
-	accumulate->GetComponentExtent(extent);
-	vtkSmartPointer<vtkImageCast> caster = vtkSmartPointer<vtkImageCast>::New();
-	caster->SetInputData(accumulate->GetOutput());
-	caster->SetOutputScalarType(VtkDataType<DataType>::value);
-	caster->Update();
-	auto rawImg = caster->GetOutput();
-
-	result->m_binCount = extent[1] + 1;
-	result->xBounds[0] = accumulate->GetMin()[0];
-	result->xBounds[1] = accumulate->GetMax()[0];
+	iAHistogramResult histogram;
+	VTK_TYPED_CALL(ComputeImageHistogram, img->GetScalarType(), img, binCount, histogram);
+
+	result->m_binCount = histogram.bins.size();
+	result->xBounds[0] = histogram.minBound;
+	result->xBounds[1] = histogram.maxBound;
 	result->rawData = new double[result->m_binCount];
-	auto vtkRawData = static_cast<DataType*>(rawImg->GetScalarPointer());
-	std::copy(vtkRawData, vtkRawData + result->m_binCount, result->rawData);
-	double null1, null2;
-	if (isVtkIntegerType(static_cast<vtkImageData*>(accumulate->GetInput())->GetScalarType()))
+	std::copy(histogram.bins.begin(), histogram.bins.end(), result->rawData);
+	if (isVtkIntegerType(img->GetScalarType()))
 	{	// for int types, the last value is inclusive:
 		result->accSpacing = (result->xBounds[1] - result->xBounds[0] + 1) / result->m_binCount;
 	}
 	else
 	{
-		accumulate->GetComponentSpacing(result->accSpacing, null1, null2);
+		result->accSpacing = iAHistogramDetail::BinWidth(result->xBounds[0], result->xBounds[1], result->m_binCount);
 	}
 	result->SetMaxFreq();
-	result->m_type = (img && (img->GetScalarType() != VTK_FLOAT) && (img->GetScalarType() != VTK_DOUBLE))
+	result->m_type = ((img->GetScalarType() != VTK_FLOAT) && (img->GetScalarType() != VTK_DOUBLE))
 		? Discrete
 		: Continuous;
 	if (info)
-		*info = iAImageInfo(accumulate->GetVoxelCount(),
-			*accumulate->GetMin(), *accumulate->GetMax(),
-			*accumulate->GetMean(), *accumulate->GetStandardDeviation());
+		*info = histogram.info;
 
 	return result;
 }
@@ -99,7 +99,8 @@ void iAQSplom::initializeGL()
 
 iAQSplom::~iAQSplom()
 {
-	delete m_maximizedPlot;
+	// delete the plots while this widget (and its GL context, which their textures belong to) still exists:
+	clear();
 	delete m_animationIn;
 	delete m_animationOut;
 }
@@ -107,6 +108,17 @@ iAQSplom::~iAQSplom()
 void iAQSplom::setData( const QTableWidget * data )
 {
 	m_splomData->import( data );
+	dataChanged();
+}
+
+void iAQSplom::setData( QSharedPointer<iASPLOMData> data )
+{
+	m_splomData = data;
+	dataChanged();
+}
+
+void iAQSplom::dataChanged()
+{
 	clear();
 	unsigned long numParams = m_splomData->numParams();
 	for( unsigned long y = 0; y < numParams; ++y )
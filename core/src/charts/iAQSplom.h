@@ -67,6 +67,8 @@ public:
 
 	//! Import data into SPLOM from QTableWidget. It is assumed that the first row contains parameter names and each column corresponds to one parameter.
 	virtual void setData( const QTableWidget * data ); 
+	//! Show the given data in the SPLOM; the data is used directly, without copying.
+	void setData( QSharedPointer<iASPLOMData> data );
 	void setLookupTable( vtkLookupTable * lut, const QString & colorArrayName );	//!< Set lookup table from VTK (vtkLookupTable) given the name of a parameter to color-code.
 	void setLookupTable( iALookupTable &lut, const QString & colorArrayName );	//!< Set lookup table given the name of a parameter to color-code.
 	void applyLookupTable();												//!< Apply lookup table to all the scatter plots.
@@ -87,6 +89,7 @@ public:
 
 protected:
 	void clear();												//!< Clear all scatter plots in the SPLOM.
+	void dataChanged();											//!< Re-create all scatter plots for the current data.
 	virtual void initializeGL();								//!< Re-implements QGLWidget.
 	virtual void paintEvent( QPaintEvent * event );				//!< Draws SPLOM. Re-implements QGLWidget.
 	virtual bool drawPopup( QPainter& painter );				//!< Draws popup on the splom
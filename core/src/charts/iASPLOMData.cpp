@@ -0,0 +1,124 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#include "pch.h"
+#include "iASPLOMData.h"
+
+#include "iAConsole.h"
+
+#include <QDir>
+#include <QTableWidget>
+#include <QTemporaryFile>
+
+#include <algorithm>
+
+iASPLOMData::iASPLOMData():
+	m_numPoints( 0 ),
+	m_values( nullptr )
+{}
+
+iASPLOMData::iASPLOMData( const QTableWidget * tw ):
+	m_numPoints( 0 ),
+	m_values( nullptr )
+{
+	import( tw );
+}
+
+iASPLOMData::~iASPLOMData()
+{
+	clear();
+}
+
+void iASPLOMData::clear()
+{
+	m_paramNames.clear();
+	m_numPoints = 0;
+	m_values = nullptr;
+	std::vector<double>().swap( m_memory );
+	if( m_backingFile )
+	{
+		m_backingFile->close();	// also unmaps the file
+		m_backingFile.reset();
+	}
+}
+
+bool iASPLOMData::allocate( const QList<QString> & paramNames, size_t numPoints, const QString & backingFileName )
+{
+	clear();
+	size_t valueCount = static_cast<size_t>( paramNames.size() ) * numPoints;
+	bool useTempFile = backingFileName.isEmpty() && valueCount * sizeof( double ) > MaxInMemoryBytes;
+	uchar * mapped = nullptr;
+	if( valueCount > 0 && ( !backingFileName.isEmpty() || useTempFile ) )
+	{
+		qint64 byteCount = static_cast<qint64>( valueCount * sizeof( double ) );
+		bool opened;
+		if( useTempFile )
+		{
+			QTemporaryFile * tempFile = new QTemporaryFile( QDir::tempPath() + "/splom_data_XXXXXX" );
+			m_backingFile.reset( tempFile );
+			opened = tempFile->open();
+		}
+		else
+		{
+			m_backingFile.reset( new QFile( backingFileName ) );
+			opened = m_backingFile->open( QIODevice::ReadWrite | QIODevice::Truncate );
+		}
+		if( opened && m_backingFile->resize( byteCount ) )
+			mapped = m_backingFile->map( 0, byteCount );
+		if( !mapped )
+		{
+			DEBUG_LOG( QString( "Could not map scatter plot data file %1: %2" )
+				.arg( m_backingFile->fileName() ).arg( m_backingFile->errorString() ) );
+			m_backingFile.reset();
+			if( !useTempFile )
+				return false;
+			// the temporary file is only an optimization, try main memory instead
+		}
+	}
+	if( mapped )
+	{
+		m_values = reinterpret_cast<double *>( mapped );
+		std::fill( m_values, m_values + valueCount, 0.0 );
+	}
+	else
+	{
+		m_memory.resize( valueCount, 0.0 );
+		m_values = m_memory.data();
+	}
+	m_paramNames = paramNames;
+	m_numPoints = numPoints;
+	return true;
+}
+
+void iASPLOMData::import( const QTableWidget * tw )
+{
+	int numParams = tw->columnCount();
+	int numPoints = std::max( tw->rowCount() - 1, 0 );
+	QList<QString> paramNames;
+	for( int c = 0; c < numParams; ++c )
+		paramNames.push_back( tw->item( 0, c )->text() );
+	allocate( paramNames, numPoints );
+	for( int c = 0; c < numParams; ++c )
+	{
+		double * values = paramData( c );
+		for( int r = 0; r < numPoints; ++r )
+			values[r] = tw->item( r + 1, c )->text().toDouble();
+	}
+}
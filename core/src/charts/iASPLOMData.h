@@ -20,51 +20,55 @@
 * ************************************************************************************/
 #pragma once
 
-#include <QTableWidget>
+#include "open_iA_Core_export.h"
+
+#include <QList>
+#include <QScopedPointer>
+#include <QString>
+
+#include <vector>
+
+class QFile;
+class QTableWidget;
 
 //! Class for storing data shown in scatter plot matrix (SPLOM).
 /*! 
 	Stores data points, parameter names as well as number of data points and parameters.
+	The values are stored column by column in one contiguous block of memory (columnar layout),
+	which can be backed by a memory-mapped file; large data sets are kept in a temporary mapped
+	file automatically. The values of one parameter are exposed as plain array, which scatter
+	plots read directly without copying.
 */
-class iASPLOMData
+class open_iA_Core_API iASPLOMData
 {
 public:
-	iASPLOMData() {};
-	explicit iASPLOMData( const QTableWidget * tw ) { import( tw ); }
+	iASPLOMData();
+	explicit iASPLOMData( const QTableWidget * tw );
+	~iASPLOMData();
 
 	//! Free all the data.
-	void clear()
-	{
-		m_paramNames.clear();
-		m_dataPoints.clear();
-	}
-
-	//! Methods that imports data from a QTableWidget and stores them in a list of double-lists.
-	void import( const QTableWidget * tw )
-	{
-		clear();
-
-		int numParams = tw->columnCount();
-		int numPoints = tw->rowCount() - 1;
-		if( numPoints < 0 )
-			numPoints = 0;
-		for( unsigned long c = 0; c < numParams; ++c )
-		{
-			m_paramNames.push_back( tw->item( 0, c )->text() );
-			m_dataPoints.push_back( QList<double>() );
-			QList<double> * paramData = &m_dataPoints[c];
-			for( unsigned long r = 1; r < numPoints + 1; ++r )
-				paramData->push_back( tw->item( r, c )->text().toDouble() );
-		}
-	}
-	QList<QList<double>> & data() { return m_dataPoints; }
-	QList<QString> & paramNames()  { return m_paramNames; }
-
-	//! Get constant reference to the lists containing raw data points.
-	const QList<QList<double>> & data() const { return m_dataPoints; }
-
-	//! Get constant reference to the list containing raw data points of a given parameter (index).
-	const QList<double> & paramData( int paramIndex ) const { return m_dataPoints[paramIndex]; }
+	void clear();
+
+	//! Values of more than this many bytes are stored in a temporary memory-mapped file if no backing file is given
+	static const size_t MaxInMemoryBytes = 1024 * 1024 * 1024;
+
+	//! Reserve storage for the given parameters and number of points, with all values set to 0.
+	//! If a backing file name is given, the values are stored in that (memory-mapped) file
+	//! instead of main memory, which allows keeping data sets larger than the available memory.
+	//! @return true if the storage could be allocated
+	bool allocate( const QList<QString> & paramNames, size_t numPoints, const QString & backingFileName = QString() );
+
+	//! Imports data from a QTableWidget; the first row is expected to contain the parameter names.
+	void import( const QTableWidget * tw );
+
+	//! Get the values of a given parameter (index), numPoints() consecutive values.
+	const double * paramData( int paramIndex ) const { return m_values + paramIndex * m_numPoints; }
+
+	//! Get the values of a given parameter (index) for modification.
+	double * paramData( int paramIndex ) { return m_values + paramIndex * m_numPoints; }
+
+	//! Get the list of parameter names.
+	const QList<QString> & paramNames() const { return m_paramNames; }
 
 	//! Get parameter name by its index.
 	QString parameterName( int paramIndex ) const { return m_paramNames[paramIndex]; }
@@ -73,9 +77,15 @@ public:
 	unsigned long numParams() const { return m_paramNames.size(); }
 
 	//! Get number of data points.
-	unsigned long numPoints() const { return m_dataPoints.size() < 1 ? 0 : m_dataPoints[0].size(); }
+	unsigned long numPoints() const { return m_numPoints; }
+
+private:
+	iASPLOMData( const iASPLOMData & other ) = delete;
+	iASPLOMData & operator=( const iASPLOMData & other ) = delete;
 
-protected:
 	QList<QString> m_paramNames;		///< list of parameter names
-	QList<QList<double>> m_dataPoints;	///< lists containing data points
+	size_t m_numPoints;					///< number of data points
+	double * m_values;					///< all values, column by column; points into m_memory or m_backingFile
+	std::vector<double> m_memory;		///< storage of the values if not file-backed
+	QScopedPointer<QFile> m_backingFile;	///< memory-mapped file containing the values (optional)
 };
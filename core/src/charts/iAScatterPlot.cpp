@@ -40,6 +40,36 @@
 #include <QTextDocument>
 #include <QWheelEvent>
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+	//! check whether a rectangle lies completely inside of a polygon:
+	//! one of its corners is inside and no polygon edge crosses its border
+	bool polygonContainsRect( QPolygonF const & poly, QRectF const & rect )
+	{
+		if ( !poly.containsPoint( rect.topLeft(), Qt::OddEvenFill ) )
+			return false;
+		QLineF rectSides[4] = {
+			QLineF( rect.topLeft(), rect.topRight() ),
+			QLineF( rect.topRight(), rect.bottomRight() ),
+			QLineF( rect.bottomRight(), rect.bottomLeft() ),
+			QLineF( rect.bottomLeft(), rect.topLeft() )
+		};
+		QPointF intersection;
+		for ( int i = 0; i < poly.size(); ++i )
+		{
+			QLineF edge( poly[i], poly[( i + 1 ) % poly.size()] );
+			for ( int s = 0; s < 4; ++s )
+				if ( edge.intersect( rectSides[s], &intersection ) == QLineF::BoundedIntersection )
+					return false;
+		}
+		return true;
+	}
+}
+
 iAScatterPlot::Settings::Settings() :
 pickedPointMagnification( 2.0 ),
 
@@ -52,6 +82,10 @@ rangeMargin( 0.08 ),
 pointRadius( 2.5 ),
 maximizedPointMagnification( 1.7 ),
 defaultGridDimensions( 100 ),
+maxGridDimensions( 1024 ),
+gridPointsPerCell( 8 ),
+densityPointThreshold( 500000 ),
+densityBinCount( 512 ),
 defaultMaxBtnSz( 10 ),
 paramTextOffset( 5 ),
 
@@ -64,7 +98,8 @@ plotBorderColor( QColor( 170, 170, 170 ) ),
 tickLineColor( QColor( 221, 221, 221 ) ),
 tickLabelColor( QColor( 100, 100, 100 ) ),
 backgroundColor( QColor( 255, 255, 255 ) ),
-selectionColor( QColor(0, 0, 0) )
+selectionColor( QColor(0, 0, 0) ),
+densityColor( QColor(0, 0, 0) )
 {}
 
 iAScatterPlot::iAScatterPlot(iAScatterPlotSelectionHandler * splom, QGLWidget* parent, int numTicks /*= 5*/, bool isMaximizedPlot /*= false */)
@@ -80,6 +115,7 @@ iAScatterPlot::iAScatterPlot(iAScatterPlotSelectionHandler * splom, QGLWidget* p
 	m_prevPtInd( -1 ),
 	m_curInd( -1 ),
 	m_pointsBuffer( 0 ),
+	m_densityTexture( 0 ),
 	m_isMaximizedPlot( isMaximizedPlot ),
 	m_isPreviewPlot( false )
 {
@@ -87,7 +123,10 @@ iAScatterPlot::iAScatterPlot(iAScatterPlotSelectionHandler * splom, QGLWidget* p
 	initGrid();
 }
 
-iAScatterPlot::~iAScatterPlot() {}
+iAScatterPlot::~iAScatterPlot()
+{
+	releaseDensityTexture();
+}
 
 void iAScatterPlot::setData( int x, int y, QSharedPointer<iASPLOMData> &splomData )
 {
@@ -398,34 +437,46 @@ double iAScatterPlot::revertTransformY( double v ) const
 void iAScatterPlot::initGrid()
 {
 	m_gridDims[0] = m_gridDims[1] = settings.defaultGridDimensions;
-	for ( int i = 0; i < m_gridDims[0] * m_gridDims[1]; ++i )
-		m_pointsGrid.push_back( QList<int>() );
+	m_gridOffsets.assign( m_gridDims[0] * m_gridDims[1] + 1, 0 );
+	m_gridPoints.clear();
 }
 
 void iAScatterPlot::updateGrid()
 {
-	for ( int i = 0; i < m_gridDims[0] * m_gridDims[1]; ++i )
-		m_pointsGrid[i].clear();
-
-	for ( unsigned long i = 0; i < m_splomData->numPoints(); ++i )
-	{
-		double x = m_splomData->paramData( m_paramIndices[0] )[i];
-		double y = m_splomData->paramData( m_paramIndices[1] )[i];
-		int xbin = p2binx( x );
-		int ybin = p2biny( y );
-		int binInd = getBinIndex( xbin, ybin );
-		m_pointsGrid[binInd].push_back( i );
-	}
+	// adapt grid resolution so that bins contain roughly the same number of points regardless of data size
+	const long long numPoints = m_splomData->numPoints();
+	int dim = static_cast<int>( std::sqrt( static_cast<double>( numPoints ) / settings.gridPointsPerCell ) );
+	m_gridDims[0] = m_gridDims[1] = clamp( settings.defaultGridDimensions, settings.maxGridDimensions, dim );
+	const size_t binCount = static_cast<size_t>( m_gridDims[0] ) * m_gridDims[1];
+
+	// counting sort of the point indices by bin:
+	const double * xData = m_splomData->paramData( m_paramIndices[0] );
+	const double * yData = m_splomData->paramData( m_paramIndices[1] );
+	std::vector<int> pointBins( numPoints );
+#pragma omp parallel for
+	for ( long long i = 0; i < numPoints; ++i )
+		pointBins[i] = getBinIndex( p2binx( xData[i] ), p2biny( yData[i] ) );
+	m_gridOffsets.assign( binCount + 1, 0 );
+	for ( long long i = 0; i < numPoints; ++i )
+		++m_gridOffsets[pointBins[i] + 1];
+	for ( size_t b = 0; b < binCount; ++b )
+		m_gridOffsets[b + 1] += m_gridOffsets[b];
+	m_gridPoints.resize( numPoints );
+	std::vector<size_t> insertPos( m_gridOffsets.begin(), m_gridOffsets.end() - 1 );
+	for ( long long i = 0; i < numPoints; ++i )
+		m_gridPoints[insertPos[pointBins[i]]++] = static_cast<unsigned int>( i );
 }
 
 void iAScatterPlot::calculateRanges()
 {
-	m_prX[0] = m_prX[1] = m_splomData->paramData( m_paramIndices[0] )[0];
-	m_prY[0] = m_prY[1] = m_splomData->paramData( m_paramIndices[1] )[0];
+	const double * xData = m_splomData->paramData( m_paramIndices[0] );
+	const double * yData = m_splomData->paramData( m_paramIndices[1] );
+	m_prX[0] = m_prX[1] = xData[0];
+	m_prY[0] = m_prY[1] = yData[0];
 	for ( unsigned long i = 1; i < m_splomData->numPoints(); ++i )
 	{
-		double x = m_splomData->paramData( m_paramIndices[0] )[i];
-		double y = m_splomData->paramData( m_paramIndices[1] )[i];
+		double x = xData[i];
+		double y = yData[i];
 		if ( x < m_prX[0] )
 			m_prX[0] = x;
 		if ( x > m_prX[1] )
@@ -509,6 +560,8 @@ void iAScatterPlot::calculateNiceSteps( double * r, QList<double> * ticks )
 
 int iAScatterPlot::getPointIndexAtPosition( QPointF mpos ) const
 {
+	if ( !hasData() )
+		return -1;
 	double px = x2p( mpos.x() );
 	double py = y2p( mpos.y() );
 	int xbin = p2binx( px );
@@ -530,15 +583,17 @@ int iAScatterPlot::getPointIndexAtPosition( QPointF mpos ) const
 
 	double minDist = pow( pPtMag * ptRad, 2 );
 	int res = -1;
+	const double * xData = m_splomData->paramData( m_paramIndices[0] );
+	const double * yData = m_splomData->paramData( m_paramIndices[1] );
 	for ( int x = xrange[0]; x < xrange[1]; ++x )
 		for ( int y = yrange[0]; y < yrange[1]; ++y )
 		{
 		binInd = getBinIndex( x, y );
-		for ( int indx = m_pointsGrid[binInd].size() - 1; indx >= 0; --indx )//foreach( int i, m_pointsGrid[binInd] )
+		for ( size_t indx = m_gridOffsets[binInd + 1]; indx > m_gridOffsets[binInd]; --indx )
 		{
-			int i = m_pointsGrid[binInd][indx];
-			double x = p2x( m_splomData->paramData( m_paramIndices[0] )[i] );
-			double y = p2y( m_splomData->paramData( m_paramIndices[1] )[i] );
+			int i = m_gridPoints[indx - 1];
+			double x = p2x( xData[i] );
+			double y = p2y( yData[i] );
 			double dist = pow( x - mpos.x(), 2 ) + pow( y - mpos.y(), 2 );
 			if ( dist < minDist )//if( dist <= m_pointRadius*m_pointRadius )
 			{
@@ -559,8 +614,16 @@ QPointF iAScatterPlot::getPositionFromPointIndex( int ind ) const
 
 void iAScatterPlot::updateSelectedPoints( bool append )
 {
+	if ( !hasData() )
+		return;
 	QVector<unsigned int> & selInds = m_splom->getSelection();
-	if ( !append )
+	const size_t numPoints = m_splomData->numPoints();
+	const char Unselected = 0, Selected = 1, NewlySelected = 2;
+	std::vector<char> pointState( numPoints, Unselected );
+	if ( append )
+		for ( unsigned int i : selInds )
+			pointState[i] = Selected;
+	else
 		selInds.clear();
 	QPolygonF pPoly;
 	for ( int i = 0; i < m_selPoly.size(); ++i )
@@ -570,20 +633,36 @@ void iAScatterPlot::updateSelectedPoints( bool append )
 	}
 	int rangeBinX[2] = { p2binx( pPoly.boundingRect().left() ), p2binx( pPoly.boundingRect().right() ) };
 	int rangeBinY[2] = { p2biny( pPoly.boundingRect().top() ), p2biny( pPoly.boundingRect().bottom() ) };
-	for ( int binx = rangeBinX[0]; binx <= rangeBinX[1]; ++binx )
-		for ( int biny = rangeBinY[0]; biny <= rangeBinY[1]; ++biny )
-		{
-		QList<int> pts = m_pointsGrid[getBinIndex( binx, biny )];
-		foreach( int i, pts )
+	const int binCountX = rangeBinX[1] - rangeBinX[0] + 1;
+	const int binCount = binCountX * ( rangeBinY[1] - rangeBinY[0] + 1 );
+	const double * xData = m_splomData->paramData( m_paramIndices[0] );
+	const double * yData = m_splomData->paramData( m_paramIndices[1] );
+	// see p2binx/p2biny: the parameter range is mapped to [0, gridDim-1]
+	const double binSize[2] = { ( m_prX[1] - m_prX[0] ) / ( m_gridDims[0] - 1 ), ( m_prY[1] - m_prY[0] ) / ( m_gridDims[1] - 1 ) };
+	// bins are independent, each point is contained in exactly one of them:
+#pragma omp parallel for schedule(dynamic, 64)
+	for ( int b = 0; b < binCount; ++b )
+	{
+		int binx = rangeBinX[0] + b % binCountX;
+		int biny = rangeBinY[0] + b / binCountX;
+		int binInd = getBinIndex( binx, biny );
+		if ( m_gridOffsets[binInd] == m_gridOffsets[binInd + 1] )
+			continue;
+		// bins at the border of the grid also contain all points outside of the range:
+		bool isBorderBin = binx == 0 || biny == 0 || binx == m_gridDims[0] - 1 || biny == m_gridDims[1] - 1;
+		QRectF binRect( m_prX[0] + binx * binSize[0], m_prY[0] + biny * binSize[1], binSize[0], binSize[1] );
+		bool allInside = !isBorderBin && polygonContainsRect( pPoly, binRect );
+		for ( size_t indx = m_gridOffsets[binInd]; indx < m_gridOffsets[binInd + 1]; ++indx )
 		{
-			QPointF pt( m_splomData->paramData( m_paramIndices[0] )[i], m_splomData->paramData( m_paramIndices[1] )[i] );
-			if ( pPoly.containsPoint( pt, Qt::OddEvenFill ) )
-			{
-				if ( append ) if ( selInds.contains( i ) ) continue;
-				selInds.push_back( i );
-			}
-		}
+			unsigned int i = m_gridPoints[indx];
+			if ( pointState[i] == Unselected &&
+				( allInside || pPoly.containsPoint( QPointF( xData[i], yData[i] ), Qt::OddEvenFill ) ) )
+				pointState[i] = NewlySelected;
 		}
+	}
+	for ( size_t i = 0; i < numPoints; ++i )
+		if ( pointState[i] == NewlySelected )
+			selInds.push_back( static_cast<unsigned int>( i ) );
 	emit selectionModified();
 }
 
@@ -664,27 +743,54 @@ void iAScatterPlot::drawPoints( QPainter &painter )
 
 	glScissor( m_globRect.left(), y, m_globRect.width(), m_globRect.height() );
 	glEnable( GL_SCISSOR_TEST );
-	if (!m_pointsBuffer->bind())//TODO: proper handling (exceptions?)
+	QVector<unsigned int> & selInds = m_splom->getSelection();
+	if ( isDensityMode() )
 	{
-		DEBUG_LOG("Failed to bind points buffer!");
-		return;
+		drawDensity();
+		// there is no per-point VBO in density mode, so the selected points are passed directly
+		std::vector<GLfloat> selPoints( 3 * selInds.size() );
+		const double * xData = m_splomData->paramData( m_paramIndices[0] );
+		const double * yData = m_splomData->paramData( m_paramIndices[1] );
+		for ( int i = 0; i < selInds.size(); ++i )
+		{
+			selPoints[3 * i + 0] = p2tx( xData[selInds[i]] );
+			selPoints[3 * i + 1] = p2ty( yData[selInds[i]] );
+			selPoints[3 * i + 2] = 0.0;
+		}
+		glEnable( GL_POINT_SMOOTH );
+		glEnable( GL_BLEND );
+		glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+		glPointSize( ptSize );
+		glColor3f( settings.selectionColor.red() / 255.0, settings.selectionColor.green() / 255.0, settings.selectionColor.blue() / 255.0 );
+		glEnableClientState( GL_VERTEX_ARRAY );
+		glVertexPointer( 3, GL_FLOAT, 0, selPoints.data() );
+		glDrawArrays( GL_POINTS, 0, selInds.size() );
+		glDisableClientState( GL_VERTEX_ARRAY );
+	}
+	else
+	{
+		if ( !m_pointsBuffer )	// the plot was in density mode when the data was set
+			createAndFillVBO();
+		if (!m_pointsBuffer->bind())//TODO: proper handling (exceptions?)
+		{
+			DEBUG_LOG("Failed to bind points buffer!");
+			return;
+		}
+		glEnable( GL_POINT_SMOOTH );
+		glEnable( GL_BLEND );
+		glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+		glPointSize( ptSize );
+		glEnableClientState( GL_VERTEX_ARRAY );
+		glVertexPointer( 3, GL_FLOAT, 7 * sizeof( GLfloat ), (const void *) ( 0 ) );
+		glEnableClientState( GL_COLOR_ARRAY );
+		glColorPointer( 4, GL_FLOAT, 7 * sizeof( GLfloat ), (const void *) ( 3 * sizeof( GLfloat ) ) );
+		glDrawArrays( GL_POINTS, 0, m_splomData->numPoints() );//glDrawElements( GL_POINTS, m_pointsBuffer->size(), GL_UNSIGNED_INT, 0 );
+		glDisableClientState( GL_COLOR_ARRAY );
+		glColor3f( settings.selectionColor.red() / 255.0, settings.selectionColor.green() / 255.0, settings.selectionColor.blue() / 255.0 );
+		glDrawElements(GL_POINTS, selInds.size(), GL_UNSIGNED_INT, selInds.data());
+		glDisableClientState( GL_VERTEX_ARRAY );
+		m_pointsBuffer->release();
 	}
-	glEnable( GL_POINT_SMOOTH );
-	glEnable( GL_BLEND );
-	glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
-	glPointSize( ptSize );
-	glEnableClientState( GL_VERTEX_ARRAY );
-	glVertexPointer( 3, GL_FLOAT, 7 * sizeof( GLfloat ), (const void *) ( 0 ) );
-	glEnableClientState( GL_COLOR_ARRAY );
-	glColorPointer( 4, GL_FLOAT, 7 * sizeof( GLfloat ), (const void *) ( 3 * sizeof( GLfloat ) ) );
-	glDrawArrays( GL_POINTS, 0, m_splomData->numPoints() );//glDrawElements( GL_POINTS, m_pointsBuffer->size(), GL_UNSIGNED_INT, 0 );
-	glDisableClientState( GL_COLOR_ARRAY );
-	glColor3f( settings.selectionColor.red() / 255.0, settings.selectionColor.green() / 255.0, settings.selectionColor.blue() / 255.0 );
-
-	QVector<unsigned int> & selInds = m_splom->getSelection();
-	glDrawElements(GL_POINTS, selInds.size(), GL_UNSIGNED_INT, selInds.data());
-	glDisableClientState( GL_VERTEX_ARRAY );
-	m_pointsBuffer->release();
 
 	//draw current point
 	double anim = m_splom->getAnimIn();
@@ -872,17 +978,23 @@ void iAScatterPlot::createAndFillVBO()
 		m_pointsBuffer->release();
 		m_pointsBuffer->destroy();
 		delete m_pointsBuffer;
+		m_pointsBuffer = 0;
 	}
-	m_pointsBuffer = new QGLBuffer( QGLBuffer::VertexBuffer );
-	if ( !m_pointsBuffer->create() )//TODO: exceptions?
-		return;
-	if ( m_splomData && m_lut->initialized() )
+	// density rendering never draws the individual points, so their VBO is only built below the threshold
+	if ( !isDensityMode() )
 	{
-		bool res = m_pointsBuffer->bind();
-		if ( res )
-			fillVBO();
-		m_pointsBuffer->release();
+		m_pointsBuffer = new QGLBuffer( QGLBuffer::VertexBuffer );
+		if ( !m_pointsBuffer->create() )//TODO: exceptions?
+			return;
+		if ( m_splomData && m_lut->initialized() )
+		{
+			bool res = m_pointsBuffer->bind();
+			if ( res )
+				fillVBO();
+			m_pointsBuffer->release();
+		}
 	}
+	updateDensityTexture();
 }
 
 void iAScatterPlot::fillVBO()
@@ -894,16 +1006,21 @@ void iAScatterPlot::fillVBO()
 		int ccount = 4 * m_splomData->numPoints();
 		int elSz = 7;
 		GLfloat * buffer = new GLfloat[vcount + ccount];
-		for ( unsigned long i = 0; i < m_splomData->numPoints(); ++i )
+		const double * xData = m_splomData->paramData( m_paramIndices[0] );
+		const double * yData = m_splomData->paramData( m_paramIndices[1] );
+		const double * colData = m_lut->initialized() ? m_splomData->paramData( m_colInd ) : nullptr;
+		const long long numPoints = m_splomData->numPoints();
+#pragma omp parallel for
+		for ( long long i = 0; i < numPoints; ++i )
 		{
-			double tx = p2tx( m_splomData->paramData( m_paramIndices[0] )[i] );
-			double ty = p2ty( m_splomData->paramData( m_paramIndices[1] )[i] );
+			double tx = p2tx( xData[i] );
+			double ty = p2ty( yData[i] );
 			buffer[elSz * i + 0] = tx;
 			buffer[elSz * i + 1] = ty;
 			buffer[elSz * i + 2] = 0.0;
 			if ( m_lut->initialized() )
 			{
-				double val = m_splomData->paramData( m_colInd )[i];
+				double val = colData[i];
 				double rgba[4]; m_lut->getColor( val, rgba );
 				buffer[elSz * i + 3] = rgba[0];
 				buffer[elSz * i + 4] = rgba[1];
@@ -916,6 +1033,102 @@ void iAScatterPlot::fillVBO()
 	}
 }
 
+bool iAScatterPlot::isDensityMode() const
+{
+	return settings.densityPointThreshold > 0 && hasData() &&
+		m_splomData->numPoints() >= settings.densityPointThreshold;
+}
+
+void iAScatterPlot::releaseDensityTexture()
+{
+	if ( !m_densityTexture )
+		return;
+	m_parentWidget->makeCurrent();	// the texture belongs to the parent's context
+	glDeleteTextures( 1, &m_densityTexture );
+	m_densityTexture = 0;
+}
+
+void iAScatterPlot::updateDensityTexture()
+{
+	releaseDensityTexture();
+	m_parentWidget->makeCurrent();
+	if ( !isDensityMode() )
+		return;
+	// 2D histogram over the normalized plot coordinates, one per thread, merged at the end;
+	// in addition, the values of the color-coded parameter are summed up to color each bin by their mean
+	const int binCount = settings.densityBinCount;
+	const size_t cellCount = static_cast<size_t>( binCount ) * binCount;
+	const double * xData = m_splomData->paramData( m_paramIndices[0] );
+	const double * yData = m_splomData->paramData( m_paramIndices[1] );
+	const double * colData = m_lut->initialized() ? m_splomData->paramData( m_colInd ) : nullptr;
+	const long long numPoints = m_splomData->numPoints();
+	std::vector<double> counts( cellCount, 0 ), colorSums( colData ? cellCount : 0, 0 );
+#pragma omp parallel
+	{
+		std::vector<double> localCounts( cellCount, 0 ), localColorSums( colorSums.size(), 0 );
+#pragma omp for
+		for ( long long i = 0; i < numPoints; ++i )
+		{
+			int binx = clamp( 0, binCount - 1, static_cast<int>( p2tx( xData[i] ) * binCount ) );
+			int biny = clamp( 0, binCount - 1, static_cast<int>( p2ty( yData[i] ) * binCount ) );
+			size_t cell = static_cast<size_t>( biny ) * binCount + binx;
+			localCounts[cell] += 1;
+			if ( colData )
+				localColorSums[cell] += colData[i];
+		}
+#pragma omp critical
+		{
+			for ( size_t c = 0; c < cellCount; ++c )
+				counts[c] += localCounts[c];
+			for ( size_t c = 0; c < colorSums.size(); ++c )
+				colorSums[c] += localColorSums[c];
+		}
+	}
+	// logarithmic opacity scale, so that sparse regions remain visible next to dense clusters:
+	double logMaxCount = std::log( 1 + *std::max_element( counts.begin(), counts.end() ) );
+	std::vector<GLubyte> texData( cellCount * 4, 0 );
+	for ( size_t c = 0; c < cellCount; ++c )
+	{
+		if ( counts[c] == 0 )
+			continue;
+		double rgba[4] = { settings.densityColor.redF(), settings.densityColor.greenF(),
+			settings.densityColor.blueF(), settings.densityColor.alphaF() };
+		if ( colData )
+			m_lut->getColor( colorSums[c] / counts[c], rgba );
+		double density = std::log( 1 + counts[c] ) / logMaxCount;
+		rgba[3] *= 0.2 + 0.8 * density;
+		for ( int i = 0; i < 4; ++i )
+			texData[c * 4 + i] = static_cast<GLubyte>( clamp( 0.0, 255.0, rgba[i] * 255 ) );
+	}
+	glGenTextures( 1, &m_densityTexture );
+	glBindTexture( GL_TEXTURE_2D, m_densityTexture );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP );
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+	glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, binCount, binCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, texData.data() );
+	glBindTexture( GL_TEXTURE_2D, 0 );
+}
+
+void iAScatterPlot::drawDensity()
+{
+	if ( !m_densityTexture )
+		return;
+	// texture covers the normalized plot coordinates [0,1]x[0,1], same as the point VBO
+	glEnable( GL_TEXTURE_2D );
+	glBindTexture( GL_TEXTURE_2D, m_densityTexture );
+	glColor4f( 1.0f, 1.0f, 1.0f, 1.0f );
+	glBegin( GL_QUADS );
+	glTexCoord2f( 0.0f, 0.0f ); glVertex3f( 0.0f, 0.0f, 0.0f );
+	glTexCoord2f( 1.0f, 0.0f ); glVertex3f( 1.0f, 0.0f, 0.0f );
+	glTexCoord2f( 1.0f, 1.0f ); glVertex3f( 1.0f, 1.0f, 0.0f );
+	glTexCoord2f( 0.0f, 1.0f ); glVertex3f( 0.0f, 1.0f, 0.0f );
+	glEnd();
+	glBindTexture( GL_TEXTURE_2D, 0 );
+	glDisable( GL_TEXTURE_2D );
+}
+
 double iAScatterPlot::getPointRadius() const
 {
 	double res = settings.pointRadius;
@@ -28,6 +28,8 @@
 #include <QScopedPointer>
 #include <QWidget>
 
+#include <vector>
+
 class iALookupTable;
 class iAScatterPlotSelectionHandler;
 class iASPLOMData;
@@ -94,8 +96,8 @@ protected:
 	double revertTransformX( double v ) const;								//!< Revert scaling and offset to get X coordinate
 	double applyTransformY( double v ) const;								//!< Apply scaling and offset to Y coordinate
 	double revertTransformY( double v ) const;								//!< Revert scaling and offset to get Y coordinate
-	void initGrid();														//!< Allocate lists for grid subdivision ( for point-picking acceleration)
-	void updateGrid();														//!< Fill subdivision grid with points ( for point-picking acceleration)
+	void initGrid();														//!< Initialize an empty grid subdivision ( for point-picking acceleration)
+	void updateGrid();														//!< Fill subdivision grid with points, grid size adapted to number of points ( for point-picking acceleration)
 	void calculateRanges();													//!< Compute parameter ranges
 	void applyMarginToRanges();												//!< Apply margins to ranges so that points are not stretched border-to-border
 	void calculateNiceSteps();												//!< Calculates nice steps displayed parameter ranges
@@ -118,6 +120,10 @@ protected:
 	void drawMaximizeButton( QPainter & painter );							//!< Draws plot's maximized button (only active plot)
 	void createAndFillVBO();												//!< Creates and fills VBO with plot's 2D-points.
 	void fillVBO();															//!< Fill existing VBO with plot's 2D-points.
+	bool isDensityMode() const;												//!< Check if points are drawn as density (2D histogram) instead of individually
+	void updateDensityTexture();											//!< Compute the 2D histogram of the plot's points and upload it as texture
+	void releaseDensityTexture();											//!< Delete the density texture (in the parent widget's GL context)
+	void drawDensity();														//!< Draws the density texture (uses native OpenGL)
 
 signals:
 	void selectionModified();												//!< Emitted when selected points changed
@@ -142,6 +148,10 @@ protected:
 		double pointRadius;
 		double maximizedPointMagnification;
 		int defaultGridDimensions;
+		int maxGridDimensions;
+		int gridPointsPerCell;
+		unsigned long densityPointThreshold;
+		int densityBinCount;
 		int defaultMaxBtnSz;
 
 		long paramTextOffset;
@@ -155,6 +165,7 @@ protected:
 		QColor tickLabelColor;
 		QColor backgroundColor;
 		QColor selectionColor;
+		QColor densityColor;
 	};
 
 	//Members
@@ -184,11 +195,13 @@ protected:
 	bool m_isPlotActive;						//!< flag indicating if the plot is active (user hovers mouse over)
 	//points
 	int m_gridDims[2];							//!< dimensions of subdivision grid (point picking acceleration)
-	QList<QList<int>> m_pointsGrid;				//!< grid bins containing point indices
+	std::vector<size_t> m_gridOffsets;			//!< for each grid bin, the start of its points in m_gridPoints (plus one past-the-end entry)
+	std::vector<unsigned int> m_gridPoints;		//!< point indices, sorted by grid bin
 	int m_prevPtInd;							//!< index of previously selected point
 	int m_prevInd;								//!< index of previously selected point(-1 if none)
 	int m_curInd;								//!< index of currently selected point (-1 if none)
 	QGLBuffer * m_pointsBuffer;					//!< OpenGL buffer used for points VBO
+	GLuint m_densityTexture;					//!< OpenGL texture containing the 2D histogram of points (0 if not in density mode)
 	//selection polygon
 	QPolygon m_selPoly;							//!< polygon of selection lasso
 	//state flags
@@ -80,6 +80,12 @@ iAScatterPlotWidget::iAScatterPlotWidget(QSharedPointer<iASPLOMData> data) :
 	m_scatterplot->setData(0, 1, data);
 }
 
+iAScatterPlotWidget::~iAScatterPlotWidget()
+{
+	// the plot holds resources in this widget's GL context, so release it before the context is gone
+	delete m_scatterplot;
+}
+
 void iAScatterPlotWidget::SetPlotColor(QColor const & c, double rangeMin, double rangeMax)
 {
 	auto lut = vtkSmartPointer<vtkLookupTable>::New();
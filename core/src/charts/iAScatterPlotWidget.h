@@ -37,6 +37,7 @@ public:
 	static const int PaddingBottom;
 	static const int TextPadding;
 	iAScatterPlotWidget(QSharedPointer<iASPLOMData> data);
+	~iAScatterPlotWidget();
 	QVector<unsigned int> GetSelection();
 	void SetSelection(QVector<unsigned int> const & selection);
 	void SetPlotColor(QColor const & c, double rangeMin, double rangeMax);
@@ -22,14 +22,14 @@
 #include "dlg_datatypeconversion.h"
 
 #include "iAConnector.h"
+#include "iAConsole.h"
+#include "charts/iAHistogramComputation.h"
 #include "charts/iAHistogramWidget.h"
+#include "io/iARawFileConverter.h"
 #include "iAToolsVTK.h"
 #include <iATransferFunction.h>
 #include "iATypedCallHelper.h"
 
-#include <itkChangeInformationImageFilter.h>
-#include <itkExtractImageFilter.h>
-#include <itkImageSliceConstIteratorWithIndex.h>
 #include <itkNormalizeImageFilter.h>
 #include <itkRescaleIntensityImageFilter.h>
 
@@ -61,126 +61,76 @@
 #include <QVariant>
 
 
-template<class T> int DataTypeConversion_template(QString const & m_filename, double* b, iAPlotData::DataType * histptr, float* m_min, float* m_max, float* m_dis, iAConnector* xyconvertimage, iAConnector* xzconvertimage, iAConnector* yzconvertimage)
+template<class T> int DataTypeConversion_template(QString const & m_filename, int scalarType, double* b, iAPlotData::DataType * histptr, float* m_min, float* m_max, float* m_dis, iAConnector* xyconvertimage, iAConnector* xzconvertimage, iAConnector* yzconvertimage)
 {
-	typedef itk::Image< T, 3 >   InputImageType;
-
-	FILE * pFile;
-	pFile = fopen( m_filename.toStdString().c_str(), "rb" );
-	if (pFile==NULL) {fputs ("File error",stderr); exit (1);}
-
-	typename InputImageType::Pointer itkimage = InputImageType::New();
-
-	// create itk image
-	float itkz = floor((float)((b[3]-1)/b[0])+1);
-	typename InputImageType::SpacingType itkspacing;	itkspacing[0] = b[4]; itkspacing[1] = b[5];	itkspacing[2] = b[6];
-	typename InputImageType::SizeType itksize;	itksize[0] = b[1]; itksize[1] = b[2]; itksize[2] = (int)itkz;
-	typename InputImageType::IndexType itkindex;	itkindex.Fill(0);
-	typename InputImageType::RegionType itkregion;	itkregion.SetSize(itksize);	itkregion.SetIndex(itkindex);
-
-	itkimage->SetSpacing(itkspacing);	itkimage->SetRegions(itkregion);	itkimage->Allocate();	itkimage->FillBuffer(0);
-
-	typename InputImageType::PixelType buffer;
-	unsigned long datatypesize = sizeof(buffer);
-	long slicesize = b[1]*b[2];
-	int slicecounter = 0;
-	size_t result;
-	int numsliceread = 0;
-
-	long totalsize = b[1]*b[2]*b[3]*datatypesize;
-	double min = std::numeric_limits<double>::max();
-	double max = std::numeric_limits<double>::lowest();
-
-	//calculation of minimum and maximum
-	fseek ( pFile , 0 , SEEK_SET );
-	while (result = fread (reinterpret_cast<char*>(&buffer),datatypesize,1,pFile))
+	int dim[3] = { static_cast<int>(b[1]), static_cast<int>(b[2]), static_cast<int>(b[3]) };
+	iARawFileConverter rawFile(m_filename, dim, scalarType);
+	double min, max;
+	if (!rawFile.ComputeRange(min, max))
 	{
-		if (buffer < min)
-		{	min = buffer;	}
-		if (buffer > max)
-		{	max = buffer;	}
+		DEBUG_LOG(rawFile.ErrorMessage());
+		return EXIT_FAILURE;
 	}
-
+	size_t const bins = static_cast<size_t>(b[7]);
 	float discretization = (float)((max-min)/(b[7]));
+	std::fill(histptr, histptr + bins, 0);
 
-	// copy the file into the buffer and create histogram:
-	typedef itk::ImageRegionIterator<InputImageType> iteratortype;
-	iteratortype iter(itkimage, itkimage->GetRequestedRegion());
-	iter.GoToBegin();
-	bool loop = 1; 
-	fseek ( pFile , 0 , SEEK_SET );
-	std::fill(histptr, histptr + static_cast<size_t>(b[7]), 0);
-	while (loop)
-	{
-		result = fread (reinterpret_cast<char*>(&buffer),datatypesize,1,pFile);
-		size_t binIdx = ((buffer-min)/discretization);
-		iter.Set(buffer);
-		++iter;
-		histptr[binIdx] += 1;
-		slicecounter++;
-		if ( slicecounter == slicesize )
-		{	// TO CHECK: does that really skip anything?
-			slicecounter = 0;
-			numsliceread++;
-			long skipmemory = slicesize*datatypesize*b[0]*numsliceread;
-			if ( skipmemory < totalsize )
-			{	fseek ( pFile , skipmemory , SEEK_SET );	}
-			else
-			{	loop = 0;	}
-		}
-	}
-	fclose(pFile);
-
-	*m_min = min;	*m_max = max;	*m_dis = discretization;
-
-	// creating projection image
+	// creating projection images
 	typedef typename itk::Image<double,3> TwoDInputImageType;
-	typename TwoDInputImageType::Pointer xytwodimage = TwoDInputImageType::New();
-
 	typename TwoDInputImageType::RegionType extractregion;
 	typename TwoDInputImageType::IndexType extractindex; extractindex.Fill(0);	extractregion.SetIndex(extractindex);
 	typename TwoDInputImageType::PointType extractpoint; extractpoint.Fill(0);
 	typename TwoDInputImageType::SpacingType extractspacing; extractspacing[0] = b[4];	extractspacing[1] = b[5];	extractspacing[2] = b[6];
-	// along z axis - xy plane
-	typename TwoDInputImageType::SizeType extractsize;	extractsize[0] = b[1]; extractsize[1] = b[2];	extractsize[2] = 1;
-	extractregion.SetSize(extractsize);
-
-	xytwodimage->SetRegions(extractregion);
-	xytwodimage->SetSpacing(extractspacing);
-	xytwodimage->SetOrigin(extractpoint);
-	xytwodimage->Allocate();
-	xytwodimage->FillBuffer(0);
-
-	typedef itk::ImageRegionIterator<TwoDInputImageType> twoditeratortype;
-	twoditeratortype xyiter (xytwodimage, xytwodimage->GetRequestedRegion());
-
-	//create slice iterator
-	typedef itk::ImageSliceConstIteratorWithIndex<InputImageType> SliceIteratorType;
-	SliceIteratorType SliceIter ( itkimage, itkimage->GetRequestedRegion() );
-
-	//set direction
-	SliceIter.SetFirstDirection(0);
-	SliceIter.SetSecondDirection(1);
-
-	SliceIter.GoToBegin();
-	while ( !SliceIter.IsAtEnd() )
+	typename TwoDInputImageType::SizeType extractsize;
+	auto createProjectionImage = [&](int sizeX, int sizeY, int sizeZ) -> typename TwoDInputImageType::Pointer
+	{
+		extractsize[0] = sizeX; extractsize[1] = sizeY; extractsize[2] = sizeZ;
+		extractregion.SetSize(extractsize);
+		typename TwoDInputImageType::Pointer image = TwoDInputImageType::New();
+		image->SetRegions(extractregion);
+		image->SetSpacing(extractspacing);
+		image->SetOrigin(extractpoint);
+		image->Allocate();
+		image->FillBuffer(0);
+		return image;
+	};
+	typename TwoDInputImageType::Pointer xytwodimage = createProjectionImage(dim[0], dim[1], 1);	// along z axis - xy plane
+	typename TwoDInputImageType::Pointer xztwodimage = createProjectionImage(dim[0], 1, dim[2]);	// along y axis - xz plane
+	typename TwoDInputImageType::Pointer yztwodimage = createProjectionImage(1, dim[1], dim[2]);	// along x axis - yz plane
+	double * xyproj = xytwodimage->GetBufferPointer();
+	double * xzproj = xztwodimage->GetBufferPointer();
+	double * yzproj = yztwodimage->GetBufferPointer();
+
+	// histogram and projections are computed from every b[0]'th slice only;
+	// in the projections along x and y, the sampled slices are stacked without gaps
+	int const sliceStep = std::max(1, static_cast<int>(b[0]));
+	qint64 const sliceValues = static_cast<qint64>(dim[0]) * dim[1];
+	bool readOk = rawFile.ReadSlabs([&](void const * data, int firstSlice, int sliceCount)
 	{
-		xyiter.GoToBegin();
-		while ( !SliceIter.IsAtEndOfSlice() )
+		for (int s = 0; s < sliceCount; ++s)
 		{
-			while ( !SliceIter.IsAtEndOfLine() )
+			int const z = firstSlice + s;
+			T const * slice = static_cast<T const *>(data) + s * sliceValues;
+			AddToHistogram(slice, static_cast<size_t>(sliceValues), 1, min, discretization, bins, histptr);
+			for (int y = 0; y < dim[1]; ++y)
 			{
-				typename InputImageType::PixelType value = SliceIter.Get();
-				typename InputImageType::IndexType index = SliceIter.GetIndex();
-				typename TwoDInputImageType::PixelType xypix = xyiter.Get() + value;
-				xyiter.Set(xypix);
-				++xyiter;
-				++SliceIter;
-			}//while
-			SliceIter.NextLine();
-		}//while
-		SliceIter.NextSlice();
-	}//while
+				for (int x = 0; x < dim[0]; ++x)
+				{
+					double value = slice[x + y * dim[0]];
+					xyproj[x + y * dim[0]] += value;
+					xzproj[x + z * dim[0]] += value;
+					yzproj[y + z * dim[1]] += value;
+				}
+			}
+		}
+	}, nullptr, sliceStep);
+	if (!readOk)
+	{
+		DEBUG_LOG(rawFile.ErrorMessage());
+		return EXIT_FAILURE;
+	}
+
+	*m_min = min;	*m_max = max;	*m_dis = discretization;
 
 	typedef itk::NormalizeImageFilter<TwoDInputImageType,TwoDInputImageType> NIFTYpe;
 	typename NIFTYpe::Pointer xynormalizefilter = NIFTYpe::New();
@@ -204,42 +154,6 @@ template<class T> int DataTypeConversion_template(QString const & m_filename, do
 	metaImageWriter->Write();
 
 	//xz plane - along y axis
-	extractsize[0] = b[1]; extractsize[1] = 1;	extractsize[2] = b[3];
-	extractregion.SetSize(extractsize);
-
-	typename TwoDInputImageType::Pointer xztwodimage = TwoDInputImageType::New();
-	xztwodimage->SetRegions(extractregion);
-	xztwodimage->SetSpacing(extractspacing);
-	xztwodimage->SetOrigin(extractpoint);
-	xztwodimage->Allocate();
-	xztwodimage->FillBuffer(0);
-
-	twoditeratortype xziter (xztwodimage, xztwodimage->GetRequestedRegion());
-
-	//set direction
-	SliceIter.SetFirstDirection(0);
-	SliceIter.SetSecondDirection(2);
-
-	SliceIter.GoToBegin();
-	while ( !SliceIter.IsAtEnd() )
-	{
-		xziter.GoToBegin();
-		while ( !SliceIter.IsAtEndOfSlice() )
-		{
-			while ( !SliceIter.IsAtEndOfLine() )
-			{
-				typename InputImageType::PixelType value = SliceIter.Get();
-				typename InputImageType::IndexType index = SliceIter.GetIndex();
-				TwoDInputImageType::PixelType xypix = xziter.Get() + value;
-				xziter.Set(xypix);
-				++xziter;
-				++SliceIter;
-			}//while
-			SliceIter.NextLine();
-		}//while
-		SliceIter.NextSlice();
-	}//while
-
 	typename NIFTYpe::Pointer xznormalizefilter = NIFTYpe::New();
 	xznormalizefilter->SetInput(xztwodimage);
 	xznormalizefilter->Update();
@@ -260,42 +174,6 @@ template<class T> int DataTypeConversion_template(QString const & m_filename, do
 	metaImageWriter->Write();
 
 	//yz plane - along x axis
-	extractsize[0] = 1; extractsize[1] = b[2];	extractsize[2] = b[3];
-	extractregion.SetSize(extractsize);
-
-	typename TwoDInputImageType::Pointer yztwodimage = TwoDInputImageType::New();
-	yztwodimage->SetRegions(extractregion);
-	yztwodimage->SetSpacing(extractspacing);
-	yztwodimage->SetOrigin(extractpoint);
-	yztwodimage->Allocate();
-	yztwodimage->FillBuffer(0);
-
-	twoditeratortype yziter (yztwodimage, yztwodimage->GetRequestedRegion());
-
-	//set direction
-	SliceIter.SetFirstDirection(1);
-	SliceIter.SetSecondDirection(2);
-
-	SliceIter.GoToBegin();
-	while ( !SliceIter.IsAtEnd() )
-	{
-		yziter.GoToBegin();
-		while ( !SliceIter.IsAtEndOfSlice() )
-		{
-			while ( !SliceIter.IsAtEndOfLine() )
-			{
-				typename InputImageType::PixelType value = SliceIter.Get();
-				typename InputImageType::IndexType index = SliceIter.GetIndex();
-				typename TwoDInputImageType::PixelType xypix = yziter.Get() + value;
-				yziter.Set(xypix);
-				++yziter;
-				++SliceIter;
-			}//while
-			SliceIter.NextLine();
-		}//while
-		SliceIter.NextSlice();
-	}//while
-
 	typename NIFTYpe::Pointer yznormalizefilter = NIFTYpe::New();
 	yznormalizefilter->SetInput(yztwodimage);
 	yznormalizefilter->Update();
@@ -320,131 +198,12 @@ template<class T> int DataTypeConversion_template(QString const & m_filename, do
 
 void dlg_datatypeconversion::DataTypeConversion(QString const & m_filename, double* b)
 {
-	VTK_TYPED_CALL(DataTypeConversion_template, m_intype, m_filename, b, m_histbinlist, &m_min, &m_max, &m_dis, xyconvertimage, xzconvertimage, yzconvertimage);
+	VTK_TYPED_CALL(DataTypeConversion_template, m_intype, m_filename, m_intype, b, m_histbinlist, &m_min, &m_max, &m_dis, xyconvertimage, xzconvertimage, yzconvertimage);
 	m_testxyimage = xyconvertimage->GetVTKImage();
 	m_testxzimage = xzconvertimage->GetVTKImage();
 	m_testyzimage = yzconvertimage->GetVTKImage();
 }
 
-//roi conversion
-template<class T> int DataTypeConversionROI_template(QString const & m_filename, double* b, double* roi, float* m_min, float* m_max, float* m_dis, iAConnector* m_roiconvertimage)
-{
-	typedef itk::Image< T, 3 >   InputImageType;
-
-	FILE * pFile;
-	pFile = fopen( m_filename.toStdString().c_str(), "rb" );
-	if (pFile==NULL) {fputs ("File error",stderr); exit (1);}
-
-	typename InputImageType::Pointer itkimage = InputImageType::New();
-
-	// create itk image
-	//float itkz = floor((float)((b[3]-1)/b[0])+1);
-	typename InputImageType::SpacingType itkspacing;	itkspacing[0] = b[4]; itkspacing[1] = b[5];	itkspacing[2] = b[6];
-	typename InputImageType::SizeType itksize;
-	itksize[0] = b[1]; itksize[1] = b[2]; itksize[2] = b[3];
-	typename InputImageType::IndexType itkindex;
-	itkindex.Fill(0);
-	typename InputImageType::RegionType itkregion;
-	itkregion.SetSize(itksize); 
-	itkregion.SetIndex(itkindex);
-
-	itkimage->SetSpacing(itkspacing);
-	itkimage->SetRegions(itkregion);
-	itkimage->Allocate();
-	itkimage->FillBuffer(0);
-
-	//create itk image iterator
-	typedef itk::ImageRegionIterator<InputImageType> iteratortype;
-	iteratortype iter (itkimage, itkimage->GetRequestedRegion());
-	iter.GoToBegin();
-
-	typename std::vector<unsigned int> m_VolumeCount ( (b[7]+1), 0 );
-
-	unsigned long datatypesize;
-	long slicesize; 
-	size_t result;
-	//int numsliceread = 0;
-
-	typename InputImageType::PixelType buffer;
-	datatypesize = sizeof(buffer);
-	slicesize = b[1]*b[2];
-	//int slicecounter = 0;
-
-	//long totalsize = b[1]*b[2]*b[3]*datatypesize;
-	float min = std::numeric_limits<float>::max();
-	float max = std::numeric_limits<float>::lowest();
-
-	//calculation of minimum and maximum
-	fseek ( pFile , 0 , SEEK_SET );
-	while (result = (fread (reinterpret_cast<char*>(&buffer),sizeof(buffer),1,pFile)))
-	{
-		if (buffer < min)
-		{	min = buffer;	}
-		if (buffer > max)
-		{	max = buffer;	}
-	}
-
-	bool loop = 1; 
-	// copy the file into the buffer:
-	fseek ( pFile , 0 , SEEK_SET );
-	while (loop)
-	{
-		result = fread (reinterpret_cast<char*>(&buffer),datatypesize,1,pFile);
-		if ( result )
-		{
-			iter.Set(buffer);
-			++iter;
-		}
-		else
-		{	loop = 0;	}
-	}
-	fclose(pFile);
-
-	typedef itk::ExtractImageFilter< InputImageType, InputImageType > EIFType;
-	typename EIFType::Pointer filter = EIFType::New();
-
-	typename EIFType::InputImageRegionType::SizeType size; size[0] = roi[1]; size[1] = roi[3]; size[2] = roi[5];
-	typename EIFType::InputImageRegionType::IndexType index; index[0] = roi[0]; index[1] = roi[2]; index[2] = roi[4];
-	typename EIFType::InputImageRegionType region; region.SetIndex(index); region.SetSize(size);
-
-	filter->SetInput( itkimage );
-	filter->SetExtractionRegion(region);
-
-	filter->Update();
-
-	//change the output image information - offset change to zero
-	typename InputImageType::IndexType idx; idx.Fill(0);
-	typename InputImageType::PointType origin; origin.Fill(0);
-	typename InputImageType::SizeType outsize; outsize[0] = roi[1];	outsize[1] = roi[3];	outsize[2] = roi[5];
-	typename InputImageType::RegionType outreg;
-	outreg.SetIndex(idx); 
-	outreg.SetSize(outsize);
-	typename InputImageType::Pointer refimage = InputImageType::New();
-	refimage->SetRegions(outreg);
-	refimage->SetOrigin(origin);
-	refimage->SetSpacing(filter->GetOutput()->GetSpacing());
-	refimage->Allocate();
-
-	typedef itk::ChangeInformationImageFilter<InputImageType> CIIFType;
-	typename CIIFType::Pointer changefilter = CIIFType::New();
-	changefilter->SetInput(filter->GetOutput());
-	changefilter->UseReferenceImageOn();
-	changefilter->SetReferenceImage(refimage);
-	changefilter->SetChangeRegion(1);
-	changefilter->Update( );
-
-	m_roiconvertimage->SetImage( changefilter->GetOutput() );
-	m_roiconvertimage->Modified();
-
-	return EXIT_SUCCESS;
-}
-
-void dlg_datatypeconversion::DataTypeConversionROI(QString const & m_filename, double* b, double *roi)
-{
-	VTK_TYPED_CALL(DataTypeConversionROI_template, m_intype, m_filename, b, roi, &m_min, &m_max, &m_dis, m_roiconvertimage);
-	m_roiimage = m_roiconvertimage->GetVTKImage();
-}
-
 dlg_datatypeconversion::dlg_datatypeconversion(QWidget *parent, vtkImageData* input, const char* filename, int intype, double* b, double* c, double* inPara) : QDialog (parent)
 {
 	setupUi(this);
@@ -453,9 +212,7 @@ dlg_datatypeconversion::dlg_datatypeconversion(QWidget *parent, vtkImageData* in
 	m_testxyimage =  vtkImageData::New();
 	m_testxzimage =  vtkImageData::New();
 	m_testyzimage =  vtkImageData::New();
-	m_roiimage =  vtkImageData::New();
 
-	m_roiconvertimage = new iAConnector();
 	xyconvertimage = new iAConnector();
 	xzconvertimage = new iAConnector();
 	yzconvertimage = new iAConnector();
@@ -776,109 +533,38 @@ void dlg_datatypeconversion::xzprojectslices()
 	SetupSliceWidget(color, vtkWidgetXZ, xzroiSource);
 }
 
-template <typename T>
-void loadBinary(FILE* pFile, vtkImageData* imageData, float shift, float scale, double &minout, double &maxout)
-{
-	T buffer;
-	fseek(pFile, 0, SEEK_SET);
-	int* dims = imageData->GetDimensions();
-	for (int z = 0; z < dims[2]; z++)
-	{
-		for (int y = 0; y<dims[1]; y++)
-		{
-			for (int x = 0; x<dims[0]; x++)
-			{
-				size_t result = fread(reinterpret_cast<char*>(&buffer), sizeof(buffer), 1, pFile);
-				double value = buffer * scale + shift;
-				value = (value > maxout) ? maxout : value;
-				value = (value < minout) ? minout : value;
-				imageData->SetScalarComponentFromDouble(x, y, z, 0, value);
-			}
-		}
-	}
-}
-
 QString dlg_datatypeconversion::coreconversionfunction( QString filename, QString & finalfilename, double* para, int indatatype, int outdatatype, double minrange, double maxrange, double minout, double maxout, int check )
 {
-	float scale = 0;
-	//scale and shift calculator
-	if ( minrange != maxrange )
-	{   scale = ( maxout - minout ) / ( maxrange - minrange );	}
-	else if ( maxrange != 0 )
-	{	//m_Scale = ( maxout - minout ) / minrange );	
-	}
-	else
-	{
-		scale = 0.0;
-	}
-	float shift = ( minout - minrange ) * scale;
-	FILE * pFile;
-	pFile = fopen ( filename.toStdString().c_str(), "rb" );
-	if (pFile==NULL) {fputs ("File error",stderr); exit (1);}
-	vtkImageData* imageData = vtkImageData::New();
-	// Setup the image
-	imageData->SetDimensions(para[1], para[2], para[3]);
-	imageData->AllocateScalars(outdatatype, 1);
-	//loading of datatype 
-	VTK_TYPED_CALL(loadBinary, indatatype, pFile, imageData, shift, scale, minout, maxout);
-	fclose(pFile);
+	int dim[3] = { static_cast<int>(para[1]), static_cast<int>(para[2]), static_cast<int>(para[3]) };
+	iARawFileConverter rawFile(filename, dim, indatatype);
 	filename.chop(4);
 	filename.append("-DT.mhd");
-	vtkMetaImageWriter* metaImageWriter = vtkMetaImageWriter::New();
-	metaImageWriter->SetFileName(filename.toStdString().c_str());
-	metaImageWriter->SetInputData(imageData);
-	metaImageWriter->Write();
+	if (!rawFile.Convert(filename, para + 4, outdatatype, minrange, maxrange, minout, maxout))
+	{
+		DEBUG_LOG(QString("Data type conversion failed: %1").arg(rawFile.ErrorMessage()));
+		return QString();
+	}
 	finalfilename = filename;
 	return filename;
 }
 
 QString dlg_datatypeconversion::coreconversionfunctionforroi(QString filename, QString & finalfilename, double* para, int outdatatype, double minrange, double maxrange, double minout, double maxout, int check, double* roi)
 {
-
-	DataTypeConversionROI(filename, m_bptr, roi);
-	float m_Scale = 0;
-	//scale and shift calculator
-	if ( minrange != maxrange )
-	{   m_Scale = ( maxout - minout ) / ( maxrange - minrange );}
-	else if ( maxrange != 0 )
-	{	//m_Scale = ( maxout - minout ) / minrange );	
-	}
-	else
-	{	m_Scale = 0.0;	}
-
-	float m_Shift = ( minout - minrange ) * m_Scale;
-
-	FILE * pFile;
-	pFile = fopen( filename.toStdString().c_str(), "rb" );
-	if (pFile==NULL) {fputs ("File error",stderr); exit (1);}
-	fclose(pFile);
-
-	vtkImageData* imageData = vtkImageData::New();
-	// Setup the image
-	imageData->SetDimensions(roi[1], roi[3], roi[5]);
-	imageData->AllocateScalars(outdatatype, 1);
-	int* dims = imageData->GetDimensions();
-	for (int z=0; z<dims[2]; z++)
+	int dim[3] = { static_cast<int>(para[1]), static_cast<int>(para[2]), static_cast<int>(para[3]) };
+	int region[6];
+	for (int i = 0; i < 6; ++i)
 	{
-		for (int y=0; y<dims[1]; y++)
-		{
-			for (int x=0; x<dims[0]; x++)
-			{
-				double buffer = m_roiimage->GetScalarComponentAsDouble(x,y,z,0);
-				double value  =  buffer * m_Scale + m_Shift;
-				value = ( value > maxout ) ? maxout : value;
-				value = ( value < minout ) ? minout : value;
-				imageData->SetScalarComponentFromDouble(x,y,z,0,value);
-			}// for x
-		}// for y
-	}//for z
-
+		region[i] = static_cast<int>(roi[i]);
+	}
+	iARawFileConverter rawFile(filename, dim, m_intype);
 	filename.chop(4);
 	filename.append("-DT-roi.mhd");
-	vtkMetaImageWriter* metaImageWriter = vtkMetaImageWriter::New();
-	metaImageWriter->SetFileName(filename.toStdString().c_str());
-	metaImageWriter->SetInputData(imageData);
-	metaImageWriter->Write();
+	// only the slices (and rows) inside the region are read from the file
+	if (!rawFile.Convert(filename, para + 4, outdatatype, minrange, maxrange, minout, maxout, region))
+	{
+		DEBUG_LOG(QString("Data type conversion of region failed: %1").arg(rawFile.ErrorMessage()));
+		return QString();
+	}
 	finalfilename = filename;
 	return filename;
 }
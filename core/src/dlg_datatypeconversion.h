@@ -46,7 +46,6 @@ public:
 	~dlg_datatypeconversion();
 
 	void DataTypeConversion(QString const & m_filename, double* b);
-	void DataTypeConversionROI(QString const & m_filename, double* b, double *roi);
 	void histogramdrawing(iAPlotData::DataType* histbinlist, float min, float max, int m_bins, double discretization);
 
 	void xyprojectslices();
@@ -75,8 +74,6 @@ public:
 private:
 	QString text11;
 
-	iAConnector* m_roiconvertimage;
-
 	double * m_bptr;
 	int m_bins;
 	vtkImageData* imageData;
@@ -85,7 +82,7 @@ private:
 	QString m_filename;
 	iAPlotData::DataType * m_histbinlist;
 	float m_min, m_max, m_dis;
-	vtkImageData* m_testxyimage, * m_testxzimage, * m_testyzimage, * m_roiimage;
+	vtkImageData* m_testxyimage, * m_testxzimage, * m_testyzimage;
 	QVTKWidget2* vtkWidgetXY, *vtkWidgetXZ, *vtkWidgetYZ;
 
 	iAConnector* xyconvertimage, * xzconvertimage, * yzconvertimage;
@@ -103,8 +103,10 @@ dlg_volumePlayer::dlg_volumePlayer(QWidget *parent, iAVolumeStack* volumeStack)
 		connect(m_newWidget, SIGNAL(stateChanged(int)), this, SLOT(enableVolume(int)));
 		m_widgetList.insert(i, m_tempStr);
 		dataTable->setRowHeight(i, 17);
-		dataTable->setItem(i,m_dimColumn,new QTableWidgetItem(QString("%1").arg(volumeStack->getVolume(i)->GetDimensions()[0]).append(QString(", %1").arg(volumeStack->getVolume(i)->GetDimensions()[1]).append(QString(", %1").arg(volumeStack->getVolume(i)->GetDimensions()[2])))));
-		dataTable->setItem(i,m_spacColumn,new QTableWidgetItem(QString("%1").arg(volumeStack->getVolume(i)->GetSpacing()[0]).append(QString(", %1").arg(volumeStack->getVolume(i)->GetSpacing()[1]).append(QString(", %1").arg(volumeStack->getVolume(i)->GetSpacing()[2])))));
+		// volumes not in memory yet are loaded only when shown; don't load them just for this table:
+		vtkImageData* volume = volumeStack->isVolumeLoaded(i) ? volumeStack->getVolume(i).GetPointer() : nullptr;
+		dataTable->setItem(i,m_dimColumn,new QTableWidgetItem(!volume ? QString("-") : QString("%1").arg(volume->GetDimensions()[0]).append(QString(", %1").arg(volume->GetDimensions()[1]).append(QString(", %1").arg(volume->GetDimensions()[2])))));
+		dataTable->setItem(i,m_spacColumn,new QTableWidgetItem(!volume ? QString("-") : QString("%1").arg(volume->GetSpacing()[0]).append(QString(", %1").arg(volume->GetSpacing()[1]).append(QString(", %1").arg(volume->GetSpacing()[2])))));
 		dataTable->setItem(i,m_fileColumn,new QTableWidgetItem(volumeStack->getFileName(i)));
 		dataTable->setItem(i,m_sortColumn,new QTableWidgetItem(QString("%1").arg(0)));
 	}
@@ -5,12 +5,29 @@
 #include "iAConsole.h"
 #include "iAFilter.h"
 #include "iAFilterRegistry.h"
+#include "iAFrameExporter.h"
 #include "io/iAITKIO.h"
+#include "io/iARawFileConverter.h"
 #include "iAMathUtility.h"
 #include "iAModuleDispatcher.h"
+#include "iAMovieHelper.h"
 #include "iAProgress.h"
 #include "iAStringHelper.h"
+#include "iAToolsVTK.h"
+#include "iATransferFunction.h"
 #include "iAValueType.h"
+#include "iAVolumeRenderer.h"
+
+#include <vtkCamera.h>
+#include <vtkColorTransferFunction.h>
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkImageMapToColors.h>
+#include <vtkImageReslice.h>
+#include <vtkPiecewiseFunction.h>
+#include <vtkRenderer.h>
+#include <vtkRenderWindow.h>
+#include <vtkWindowToImageFilter.h>
 
 #include <QFileInfo>
 #include <QTextStream>
@@ -125,7 +142,7 @@ namespace
 	void PrintUsage()
 	{
 		std::cout << "open_iA command line tool. Usage:" << std::endl
-			<< "  open_iA_cmd [-l] [-h ...] [-r ...]" << std::endl
+			<< "  open_iA_cmd [-l] [-h ...] [-r ...] [-p ...] [-t ...] [-v ...]" << std::endl
 			<< "     -l" << std::endl
 			<< "         List available filters" << std::endl
 			<< "     -h FilterName" << std::endl
@@ -136,7 +153,23 @@ namespace
 			<< "           -c   compress output" << std::endl
 			<< "           -f   overwrite output if it exists" << std::endl
 			<< "     -p FilterName" << std::endl
-			<< "         Output the Parameter Descriptor for the given filter (required for sampling)." << std::endl;
+			<< "         Output the Parameter Descriptor for the given filter (required for sampling)." << std::endl
+			<< "     -t Input -o Output -d DimX DimY DimZ -it InputType -ot OutputType [-s SpacingX SpacingY SpacingZ]" << std::endl
+			<< "        [-r RangeMin RangeMax] [-m OutputMin OutputMax] [-roi X SizeX Y SizeY Z SizeZ] [-q] [-f]" << std::endl
+			<< "         Convert the raw image file Input to another data type, write to Output (.mhd)." << std::endl
+			<< "         Data types are given as VTK type names, e.g. VTK_UNSIGNED_CHAR, VTK_FLOAT." << std::endl
+			<< "           -r   input range mapped linearly to the output range (default: value range of the input)" << std::endl
+			<< "           -m   output range; values outside are clamped (default: range of the output type)" << std::endl
+			<< "           -roi only convert the given region (origin and size per axis)" << std::endl
+			<< "     -v Input -o Output [-m turntable|slices] [-a x|y|z] [-n Frames] [-s Width Height] [-c Quality] [-q] [-f]" << std::endl
+			<< "         Render a video of the image Input without a window, write to Output." << std::endl
+			<< "         Output is either a movie (" << GetAvailableMovieFormats().toStdString() << ") or an image file;" << std::endl
+			<< "         for an image file, the frame number is appended to the file name of each frame." << std::endl
+			<< "           -m   turntable: volume rendering rotating around the axis (default); slices: sweep through all slices along the axis" << std::endl
+			<< "           -a   axis of rotation or slicing (default: z)" << std::endl
+			<< "           -n   number of frames of a turntable video (default: 360)" << std::endl
+			<< "           -s   size of the turntable rendering (default: 800 600); slices have the size of the image" << std::endl
+			<< "           -c   movie quality, 0..2 (default: 2)" << std::endl;
 	}
 
 	enum ParseMode { None, Input, Output, Parameter, InvalidParameter, Quiet, Compress, Overwrite};
@@ -326,6 +359,289 @@ namespace
 			return 1;
 		}
 	}
+
+	//! collect the values following each of the given options in args (starting at index 1, args[0] is the input)
+	//! \return false if an unknown option or a wrong number of values for an option was given
+	bool ParseOptions(QStringList const & args, QStringList const & options, int const * expectedCount,
+		QMap<QString, QStringList> & values)
+	{
+		QString curOption;
+		for (int a = 1; a < args.size(); ++a)
+		{
+			if (options.contains(args[a]))
+			{
+				curOption = args[a];
+				values.insert(curOption, QStringList());
+			}
+			else if (curOption.isEmpty())
+			{
+				std::cout << QString("Invalid/Unexpected parameter: '%1', please check your syntax!").arg(args[a]).toStdString() << std::endl;
+				return false;
+			}
+			else
+			{
+				values[curOption] << args[a];
+			}
+		}
+		for (int o = 0; o < options.size(); ++o)
+		{
+			if (values.contains(options[o]) && values[options[o]].size() != expectedCount[o])
+			{
+				std::cout << QString("Option %1 expects %2 value(s), %3 were given.").arg(options[o])
+					.arg(expectedCount[o]).arg(values[options[o]].size()).toStdString() << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	int ConvertRawDataType(QStringList const & args)
+	{
+		QString inputFile = args[0];
+		QStringList options = QStringList() << "-o" << "-d" << "-it" << "-ot" << "-s" << "-r" << "-m" << "-roi" << "-q" << "-f";
+		int const expectedCount[] = { 1, 3, 1, 1, 3, 2, 2, 6, 0, 0 };
+		QMap<QString, QStringList> values;
+		if (!ParseOptions(args, options, expectedCount, values))
+		{
+			return 1;
+		}
+		if (!values.contains("-o") || !values.contains("-d") || !values.contains("-it") || !values.contains("-ot"))
+		{
+			std::cout << "Missing parameters - output file (-o), dimensions (-d), input (-it) and output type (-ot) are required" << std::endl;
+			return 1;
+		}
+		QString outputFile = values["-o"][0];
+		bool quiet = values.contains("-q");
+		QStringList outputFiles = QStringList() << outputFile << iARawFileConverter::OutputRawFileName(outputFile);
+		for (QString const & fileName : outputFiles)
+		{
+			if (QFileInfo(fileName).exists() && QFileInfo(fileName) == QFileInfo(inputFile))
+			{
+				std::cout << QString("Output file '%1' is the input file! Aborting.").arg(fileName).toStdString() << std::endl;
+				return 1;
+			}
+			if (QFile(fileName).exists() && !values.contains("-f"))
+			{
+				std::cout << QString("Output file '%1' already exists! Aborting. "
+					"Specify -f to overwrite existing files.").arg(fileName).toStdString() << std::endl;
+				return 1;
+			}
+		}
+		int inType = MapVTKTypeStringToInt(values["-it"][0]);
+		int outType = MapVTKTypeStringToInt(values["-ot"][0]);
+		if (inType == -1 || outType == -1)
+		{
+			std::cout << "Invalid data type; expected a VTK type name such as VTK_UNSIGNED_CHAR or VTK_FLOAT" << std::endl;
+			return 1;
+		}
+		int dim[3];
+		double spacing[3] = { 1.0, 1.0, 1.0 };
+		int roi[6];
+		for (int i = 0; i < 3; ++i)
+		{
+			dim[i] = values["-d"][i].toInt();
+			if (values.contains("-s"))
+			{
+				spacing[i] = values["-s"][i].toDouble();
+			}
+		}
+		for (int i = 0; i < 6 && values.contains("-roi"); ++i)
+		{
+			roi[i] = values["-roi"][i].toInt();
+		}
+		iARawFileConverter converter(inputFile, dim, inType);
+		double rangeMin, rangeMax;
+		if (values.contains("-r"))
+		{
+			rangeMin = values["-r"][0].toDouble();
+			rangeMax = values["-r"][1].toDouble();
+		}
+		else
+		{
+			if (!quiet)
+			{
+				std::cout << "Determining value range of '" << inputFile.toStdString() << "'" << std::endl;
+			}
+			iACommandLineProgressIndicator rangeProgressIndicator(50, quiet);
+			converter.SetProgressCallback([&rangeProgressIndicator](int percent) { rangeProgressIndicator.Progress(percent); });
+			if (!converter.ComputeRange(rangeMin, rangeMax))
+			{
+				std::cout << "ERROR: " << converter.ErrorMessage().toStdString() << std::endl;
+				return 1;
+			}
+		}
+		double outMin = values.contains("-m") ? values["-m"][0].toDouble() : vtkDataArray::GetDataTypeMin(outType);
+		double outMax = values.contains("-m") ? values["-m"][1].toDouble() : vtkDataArray::GetDataTypeMax(outType);
+		if (!quiet)
+		{
+			std::cout << QString("Converting '%1' (range %2..%3) to '%4' (range %5..%6)")
+				.arg(inputFile).arg(rangeMin).arg(rangeMax).arg(outputFile).arg(outMin).arg(outMax).toStdString() << std::endl;
+		}
+		iACommandLineProgressIndicator convertProgressIndicator(50, quiet);
+		converter.SetProgressCallback([&convertProgressIndicator](int percent) { convertProgressIndicator.Progress(percent); });
+		if (!converter.Convert(outputFile, spacing, outType, rangeMin, rangeMax, outMin, outMax, values.contains("-roi") ? roi : nullptr))
+		{
+			std::cout << "ERROR: " << converter.ErrorMessage().toStdString() << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+	int ExportVideo(QStringList const & args)
+	{
+		QString inputFile = args[0];
+		QStringList options = QStringList() << "-o" << "-m" << "-a" << "-n" << "-s" << "-c" << "-q" << "-f";
+		int const expectedCount[] = { 1, 1, 1, 1, 2, 1, 0, 0 };
+		QMap<QString, QStringList> values;
+		if (!ParseOptions(args, options, expectedCount, values))
+		{
+			return 1;
+		}
+		if (!values.contains("-o"))
+		{
+			std::cout << "Missing parameters - output file (-o) is required" << std::endl;
+			return 1;
+		}
+		QString outputFile = values["-o"][0];
+		bool quiet = values.contains("-q");
+		QString mode = values.contains("-m") ? values["-m"][0] : "turntable";
+		QString axisName = values.contains("-a") ? values["-a"][0].toLower() : "z";
+		int axis = axisName == "x" ? 0 : axisName == "y" ? 1 : axisName == "z" ? 2 : -1;
+		int size[2] = { 800, 600 };
+		if (values.contains("-s"))
+		{
+			size[0] = values["-s"][0].toInt();
+			size[1] = values["-s"][1].toInt();
+		}
+		int frameCount = values.contains("-n") ? values["-n"][0].toInt() : 360;
+		int quality = values.contains("-c") ? values["-c"][0].toInt() : 2;
+		if ((mode != "turntable" && mode != "slices") || axis == -1 || frameCount < 1 || size[0] < 2 || size[1] < 2)
+		{
+			std::cout << "Invalid parameters - mode (-m) has to be 'turntable' or 'slices', axis (-a) one of x, y or z, "
+				"frame count (-n) and size (-s) positive" << std::endl;
+			return 1;
+		}
+		if (iAFrameExporter::OutputExists(outputFile) && !values.contains("-f"))
+		{
+			std::cout << QString("Output file '%1'%2 already exists! Aborting. "
+				"Specify -f to overwrite existing files.").arg(outputFile)
+				.arg(iAFrameExporter::IsMovieFile(outputFile) ? "" : " (or a frame file of it)").toStdString() << std::endl;
+			return 1;
+		}
+		try
+		{
+			if (!quiet)
+			{
+				std::cout << "Reading input file '" << inputFile.toStdString() << "'" << std::endl;
+			}
+			iAITKIO::ScalarPixelType pixelType;
+			iAITKIO::ImagePointer itkImg = iAITKIO::readFile(inputFile, pixelType, false);
+			iAConnector con;
+			con.SetImage(itkImg);
+			vtkSmartPointer<vtkImageData> img = con.GetVTKImage();
+			double range[2];
+			img->GetScalarRange(range);
+			auto ctf = GetDefaultColorTransferFunction(range);
+			auto otf = GetDefaultPiecewiseFunction(range, false);
+
+			iAFrameExporter exporter(outputFile, quality);
+			if (!exporter.Start())
+			{
+				std::cout << "ERROR: " << exporter.ErrorMessage().toStdString() << std::endl;
+				return 1;
+			}
+			if (!quiet)
+			{
+				std::cout << QString("Exporting %1 along %2 axis to '%3'").arg(mode).arg(axisName).arg(outputFile).toStdString() << std::endl;
+			}
+			iACommandLineProgressIndicator progressIndicator(50, quiet);
+			if (mode == "turntable")
+			{
+				// movie encoders expect even frame sizes
+				size[0] += size[0] % 2;
+				size[1] += size[1] % 2;
+				auto renWin = vtkSmartPointer<vtkRenderWindow>::New();
+				renWin->OffScreenRenderingOn();
+				renWin->SetSize(size);
+				auto ren = vtkSmartPointer<vtkRenderer>::New();
+				ren->SetBackground(1, 1, 1);
+				renWin->AddRenderer(ren);
+				iASimpleTransferFunction transfer(ctf, otf);
+				iAVolumeRenderer volRen(&transfer, img);
+				volRen.AddTo(ren);
+				// rotate around the chosen axis, looking at the volume from the side:
+				double viewUp[3] = { 0, 0, 0 };
+				viewUp[axis] = 1;
+				double position[3] = { 0, 0, 0 };
+				position[(axis + 1) % 3] = -1;
+				vtkCamera* cam = ren->GetActiveCamera();
+				cam->SetFocalPoint(0, 0, 0);
+				cam->SetPosition(position);
+				cam->SetViewUp(viewUp);
+				ren->ResetCamera();
+				auto w2if = vtkSmartPointer<vtkWindowToImageFilter>::New();
+				w2if->SetInput(renWin);
+				w2if->ReadFrontBufferOff();
+				for (int f = 0; f < frameCount; ++f)
+				{
+					renWin->Render();
+					w2if->Modified();
+					w2if->Update();
+					if (!exporter.Add(w2if->GetOutput(), f))
+						break;
+					progressIndicator.Progress(100 * (f + 1) / frameCount);
+					cam->Azimuth(360.0 / frameCount);
+				}
+			}
+			else
+			{
+				// one slice per frame, resampled perpendicular to the chosen axis and mapped through the color transfer function
+				int xAxis = axis == 0 ? 1 : 0;
+				int yAxis = axis == 2 ? 1 : 2;
+				int const * dim = img->GetDimensions();
+				double const * spacing = img->GetSpacing();
+				double const * origin = img->GetOrigin();
+				double axes[9] = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+				axes[xAxis] = 1;
+				axes[3 + yAxis] = 1;
+				axes[6 + axis] = 1;
+				auto reslicer = vtkSmartPointer<vtkImageReslice>::New();
+				reslicer->SetInputData(img);
+				reslicer->SetOutputDimensionality(2);
+				reslicer->SetResliceAxesDirectionCosines(axes);
+				reslicer->SetOutputOrigin(0, 0, 0);
+				reslicer->SetOutputSpacing(spacing[xAxis], spacing[yAxis], 1);
+				// movie encoders expect even frame sizes
+				reslicer->SetOutputExtent(0, dim[xAxis] + dim[xAxis] % 2 - 1, 0, dim[yAxis] + dim[yAxis] % 2 - 1, 0, 0);
+				reslicer->SetBackgroundLevel(range[0]);
+				auto colorMapper = vtkSmartPointer<vtkImageMapToColors>::New();
+				colorMapper->SetInputConnection(reslicer->GetOutputPort());
+				colorMapper->SetLookupTable(ctf);
+				colorMapper->SetOutputFormatToRGB();
+				frameCount = dim[axis];
+				for (int f = 0; f < frameCount; ++f)
+				{
+					double sliceOrigin[3] = { origin[0], origin[1], origin[2] };
+					sliceOrigin[axis] += f * spacing[axis];
+					reslicer->SetResliceAxesOrigin(sliceOrigin);
+					colorMapper->Update();
+					if (!exporter.Add(colorMapper->GetOutput(), f))
+						break;
+					progressIndicator.Progress(100 * (f + 1) / frameCount);
+				}
+			}
+			if (!exporter.Finish())
+			{
+				std::cout << "ERROR: " << exporter.ErrorMessage().toStdString() << std::endl;
+				return 1;
+			}
+			return 0;
+		}
+		catch (std::exception & e)
+		{
+			std::cout << "ERROR: " << e.what() << std::endl;
+			return 1;
+		}
+	}
 }
 
 int ProcessCommandLine(int argc, char const * const * argv)
@@ -353,6 +669,24 @@ int ProcessCommandLine(int argc, char const * const * argv)
 	{
 		PrintParameterDescriptor(argv[2]);
 	}
+	else if (argc > 2 && QString(argv[1]) == "-t")
+	{
+		QStringList args;
+		for (int a = 2; a < argc; ++a)
+		{
+			args << argv[a];
+		}
+		return ConvertRawDataType(args);
+	}
+	else if (argc > 2 && QString(argv[1]) == "-v")
+	{
+		QStringList args;
+		for (int a = 2; a < argc; ++a)
+		{
+			args << argv[a];
+		}
+		return ExportVideo(args);
+	}
 	else
 	{
 		PrintUsage();
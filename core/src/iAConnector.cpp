@@ -24,10 +24,14 @@
 #include "iAConnector.h"
 #include "iAExtendedTypedCallHelper.h"
 #include "iAToolsITK.h"
+#include "iATypedCallHelper.h"
 
+#include <vtkDataArray.h>
 #include <vtkImageData.h>
 #include <vtkImageExport.h>
 #include <vtkImageImport.h>
+#include <vtkPointData.h>
+#include <vtkVersion.h>
 
 #include <itkVTKImageImport.h>
 #include <itkVTKImageExport.h>
@@ -119,6 +123,22 @@ void SetupPipelineITKtoVTK(
 	importer->Update();
 }
 
+/**
+* Makes the pixel container of the given ITK image give up ownership of its
+* buffer, if it currently owns it (which is the case if it was allocated by ITK).
+* \param imageBase the image whose buffer should be released
+* \param released set to true if the buffer is released, false otherwise
+*/
+template <class T>
+void ReleasePixelContainer(iAConnector::ImagePointer & imageBase, bool & released)
+{
+	typedef itk::Image< T, 3 > ImageType;
+	ImageType * image = dynamic_cast<ImageType *>(imageBase.GetPointer());
+	released = image && image->GetPixelContainer()->GetContainerManageMemory();
+	if (released)
+		image->GetPixelContainer()->SetContainerManageMemory(false);
+}
+
 iAConnector::iAConnector() :
 	m_ITKImage(ImageBaseType::New()),
 	m_VTKImage(vtkSmartPointer<vtkImageData>::New()),
@@ -126,6 +146,7 @@ iAConnector::iAConnector() :
 	m_isTypeInitialized(false),
 	m_itkPixelType( itk::ImageIOBase::UNKNOWNPIXELTYPE ),
 	m_isPixelTypeInitialized( false ),
+	m_vtkOwnsData( false ),
 	m_vtkImporter(vtkSmartPointer<vtkImageImport>::New()),
 	m_vtkExporter(vtkSmartPointer<vtkImageExport>::New())
 {}
@@ -140,6 +161,7 @@ void iAConnector::SetImage( ImageBaseType * image )
 	if( this->m_ITKImage.GetPointer() == image )
 		return;
 	m_ITKImage = image;
+	m_vtkOwnsData = false;
 	UpdateImageVTK();
 }
 
@@ -157,6 +179,7 @@ void iAConnector::SetImage(vtkSmartPointer<vtkImageData> imageData)
 	if (m_VTKImage == imageData)
 		return;
 	m_VTKImage = imageData;
+	m_vtkOwnsData = true;
 	UpdateImageITK();
 }
 
@@ -180,6 +203,44 @@ iAConnector::ImageBaseType* iAConnector::GetITKImage() const
 	return m_ITKImage;
 }
 
+void iAConnector::TransferVTKImage(vtkImageData* target)
+{
+	target->ReleaseData();
+	target->Initialize();
+	vtkDataArray* scalars = m_VTKImage->GetPointData()->GetScalars();
+	bool shareBuffer = m_vtkOwnsData;
+#if (VTK_MAJOR_VERSION > 7 || (VTK_MAJOR_VERSION == 7 && VTK_MINOR_VERSION > 0))
+	// the VTK image only references the buffer of the ITK image; for scalar images,
+	// this buffer was allocated with new[], so the VTK array can take it over:
+	if (!shareBuffer && scalars && GetITKPixelType() == itk::ImageIOBase::SCALAR)
+	{
+		ITK_TYPED_CALL(ReleasePixelContainer, GetITKScalarPixelType(), m_ITKImage, shareBuffer);
+		if (shareBuffer)
+		{
+			scalars->SetVoidArray(scalars->GetVoidPointer(0),
+				scalars->GetNumberOfTuples() * scalars->GetNumberOfComponents(),
+				0, vtkAbstractArray::VTK_DATA_ARRAY_DELETE);
+		}
+	}
+#endif
+	if (shareBuffer)
+		target->ShallowCopy(m_VTKImage);
+	else
+		target->DeepCopy(m_VTKImage);
+	target->CopyInformationFromPipeline(m_VTKImage->GetInformation());
+
+	// drop all references to the image (and the pipelines which might still hold it):
+	m_itkImporter = 0;
+	m_itkExporter = 0;
+	m_vtkImporter = vtkSmartPointer<vtkImageImport>::New();
+	m_vtkExporter = vtkSmartPointer<vtkImageExport>::New();
+	m_ITKImage = ImageBaseType::New();
+	m_VTKImage = vtkSmartPointer<vtkImageData>::New();
+	m_vtkOwnsData = false;
+	m_isTypeInitialized = false;
+	m_isPixelTypeInitialized = false;
+}
+
 void iAConnector::UpdateScalarType()
 {
 	m_isTypeInitialized = true;
@@ -57,6 +57,12 @@ public:
 	vtkSmartPointer<vtkImageData> GetVTKImage() const;
 	ImageBaseType* GetITKImage() const;
 
+	/** Hands the VTK image over to the given target image and resets this connector.
+	 *  Wherever possible, the pixel buffer is not copied; instead, ownership of the
+	 *  buffer is passed on to target, so that the image is only held in memory once.
+	 *  Afterwards, this connector holds an empty image. */
+	void TransferVTKImage(vtkImageData* target);
+
 	// -Helper methods
 	ITKScalarPixelType GetITKScalarPixelType();
 	ITKPixelType GetITKPixelType();
@@ -76,6 +82,7 @@ protected:
 	bool m_isTypeInitialized;
 	ITKPixelType m_itkPixelType;
 	bool m_isPixelTypeInitialized;
+	bool m_vtkOwnsData; //!< whether the pixel buffer is owned by the VTK image (true) or the ITK image (false)
 
 	ProcessObjectPointer m_itkImporter;//itk::VTKImageImport
 	ProcessObjectPointer m_itkExporter;//itk::VTKImageExport
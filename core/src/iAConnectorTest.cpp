@@ -0,0 +1,101 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#include "iAConnector.h"
+
+#include "iASimpleTester.h"
+
+#include <itkImage.h>
+
+#include <vtkImageData.h>
+#include <vtkVersion.h>
+
+#ifdef _MSC_VER
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+//! peak resident set size of the current process, in bytes
+size_t PeakRSS()
+{
+#ifdef _MSC_VER
+	PROCESS_MEMORY_COUNTERS info;
+	GetProcessMemoryInfo(GetCurrentProcess(), &info, sizeof(info));
+	return static_cast<size_t>(info.PeakWorkingSetSize);
+#else
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+	return static_cast<size_t>(usage.ru_maxrss);
+#else
+	return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+BEGIN_TEST
+	typedef itk::Image<unsigned short, 3> ImageType;
+	const int Size[3] = { 256, 256, 512 };
+	const size_t ImageBytes = static_cast<size_t>(Size[0]) * Size[1] * Size[2] * sizeof(unsigned short);
+
+	size_t peakBefore = PeakRSS();
+	void * itkBuffer = 0;
+	vtkSmartPointer<vtkImageData> target = vtkSmartPointer<vtkImageData>::New();
+	{
+		ImageType::Pointer image = ImageType::New();
+		ImageType::RegionType region;
+		region.SetSize(0, Size[0]);
+		region.SetSize(1, Size[1]);
+		region.SetSize(2, Size[2]);
+		image->SetRegions(region);
+		image->Allocate();
+		image->FillBuffer(42);
+		itkBuffer = image->GetBufferPointer();
+		iAConnector con;
+		con.SetImage(image);
+		con.Modified();
+		con.TransferVTKImage(target);
+	}
+	// the ITK image is gone now, the data has to survive in target:
+	TestEqual(Size[0] * Size[1] * Size[2], static_cast<int>(target->GetNumberOfPoints()));
+	TestEqualFloatingPoint(42.0, target->GetScalarComponentAsDouble(Size[0] - 1, Size[1] - 1, Size[2] - 1, 0));
+#if (VTK_MAJOR_VERSION > 7 || (VTK_MAJOR_VERSION == 7 && VTK_MINOR_VERSION > 0))
+	TestAssert(target->GetScalarPointer() == itkBuffer);
+	// loading must not need more memory than the image itself (plus some tolerance):
+	size_t peakAfter = PeakRSS();
+	TestAssert(peakAfter - peakBefore < ImageBytes * 3 / 2);
+#endif
+
+	// image which was set as VTK image is passed on as well:
+	vtkSmartPointer<vtkImageData> vtkSource = vtkSmartPointer<vtkImageData>::New();
+	vtkSource->SetExtent(0, 9, 0, 9, 0, 9);
+	vtkSource->AllocateScalars(VTK_FLOAT, 1);
+	void * vtkBuffer = vtkSource->GetScalarPointer();
+	iAConnector con;
+	con.SetImage(vtkSource);
+	con.Modified();
+	vtkSmartPointer<vtkImageData> target2 = vtkSmartPointer<vtkImageData>::New();
+	con.TransferVTKImage(target2);
+	TestAssert(target2->GetScalarPointer() == vtkBuffer);
+END_TEST
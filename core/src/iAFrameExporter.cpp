@@ -0,0 +1,235 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#include "pch.h"
+#include "iAFrameExporter.h"
+
+#include "iAMovieHelper.h"
+#include "iAToolsVTK.h"
+
+#include <vtkGenericMovieWriter.h>
+#include <vtkImageData.h>
+
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QThread>
+
+#include <algorithm>
+
+class iAFrameExporter::WriterThread : public QThread
+{
+public:
+	WriterThread(iAFrameExporter* exporter) : m_exporter(exporter) {}
+private:
+	void run() override
+	{
+		Frame frame;
+		while (m_exporter->TakeFrame(frame))
+			m_exporter->WriteFrame(frame);
+	}
+	iAFrameExporter* m_exporter;
+};
+
+
+iAFrameExporter::iAFrameExporter(QString const & fileName, int quality, int queueSize) :
+	m_fileName(fileName),
+	m_quality(quality),
+	m_queueSize(std::max(1, queueSize)),
+	m_isMovie(IsMovieFile(fileName)),
+	m_movieStarted(false),
+	m_finishing(false),
+	m_failed(false)
+{}
+
+
+iAFrameExporter::~iAFrameExporter()
+{
+	Finish();
+}
+
+
+void iAFrameExporter::SetFrameProcessor(FrameProcessor processor)
+{
+	m_processor = processor;
+}
+
+
+bool iAFrameExporter::IsMovieFile(QString const & fileName)
+{
+	QString suffix = QFileInfo(fileName).suffix().toLower();
+	return suffix == "ogv" || suffix == "avi";
+}
+
+
+QString iAFrameExporter::FrameFileName(QString const & fileName, int frameNumber)
+{
+	QFileInfo fi(fileName);
+	return QString("%1/%2%3.%4").arg(fi.absolutePath()).arg(fi.completeBaseName())
+		.arg(frameNumber).arg(fi.suffix());
+}
+
+
+bool iAFrameExporter::OutputExists(QString const & fileName)
+{
+	if (IsMovieFile(fileName))
+		return QFileInfo(fileName).exists();
+	QFileInfo fi(fileName);
+	QString baseName = fi.completeBaseName();
+	QStringList candidates = QDir(fi.absolutePath()).entryList(
+		QStringList() << QString("%1*.%2").arg(baseName).arg(fi.suffix()), QDir::Files);
+	for (QString const & candidate : candidates)
+	{
+		bool isNumber;
+		QString frameNumber = QFileInfo(candidate).completeBaseName().mid(baseName.length());
+		frameNumber.toInt(&isNumber);
+		if (isNumber)
+			return true;
+	}
+	return false;
+}
+
+
+bool iAFrameExporter::Start()
+{
+	int threadCount = 1;
+	if (m_isMovie)
+	{
+		m_movieWriter = GetMovieWriter(m_fileName, m_quality);
+		if (!m_movieWriter)
+		{
+			m_errorMessage = "Movie export not available for the given file type!";
+			m_failed = true;
+			return false;
+		}
+		m_movieWriter->SetFileName(m_fileName.toLatin1().constData());
+	}
+	else
+	{
+		// image files are independent of each other, so compress several at once;
+		// leave one core to the thread producing the frames
+		threadCount = std::max(1, QThread::idealThreadCount() - 1);
+	}
+	m_finishing = false;
+	for (int i = 0; i < threadCount; ++i)
+	{
+		auto thread = new WriterThread(this);
+		m_threads.push_back(thread);
+		thread->start();
+	}
+	return true;
+}
+
+
+bool iAFrameExporter::Add(vtkImageData* frame, int frameNumber)
+{
+	auto copy = vtkSmartPointer<vtkImageData>::New();
+	copy->DeepCopy(frame);
+	if (m_isMovie && !m_movieStarted)
+	{
+		// Start() needs an input to determine the frame size, and some encoders
+		// show a dialog there, so it has to be called from the producing thread:
+		if (m_failed)
+			return false;
+		m_movieWriter->SetInputData(m_processor ? m_processor(copy) : copy);
+		m_movieWriter->Start();
+		m_movieStarted = true;
+	}
+	QMutexLocker locker(&m_mutex);
+	while (m_queue.size() >= m_queueSize && !m_failed)
+		m_frameTaken.wait(&m_mutex);
+	if (m_failed)
+		return false;
+	m_queue.enqueue(Frame(frameNumber, copy));
+	m_frameAdded.wakeOne();
+	return true;
+}
+
+
+bool iAFrameExporter::TakeFrame(Frame & frame)
+{
+	QMutexLocker locker(&m_mutex);
+	while (m_queue.isEmpty() && !m_finishing && !m_failed)
+		m_frameAdded.wait(&m_mutex);
+	if (m_queue.isEmpty() || m_failed)
+		return false;
+	frame = m_queue.dequeue();
+	m_frameTaken.wakeOne();
+	return true;
+}
+
+
+void iAFrameExporter::WriteFrame(Frame const & frame)
+{
+	vtkSmartPointer<vtkImageData> image = m_processor ? m_processor(frame.second) : frame.second;
+	if (m_isMovie)
+	{
+		m_movieWriter->SetInputData(image);
+		m_movieWriter->Write();
+		if (m_movieWriter->GetError())
+			SetError(QString("Error while encoding frame %1 of the movie!").arg(frame.first));
+	}
+	else
+	{
+		QString fileName = FrameFileName(m_fileName, frame.first);
+		if (!WriteSingleSliceImage(fileName, image))
+			SetError(QString("Could not write image file %1!").arg(fileName));
+	}
+}
+
+
+void iAFrameExporter::SetError(QString const & msg)
+{
+	QMutexLocker locker(&m_mutex);
+	if (!m_failed)
+		m_errorMessage = msg;
+	m_failed = true;
+	m_frameAdded.wakeAll();
+	m_frameTaken.wakeAll();
+}
+
+
+bool iAFrameExporter::Finish()
+{
+	{
+		QMutexLocker locker(&m_mutex);
+		m_finishing = true;
+		m_frameAdded.wakeAll();
+	}
+	for (auto thread : m_threads)
+	{
+		thread->wait();
+		delete thread;
+	}
+	m_threads.clear();
+	if (m_movieStarted)
+	{
+		m_movieWriter->End();
+		m_movieStarted = false;
+	}
+	m_queue.clear();
+	return !m_failed;
+}
+
+
+QString const & iAFrameExporter::ErrorMessage() const
+{
+	return m_errorMessage;
+}
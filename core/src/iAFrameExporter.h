@@ -0,0 +1,100 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#pragma once
+
+#include "open_iA_Core_export.h"
+
+#include <vtkSmartPointer.h>
+
+#include <QMutex>
+#include <QPair>
+#include <QQueue>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <functional>
+
+class vtkGenericMovieWriter;
+class vtkImageData;
+
+class QThread;
+
+//! Pipelined export of a sequence of frames to a movie or an image stack.
+//! The frames are produced (rendered and read back) by the caller on the thread owning the
+//! render window; Add() only copies them into a bounded queue and returns. The encoding of
+//! the movie (in order, on one thread) or the compression and writing of the image files (on
+//! several threads) happens in the background, while the caller already renders the next frames.
+class open_iA_Core_API iAFrameExporter
+{
+public:
+	//! processing applied to each frame on the background threads before it is written
+	typedef std::function<vtkSmartPointer<vtkImageData>(vtkSmartPointer<vtkImageData>)> FrameProcessor;
+
+	//! \param fileName either a movie file (see GetAvailableMovieFormats) or an image file;
+	//!     for an image stack, the frame number is appended to the base name of each file
+	//! \param quality the movie quality (0..2), ignored for image stacks
+	//! \param queueSize maximum number of frames waiting to be written; Add() blocks while the queue is full
+	iAFrameExporter(QString const & fileName, int quality = 2, int queueSize = 8);
+	//! waits for all queued frames to be written (see Finish)
+	~iAFrameExporter();
+	//! set a processing step applied to each frame on the writer threads (e.g. intensity rescaling)
+	void SetFrameProcessor(FrameProcessor processor);
+	//! start the writer threads
+	//! \return false if no writer is available for the type of the given file
+	bool Start();
+	//! queue a copy of the given frame for writing
+	//! \param frameNumber appended to the file name of the frame when writing an image stack
+	//! \return false if writing one of the previous frames has failed
+	bool Add(vtkImageData* frame, int frameNumber);
+	//! wait until all frames are written and close the output
+	//! \return true if all frames were written successfully
+	bool Finish();
+	QString const & ErrorMessage() const;
+	//! whether the given file name refers to a movie (as opposed to an image file)
+	static bool IsMovieFile(QString const & fileName);
+	//! whether writing to the given file would overwrite an existing file;
+	//! for an image stack, whether any frame file of that name exists
+	static bool OutputExists(QString const & fileName);
+private:
+	class WriterThread;
+	typedef QPair<int, vtkSmartPointer<vtkImageData> > Frame;
+	static QString FrameFileName(QString const & fileName, int frameNumber);
+	bool TakeFrame(Frame & frame);
+	void WriteFrame(Frame const & frame);
+	void SetError(QString const & msg);
+
+	QString m_fileName;
+	int m_quality;
+	int m_queueSize;
+	bool m_isMovie;
+	bool m_movieStarted;
+	bool m_finishing;
+	std::atomic<bool> m_failed;
+	vtkSmartPointer<vtkGenericMovieWriter> m_movieWriter;
+	FrameProcessor m_processor;
+	QVector<QThread*> m_threads;
+	QQueue<Frame> m_queue;
+	QMutex m_mutex;
+	QWaitCondition m_frameAdded, m_frameTaken;
+	QString m_errorMessage;
+};
@@ -25,31 +25,67 @@
 #include "iAToolsITK.h" // for GetITKScalarPixelType
 
 
-// TODO: check why this function is delivering bogus results for larger images!
+#include <algorithm>
+#include <unordered_set>
+
+namespace
+{
+	//! number of voxels processed by one thread at a time
+	const long long ChunkSize = 1 << 16;
+
+	long long VoxelCount(iAITKIO::ImagePointer img)
+	{
+		auto size = img->GetLargestPossibleRegion().GetSize();
+		return static_cast<long long>(size[0]) * size[1] * size[2];
+	}
+
+	int ChunkCount(long long voxelCount)
+	{
+		return static_cast<int>((voxelCount + ChunkSize - 1) / ChunkSize);
+	}
+
+	bool SameSize(iAITKIO::ImagePointer img, iAITKIO::ImagePointer ref)
+	{
+		if (img->GetLargestPossibleRegion().GetSize() != ref->GetLargestPossibleRegion().GetSize())
+		{
+			DEBUG_LOG("Image comparison: The sizes of the images to be compared differ!");
+			return false;
+		}
+		return true;
+	}
+}
+
 template <typename T>
 void compareImg_tmpl(iAITKIO::ImagePointer imgB, iAITKIO::ImagePointer refB, iAImageComparisonResult & result)
 {
 	typedef itk::Image<T, iAITKIO::m_DIM > ImgType;
 	ImgType * img = dynamic_cast<ImgType*>(imgB.GetPointer());
 	ImgType * ref = dynamic_cast<ImgType*>(refB.GetPointer());
+	result.equalPixelRate = 0;
 	if (!img || !ref)
 	{
 		DEBUG_LOG("compareImg_tmpl: One of the images to be compared is NULL!");
-		result.equalPixelRate = 0;
 		return;
 	}
-	typename ImgType::RegionType reg = ref->GetLargestPossibleRegion();
-	double size = reg.GetSize()[0] * reg.GetSize()[1] * reg.GetSize()[2];
-	double sumEqual = 0.0;
+	if (!SameSize(imgB, refB))
+	{
+		return;
+	}
+	long long const size = VoxelCount(refB);
+	T const * imgBuf = img->GetBufferPointer();
+	T const * refBuf = ref->GetBufferPointer();
+	int const chunks = ChunkCount(size);
+	long long sumEqual = 0;
 #pragma omp parallel for reduction(+:sumEqual)
-	for (int i = 0; i < size; ++i)
+	for (int c = 0; c < chunks; ++c)
 	{
-		if (img->GetBufferPointer()[i] == ref->GetBufferPointer()[i])
+		long long const end = std::min(size, (c + 1) * ChunkSize);
+		for (long long i = c * ChunkSize; i < end; ++i)
 		{
-			++sumEqual;
+			sumEqual += (imgBuf[i] == refBuf[i]) ? 1 : 0;
 		}
 	}
-	result.equalPixelRate = sumEqual / size;
+	result.equalPixelRate = (size > 0) ? static_cast<double>(sumEqual) / size : 0;
 }
 
 iAImageComparisonResult CompareImages(iAITKIO::ImagePointer img, iAITKIO::ImagePointer reference)
@@ -58,3 +94,395 @@ iAImageComparisonResult CompareImages(iAITKIO::ImagePointer img, iAITKIO::ImageP
 	ITK_TYPED_CALL(compareImg_tmpl, GetITKScalarPixelType(img), img, reference, result);
 	return result;
 }
+
+
+iAConfusionMatrix::iAConfusionMatrix(int labelCount) :
+	m_labelCount(std::max(0, labelCount))
+{
+	Init();
+}
+
+iAConfusionMatrix::iAConfusionMatrix(std::vector<long long> const & labels) :
+	m_labelCount(static_cast<int>(labels.size())),
+	m_labels(labels)
+{
+	Init();
+}
+
+void iAConfusionMatrix::Init()
+{
+	m_sparse = m_labelCount > MaxDenseLabelCount;
+	if (m_sparse)
+	{
+		m_labelTotals.resize(m_labelCount, 0);
+		m_refTotals.resize(m_labelCount, 0);
+	}
+	else
+	{
+		m_counts.resize(static_cast<size_t>(m_labelCount) * m_labelCount, 0);
+	}
+	m_outside = 0;
+	m_ignored = 0;
+}
+
+int iAConfusionMatrix::LabelCount() const
+{
+	return m_labelCount;
+}
+
+long long iAConfusionMatrix::Label(int index) const
+{
+	return m_labels.empty() ? index : m_labels[index];
+}
+
+long long iAConfusionMatrix::Count(int label, int refLabel) const
+{
+	if (m_sparse)
+	{
+		auto it = m_entries.find(static_cast<long long>(label) * m_labelCount + refLabel);
+		return (it != m_entries.end()) ? it->second : 0;
+	}
+	return m_counts[static_cast<size_t>(label) * m_labelCount + refLabel];
+}
+
+long long iAConfusionMatrix::LabelTotal(int label) const
+{
+	if (m_sparse)
+	{
+		return m_labelTotals[label];
+	}
+	long long sum = 0;
+	for (int r = 0; r < m_labelCount; ++r)
+	{
+		sum += Count(label, r);
+	}
+	return sum;
+}
+
+long long iAConfusionMatrix::RefTotal(int refLabel) const
+{
+	if (m_sparse)
+	{
+		return m_refTotals[refLabel];
+	}
+	long long sum = 0;
+	for (int l = 0; l < m_labelCount; ++l)
+	{
+		sum += Count(l, refLabel);
+	}
+	return sum;
+}
+
+long long iAConfusionMatrix::Total() const
+{
+	long long sum = 0;
+	for (long long count : (m_sparse ? m_labelTotals : m_counts))
+	{
+		sum += count;
+	}
+	return sum;
+}
+
+long long iAConfusionMatrix::Matching() const
+{
+	long long sum = 0;
+	for (int l = 0; l < m_labelCount; ++l)
+	{
+		sum += Count(l, l);
+	}
+	return sum;
+}
+
+long long iAConfusionMatrix::OutsideCount() const
+{
+	return m_outside;
+}
+
+long long iAConfusionMatrix::IgnoredCount() const
+{
+	return m_ignored;
+}
+
+namespace
+{
+	double Ratio(long long numerator, long long denominator)
+	{
+		return (denominator == 0) ? 0.0 : static_cast<double>(numerator) / denominator;
+	}
+}
+
+double iAConfusionMatrix::EqualPixelRate() const
+{
+	return Ratio(Matching(), Total() + m_outside);
+}
+
+double iAConfusionMatrix::Dice(int label) const
+{
+	return Ratio(2 * Count(label, label), LabelTotal(label) + RefTotal(label));
+}
+
+double iAConfusionMatrix::Jaccard(int label) const
+{
+	return Ratio(Count(label, label), LabelTotal(label) + RefTotal(label) - Count(label, label));
+}
+
+double iAConfusionMatrix::Dice() const
+{
+	long long intersection = 0, sizes = 0;
+	for (int l = 0; l < m_labelCount; ++l)
+	{
+		if (Label(l) == 0)
+		{
+			continue;
+		}
+		intersection += Count(l, l);
+		sizes += LabelTotal(l) + RefTotal(l);
+	}
+	return Ratio(2 * intersection, sizes);
+}
+
+double iAConfusionMatrix::Jaccard() const
+{
+	long long intersection = 0, unions = 0;
+	for (int l = 0; l < m_labelCount; ++l)
+	{
+		if (Label(l) == 0)
+		{
+			continue;
+		}
+		intersection += Count(l, l);
+		unions += LabelTotal(l) + RefTotal(l) - Count(l, l);
+	}
+	return Ratio(intersection, unions);
+}
+
+double iAConfusionMatrix::Kappa() const
+{
+	long long const total = Total();
+	if (total == 0)
+	{
+		return 0;
+	}
+	double const observed = Ratio(Matching(), total);
+	double chance = 0;
+	for (int l = 0; l < m_labelCount; ++l)
+	{
+		chance += (static_cast<double>(LabelTotal(l)) / total) * (static_cast<double>(RefTotal(l)) / total);
+	}
+	return (chance < 1) ? (observed - chance) / (1 - chance) : 1.0;
+}
+
+double iAConfusionMatrix::Precision(int label) const
+{
+	return Ratio(Count(label, label), LabelTotal(label));
+}
+
+double iAConfusionMatrix::Recall(int label) const
+{
+	return Ratio(Count(label, label), RefTotal(label));
+}
+
+double iAConfusionMatrix::MeanPrecision() const
+{
+	double sum = 0;
+	for (int l = 0; l < m_labelCount; ++l)
+	{
+		sum += Precision(l);
+	}
+	return (m_labelCount > 0) ? sum / m_labelCount : 0;
+}
+
+double iAConfusionMatrix::MeanRecall() const
+{
+	double sum = 0;
+	for (int l = 0; l < m_labelCount; ++l)
+	{
+		sum += Recall(l);
+	}
+	return (m_labelCount > 0) ? sum / m_labelCount : 0;
+}
+
+double iAConfusionMatrix::FalsePositiveError(int label) const
+{
+	return Ratio(LabelTotal(label) - Count(label, label), RefTotal(label));
+}
+
+double iAConfusionMatrix::FalseNegativeError(int label) const
+{
+	return Ratio(RefTotal(label) - Count(label, label), RefTotal(label));
+}
+
+void iAConfusionMatrix::Add(iAConfusionMatrix const & other)
+{
+	for (size_t i = 0; i < m_counts.size(); ++i)
+	{
+		m_counts[i] += other.m_counts[i];
+	}
+	for (auto const & entry : other.m_entries)
+	{
+		m_entries[entry.first] += entry.second;
+	}
+	for (size_t i = 0; i < m_labelTotals.size(); ++i)
+	{
+		m_labelTotals[i] += other.m_labelTotals[i];
+		m_refTotals[i] += other.m_refTotals[i];
+	}
+	m_outside += other.m_outside;
+	m_ignored += other.m_ignored;
+}
+
+
+template <typename T>
+void maxLabel_tmpl(iAITKIO::ImagePointer imgB, iAITKIO::ImagePointer refB, long long & maxLabel)
+{
+	typedef itk::Image<T, iAITKIO::m_DIM > ImgType;
+	ImgType * img = dynamic_cast<ImgType*>(imgB.GetPointer());
+	ImgType * ref = dynamic_cast<ImgType*>(refB.GetPointer());
+	if (!img || !ref)
+	{
+		return;
+	}
+	long long const size = VoxelCount(refB);
+	T const * imgBuf = img->GetBufferPointer();
+	T const * refBuf = ref->GetBufferPointer();
+	int const chunks = ChunkCount(size);
+	std::vector<long long> chunkMax(chunks, -1);
+#pragma omp parallel for
+	for (int c = 0; c < chunks; ++c)
+	{
+		long long const end = std::min(size, (c + 1) * ChunkSize);
+		T curMax = std::max(imgBuf[c * ChunkSize], refBuf[c * ChunkSize]);
+		for (long long i = c * ChunkSize; i < end; ++i)
+		{
+			curMax = (imgBuf[i] > curMax) ? imgBuf[i] : curMax;
+			curMax = (refBuf[i] > curMax) ? refBuf[i] : curMax;
+		}
+		chunkMax[c] = static_cast<long long>(curMax);
+	}
+	for (long long m : chunkMax)
+	{
+		maxLabel = std::max(maxLabel, m);
+	}
+}
+
+template <typename T>
+void labelValues_tmpl(iAITKIO::ImagePointer imgB, iAITKIO::ImagePointer refB, std::vector<long long> & labels)
+{
+	typedef itk::Image<T, iAITKIO::m_DIM > ImgType;
+	ImgType * img = dynamic_cast<ImgType*>(imgB.GetPointer());
+	ImgType * ref = dynamic_cast<ImgType*>(refB.GetPointer());
+	if (!img || !ref)
+	{
+		return;
+	}
+	long long const size = VoxelCount(refB);
+	T const * bufs[2] = { img->GetBufferPointer(), ref->GetBufferPointer() };
+	int const chunks = ChunkCount(size);
+	std::unordered_set<long long> allLabels;
+#pragma omp parallel
+	{
+		std::unordered_set<long long> threadLabels;
+#pragma omp for
+		for (int c = 0; c < chunks; ++c)
+		{
+			long long const end = std::min(size, (c + 1) * ChunkSize);
+			for (T const * buf : bufs)
+			{
+				long long last = -1;
+				for (long long i = c * ChunkSize; i < end; ++i)
+				{
+					long long label = static_cast<long long>(buf[i]);
+					if (label != last && label >= 0)	// labels typically come in runs; negative labels are never valid
+					{
+						threadLabels.insert(label);
+						last = label;
+					}
+				}
+			}
+		}
+#pragma omp critical
+		allLabels.insert(threadLabels.begin(), threadLabels.end());
+	}
+	labels.assign(allLabels.begin(), allLabels.end());
+	std::sort(labels.begin(), labels.end());
+}
+
+template <typename T>
+void confusionMatrix_tmpl(iAITKIO::ImagePointer imgB, iAITKIO::ImagePointer refB, bool binary, iAConfusionMatrix & result)
+{
+	typedef itk::Image<T, iAITKIO::m_DIM > ImgType;
+	ImgType * img = dynamic_cast<ImgType*>(imgB.GetPointer());
+	ImgType * ref = dynamic_cast<ImgType*>(refB.GetPointer());
+	if (!img || !ref)
+	{
+		DEBUG_LOG("Confusion matrix: One of the images to be compared is NULL or their types differ!");
+		return;
+	}
+	long long const size = VoxelCount(refB);
+	T const * imgBuf = img->GetBufferPointer();
+	T const * refBuf = ref->GetBufferPointer();
+	int const chunks = ChunkCount(size);
+	iAConfusionMatrix const empty(result);
+#pragma omp parallel
+	{
+		// each thread counts into its own matrix; they are summed up at the end
+		iAConfusionMatrix threadResult(empty);
+#pragma omp for
+		for (int c = 0; c < chunks; ++c)
+		{
+			long long const end = std::min(size, (c + 1) * ChunkSize);
+			if (binary)
+			{
+				for (long long i = c * ChunkSize; i < end; ++i)
+				{
+					threadResult.Increment(imgBuf[i] != 0, refBuf[i] != 0);
+				}
+			}
+			else
+			{
+				for (long long i = c * ChunkSize; i < end; ++i)
+				{
+					threadResult.Increment(static_cast<long long>(imgBuf[i]), static_cast<long long>(refBuf[i]));
+				}
+			}
+		}
+#pragma omp critical
+		result.Add(threadResult);
+	}
+}
+
+iAConfusionMatrix ComputeConfusionMatrix(iAITKIO::ImagePointer img, iAITKIO::ImagePointer reference, int labelCount)
+{
+	if (!img || !reference || !SameSize(img, reference))
+	{
+		return iAConfusionMatrix();
+	}
+	if (labelCount <= 0)
+	{
+		long long maxLabel = -1;
+		ITK_TYPED_CALL(maxLabel_tmpl, GetITKScalarPixelType(img), img, reference, maxLabel);
+		if (maxLabel >= iAConfusionMatrix::MaxDenseLabelCount)
+		{
+			// large label values (e.g. individually labeled objects): only use the labels that occur
+			std::vector<long long> labels;
+			ITK_TYPED_CALL(labelValues_tmpl, GetITKScalarPixelType(img), img, reference, labels);
+			iAConfusionMatrix result(labels);
+			ITK_TYPED_CALL(confusionMatrix_tmpl, GetITKScalarPixelType(img), img, reference, false, result);
+			return result;
+		}
+		labelCount = static_cast<int>(maxLabel + 1);
+	}
+	iAConfusionMatrix result(labelCount);
+	ITK_TYPED_CALL(confusionMatrix_tmpl, GetITKScalarPixelType(img), img, reference, false, result);
+	return result;
+}
+
+iAConfusionMatrix ComputeBinaryConfusionMatrix(iAITKIO::ImagePointer img, iAITKIO::ImagePointer reference)
+{
+	iAConfusionMatrix result(2);
+	if (img && reference && SameSize(img, reference))
+	{
+		ITK_TYPED_CALL(confusionMatrix_tmpl, GetITKScalarPixelType(img), img, reference, true, result);
+	}
+	return result;
+}
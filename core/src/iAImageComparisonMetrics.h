@@ -24,6 +24,10 @@
 #include "io/iAITKIO.h" // for image type
 #include "open_iA_Core_export.h"
 
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
 struct open_iA_Core_API iAImageComparisonResult
 {
 	// double dice;
@@ -32,3 +36,116 @@ struct open_iA_Core_API iAImageComparisonResult
 
 
 open_iA_Core_API iAImageComparisonResult CompareImages(iAITKIO::ImagePointer img, iAITKIO::ImagePointer reference);
+
+//! Confusion matrix of a label image and a reference label image.
+//! Entry (l, r) holds the number of voxels with the label of index l in the image and the label of index r in the reference.
+//! The labels are either the values 0..labelCount-1 (index and label are the same), or a given list of label values,
+//! for example only those that actually occur in images with large label values; all methods taking a label
+//! expect its index. Up to MaxDenseLabelCount labels, all entries are stored; for more labels, only the non-zero ones.
+//! All overlap measures are derived from it; voxel counts are 64 bit, so images of any size are supported.
+class open_iA_Core_API iAConfusionMatrix
+{
+public:
+	//! maximum number of labels for which the full matrix is stored (it is held once per thread while counting)
+	static const int MaxDenseLabelCount = 1024;
+	explicit iAConfusionMatrix(int labelCount = 0);
+	//! matrix over the given label values, which need to be sorted ascending and unique
+	explicit iAConfusionMatrix(std::vector<long long> const & labels);
+	int LabelCount() const;
+	//! the label value at the given index
+	long long Label(int index) const;
+	//! the index of the given label value, -1 if it is not one of the labels of this matrix
+	int Index(long long label) const
+	{
+		if (m_labels.empty())
+		{
+			return (label >= 0 && label < m_labelCount) ? static_cast<int>(label) : -1;
+		}
+		auto it = std::lower_bound(m_labels.begin(), m_labels.end(), label);
+		return (it != m_labels.end() && *it == label) ? static_cast<int>(it - m_labels.begin()) : -1;
+	}
+	long long Count(int label, int refLabel) const;
+	//! number of voxels with the given label in the image (and a valid label in the reference)
+	long long LabelTotal(int label) const;
+	//! number of voxels with the given label in the reference (and a valid label in the image)
+	long long RefTotal(int refLabel) const;
+	//! number of voxels with valid labels in both images
+	long long Total() const;
+	//! number of voxels with the same label in both images
+	long long Matching() const;
+	//! number of voxels with a label not in this matrix in the image (but valid in the reference)
+	long long OutsideCount() const;
+	//! number of voxels with a label not in this matrix in the reference (e.g. "undecided" voxels); not counted anywhere else
+	long long IgnoredCount() const;
+
+	//! ratio of voxels with the same label in both images (overall accuracy);
+	//! voxels with an invalid label in the image count as mismatches (denominator is Total() + OutsideCount())
+	double EqualPixelRate() const;
+	double Dice(int label) const;
+	double Jaccard(int label) const;
+	//! Dice coefficient over all labels except 0 (same as the "mean overlap" of itk::LabelOverlapMeasuresImageFilter)
+	double Dice() const;
+	//! Jaccard index over all labels except 0 (same as the "union overlap" of itk::LabelOverlapMeasuresImageFilter)
+	double Jaccard() const;
+	//! Cohen's kappa
+	double Kappa() const;
+	//! ratio of voxels labeled as label in the image that have this label in the reference
+	double Precision(int label) const;
+	//! ratio of voxels labeled as label in the reference that have this label in the image
+	double Recall(int label) const;
+	double MeanPrecision() const;
+	double MeanRecall() const;
+	//! voxels wrongly labeled as label, relative to the reference size of label
+	double FalsePositiveError(int label) const;
+	//! voxels of label in the reference missed in the image, relative to the reference size of label
+	double FalseNegativeError(int label) const;
+
+	//! add the counts of a matrix over the same labels
+	void Add(iAConfusionMatrix const & other);
+	//! increment the entry for the given label values; labels not in this matrix are counted as outside / ignored
+	void Increment(long long label, long long refLabel)
+	{
+		int const refIndex = Index(refLabel);
+		if (refIndex < 0)
+		{
+			++m_ignored;
+			return;
+		}
+		int const index = Index(label);
+		if (index < 0)
+		{
+			++m_outside;
+		}
+		else if (m_sparse)
+		{
+			++m_entries[static_cast<long long>(index) * m_labelCount + refIndex];
+			++m_labelTotals[index];
+			++m_refTotals[refIndex];
+		}
+		else
+		{
+			++m_counts[static_cast<size_t>(index) * m_labelCount + refIndex];
+		}
+	}
+private:
+	void Init();
+	int m_labelCount;
+	std::vector<long long> m_labels;	//!< the label value for each index; empty if they are the same
+	bool m_sparse;						//!< whether only the non-zero entries are stored
+	std::vector<long long> m_counts;	//!< all entries, row by row (if not sparse)
+	std::unordered_map<long long, long long> m_entries;	//!< non-zero entries by (label * labelCount + refLabel) (if sparse)
+	std::vector<long long> m_labelTotals, m_refTotals;	//!< row and column sums (if sparse)
+	long long m_outside;
+	long long m_ignored;
+};
+
+//! Compute the confusion matrix of a label image and a reference in a single, parallel pass.
+//! Both images need to have the same size and pixel type.
+//! \param labelCount the number of labels (values 0..labelCount-1); if <= 0, it is set to
+//!     the largest label occurring in the two images plus one (requires one additional pass);
+//!     if that is more than iAConfusionMatrix::MaxDenseLabelCount, the matrix is instead built over
+//!     the labels actually occurring in the two images (requires another pass)
+open_iA_Core_API iAConfusionMatrix ComputeConfusionMatrix(iAITKIO::ImagePointer img, iAITKIO::ImagePointer reference, int labelCount = 0);
+
+//! Compute the confusion matrix of two binary masks (label 0: value 0, label 1: any other value).
+open_iA_Core_API iAConfusionMatrix ComputeBinaryConfusionMatrix(iAITKIO::ImagePointer img, iAITKIO::ImagePointer reference);
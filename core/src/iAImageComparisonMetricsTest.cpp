@@ -0,0 +1,111 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#include "iAImageComparisonMetrics.h"
+
+#include "iASimpleTester.h"
+
+#include <itkImage.h>
+
+#include <vector>
+
+typedef itk::Image<int, 3> LabelImageType;
+
+LabelImageType::Pointer CreateLabelImage(std::vector<int> const & labels)
+{
+	LabelImageType::Pointer image = LabelImageType::New();
+	LabelImageType::RegionType region;
+	region.SetSize(0, labels.size());
+	region.SetSize(1, 1);
+	region.SetSize(2, 1);
+	image->SetRegions(region);
+	image->Allocate();
+	std::copy(labels.begin(), labels.end(), image->GetBufferPointer());
+	return image;
+}
+
+BEGIN_TEST
+	// hand-computed example with 3 labels (rows: image, columns: reference):
+	//        ref 0  ref 1  ref 2
+	// img 0    3      0      0
+	// img 1    0      3      1
+	// img 2    1      1      1
+	std::vector<int> const img = { 0, 0, 1, 1, 1, 2, 2, 0, 1, 2 };
+	std::vector<int> const ref = { 0, 0, 1, 1, 2, 2, 0, 0, 1, 1 };
+	iAConfusionMatrix m(3);
+	for (size_t i = 0; i < img.size(); ++i)
+	{
+		m.Increment(img[i], ref[i]);
+	}
+	TestEqual(3LL, m.Count(2, 0) + m.Count(2, 1) + m.Count(2, 2));
+	TestEqual(10LL, m.Total());
+	TestEqual(7LL, m.Matching());
+	TestEqualFloatingPoint(0.7, m.EqualPixelRate());
+	TestEqualFloatingPoint(2.0 * 3 / (4 + 4), m.Dice(1));
+	TestEqualFloatingPoint(2.0 * 1 / (3 + 2), m.Dice(2));
+	TestEqualFloatingPoint(2.0 * (3 + 1) / (8 + 5), m.Dice());
+	// chance agreement (3*4 + 4*4 + 3*2) / 100 = 0.34; kappa = (0.7 - 0.34) / (1 - 0.34)
+	TestEqualFloatingPoint(6.0 / 11, m.Kappa());
+
+	// an invalid label in the image counts as mismatch, an invalid one in the reference is ignored
+	m.Increment(5, 1);
+	m.Increment(1, -1);
+	TestEqual(1LL, m.OutsideCount());
+	TestEqual(1LL, m.IgnoredCount());
+	TestEqualFloatingPoint(7.0 / 11, m.EqualPixelRate());
+	TestEqualFloatingPoint(6.0 / 11, m.Kappa());
+
+	// computed from images, with automatically determined label count
+	iAConfusionMatrix fromImages = ComputeConfusionMatrix(CreateLabelImage(img).GetPointer(), CreateLabelImage(ref).GetPointer());
+	TestEqual(3, fromImages.LabelCount());
+	TestEqualFloatingPoint(0.7, fromImages.EqualPixelRate());
+	TestEqualFloatingPoint(6.0 / 11, fromImages.Kappa());
+
+	// large label values: the matrix is built over the labels occurring in the images
+	std::vector<int> const labelValues = { 0, 5000, 70000 };
+	std::vector<int> bigImg, bigRef;
+	for (size_t i = 0; i < img.size(); ++i)
+	{
+		bigImg.push_back(labelValues[img[i]]);
+		bigRef.push_back(labelValues[ref[i]]);
+	}
+	iAConfusionMatrix compact = ComputeConfusionMatrix(CreateLabelImage(bigImg).GetPointer(), CreateLabelImage(bigRef).GetPointer());
+	TestEqual(3, compact.LabelCount());
+	TestEqual(70000LL, compact.Label(2));
+	TestEqual(1, compact.Index(5000));
+	TestEqualFloatingPoint(0.7, compact.EqualPixelRate());
+	TestEqualFloatingPoint(2.0 * (3 + 1) / (8 + 5), compact.Dice());
+	TestEqualFloatingPoint(6.0 / 11, compact.Kappa());
+
+	// more labels than are stored densely: every voxel has its own label, the image misses half of them
+	int const manyLabels = 3 * iAConfusionMatrix::MaxDenseLabelCount;
+	std::vector<int> manyImg, manyRef;
+	for (int i = 0; i < manyLabels; ++i)
+	{
+		manyRef.push_back(i + 1);
+		manyImg.push_back((i % 2 == 0) ? i + 1 : 0);
+	}
+	iAConfusionMatrix sparse = ComputeConfusionMatrix(CreateLabelImage(manyImg).GetPointer(), CreateLabelImage(manyRef).GetPointer());
+	TestEqual(manyLabels + 1, sparse.LabelCount());
+	TestEqual(static_cast<long long>(manyLabels), sparse.Total());
+	TestEqualFloatingPoint(0.5, sparse.EqualPixelRate());
+	// Dice over labels != 0: intersection manyLabels/2, image sizes manyLabels/2, reference sizes manyLabels
+	TestEqualFloatingPoint(2.0 * (manyLabels / 2) / (manyLabels / 2 + manyLabels), sparse.Dice());
+END_TEST
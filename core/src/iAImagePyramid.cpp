@@ -0,0 +1,158 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#include "pch.h"
+#include "iAImagePyramid.h"
+
+#include "iAConsole.h"
+#include "iAToolsVTK.h"
+
+#include <vtkImageData.h>
+#include <vtkImageShrink3D.h>
+
+#include <QDir>
+#include <QFileInfo>
+
+namespace
+{
+	const int ShrinkFactor = 2;
+}
+
+iAImagePyramid::iAImagePyramid(vtkSmartPointer<vtkImageData> image, QString const & fileName):
+	m_source(image),
+	m_fileName(fileName),
+	m_sourceMTime(image->GetMTime())
+{
+	// the shrink filter would otherwise connect to the image the GUI is working on
+	auto copy = vtkSmartPointer<vtkImageData>::New();
+	copy->ShallowCopy(image);
+	m_levels.push_back(copy);
+}
+
+bool iAImagePyramid::IsBuiltFrom(vtkImageData* image) const
+{
+	return image && image == m_source.GetPointer() && image->GetMTime() == m_sourceMTime;
+}
+
+QString iAImagePyramid::CacheFileName(int level) const
+{
+	return m_fileName + ".pyramid/level" + QString::number(level) + ".mhd";
+}
+
+bool iAImagePyramid::LoadFromCache(int level)
+{
+	if (m_fileName.isEmpty())
+		return false;
+	QFileInfo source(m_fileName);
+	QFileInfo cache(CacheFileName(level));
+	if (!source.exists() || !cache.exists() || cache.lastModified() < source.lastModified())
+		return false;
+	try
+	{
+		vtkSmartPointer<vtkImageData> img = ReadImage(cache.absoluteFilePath(), false);
+		int const * prevDim = m_levels[level - 1]->GetDimensions();
+		int const * dim = img->GetDimensions();
+		if (img->GetScalarType() != m_levels[0]->GetScalarType())
+			return false;
+		for (int i = 0; i < 3; ++i)
+			if (dim[i] != std::max(1, prevDim[i] / ShrinkFactor))
+				return false;
+		m_levels.push_back(img);
+		return true;
+	}
+	catch (std::exception & e)
+	{
+		DEBUG_LOG(QString("Could not read cached pyramid level %1: %2").arg(level).arg(e.what()));
+		return false;
+	}
+}
+
+void iAImagePyramid::Build()
+{
+	bool writeCache = !m_fileName.isEmpty() && QFileInfo(m_fileName).exists() &&
+		QDir().mkpath(m_fileName + ".pyramid");
+	for (int level = 1; level <= DownsampledLevels; ++level)
+	{
+		int const * prevDim = m_levels[level - 1]->GetDimensions();
+		if (prevDim[0] < ShrinkFactor && prevDim[1] < ShrinkFactor && prevDim[2] < ShrinkFactor)
+			break;
+		if (LoadFromCache(level))
+			continue;
+		auto shrink = vtkSmartPointer<vtkImageShrink3D>::New();
+		shrink->SetInputData(m_levels[level - 1]);
+		shrink->SetShrinkFactors(
+			prevDim[0] < ShrinkFactor ? 1 : ShrinkFactor,
+			prevDim[1] < ShrinkFactor ? 1 : ShrinkFactor,
+			prevDim[2] < ShrinkFactor ? 1 : ShrinkFactor);
+		shrink->AveragingOn();
+		shrink->Update();
+		vtkSmartPointer<vtkImageData> img = vtkSmartPointer<vtkImageData>::New();
+		img->ShallowCopy(shrink->GetOutput());
+		m_levels.push_back(img);
+		if (writeCache)
+		{
+			try
+			{
+				StoreImage(img, CacheFileName(level), false);
+			}
+			catch (std::exception & e)
+			{
+				DEBUG_LOG(QString("Could not store pyramid level %1: %2").arg(level).arg(e.what()));
+				writeCache = false;
+			}
+		}
+	}
+}
+
+int iAImagePyramid::LevelCount() const
+{
+	return static_cast<int>(m_levels.size());
+}
+
+vtkSmartPointer<vtkImageData> iAImagePyramid::Level(int level) const
+{
+	return m_levels[level];
+}
+
+vtkSmartPointer<vtkImageData> iAImagePyramid::LevelForVoxelCount(vtkIdType maxVoxels) const
+{
+	for (size_t level = 1; level < m_levels.size(); ++level)
+	{
+		if (m_levels[level]->GetNumberOfPoints() <= maxVoxels || level == m_levels.size() - 1)
+			return m_levels[level];
+	}
+	return vtkSmartPointer<vtkImageData>();
+}
+
+
+iAImagePyramidBuilder::iAImagePyramidBuilder(QSharedPointer<iAImagePyramid> pyramid):
+	m_pyramid(pyramid)
+{}
+
+QSharedPointer<iAImagePyramid> iAImagePyramidBuilder::Pyramid() const
+{
+	return m_pyramid;
+}
+
+void iAImagePyramidBuilder::run()
+{
+	m_pyramid->Build();
+	emit PyramidReady();
+}
@@ -0,0 +1,89 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#pragma once
+
+#include "open_iA_Core_export.h"
+
+#include <vtkSmartPointer.h>
+#include <vtkType.h>
+#include <vtkVersion.h>
+
+#include <QSharedPointer>
+#include <QString>
+#include <QThread>
+
+#include <vector>
+
+class vtkImageData;
+
+#if !(VTK_MAJOR_VERSION > 7 || (VTK_MAJOR_VERSION == 7 && VTK_MINOR_VERSION > 0))
+typedef unsigned long vtkMTimeType;
+#endif
+
+//! A multi-resolution representation of an image: level 0 is a shallow copy of the image,
+//! each further level is downsampled by a factor of 2 (by averaging) in each dimension.
+//! Optionally, the downsampled levels are cached in a sidecar folder next to the image
+//! file ("<filename>.pyramid"), so that they only need to be computed once.
+class open_iA_Core_API iAImagePyramid
+{
+public:
+	//! number of voxels which can be resliced/rendered fast enough during interaction
+	static const vtkIdType InteractionVoxelCount = 256 * 256 * 256;
+	//! the number of downsampled levels (2x, 4x, 8x)
+	static const int DownsampledLevels = 3;
+
+	//! create a pyramid for the given image; call from the thread owning the image,
+	//! Build only accesses the shallow copy taken here and can run in any thread
+	//! @param fileName the file the image was loaded from, used for the cache; pass an empty string to disable caching
+	iAImagePyramid(vtkSmartPointer<vtkImageData> image, QString const & fileName);
+	//! load the downsampled levels from cache if available, otherwise compute (and cache) them
+	void Build();
+	//! whether the pyramid was built from the given image in its current state
+	bool IsBuiltFrom(vtkImageData* image) const;
+	//! number of levels currently available (including the full resolution level 0)
+	int LevelCount() const;
+	//! retrieve the level with the given index (0 = full resolution)
+	vtkSmartPointer<vtkImageData> Level(int level) const;
+	//! the finest downsampled level with at most the given number of voxels;
+	//! the coarsest level if none is small enough, null if no downsampled level is available
+	vtkSmartPointer<vtkImageData> LevelForVoxelCount(vtkIdType maxVoxels) const;
+private:
+	QString CacheFileName(int level) const;
+	bool LoadFromCache(int level);
+	std::vector<vtkSmartPointer<vtkImageData> > m_levels;
+	vtkSmartPointer<vtkImageData> m_source;
+	QString m_fileName;
+	vtkMTimeType m_sourceMTime;
+};
+
+//! Builds an image pyramid in the background
+class iAImagePyramidBuilder : public QThread
+{
+	Q_OBJECT
+public:
+	iAImagePyramidBuilder(QSharedPointer<iAImagePyramid> pyramid);
+	QSharedPointer<iAImagePyramid> Pyramid() const;
+signals:
+	void PyramidReady();
+private:
+	void run() override;
+	QSharedPointer<iAImagePyramid> m_pyramid;
+};
@@ -104,6 +104,44 @@ size_t getCurrentRSS( )
 #endif
 }
 
+size_t getAvailablePhysicalMemory()
+{
+#if defined(_WIN32)
+	MEMORYSTATUSEX status;
+	status.dwLength = sizeof(status);
+	if (!GlobalMemoryStatusEx(&status))
+		return 0;
+	return (size_t)status.ullAvailPhys;
+
+#elif defined(__APPLE__) && defined(__MACH__)
+	vm_statistics64_data_t stats;
+	mach_msg_type_number_t count = HOST_VM_INFO64_COUNT;
+	if (host_statistics64(mach_host_self(), HOST_VM_INFO64, (host_info64_t)&stats, &count) != KERN_SUCCESS)
+		return 0;
+	// inactive pages can be reclaimed without swapping
+	return (size_t)(stats.free_count + stats.inactive_count) * (size_t)sysconf(_SC_PAGESIZE);
+
+#elif defined(__linux__) || defined(__linux) || defined(linux) || defined(__gnu_linux__)
+	// MemAvailable includes the page cache that can be dropped; fall back to the free pages on older kernels
+	FILE* fp = fopen("/proc/meminfo", "r");
+	if (fp)
+	{
+		char line[256];
+		unsigned long long kB = 0;
+		bool found = false;
+		while (!found && fgets(line, sizeof(line), fp))
+			found = sscanf(line, "MemAvailable: %llu kB", &kB) == 1;
+		fclose(fp);
+		if (found)
+			return (size_t)(kB * 1024);
+	}
+	return (size_t)sysconf(_SC_AVPHYS_PAGES) * (size_t)sysconf(_SC_PAGESIZE);
+
+#else
+	return (size_t)0L;          /* Unsupported. */
+#endif
+}
+
 // class iAPerformanceTimer
 
 class iAPerfTimerImpl
@@ -132,6 +132,10 @@ private:
 //! @return the number of bytes currently in use by the application
 size_t getCurrentRSS();
 
+//! Helper method for getting the physical memory currently available to applications
+//! @return the number of bytes available, or 0 if it cannot be determined on this OS
+open_iA_Core_API size_t getAvailablePhysicalMemory();
+
 //! format the given time in a human-readable format
 //! @param duration the time to format (in seconds)
 open_iA_Core_API QString formatDuration(double duration);
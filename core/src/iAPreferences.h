@@ -30,7 +30,9 @@ public:
 		MagicLensSize,
 		MagicLensFrameWidth;
 	bool Compression,
-		ResultInNewWindow;
+		ResultInNewWindow,
+		MemoryMappedLoading,
+		ImagePyramidCache;
 		//LogToFile;
 	iAPreferences():
 		HistogramBins(DefaultHistogramBins),
@@ -38,6 +40,8 @@ public:
 		MagicLensSize(DefaultMagicLensSize),
 		MagicLensFrameWidth(3),
 		Compression(true),
-		ResultInNewWindow(true)
+		ResultInNewWindow(true),
+		MemoryMappedLoading(false),
+		ImagePyramidCache(false)
 	{}
 };
\ No newline at end of file
@@ -25,7 +25,7 @@
 #include "iAChannelID.h"
 #include "iAConsole.h"
 #include "iAChannelVisualizationData.h"
-#include "iAMovieHelper.h"
+#include "iAFrameExporter.h"
 #include "iAObserverProgress.h"
 #include "iARenderObserver.h"
 #include "iARenderSettings.h"
@@ -37,7 +37,6 @@
 #include <vtkCellArray.h>
 #include <vtkCellLocator.h>
 #include <vtkCubeSource.h>
-#include <vtkGenericMovieWriter.h>
 #include <vtkGenericRenderWindowInteractor.h>
 #include <vtkImageData.h>
 #include <vtkImageCast.h>
@@ -394,10 +393,12 @@ vtkCamera* iARenderer::getCamera()
 
 void iARenderer::saveMovie( const QString& fileName, int mode, int qual /*= 2*/ )
 {
-	vtkSmartPointer<vtkGenericMovieWriter> movieWriter = GetMovieWriter(fileName, qual);
-
-	if (movieWriter.GetPointer() == NULL)
+	iAFrameExporter exporter(fileName, qual);
+	if (!exporter.Start())
+	{
+		emit msg(exporter.ErrorMessage());
 		return;
+	}
 
 	interactor->Disable();
 
@@ -411,13 +412,6 @@ void iARenderer::saveMovie( const QString& fileName, int mode, int qual /*= 2*/
 	w2if->SetInput(renWin);
 	w2if->ReadFrontBufferOff();
 
-	movieWriter->SetInputConnection(w2if->GetOutputPort());
-	movieWriter->SetFileName(fileName.toLatin1().data());
-	movieWriter->Start();
-
-	int i;
-	int* extent = imageData->GetExtent();
-
 	emit msg(tr("%1  MOVIE export started. Output: %2").arg(QLocale().toString(QDateTime::currentDateTime(), QLocale::ShortFormat), fileName));
 
 	int numRenderings = 360;//TODO
@@ -455,30 +449,26 @@ void iARenderer::saveMovie( const QString& fileName, int mode, int qual /*= 2*/
 	}
 	cam->SetViewUp ( view );
 	cam->SetPosition ( point );
-	for ( i =0; i < numRenderings; i++ ) {
+	for (int i =0; i < numRenderings; i++ ) {
 		ren->ResetCamera();
 		renWin->Render();
 
+		// only render and read back here; the frame is encoded in the background
+		// while the next one is rendered:
 		w2if->Modified();
-		movieWriter->Write();
-		if (movieWriter->GetError()) { 
-			emit msg(movieWriter->GetStringFromErrorCode(movieWriter->GetErrorCode())); 
+		w2if->Update();
+		if (!exporter.Add(w2if->GetOutput(), i))
 			break;
-		}
-		emit progress( 100 * (i+1) / (extent[1]-extent[0]));
+		emit progress( 100 * (i+1) / numRenderings);
+		QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
 		cam->ApplyTransform(rot);
 	}
-
-	movieWriter->End(); 
-	movieWriter->ReleaseDataFlagOn();
-	w2if->ReleaseDataFlagOn();
+	bool success = exporter.Finish();
 
 	interactor->Enable();
 
-	if (movieWriter->GetError()) emit msg(tr("  MOVIE export failed."));
+	if (!success) emit msg(tr("  MOVIE export failed: %1").arg(exporter.ErrorMessage()));
 	else emit msg(tr("  MOVIE export completed."));
-
-	return;
 }
 
 void iARenderer::mouseRightButtonReleasedSlot()
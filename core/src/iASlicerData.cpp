@@ -29,6 +29,7 @@
 #include "iAMathUtility.h"
 #include "iAModality.h"
 #include "iAModalityList.h"
+#include "iAFrameExporter.h"
 #include "iAMovieHelper.h"
 #include "iAPieChartGlyph.h"
 #include "iARulerWidget.h"
@@ -48,7 +49,6 @@
 #include <vtkColorTransferFunction.h>
 #include <vtkDataSetMapper.h>
 #include <vtkDiskSource.h>
-#include <vtkGenericMovieWriter.h>
 #include <vtkGenericOpenGLRenderWindow.h>
 #include <vtkImageActor.h>
 #include <vtkImageBlend.h>
@@ -85,18 +85,20 @@
 #include <vtkCommand.h>
 
 #include <QBitmap>
+#include <QCoreApplication>
 #include <QDate>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QString>
 #include <QThread>
+#include <QTimer>
 
-#include <string>
-#include <sstream>
 
 namespace
 {
 	const double PickTolerance = 100.0;
+	//! time (in ms) after the last slice change until the full resolution image is resliced again
+	const int FullResolutionDelay = 300;
 }
 
 class iAInteractorStyleImage : public vtkInteractorStyleImage
@@ -157,8 +159,14 @@ iASlicerData::iASlicerData( iASlicer const * slicerMaster, QObject * parent /*=
 	colorTransferFunction(nullptr),
 	isolines(false),
 	poly(false),
-	roiActive(false)
-{
+	roiActive(false),
+	m_interactionImageMTime(0),
+	m_interactionImageActive(false),
+	m_fullResolutionTimer(new QTimer(this))
+{
+	m_fullResolutionTimer->setSingleShot(true);
+	m_fullResolutionTimer->setInterval(FullResolutionDelay);
+	connect(m_fullResolutionTimer, SIGNAL(timeout()), this, SLOT(restoreFullResolution()));
 	renWin->AlphaBitPlanesOn();
 	renWin->LineSmoothingOn();
 	renWin->PointSmoothingOn();
@@ -472,6 +480,7 @@ void iASlicerData::RemoveImageActor(vtkSmartPointer<vtkImageActor> imgActor)
 
 void iASlicerData::blend(vtkAlgorithmOutput *data, vtkAlgorithmOutput *data2, double opacity, double * range)
 { 
+	setInteractionImage(nullptr);
 	vtkSmartPointer<vtkLookupTable> lut = vtkSmartPointer<vtkLookupTable>::New(); 
 	lut->SetRange( range ); 
 	lut->SetHueRange(0, 1);
@@ -503,6 +512,7 @@ void iASlicerData::blend(vtkAlgorithmOutput *data, vtkAlgorithmOutput *data2, do
 void iASlicerData::reInitialize( vtkImageData *ds, vtkTransform *tr, vtkColorTransferFunction* ctf,
 	bool showIsoLines, bool showPolygon)
 {
+	setInteractionImage(nullptr);
 	imageData = ds;
 	transform = tr;
 	colorTransferFunction = ctf;
@@ -603,10 +613,44 @@ void iASlicerData::setup(iASingleSlicerSettings const & settings)
 }
 
 
+void iASlicerData::setInteractionImage(vtkImageData* img)
+{
+	restoreFullResolution();
+	m_interactionImage = img;
+	if (img && imageData)
+		m_interactionImageMTime = imageData->GetMTime();
+}
+
+
+void iASlicerData::restoreFullResolution()
+{
+	m_fullResolutionTimer->stop();
+	if (!m_interactionImageActive)
+		return;
+	m_interactionImageActive = false;
+	reslicer->SetInputData(imageData);
+	reslicer->SetInformationInput(imageData);
+	UpdateReslicer();
+	interactor->Render();
+}
+
+
 void iASlicerData::setResliceAxesOrigin( double x, double y, double z )
 {
 	if (interactor->GetEnabled())
 	{
+		if (m_interactionImage && imageData->GetMTime() != m_interactionImageMTime)
+			setInteractionImage(nullptr);	// full image was modified, downsampled version is outdated
+		if (m_interactionImage)
+		{	// reslice the coarse image while moving, the full one once the slice position settles
+			if (!m_interactionImageActive)
+			{	// information input determines output spacing and extent, so slice at the coarse resolution
+				reslicer->SetInputData(m_interactionImage);
+				reslicer->SetInformationInput(m_interactionImage);
+				m_interactionImageActive = true;
+			}
+			m_fullResolutionTimer->start();
+		}
 		reslicer->SetResliceAxesOrigin( x, y, z );
 		UpdateReslicer();
 		interactor->Render(); 
@@ -695,11 +739,14 @@ void iASlicerData::saveMovie( QString& fileName, int qual /*= 2*/ )
 		return;
 	}
 
-	vtkSmartPointer<vtkGenericMovieWriter> movieWriter = GetMovieWriter(fileName, qual);
-
-	if (movieWriter.GetPointer() == NULL)
+	iAFrameExporter exporter(fileName, qual);
+	if (!exporter.Start())
+	{
+		emit msg(exporter.ErrorMessage());
 		return;
+	}
 
+	restoreFullResolution();
 	interactor->Disable();
 
 	vtkSmartPointer<vtkWindowToImageFilter> w2if = vtkSmartPointer<vtkWindowToImageFilter>::New();
@@ -712,78 +759,40 @@ void iASlicerData::saveMovie( QString& fileName, int qual /*= 2*/ )
 	w2if->SetInput(renWin);
 	w2if->ReadFrontBufferOff();
 
-	movieWriter->SetInputConnection(w2if->GetOutputPort());
-	movieWriter->SetFileName(fileName.toLatin1().data());
-	movieWriter->Start();
-
-	int i;
 	int* extent = imageData->GetExtent();
 	double* spacing = imageData->GetSpacing();
+	int sliceAxis = SlicerZInd(m_mode);
+	int sliceCount = extent[sliceAxis * 2 + 1] - extent[sliceAxis * 2];
 
 	emit msg(tr("%1  MOVIE export started. Output: %2").arg(QLocale().toString(QDateTime::currentDateTime(), QLocale::ShortFormat), fileName));
 
-	if (m_mode == iASlicerMode::YZ)      // YZ
-	{					
-		for ( i = extent[0]; i < extent[1]; i++ )
-		{
-			reslicer->SetResliceAxesOrigin( i * spacing[0], 0, 0 ); 
-			update();
-			w2if->Modified();
-
-			movieWriter->Write();
-			if (movieWriter->GetError()) { 
-				emit msg(movieWriter->GetStringFromErrorCode(movieWriter->GetErrorCode())); 
-				break;
-			}
-			emit progress( 100 * (i+1) / (extent[1]-extent[0]));
-		}
-	}
-	else if (m_mode == iASlicerMode::XY)  // XY
+	for (int i = 0; i < sliceCount; i++)
 	{
-		for ( i = extent[4]; i < extent[5]; i++ )
-		{
-			reslicer->SetResliceAxesOrigin( 0, 0, i * spacing[2] ); 
-			update();
-			w2if->Modified();
-			movieWriter->Write();
-			if (movieWriter->GetError()) { 
-				emit msg(movieWriter->GetStringFromErrorCode(movieWriter->GetErrorCode())); 
-				break;
-			}
-			emit progress( 100 * (i+1) / (extent[5]-extent[4]));
-		}
-	}
-	else if (m_mode == iASlicerMode::XZ)  // XZ
-	{			
-		for ( i = extent[2]; i < extent[3]; i++ )
-		{
-			reslicer->SetResliceAxesOrigin( 0, i * spacing[1], 0 ); 
-			update();
-			w2if->Modified();
-			movieWriter->Write();
-			if (movieWriter->GetError()) { 
-				emit msg(movieWriter->GetStringFromErrorCode(movieWriter->GetErrorCode())); 
-				break;
-			}
-			emit progress( 100 * (i+1) / (extent[3]-extent[2]));
-		}
+		double origin[3] = { 0, 0, 0 };
+		origin[sliceAxis] = (extent[sliceAxis * 2] + i) * spacing[sliceAxis];
+		reslicer->SetResliceAxesOrigin(origin);
+		update();
+		// only render and read back here; the frame is encoded in the background
+		// while the next one is rendered:
+		w2if->Modified();
+		w2if->Update();
+		if (!exporter.Add(w2if->GetOutput(), i))
+			break;
+		emit progress( 100 * (i+1) / sliceCount);
+		QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
 	}
-
-	movieWriter->End(); 
-	movieWriter->ReleaseDataFlagOn();
-	w2if->ReleaseDataFlagOn();
+	bool success = exporter.Finish();
 
 	interactor->Enable();
 
-	if (movieWriter->GetError()) emit msg(tr("  MOVIE export failed."));
+	if (!success) emit msg(tr("  MOVIE export failed: %1").arg(exporter.ErrorMessage()));
 	else emit msg(tr("  MOVIE export completed."));
-
-	return;
 }
 
 
 void iASlicerData::changeImageData( vtkImageData *idata )
 {
+	setInteractionImage(nullptr);
 	imageData = idata;
 
 	reslicer->SetInputData( imageData );
@@ -870,14 +879,12 @@ void iASlicerData::saveImageStack()
 	if (file.isEmpty())
 		return;
 
-	std::string current_file = file.toLocal8Bit().constData();
-	size_t dotpos = current_file.find_last_of(".");
-	assert( dotpos != std::string::npos );
-	if ( dotpos == std::string::npos )
+	QFileInfo fileInfo(file);
+	assert( !fileInfo.suffix().isEmpty() );
+	if ( fileInfo.suffix().isEmpty() )
 	{
 		return;
 	}
-	current_file.erase(dotpos,4);
 
 	int const * arr = imageData->GetDimensions();
 	double const * spacing = imageData->GetSpacing();
@@ -895,7 +902,6 @@ void iASlicerData::saveImageStack()
 		<< tr("#From Slice Number:")
 		<<  tr("#To Slice Number:") );
 	QList<QVariant> inPara = ( QList<QVariant>() << (saveNative ? tr("true") : tr("false"))<<tr("%1").arg(sliceFirst) <<tr("%1").arg(sliceLast)  );
-	QFileInfo fileInfo(file);
 	if ((QString::compare(fileInfo.suffix(), "TIF", Qt::CaseInsensitive) == 0) ||
 		(QString::compare(fileInfo.suffix(), "TIFF", Qt::CaseInsensitive) == 0))
 	{
@@ -921,25 +927,14 @@ void iASlicerData::saveImageStack()
 		msgBox.exec();
 		return;
 	}
-	interactor->Disable();
-	vtkImageData* img;
-	for(int slice=sliceFirst; slice<=sliceLast; slice++)
+	iAFrameExporter exporter(file);
+	if (saveNative)
 	{
-		//Determine which axis
-		if(m_mode==0){ //yz
-			setResliceAxesOrigin(slice * spacing[0], 0, 0);
-		} else if(m_mode==1){  //xy
-			setResliceAxesOrigin(0, 0, slice * spacing[2]);
-		} else if(m_mode==2){  //xz
-			setResliceAxesOrigin(0, slice * spacing[1], 0);
-		}
-		update();
-
-		vtkSmartPointer<vtkWindowToImageFilter> wtif = vtkSmartPointer<vtkWindowToImageFilter>::New();
-		iAConnector con;
-		if (saveNative)
+		// the intensity rescaling is done on the writer threads:
+		exporter.SetFrameProcessor([output16Bit](vtkSmartPointer<vtkImageData> slice) -> vtkSmartPointer<vtkImageData>
 		{
-			con.SetImage(reslicer->GetOutput());
+			iAConnector con;
+			con.SetImage(slice);
 			iAITKIO::ImagePointer imgITK;
 			if (!output16Bit)
 			{
@@ -950,27 +945,48 @@ void iASlicerData::saveImageStack()
 				imgITK = RescaleImageTo<unsigned short>(con.GetITKImage(), 0, 65535);
 			}
 			con.SetImage(imgITK);
-			img = con.GetVTKImage();
+			// take over the buffer, the connector (and its ITK image) goes out of scope here:
+			auto result = vtkSmartPointer<vtkImageData>::New();
+			con.TransferVTKImage(result);
+			return result;
+		});
+	}
+	exporter.Start();
+	restoreFullResolution();
+	interactor->Disable();
+	vtkSmartPointer<vtkWindowToImageFilter> wtif = vtkSmartPointer<vtkWindowToImageFilter>::New();
+	wtif->SetInput(renWin);
+	wtif->ReadFrontBufferOff();
+	for(int slice=sliceFirst; slice<=sliceLast; slice++)
+	{
+		double origin[3] = { 0, 0, 0 };
+		origin[num] = slice * spacing[num];
+		reslicer->SetResliceAxesOrigin(origin);
+		update();
+		vtkImageData* img;
+		if (saveNative)
+		{
+			img = reslicer->GetOutput();
 		}
 		else
 		{
-			wtif->SetInput(renWin);
-			wtif->ReadFrontBufferOff();
+			wtif->Modified();
 			wtif->Update();
 			img = wtif->GetOutput();
 		}
-
-		//append slice number to filename
-		std::stringstream ss;
-		ss << slice;
-		std::string appendFile(ss.str());
-		std::string newFileName(current_file);
-		newFileName.append(appendFile);
-		newFileName.append(".");
-		newFileName.append(fileInfo.suffix().toStdString());
-		WriteSingleSliceImage(newFileName.c_str(), img);
+		// file name is the chosen one with the slice number appended to its base name
+		if (!exporter.Add(img, slice))
+			break;
+		emit progress(100 * (slice - sliceFirst + 1) / (sliceLast - sliceFirst + 1));
+		QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
 	}
+	bool success = exporter.Finish();
 	interactor->Enable();
+	if (!success)
+	{
+		QMessageBox::warning(mdi_parent, tr("Save Image Stack"), exporter.ErrorMessage());
+		return;
+	}
 	QMessageBox msgBox;
 	msgBox.setText("Saving image stack completed.");
 	msgBox.exec();
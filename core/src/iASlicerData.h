@@ -25,11 +25,14 @@
 #include "iASlicerMode.h"
 
 #include <vtkSmartPointer.h>
+#include <vtkVersion.h>
 
 #include <QCursor>
 #include <QMap>
 #include <QSharedPointer>
 
+class QTimer;
+
 class vtkActor;
 class vtkAlgorithmOutput;
 class vtkCamera;
@@ -81,6 +84,9 @@ public:
 	void initialize( vtkImageData *ds, vtkTransform *tr, vtkColorTransferFunction* ctf);
 	void reInitialize( vtkImageData *ds, vtkTransform *tr, vtkColorTransferFunction* ctf, bool showisolines = false, bool showpolygon = false);
 	void changeImageData(vtkImageData *idata);
+	//! set a downsampled version of the image, which is resliced instead of the full
+	//! image while the slice position is changing; pass null to always use the full image
+	void setInteractionImage(vtkImageData* img);
 	void setup(iASingleSlicerSettings const & settings);
 	
 	void initializeChannel(iAChannelID id, iAChannelVisualizationData * chData);
@@ -195,7 +201,17 @@ Q_SIGNALS:
 	void oslicerCol(double cl, double cw, int mode);
 	//key press
 	void Pick();
+private slots:
+	void restoreFullResolution();
 private:
+	vtkSmartPointer<vtkImageData> m_interactionImage;
+#if (VTK_MAJOR_VERSION > 7 || (VTK_MAJOR_VERSION == 7 && VTK_MINOR_VERSION > 0))
+	vtkMTimeType m_interactionImageMTime;
+#else
+	unsigned long m_interactionImageMTime;
+#endif
+	bool m_interactionImageActive;
+	QTimer* m_fullResolutionTimer;
 	iAMagicLens * m_magicLensExternal;
 	vtkRenderWindowInteractor* interactor;
 	iAInteractorStyleImage* interactorStyle;
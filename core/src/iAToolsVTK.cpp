@@ -26,6 +26,7 @@
 #include "iAVtkDraw.h"
 
 #include <vtkBMPWriter.h>
+#include <vtkErrorCode.h>
 #include <vtkImageData.h>
 #include <vtkImageWriter.h>
 #include <vtkJPEGWriter.h>
@@ -82,10 +83,12 @@ vtkSmartPointer<vtkImageData> ReadImage(QString const & filename, bool releaseFl
 	iAITKIO::ScalarPixelType pixelType;
 	iAITKIO::ImagePointer img = iAITKIO::readFile(filename, pixelType, releaseFlag);
 	con.SetImage(img);
-	return con.GetVTKImage();
+	vtkSmartPointer<vtkImageData> result = vtkSmartPointer<vtkImageData>::New();
+	con.TransferVTKImage(result);
+	return result;
 }
 
-void WriteSingleSliceImage(QString const & filename, vtkImageData* imageData)
+bool WriteSingleSliceImage(QString const & filename, vtkImageData* imageData)
 {
 	QFileInfo fi(filename);
 	vtkSmartPointer<vtkImageWriter> writer;
@@ -96,19 +99,20 @@ void WriteSingleSliceImage(QString const & filename, vtkImageData* imageData)
 		writer = vtkSmartPointer<vtkPNGWriter>::New();
 	}
 	else if ((QString::compare(fi.suffix(), "JPG", Qt::CaseInsensitive) == 0) || (QString::compare(fi.suffix(), "JPEG", Qt::CaseInsensitive) == 0)) {
-		writer = vtkJPEGWriter::New();
+		writer = vtkSmartPointer<vtkJPEGWriter>::New();
 	}
 	else if (QString::compare(fi.suffix(), "BMP", Qt::CaseInsensitive) == 0) {
-		writer = vtkBMPWriter::New();
+		writer = vtkSmartPointer<vtkBMPWriter>::New();
 	}
 	else
 	{
 		DEBUG_LOG("Could not write image: Filename has an unknown extension!");
-		return;
+		return false;
 	}
 	writer->SetFileName(filename.toLatin1());
 	writer->SetInputData(imageData);
 	writer->Write();
+	return writer->GetErrorCode() == vtkErrorCode::NoError;
 }
 
 
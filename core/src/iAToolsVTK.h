@@ -39,7 +39,9 @@ open_iA_Core_API vtkSmartPointer<vtkImageData> AllocateImage(int vtkType, int co
 open_iA_Core_API void StoreImage(vtkSmartPointer<vtkImageData> image, QString const & filename, bool useCompression = true);
 vtkSmartPointer<vtkImageData> ReadImage(QString const & filename, bool releaseFlag);
 
-void WriteSingleSliceImage(QString const & filename, vtkImageData* imageData);
+//! write a 2D image to a tif, png, jpg or bmp file (chosen by the extension of the file name)
+//! \return true if the image was written, false if the extension is unknown or writing failed
+bool WriteSingleSliceImage(QString const & filename, vtkImageData* imageData);
 
 int MapVTKTypeStringToInt(QString const & vtkTypeName);
 
@@ -25,6 +25,7 @@
 #include "iATransferFunction.h"
 #include "iAVolumeSettings.h"
 
+#include <vtkCallbackCommand.h>
 #include <vtkImageData.h>
 #include <vtkOpenGLRenderer.h>
 #include <vtkOutlineFilter.h>
@@ -54,8 +55,13 @@ iAVolumeRenderer::iAVolumeRenderer(
 	outlineMapper(vtkSmartPointer<vtkPolyDataMapper>::New()),
 	outlineActor(vtkSmartPointer<vtkActor>::New()),
 	currentRenderer(0),
-	currentBoundingBoxRenderer(0)
+	currentBoundingBoxRenderer(0),
+	m_selectMapperCallback(vtkSmartPointer<vtkCallbackCommand>::New()),
+	m_selectMapperObserver(0),
+	m_interactionImageMTime(0)
 {
+	m_selectMapperCallback->SetCallback(SelectMapper);
+	m_selectMapperCallback->SetClientData(this);
 	m_isFlat = IsFlat(imgData->GetExtent());
 	if (!m_isFlat)
 	{
@@ -78,6 +84,8 @@ void iAVolumeRenderer::SetImage(iATransferFunction * transfer, vtkSmartPointer<v
 	m_isFlat = IsFlat(imgData->GetExtent());
 	if (m_isFlat)
 		return;
+	m_image = imgData;
+	SetInteractionImage(nullptr);
 	volMapper->SetInputData(imgData);
 	if ( imgData->GetNumberOfScalarComponents() > 1 )
 	{
@@ -95,6 +103,41 @@ void iAVolumeRenderer::SetImage(iATransferFunction * transfer, vtkSmartPointer<v
 	Update();
 }
 
+void iAVolumeRenderer::SetInteractionImage(vtkSmartPointer<vtkImageData> imgData)
+{
+	if (m_isFlat)
+		return;
+	if (!imgData)
+	{
+		m_interactionMapper = nullptr;
+		volume->SetMapper(volMapper);
+		return;
+	}
+	m_interactionMapper = vtkSmartPointer<vtkSmartVolumeMapper>::New();
+	m_interactionMapper->SetBlendMode(volMapper->GetBlendMode());
+	m_interactionMapper->SetRequestedRenderMode(volMapper->GetRequestedRenderMode());
+	m_interactionMapper->SetClippingPlanes(volMapper->GetClippingPlanes());
+	m_interactionMapper->SetInputData(imgData);
+	m_interactionImageMTime = m_image->GetMTime();
+}
+
+void iAVolumeRenderer::SelectMapper(vtkObject* caller, unsigned long, void* clientData, void*)
+{
+	iAVolumeRenderer* renderer = static_cast<iAVolumeRenderer*>(clientData);
+	if (!renderer->m_interactionMapper)
+		return;
+	if (renderer->m_image->GetMTime() != renderer->m_interactionImageMTime)
+	{	// full image was modified since the downsampled version was created
+		renderer->SetInteractionImage(nullptr);
+		return;
+	}
+	vtkRenderWindow* renWin = static_cast<vtkRenderer*>(caller)->GetRenderWindow();
+	bool interacting = renWin && renWin->GetDesiredUpdateRate() > 1.0;
+	vtkSmartVolumeMapper* mapper = interacting ? renderer->m_interactionMapper.GetPointer() : renderer->volMapper.GetPointer();
+	if (renderer->volume->GetMapper() != mapper)
+		renderer->volume->SetMapper(mapper);
+}
+
 void iAVolumeRenderer::SetMovable(bool movable)
 {
 	volume->SetPickable(movable);
@@ -116,6 +159,8 @@ void iAVolumeRenderer::ApplySettings(iAVolumeSettings const & vs)
 	volMapper->SetSampleDistance(vs.SampleDistance);
 	volMapper->InteractiveAdjustSampleDistancesOff();
 #endif
+	if (m_interactionMapper)
+		m_interactionMapper->SetRequestedRenderMode(vs.Mode);
 }
 
 double * iAVolumeRenderer::GetOrientation()
@@ -156,6 +201,7 @@ void iAVolumeRenderer::AddTo(vtkRenderer* w)
 	if (m_isFlat)
 		return;
 	w->AddVolume(volume);
+	m_selectMapperObserver = w->AddObserver(vtkCommand::StartEvent, m_selectMapperCallback);
 	currentRenderer = w;
 }
 
@@ -168,6 +214,7 @@ void iAVolumeRenderer::Remove()
 		return;
 	}
 	currentRenderer->RemoveVolume(volume);
+	currentRenderer->RemoveObserver(m_selectMapperObserver);
 	currentRenderer = 0;
 }
 
@@ -228,6 +275,8 @@ void iAVolumeRenderer::SetCuttingPlanes(vtkPlane* p1, vtkPlane* p2, vtkPlane* p3
 	volMapper->AddClippingPlane(p1);
 	volMapper->AddClippingPlane(p2);
 	volMapper->AddClippingPlane(p3);
+	if (m_interactionMapper)
+		m_interactionMapper->SetClippingPlanes(volMapper->GetClippingPlanes());
 }
 
 void iAVolumeRenderer::RemoveCuttingPlanes()
@@ -235,6 +284,8 @@ void iAVolumeRenderer::RemoveCuttingPlanes()
 	if (m_isFlat)
 		return;
 	volMapper->RemoveAllClippingPlanes();
+	if (m_interactionMapper)
+		m_interactionMapper->RemoveAllClippingPlanes();
 }
 
 
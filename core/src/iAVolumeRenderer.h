@@ -23,6 +23,7 @@
 #include "open_iA_Core_export.h"
 
 #include <vtkSmartPointer.h>
+#include <vtkVersion.h>
 
 #include <QSharedPointer>
 
@@ -30,6 +31,7 @@ class iAVolumeSettings;
 class iATransferFunction;
 
 class vtkActor;
+class vtkCallbackCommand;
 class vtkImageData;
 class vtkPlane;
 class vtkOpenGLRenderer;
@@ -67,8 +69,23 @@ public:
 
 	void SetImage(iATransferFunction * transfer, vtkSmartPointer<vtkImageData> imgData);
 
+	//! set a downsampled version of the image, which is rendered instead of
+	//! the full image while the user interacts with the render window.
+	//! Pass null to always render the full image.
+	void SetInteractionImage(vtkSmartPointer<vtkImageData> imgData);
+
 	void SetMovable(bool movable);
 private:
+	static void SelectMapper(vtkObject* caller, unsigned long eventId, void* clientData, void* callData);
+	vtkSmartPointer<vtkImageData> m_image;
+	vtkSmartPointer<vtkSmartVolumeMapper> m_interactionMapper;
+	vtkSmartPointer<vtkCallbackCommand> m_selectMapperCallback;
+	unsigned long m_selectMapperObserver;
+#if (VTK_MAJOR_VERSION > 7 || (VTK_MAJOR_VERSION == 7 && VTK_MINOR_VERSION > 0))
+	vtkMTimeType m_interactionImageMTime;
+#else
+	unsigned long m_interactionImageMTime;
+#endif
 	vtkSmartPointer<vtkVolume> volume;
 	vtkSmartPointer<vtkVolumeProperty> volProp;
 	vtkSmartPointer<vtkSmartVolumeMapper> volMapper;
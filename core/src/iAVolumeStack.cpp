@@ -22,11 +22,16 @@
 #include "pch.h"
 #include "iAVolumeStack.h"
 
+#include "iAConsole.h"
+
 #include <vtkDataSet.h>
 #include <vtkImageData.h>
 #include <vtkPiecewiseFunction.h>
 #include <vtkStructuredData.h> // Needed for inline methods
 
+#include <QThread>
+
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <map>
@@ -35,13 +40,52 @@
 
 using namespace std;
 
-iAVolumeStack::iAVolumeStack()
+class iAVolumeStack::PrefetchThread : public QThread
+{
+public:
+	PrefetchThread(iAVolumeStack* stack) : m_stack(stack) {}
+private:
+	void run() override
+	{
+		QMutexLocker locker(&m_stack->m_mutex);
+		while (true)
+		{
+			while (m_stack->m_requests.isEmpty() && !m_stack->m_stopPrefetching)
+				m_stack->m_requestAdded.wait(&m_stack->m_mutex);
+			if (m_stack->m_stopPrefetching)
+				return;
+			auto request = m_stack->m_requests.dequeue();
+			locker.unlock();
+			vtkSmartPointer<vtkImageData> volume = m_stack->loadVolume(request.second);
+			locker.relock();
+			m_stack->m_prefetched.insert(request.first, volume);
+			m_stack->m_pending.remove(request.first);
+			m_stack->m_prefetchDone.wakeAll();
+		}
+	}
+	iAVolumeStack* m_stack;
+};
+
+iAVolumeStack::iAVolumeStack():
+	m_cacheSize(DefaultCacheSize),
+	m_prefetchThread(nullptr),
+	m_stopPrefetching(false)
 {
 	id = 0;
 }
 
 iAVolumeStack::~iAVolumeStack()
 {
+	if (m_prefetchThread)
+	{
+		{
+			QMutexLocker locker(&m_mutex);
+			m_stopPrefetching = true;
+			m_requestAdded.wakeAll();
+		}
+		m_prefetchThread->wait();
+		delete m_prefetchThread;
+	}
 	// clear vectors
 	while(!colorTransferVector.empty()) {
 		vtkColorTransferFunction* ctf = colorTransferVector.back();
@@ -62,9 +106,112 @@ void iAVolumeStack::addVolume(vtkImageData* volume)
 	volumes.push_back(image);
 }
 
-vtkImageData* iAVolumeStack::getVolume(int i)
+vtkSmartPointer<vtkImageData> iAVolumeStack::getVolume(int i)
 {
-	return volumes.at(i);
+	if (!m_loader)
+		return volumes.at(i);
+	// hold our own reference: collecting prefetched volumes can evict the requested one from the cache
+	vtkSmartPointer<vtkImageData> result = volumes.at(i);
+	if (!result)
+	{
+		{
+			QMutexLocker locker(&m_mutex);
+			while (m_pending.contains(i))
+				m_prefetchDone.wait(&m_mutex);
+		}
+		collectPrefetched();
+		result = volumes[i];
+		if (!result)
+			result = loadVolume(fileNameArray.at(i));
+	}
+	else
+	{
+		collectPrefetched();
+	}
+	if (result)
+	{
+		volumes[i] = result;
+		touch(i);
+	}
+	return result;
+}
+
+bool iAVolumeStack::isVolumeLoaded(int i)
+{
+	return volumes.at(i) != nullptr;
+}
+
+void iAVolumeStack::setVolumeLoader(VolumeLoader loader, int cacheSize)
+{
+	m_loader = loader;
+	// the current volume and the one blended with it need to fit at least
+	m_cacheSize = std::max(2, cacheSize);
+	m_recentlyUsed.clear();
+	for (int i = static_cast<int>(volumes.size()) - 1; i >= 0; --i)
+		if (volumes[i])
+			touch(i);
+}
+
+void iAVolumeStack::prefetchVolume(int i)
+{
+	if (!m_loader || i < 0 || i >= static_cast<int>(volumes.size()) || volumes[i])
+		return;
+	QMutexLocker locker(&m_mutex);
+	if (m_pending.contains(i) || m_prefetched.contains(i))
+		return;
+	m_pending.insert(i);
+	m_requests.enqueue(qMakePair(i, fileNameArray.at(i)));
+	if (!m_prefetchThread)
+	{
+		m_prefetchThread = new PrefetchThread(this);
+		m_prefetchThread->start(QThread::LowPriority);
+	}
+	m_requestAdded.wakeOne();
+}
+
+vtkSmartPointer<vtkImageData> iAVolumeStack::loadVolume(QString const & fileName)
+{
+	try
+	{
+		vtkSmartPointer<vtkImageData> volume = m_loader(fileName);
+		if (volume)
+			return volume;
+	}
+	catch (std::exception & e)
+	{
+		DEBUG_LOG(QString("Loading volume %1 failed: %2").arg(fileName).arg(e.what()));
+		return nullptr;
+	}
+	DEBUG_LOG(QString("Loading volume %1 failed!").arg(fileName));
+	return nullptr;
+}
+
+void iAVolumeStack::collectPrefetched()
+{
+	QMap<int, vtkSmartPointer<vtkImageData> > prefetched;
+	{
+		QMutexLocker locker(&m_mutex);
+		prefetched.swap(m_prefetched);
+	}
+	for (auto it = prefetched.begin(); it != prefetched.end(); ++it)
+	{
+		if (!it.value() || volumes[it.key()])
+			continue;
+		volumes[it.key()] = it.value();
+		touch(it.key());
+	}
+}
+
+void iAVolumeStack::touch(int i)
+{
+	m_recentlyUsed.remove(i);
+	m_recentlyUsed.push_front(i);
+	while (m_recentlyUsed.size() > static_cast<size_t>(m_cacheSize))
+	{
+		// users still referencing the volume keep it alive; we only drop our reference
+		volumes[m_recentlyUsed.back()] = nullptr;
+		m_recentlyUsed.pop_back();
+	}
 }
 
 size_t iAVolumeStack::getNumberOfVolumes()
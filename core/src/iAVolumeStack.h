@@ -28,8 +28,16 @@
 #include <vtkSmartPointer.h>
 #include <vtkStructuredData.h> // Needed for inline methods
 
+#include <QMap>
+#include <QMutex>
+#include <QPair>
+#include <QQueue>
+#include <QSet>
 #include <QString>
+#include <QWaitCondition>
 
+#include <functional>
+#include <list>
 #include <map>
 #include <string.h>
 #include <iostream>
@@ -44,14 +52,30 @@ class vtkColorTransferFunction;
 
 #include <vtkColorTransferFunction.h>
 
+//! A series of volumes (e.g. the time steps of a 4D CT dataset) with their transfer functions.
+//! If a volume loader is set, only a window of the most recently used volumes is kept in memory;
+//! the other volumes are loaded from their files on demand, or in advance via prefetchVolume.
 class open_iA_Core_API iAVolumeStack
 {
 	public:
+		//! loads the volume stored in the given file; called from a background thread,
+		//! so it must not access any state shared with the GUI
+		typedef std::function<vtkSmartPointer<vtkImageData>(QString const & fileName)> VolumeLoader;
+		//! default number of volumes kept in memory when loading on demand
+		static const int DefaultCacheSize = 8;
 
 		iAVolumeStack();
 		~iAVolumeStack();
 
-		vtkImageData* getVolume(int i);
+		//! returns the volume with the given index; if it is not in memory, it is loaded first
+		//! (waiting for a prefetch of it that is still in progress). Returns null if loading failed.
+		vtkSmartPointer<vtkImageData> getVolume(int i);
+		//! whether the volume with the given index is currently held in memory
+		bool isVolumeLoaded(int i);
+		//! load volumes on demand through the given loader, keeping at most cacheSize of them in memory
+		void setVolumeLoader(VolumeLoader loader, int cacheSize = DefaultCacheSize);
+		//! start loading the volume with the given index in the background, if it is not in memory yet
+		void prefetchVolume(int i);
 		void addVolume(vtkImageData* volume);
 		void addFileName(QString fileName);
 		QString getFileName(int i);
@@ -65,9 +89,27 @@ class open_iA_Core_API iAVolumeStack
 		vector<QString> * GetFileNames();
 
 	private:
+		class PrefetchThread;
+		vtkSmartPointer<vtkImageData> loadVolume(QString const & fileName);
+		//! move volumes loaded in the background into the stack
+		void collectPrefetched();
+		//! mark the given volume as most recently used, and remove the least recently used ones beyond the cache size
+		void touch(int i);
+
 		int id;
 		vector<vtkSmartPointer<vtkImageData> > volumes;
 		vector<vtkColorTransferFunction*> colorTransferVector;
 		vector<vtkPiecewiseFunction*> piecewiseVector;
 		vector<QString> fileNameArray;
+
+		VolumeLoader m_loader;
+		int m_cacheSize;
+		std::list<int> m_recentlyUsed;                //!< indices of volumes in memory, most recently used first
+		PrefetchThread* m_prefetchThread;
+		QMutex m_mutex;                               //!< guards the members below, shared with the prefetch thread
+		QWaitCondition m_requestAdded, m_prefetchDone;
+		QQueue<QPair<int, QString> > m_requests;      //!< volumes still to be prefetched (index and file name)
+		QSet<int> m_pending;                          //!< volumes requested or currently being prefetched
+		QMap<int, vtkSmartPointer<vtkImageData> > m_prefetched;
+		bool m_stopPrefetching;
 };
@@ -29,6 +29,9 @@
 #include "iAConsole.h"
 #include "iAExceptionThrowingErrorObserver.h"
 #include "iAExtendedTypedCallHelper.h"
+#include "iAImageStackReader.h"
+#include "iAITKIO.h"
+#include "iAMemoryMappedIO.h"
 #include "iAObserverProgress.h"
 #include "iAOIFReader.h"
 #include "iAProgress.h"
@@ -49,16 +52,12 @@
 #include <itkNumericSeriesFileNames.h>
 #include <itkRawImageIO.h>
 
-#include <vtkBMPReader.h>
 #include <vtkImageData.h>
-#include <vtkJPEGReader.h>
-#include <vtkPNGReader.h>
 #include <vtkPolyData.h>
 #include <vtkSTLReader.h>
 #include <vtkSTLWriter.h>
 #include <vtkStringArray.h>
 #include <vtkTable.h>
-#include <vtkTIFFReader.h>
 #include <vtkVersion.h>
 #include <vtkXMLImageDataReader.h>
 
@@ -130,7 +129,10 @@ template<class T> int read_raw_image_template ( int d, unsigned long h, int bO,
 	reader->Modified();
 	reader->Update();
 	
-	image->SetImage(reader->GetOutput());
+	// detach output from reader, so that the connector is the only owner of the buffer:
+	typename InputImageType::Pointer output = reader->GetOutput();
+	output->DisconnectPipeline();
+	image->SetImage(output);
 	image->Modified();
 	
 	reader->ReleaseDataFlagOn();
@@ -159,7 +161,9 @@ int read_image_template( QString f, iAProgress* p, iAConnector* image  )
 	
 	reader->Update();
 	
-	image->SetImage(reader->GetOutput());
+	typename InputImageType::Pointer output = reader->GetOutput();
+	output->DisconnectPipeline();
+	image->SetImage(output);
 	image->Modified();
 	
 	reader->ReleaseDataFlagOn();
@@ -228,6 +232,14 @@ void iAIO::init(QObject *par)
 	byteOrder = 1;
 
 	ioID = 0;
+	m_memoryMappedLoading = false;
+	m_lazyVolumeStackLoading = false;
+	m_hdf5Step = 1;
+	for (int i = 0; i < 3; ++i)
+	{
+		m_hdf5ROIStart[i] = 0;
+		m_hdf5ROISize[i] = 0;
+	}
 	iosettingsreader();
 
 	stlReader = vtkSTLReader::New();
@@ -357,8 +369,6 @@ void printHDF5ErrorsToConsole()
 	herr_t walkresult = H5Ewalk(err_stack, H5E_WALK_UPWARD, errorfunc, NULL);
 }
 
-#include <vtkImageImport.h>
-
 bool iAIO::loadHDF5File()
 {
 	if (m_hdf5Path.size() < 2)
@@ -378,12 +388,20 @@ bool iAIO::loadHDF5File()
 	}
 
 	hid_t dataset_id = H5Dopen(loc_id, m_hdf5Path[0].toStdString().c_str(), H5P_DEFAULT);
+	auto closeAll = [&]()
+	{
+		H5Dclose(dataset_id);
+		while (openGroups.size() > 0)
+		{
+			H5Gclose(openGroups.pop());
+		}
+		H5Fclose(file);
+	};
 	hid_t space = H5Dget_space(dataset_id);
 	int rank = H5Sget_simple_extent_ndims(space);
-	hsize_t * hdf5Dims = new hsize_t[rank];
-	hsize_t * maxdims = new hsize_t[rank];
-	int status = H5Sget_simple_extent_dims(space, hdf5Dims, maxdims);
-	H5S_class_t hdf5Class = H5Sget_simple_extent_type(space);
+	std::vector<hsize_t> hdf5Dims(rank);
+	std::vector<hsize_t> maxdims(rank);
+	int status = H5Sget_simple_extent_dims(space, hdf5Dims.data(), maxdims.data());
 	hid_t type_id = H5Dget_type(dataset_id);
 	H5T_class_t hdf5Type = H5Tget_class(type_id);
 	size_t numBytes = H5Tget_size(type_id);
@@ -405,46 +423,92 @@ bool iAIO::loadHDF5File()
 		if (i < rank - 1) caption += " x ";
 	}
 	DEBUG_LOG(caption);
-	status = H5Sclose(space);
-	if (vtkType == InvalidHDF5Type)
+	if (vtkType == InvalidHDF5Type || rank < 1 || rank > 3)
 	{
-		DEBUG_LOG("Can't load a dataset of this data type!");
+		DEBUG_LOG("Can't load a dataset of this data type or rank!");
+		H5Sclose(space);
+		closeAll();
 		return false;
 	}
 
-	// actual reading of data:
-	//status = H5Dread(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, );
-
-	int dim[3];
+	// region to read, in dataset coordinates:
+	hsize_t start[3], stride[3], outDims[3];
 	for (int i = 0; i < 3; ++i)
 	{
-		dim[i] = (i < rank) ? hdf5Dims[i] : 1;
+		hsize_t size = (i < rank) ? hdf5Dims[i] : 1;
+		start[i] = std::min(static_cast<hsize_t>(std::max(m_hdf5ROIStart[i], 0)), size - 1);
+		hsize_t roiSize = size - start[i];
+		if (m_hdf5ROISize[i] > 0)
+		{
+			roiSize = std::min(static_cast<hsize_t>(m_hdf5ROISize[i]), roiSize);
+		}
+		stride[i] = (i < rank) ? std::max(m_hdf5Step, 1) : 1;
+		outDims[i] = (roiSize + stride[i] - 1) / stride[i];
+	}
+
+	// read in blocks along the slowest dimension, aligned to the chunks of the dataset,
+	// so that every chunk needs to be read (and decompressed) only once:
+	hsize_t blockSize = 0;
+	hid_t createPList = H5Dget_create_plist(dataset_id);
+	if (H5Pget_layout(createPList) == H5D_CHUNKED)
+	{
+		hsize_t chunkDims[3];
+		H5Pget_chunk(createPList, rank, chunkDims);
+		blockSize = chunkDims[0];
 	}
-	unsigned char * raw_data = new unsigned char[numBytes * dim[0] * dim[1] * dim[2] ];
-	status = H5Dread(dataset_id, GetHDF5ReadType(hdf5Type, numBytes, sign), H5S_ALL, H5S_ALL, H5P_DEFAULT, raw_data);
-	if (status < 0)
+	H5Pclose(createPList);
+	if (blockSize == 0)
 	{
-		DEBUG_LOG("Reading dataset failed!");
-		printHDF5ErrorsToConsole();
-		return false;
+		const hsize_t ContiguousBlockBytes = 64 * 1024 * 1024;
+		hsize_t planeBytes = numBytes;
+		for (int i = 1; i < rank; ++i)
+		{
+			planeBytes *= hdf5Dims[i];
+		}
+		blockSize = std::max(static_cast<hsize_t>(1), ContiguousBlockBytes / planeBytes);
 	}
-	H5Dclose(dataset_id);
-	while (openGroups.size() > 0)
+
+	// read directly into the buffer of the image, so that it doesn't need to be copied later:
+	vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+	image->SetSpacing(m_hdf5Spacing[0] * stride[0], m_hdf5Spacing[1] * stride[1], m_hdf5Spacing[2] * stride[2]);
+	image->SetOrigin(start[0] * m_hdf5Spacing[0], start[1] * m_hdf5Spacing[1], start[2] * m_hdf5Spacing[2]);
+	image->SetExtent(0, outDims[0]-1, 0, outDims[1]-1, 0, outDims[2]-1);
+	image->AllocateScalars(vtkType, 1);
+	hid_t memSpace = H5Screate_simple(rank, outDims, NULL);
+	hid_t readType = GetHDF5ReadType(hdf5Type, numBytes, sign);
+	hsize_t roiEnd = start[0] + (outDims[0] - 1) * stride[0] + 1;
+	for (hsize_t blockStart = (start[0] / blockSize) * blockSize; blockStart < roiEnd; blockStart += blockSize)
 	{
-		H5Gclose(openGroups.pop());
-	}
-	H5Fclose(file);
-
-	vtkSmartPointer<vtkImageImport> imgImport = vtkSmartPointer<vtkImageImport>::New();
-	imgImport->SetDataSpacing(m_hdf5Spacing[0], m_hdf5Spacing[1], m_hdf5Spacing[2]);
-	imgImport->SetDataOrigin(0, 0, 0);
-	imgImport->SetWholeExtent(0, dim[0]-1, 0, dim[1]-1, 0, dim[2]-1);
-	imgImport->SetDataExtentToWholeExtent();
-	imgImport->SetDataScalarType(vtkType);
-	imgImport->SetNumberOfScalarComponents(1);
-	imgImport->SetImportVoidPointer(raw_data, 0);
-	imgImport->Update();
-	getConnector()->SetImage(imgImport->GetOutput());
+		// output rows with a source row inside the current block:
+		hsize_t firstSrc = std::max(blockStart, start[0]);
+		hsize_t outFirst = (firstSrc - start[0] + stride[0] - 1) / stride[0];
+		hsize_t outLast  = std::min(outDims[0], (blockStart + blockSize - start[0] + stride[0] - 1) / stride[0]);
+		if (outLast <= outFirst)
+		{
+			continue;
+		}
+		hsize_t fileStart[3] = { start[0] + outFirst * stride[0], start[1], start[2] };
+		hsize_t memStart[3] = { outFirst, 0, 0 };
+		hsize_t count[3] = { outLast - outFirst, outDims[1], outDims[2] };
+		H5Sselect_hyperslab(space, H5S_SELECT_SET, fileStart, stride, count, NULL);
+		H5Sselect_hyperslab(memSpace, H5S_SELECT_SET, memStart, NULL, count, NULL);
+		status = H5Dread(dataset_id, readType, memSpace, space, H5P_DEFAULT, image->GetScalarPointer());
+		if (status < 0)
+		{
+			DEBUG_LOG("Reading dataset failed!");
+			printHDF5ErrorsToConsole();
+			H5Sclose(memSpace);
+			H5Sclose(space);
+			closeAll();
+			return false;
+		}
+		observerProgress->manualProgressUpdate(static_cast<int>(100 * outLast / outDims[0]));
+	}
+	H5Sclose(memSpace);
+	H5Sclose(space);
+	closeAll();
+
+	getConnector()->SetImage(image);
 	getConnector()->Modified();
 	postImageReadActions();
 
@@ -572,7 +636,12 @@ void iAIO::run()
 		if ((ioID == MHD_WRITER) || (ioID == STL_WRITER) || (ioID == TIF_STACK_WRITER) 
 			|| (ioID == JPG_STACK_WRITER) || (ioID == PNG_STACK_WRITER)|| (ioID == BMP_STACK_WRITER) || (ioID ==DCM_WRITER) )
 			emit done(true);
-		else emit done();
+		else
+		{
+			if (m_postReadAction)
+				m_postReadAction();
+			emit done();
+		}
 	} else {
 		emit msg(tr("   FILE I/O FAILED!"));
 		emit failed();
@@ -878,6 +947,23 @@ bool iAIO::setupIO( IOType type, QString f, bool c, int channel)
 				emit msg("Invalid spacing (has to be a valid floating point number)!");
 				return false;
 			}
+			QLineEdit* roiStart[3] = { dlg.edROIStartX, dlg.edROIStartY, dlg.edROIStartZ };
+			QLineEdit* roiSize[3] = { dlg.edROISizeX, dlg.edROISizeY, dlg.edROISizeZ };
+			bool okStart = true, okSize = true, okStep;
+			for (int i = 0; i < 3; ++i)
+			{
+				bool ok;
+				m_hdf5ROIStart[i] = roiStart[i]->text().toInt(&ok);
+				okStart &= ok && m_hdf5ROIStart[i] >= 0;
+				m_hdf5ROISize[i] = roiSize[i]->text().toInt(&ok);
+				okSize &= ok && m_hdf5ROISize[i] >= 0;
+			}
+			m_hdf5Step = dlg.edStep->text().toInt(&okStep);
+			if (!(okStart && okSize && okStep && m_hdf5Step >= 1))
+			{
+				emit msg("Invalid region of interest or step (have to be non-negative integers, step at least 1)!");
+				return false;
+			}
 			return true;
 		}
 #endif
@@ -1012,6 +1098,17 @@ bool iAIO::loadMetaImageFile(QString const & fileName)
 		return false;
 	}
 
+	if (m_memoryMappedLoading && fileName.endsWith(".mhd", Qt::CaseInsensitive))
+	{
+		vtkSmartPointer<vtkImageData> img = iAMemoryMappedIO::MapMetaImage(fileName);
+		if (img)
+		{
+			getConnector()->SetImage(img);
+			getConnector()->Modified();
+			return true;
+		}
+		emit msg(tr("  Memory-mapped loading of %1 not possible, reading whole file.").arg(fileName));
+	}
 	try
 	{
 		imageIO->SetFileName(fileName.toLatin1());
@@ -1043,9 +1140,34 @@ bool iAIO::readVolumeMHDStack()
 		emit msg(tr("  No files matched the given criteria!"));
 		return false;
 	}
+	if (m_lazyVolumeStackLoading)
+	{
+		bool memoryMapped = m_memoryMappedLoading;
+		m_volumeLoader = [memoryMapped](QString const & volumeFileName) -> vtkSmartPointer<vtkImageData>
+		{
+			if (memoryMapped && volumeFileName.endsWith(".mhd", Qt::CaseInsensitive))
+			{
+				vtkSmartPointer<vtkImageData> img = iAMemoryMappedIO::MapMetaImage(volumeFileName);
+				if (img)
+					return img;
+			}
+			iAITKIO::ScalarPixelType pixelType;
+			iAITKIO::ImagePointer itkImg = iAITKIO::readFile(volumeFileName, pixelType, false);
+			iAConnector con;
+			con.SetImage(itkImg);
+			auto img = vtkSmartPointer<vtkImageData>::New();
+			con.TransferVTKImage(img);
+			return img;
+		};
+	}
 	for (int m=0; m<=fileNameArray->GetMaxId(); m++)
 	{
 		fileName=(fileNameArray->GetValue(m));
+		if (m_lazyVolumeStackLoading && m > 0)
+		{
+			addLazyVolume(fileName);
+			continue;
+		}
 		if (!loadMetaImageFile(fileName))
 		{
 			return false;
@@ -1053,7 +1175,7 @@ bool iAIO::readVolumeMHDStack()
 		if(m_volumes)
 		{
 			vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
-			image->DeepCopy(getConnector()->GetVTKImage());
+			getConnector()->TransferVTKImage(image);
 			m_volumes->push_back(image);
 		}
 		if(m_fileNames_volstack)
@@ -1070,18 +1192,58 @@ bool iAIO::readVolumeMHDStack()
 
 bool iAIO::readVolumeStack()
 {
+	if (m_lazyVolumeStackLoading)
+	{
+		bool memoryMapped = m_memoryMappedLoading;
+		unsigned long rawHeaderSize = headersize;
+		int rawScalarType = scalarType, rawByteOrder = byteOrder, rawDim = dim;
+		int rawExtent[6];
+		double rawSpacing[3], rawOrigin[3];
+		std::copy(extent, extent + 6, rawExtent);
+		std::copy(spacing, spacing + 3, rawSpacing);
+		std::copy(origin, origin + 3, rawOrigin);
+		m_volumeLoader = [=](QString const & volumeFileName) -> vtkSmartPointer<vtkImageData>
+		{
+			if (memoryMapped)
+			{
+				vtkSmartPointer<vtkImageData> img = iAMemoryMappedIO::MapRaw(volumeFileName, rawHeaderSize,
+					rawScalarType, rawExtent, rawSpacing, rawOrigin, rawByteOrder);
+				if (img)
+					return img;
+			}
+			int e[6];
+			double sp[3], o[3];
+			std::copy(rawExtent, rawExtent + 6, e);
+			std::copy(rawSpacing, rawSpacing + 3, sp);
+			std::copy(rawOrigin, rawOrigin + 3, o);
+			iAConnector con;
+			iAProgress progress;
+			VTK_TYPED_CALL(read_raw_image_template, rawScalarType, rawDim, rawHeaderSize, rawByteOrder, e, sp, o,
+				volumeFileName, &progress, &con);
+			auto img = vtkSmartPointer<vtkImageData>::New();
+			con.TransferVTKImage(img);
+			return img;
+		};
+	}
 	for (int m=0; m<=fileNameArray->GetMaxId(); m++)
 	{
 		fileName=(fileNameArray->GetValue(m));
+		if (m_lazyVolumeStackLoading && m > 0)
+		{
+			addLazyVolume(fileName);
+			continue;
+		}
 		if (!readRawImage())
 		{
 			return false;
 		}
 
-		vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
-		image->DeepCopy(getConnector()->GetVTKImage());
 		if(m_volumes)
+		{
+			vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+			getConnector()->TransferVTKImage(image);
 			m_volumes->push_back(image);
+		}
 		if(m_fileNames_volstack)
 			m_fileNames_volstack->push_back(fileName);
 
@@ -1130,6 +1292,17 @@ bool iAIO::writeVolumeStack()
 
 bool iAIO::readRawImage()
 {
+	if (m_memoryMappedLoading)
+	{
+		vtkSmartPointer<vtkImageData> img = iAMemoryMappedIO::MapRaw(fileName, headersize, scalarType, extent, spacing, origin, byteOrder);
+		if (img)
+		{
+			getConnector()->SetImage(img);
+			getConnector()->Modified();
+			return true;
+		}
+		emit msg(tr("  Memory-mapped loading of %1 not possible, reading whole file.").arg(fileName));
+	}
 	try
 	{
 		VTK_TYPED_CALL(read_raw_image_template, scalarType, dim, headersize, byteOrder, extent, spacing, origin, fileName, getItkProgress(), getConnector());
@@ -1150,10 +1323,7 @@ bool iAIO::readRawImage()
 
 void iAIO::postImageReadActions()
 {
-	getVtkImageData()->ReleaseData();
-	getVtkImageData()->Initialize();
-	getVtkImageData()->DeepCopy(getConnector()->GetVTKImage());
-	getVtkImageData()->CopyInformationFromPipeline(getConnector()->GetVTKImage()->GetInformation());
+	getConnector()->TransferVTKImage(getVtkImageData());
 	emit msg(tr("%1  Loading file %2 completed.").arg(QLocale().toString(QDateTime::currentDateTime(), QLocale::ShortFormat)).arg(fileName));
 }
 
@@ -1731,32 +1901,28 @@ bool iAIO::setupStackReader( QString f )
 
 bool iAIO::readImageStack()
 {
-	vtkSmartPointer<vtkImageReader2> imgReader;
 	switch (ioID)
 	{
-		case TIF_STACK_READER: imgReader = vtkSmartPointer<vtkTIFFReader>::New(); break;
-		case JPG_STACK_READER: imgReader = vtkSmartPointer<vtkJPEGReader>::New(); break;
-		case PNG_STACK_READER: imgReader = vtkSmartPointer<vtkPNGReader>::New(); break;
-		case BMP_STACK_READER: imgReader = vtkSmartPointer<vtkBMPReader>::New(); break;
+		case TIF_STACK_READER:
+		case JPG_STACK_READER:
+		case PNG_STACK_READER:
+		case BMP_STACK_READER: break;
 		default: emit msg(tr("%1  Invalid Image Stack IO id, aborting.")
 			.arg(QLocale().toString(QDateTime::currentDateTime(), QLocale::ShortFormat)));
 			return false;
 	}
-	imgReader->ReleaseDataFlagOn();
-	imgReader->AddObserver(vtkCommand::ProgressEvent, observerProgress);
-	imgReader->AddObserver(vtkCommand::ErrorEvent, iAExceptionThrowingErrorObserver::New());
-	try
+	QStringList fileNames;
+	for (vtkIdType i = 0; i < fileNameArray->GetNumberOfValues(); ++i)
 	{
-		imgReader->SetFileNames(fileNameArray);
-		imgReader->SetDataOrigin(origin);
-		imgReader->SetDataSpacing(spacing);
-		imgReader->SetOutput(getVtkImageData());
-		imgReader->Update();
+		fileNames.append(QString::fromLatin1(fileNameArray->GetValue(i).c_str()));
 	}
-	catch (std::exception &e)
+	iAImageStackReader stackReader;
+	stackReader.AddStack(fileNames, origin, spacing, getVtkImageData());
+	stackReader.SetProgressCallback([this](int percent) { observerProgress->manualProgressUpdate(percent); });
+	if (!stackReader.Read())
 	{
 		emit msg(tr("%1  An error occured while loading image stack (%2), aborting.")
-			.arg(QLocale().toString(QDateTime::currentDateTime(), QLocale::ShortFormat)).arg(e.what()));
+			.arg(QLocale().toString(QDateTime::currentDateTime(), QLocale::ShortFormat)).arg(stackReader.ErrorMessage()));
 		return false;
 	}
 
@@ -1917,6 +2083,40 @@ void iAIO::setAdditionalInfo(QString const & additionalInfo)
 }
 
 
+void iAIO::setMemoryMappedLoading(bool enabled)
+{
+	m_memoryMappedLoading = enabled;
+}
+
+
+void iAIO::setLazyVolumeStackLoading(bool enabled)
+{
+	m_lazyVolumeStackLoading = enabled;
+}
+
+
+std::function<vtkSmartPointer<vtkImageData>(QString const &)> iAIO::getVolumeLoader() const
+{
+	return m_volumeLoader;
+}
+
+
+void iAIO::setPostReadAction(std::function<void()> action)
+{
+	m_postReadAction = action;
+}
+
+
+void iAIO::addLazyVolume(QString const & volumeFileName)
+{
+	// placeholder; the volume is loaded when needed, through the loader from getVolumeLoader()
+	if (m_volumes)
+		m_volumes->push_back(nullptr);
+	if (m_fileNames_volstack)
+		m_fileNames_volstack->push_back(volumeFileName);
+}
+
+
 QString iAIO::getFileName()
 {
 	return fileName;
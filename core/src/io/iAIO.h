@@ -31,6 +31,7 @@
 #include <QDir>
 #include <QString>
 
+#include <functional>
 #include <vector>
 
 class vtkImageData;
@@ -66,6 +67,17 @@ public:
 
 	void setAdditionalInfo(QString const & additionalInfo);
 	QString getAdditionalInfo();
+	//! enable loading uncompressed RAW and MHD files via memory mapping (if possible)
+	void setMemoryMappedLoading(bool enabled);
+	//! when reading a volume stack, only read the first volume; for the others, only file names
+	//! and empty placeholders are added, they can be loaded on demand with getVolumeLoader()
+	void setLazyVolumeStackLoading(bool enabled);
+	//! loader for the volumes of the last volume stack read with lazy loading enabled
+	//! (see iAVolumeStack::setVolumeLoader)
+	std::function<vtkSmartPointer<vtkImageData>(QString const &)> getVolumeLoader() const;
+	//! set a function which is run in the I/O thread after a file was read successfully, before done()
+	//! is emitted; for preparing data derived from the loaded data without blocking the user interface
+	void setPostReadAction(std::function<void()> action);
 
 	// TODO: move to Multimodal fusion
 	// {
@@ -105,6 +117,7 @@ private:
 
 	bool readVolumeStack( );
 	bool readVolumeMHDStack( );
+	void addLazyVolume(QString const & volumeFileName);
 	bool readImageData( );
 	bool readMetaImage( );
 	bool readSTL( );
@@ -154,9 +167,16 @@ private:
 
 	QString m_additionalInfo;
 	int m_channel;
+	bool m_memoryMappedLoading;
+	bool m_lazyVolumeStackLoading;
+	std::function<vtkSmartPointer<vtkImageData>(QString const &)> m_volumeLoader;
+	std::function<void()> m_postReadAction;
 
 	QVector<QString> m_hdf5Path;
 	bool m_isITKHDF5;
 	double m_hdf5Spacing[3];
+	int m_hdf5ROIStart[3];
+	int m_hdf5ROISize[3];  //!< size of region to load; 0 means up to the end of the dataset
+	int m_hdf5Step;        //!< only load every n-th voxel (for previews)
 	bool loadHDF5File();
 };
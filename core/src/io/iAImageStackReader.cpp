@@ -0,0 +1,239 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#include "pch.h"
+#include "iAImageStackReader.h"
+
+#include "iAExceptionThrowingErrorObserver.h"
+
+#include <vtkBMPReader.h>
+#include <vtkImageData.h>
+#include <vtkJPEGReader.h>
+#include <vtkPNGReader.h>
+#include <vtkTIFFReader.h>
+
+#include <QFileInfo>
+
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+	//! decode a single slice file with its own reader; throws std::runtime_error on errors
+	vtkSmartPointer<vtkImageData> ReadSlice(QString const & fileName)
+	{
+		vtkSmartPointer<vtkImageReader2> reader = iAImageStackReader::CreateReader(QFileInfo(fileName).suffix());
+		if (!reader)
+		{
+			throw std::runtime_error(QString("Unsupported image file type (%1).").arg(fileName).toStdString());
+		}
+		vtkSmartPointer<iAExceptionThrowingErrorObserver> errorObserver = vtkSmartPointer<iAExceptionThrowingErrorObserver>::New();
+		reader->AddObserver(vtkCommand::ErrorEvent, errorObserver);
+		reader->SetFileName(fileName.toLatin1().constData());
+		reader->Update();
+		return reader->GetOutput();
+	}
+}
+
+
+vtkSmartPointer<vtkImageReader2> iAImageStackReader::CreateReader(QString const & extension)
+{
+	QString ext = extension.toLower();
+	if (ext == "jpg" || ext == "jpeg")
+	{
+		return vtkSmartPointer<vtkJPEGReader>::New();
+	}
+	else if (ext == "png")
+	{
+		return vtkSmartPointer<vtkPNGReader>::New();
+	}
+	else if (ext == "bmp")
+	{
+		return vtkSmartPointer<vtkBMPReader>::New();
+	}
+	else if (ext == "tif" || ext == "tiff")
+	{
+		return vtkSmartPointer<vtkTIFFReader>::New();
+	}
+	return vtkSmartPointer<vtkImageReader2>();
+}
+
+
+int iAImageStackReader::AddStack(QStringList const & fileNames, double const * origin, double const * spacing,
+	vtkSmartPointer<vtkImageData> target)
+{
+	Stack stack;
+	stack.fileNames = fileNames;
+	for (int i = 0; i < 3; ++i)
+	{
+		stack.origin[i] = origin[i];
+		stack.spacing[i] = spacing[i];
+	}
+	stack.image = target;
+	stack.scalars = nullptr;
+	stack.sliceBytes = 0;
+	m_stacks.push_back(stack);
+	return static_cast<int>(m_stacks.size() - 1);
+}
+
+
+void iAImageStackReader::SetProgressCallback(std::function<void(int)> progress)
+{
+	m_progress = progress;
+}
+
+
+bool iAImageStackReader::ReadFirstSlice(Stack & stack)
+{
+	if (stack.fileNames.isEmpty())
+	{
+		m_errorMessage = "Image stack contains no files.";
+		return false;
+	}
+	vtkSmartPointer<vtkImageData> slice;
+	try
+	{
+		slice = ReadSlice(stack.fileNames[0]);
+	}
+	catch (std::exception & e)
+	{
+		m_errorMessage = QString("Reading %1 failed: %2").arg(stack.fileNames[0]).arg(e.what());
+		return false;
+	}
+	int const * dim = slice->GetDimensions();
+	if (!stack.image)
+	{
+		stack.image = vtkSmartPointer<vtkImageData>::New();
+	}
+	stack.image->ReleaseData();
+	stack.image->SetExtent(0, dim[0] - 1, 0, dim[1] - 1, 0, stack.fileNames.size() - 1);
+	stack.image->SetOrigin(stack.origin);
+	stack.image->SetSpacing(stack.spacing);
+	stack.image->AllocateScalars(slice->GetScalarType(), slice->GetNumberOfScalarComponents());
+	stack.scalars = static_cast<char*>(stack.image->GetScalarPointer());
+	stack.sliceBytes = static_cast<size_t>(dim[0]) * dim[1] *
+		stack.image->GetScalarSize() * stack.image->GetNumberOfScalarComponents();
+	std::memcpy(stack.scalars, slice->GetScalarPointer(), stack.sliceBytes);
+	return true;
+}
+
+
+bool iAImageStackReader::Read()
+{
+	m_errorMessage.clear();
+	// the first slice of each stack determines its size and data type
+	for (Stack & stack : m_stacks)
+	{
+		if (!ReadFirstSlice(stack))
+		{
+			return false;
+		}
+	}
+	struct SliceJob
+	{
+		int stack;
+		int slice;
+	};
+	std::vector<SliceJob> jobs;
+	for (size_t s = 0; s < m_stacks.size(); ++s)
+	{
+		for (int z = 1; z < m_stacks[s].fileNames.size(); ++z)
+		{
+			SliceJob job = { static_cast<int>(s), z };
+			jobs.push_back(job);
+		}
+	}
+	int const totalSlices = static_cast<int>(jobs.size() + m_stacks.size());
+	int finishedSlices = static_cast<int>(m_stacks.size());
+	int reportedPercent = -1;
+	std::atomic<bool> failed(false);
+	#pragma omp parallel for schedule(dynamic)
+	for (int j = 0; j < static_cast<int>(jobs.size()); ++j)
+	{
+		if (failed.load(std::memory_order_relaxed))		// only an early out, the error is recorded in the critical section below
+		{
+			continue;
+		}
+		Stack const & stack = m_stacks[jobs[j].stack];
+		QString const & fileName = stack.fileNames[jobs[j].slice];
+		QString error;
+		try
+		{
+			vtkSmartPointer<vtkImageData> slice = ReadSlice(fileName);
+			int const * sliceDim = slice->GetDimensions();
+			int const * dim = stack.image->GetDimensions();
+			if (sliceDim[0] != dim[0] || sliceDim[1] != dim[1] || sliceDim[2] != 1 ||
+				slice->GetScalarType() != stack.image->GetScalarType() ||
+				slice->GetNumberOfScalarComponents() != stack.image->GetNumberOfScalarComponents())
+			{
+				error = QString("Size or data type of %1 differs from the first slice of the stack.").arg(fileName);
+			}
+			else
+			{
+				std::memcpy(stack.scalars + jobs[j].slice * stack.sliceBytes, slice->GetScalarPointer(), stack.sliceBytes);
+			}
+		}
+		catch (std::exception & e)
+		{
+			error = QString("Reading %1 failed: %2").arg(fileName).arg(e.what());
+		}
+		#pragma omp critical (iAImageStackReaderProgress)
+		{
+			if (!error.isEmpty() && !failed)
+			{
+				m_errorMessage = error;
+				failed = true;
+			}
+			++finishedSlices;
+			int percent = finishedSlices * 100 / totalSlices;
+			if (m_progress && percent != reportedPercent)
+			{
+				reportedPercent = percent;
+				m_progress(percent);
+			}
+		}
+	}
+	if (failed)
+	{
+		return false;
+	}
+	for (Stack & stack : m_stacks)
+	{
+		stack.image->Modified();
+	}
+	if (m_progress)
+	{
+		m_progress(100);
+	}
+	return true;
+}
+
+
+vtkSmartPointer<vtkImageData> iAImageStackReader::Image(int stackIdx) const
+{
+	return m_stacks[stackIdx].image;
+}
+
+
+QString const & iAImageStackReader::ErrorMessage() const
+{
+	return m_errorMessage;
+}
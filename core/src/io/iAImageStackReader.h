@@ -0,0 +1,75 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#pragma once
+
+#include "open_iA_Core_export.h"
+
+#include <vtkSmartPointer.h>
+
+#include <QString>
+#include <QStringList>
+
+#include <functional>
+#include <vector>
+
+class vtkImageData;
+class vtkImageReader2;
+
+//! Reads series of 2D image files (TIFF, PNG, BMP, JPEG), each series into one volume.
+//! In contrast to passing the file list to a single vtkImageReader2, the slices are decoded
+//! concurrently, each by its own reader, and copied directly into their slab of the output
+//! image, which is allocated once up front. Several stacks can be added; the slices of all
+//! of them are then decoded in one parallel pass.
+class open_iA_Core_API iAImageStackReader
+{
+public:
+	//! create a VTK reader for the given file extension (tif, tiff, png, bmp, jpg, jpeg; case-insensitive)
+	//! \return the reader, or a null pointer if the extension is not supported
+	static vtkSmartPointer<vtkImageReader2> CreateReader(QString const & extension);
+	//! add a stack of slices to be read
+	//! \param fileNames the slice files, in z order
+	//! \param target image to read into; if null, a new image is created (see Image())
+	//! \return index of the stack, for retrieving its image after Read()
+	int AddStack(QStringList const & fileNames, double const * origin, double const * spacing,
+		vtkSmartPointer<vtkImageData> target = vtkSmartPointer<vtkImageData>());
+	//! set a function which is called with the overall progress (0..100) whenever a slice is finished
+	void SetProgressCallback(std::function<void(int)> progress);
+	//! decode all slices of all added stacks
+	//! \return true on success, false otherwise (see ErrorMessage())
+	bool Read();
+	//! the image of the stack with the given index
+	vtkSmartPointer<vtkImageData> Image(int stackIdx) const;
+	QString const & ErrorMessage() const;
+private:
+	struct Stack
+	{
+		QStringList fileNames;
+		double origin[3];
+		double spacing[3];
+		vtkSmartPointer<vtkImageData> image;
+		char* scalars;		//!< start of the scalar buffer of image
+		size_t sliceBytes;	//!< size of one slice in the scalar buffer
+	};
+	bool ReadFirstSlice(Stack & stack);
+	std::vector<Stack> m_stacks;
+	std::function<void(int)> m_progress;
+	QString m_errorMessage;
+};
@@ -0,0 +1,254 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+ 
+#include "pch.h"
+#include "iAMemoryMappedIO.h"
+
+#include "iAConsole.h"
+#include "iAFileUtils.h"
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkImageReader2.h>    // for VTK_FILE_BYTE_ORDER_...
+#include <vtkPointData.h>
+#include <vtkVersion.h>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QSysInfo>
+#include <QTextStream>
+
+namespace
+{
+	//! files currently mapped, by address of their mapping
+	QMap<void*, QFile*> MappedFiles;
+	QMutex MappedFilesMutex;
+
+	//! called by VTK when the scalar array of a mapped image is freed
+	void UnmapFile(void * data)
+	{
+		QMutexLocker lock(&MappedFilesMutex);
+		QFile* file = MappedFiles.take(data);
+		if (!file)
+		{
+			return;
+		}
+		file->unmap(static_cast<uchar*>(data));
+		delete file;
+	}
+
+	vtkSmartPointer<vtkImageData> MapFile(QString const & fileName, qint64 offset, int scalarType,
+		int const * extent, double const * spacing, double const * origin, int byteOrder)
+	{
+#if (VTK_MAJOR_VERSION > 8 || (VTK_MAJOR_VERSION == 8 && VTK_MINOR_VERSION > 0))
+		bool fileIsLittleEndian = (byteOrder == VTK_FILE_BYTE_ORDER_LITTLE_ENDIAN);
+		if (fileIsLittleEndian != (QSysInfo::ByteOrder == QSysInfo::LittleEndian))
+		{
+			DEBUG_LOG(QString("Memory mapping %1: byte order differs from the one of this machine, data needs to be converted.").arg(fileName));
+			return vtkSmartPointer<vtkImageData>();
+		}
+		int typeSize = vtkDataArray::GetDataTypeSize(scalarType);
+		if (typeSize <= 0 || offset % typeSize != 0)
+		{
+			DEBUG_LOG(QString("Memory mapping %1: Header size is not a multiple of the data type size.").arg(fileName));
+			return vtkSmartPointer<vtkImageData>();
+		}
+		qint64 valueCount = static_cast<qint64>(extent[1] - extent[0] + 1) *
+			(extent[3] - extent[2] + 1) * (extent[5] - extent[4] + 1);
+		qint64 byteCount = valueCount * typeSize;
+		QFile* file = new QFile(fileName);
+		if (!file->open(QIODevice::ReadOnly) || file->size() < offset + byteCount)
+		{
+			DEBUG_LOG(QString("Memory mapping %1: Could not open file, or file is smaller than expected.").arg(fileName));
+			delete file;
+			return vtkSmartPointer<vtkImageData>();
+		}
+		// private mapping: modifications of the image (e.g. by in-place filters) never get written to the file
+		uchar* data = file->map(offset, byteCount, QFileDevice::MapPrivateOption);
+		if (!data)
+		{
+			DEBUG_LOG(QString("Memory mapping %1 failed: %2").arg(fileName).arg(file->errorString()));
+			delete file;
+			return vtkSmartPointer<vtkImageData>();
+		}
+		{
+			QMutexLocker lock(&MappedFilesMutex);
+			MappedFiles.insert(data, file);
+		}
+		vtkSmartPointer<vtkDataArray> scalars = vtkSmartPointer<vtkDataArray>::Take(vtkDataArray::CreateDataArray(scalarType));
+		scalars->SetNumberOfComponents(1);
+		scalars->SetVoidArray(data, valueCount, 0, vtkAbstractArray::VTK_DATA_ARRAY_USER_DEFINED);
+		scalars->SetArrayFreeFunction(UnmapFile);
+		vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+		image->SetExtent(const_cast<int*>(extent));
+		image->SetSpacing(spacing[0], spacing[1], spacing[2]);
+		image->SetOrigin(origin[0], origin[1], origin[2]);
+		image->GetPointData()->SetScalars(scalars);
+		return image;
+#else
+		DEBUG_LOG("Memory mapping requires VTK >= 8.1.");
+		return vtkSmartPointer<vtkImageData>();
+#endif
+	}
+
+	int MapMetaTypeToVTKType(QString const & metaType)
+	{
+		if (metaType == "MET_CHAR")           return VTK_CHAR;
+		if (metaType == "MET_UCHAR")          return VTK_UNSIGNED_CHAR;
+		if (metaType == "MET_SHORT")          return VTK_SHORT;
+		if (metaType == "MET_USHORT")         return VTK_UNSIGNED_SHORT;
+		if (metaType == "MET_INT")            return VTK_INT;
+		if (metaType == "MET_UINT")           return VTK_UNSIGNED_INT;
+		if (metaType == "MET_LONG")           return VTK_INT;   // MetaIO longs are 32 bit
+		if (metaType == "MET_ULONG")          return VTK_UNSIGNED_INT;
+		if (metaType == "MET_LONG_LONG")      return VTK_LONG_LONG;
+		if (metaType == "MET_ULONG_LONG")     return VTK_UNSIGNED_LONG_LONG;
+		if (metaType == "MET_FLOAT")          return VTK_FLOAT;
+		if (metaType == "MET_DOUBLE")         return VTK_DOUBLE;
+		return -1;
+	}
+
+	bool IsTrue(QString const & value)
+	{
+		return value.compare("True", Qt::CaseInsensitive) == 0 || value == "1";
+	}
+}
+
+vtkSmartPointer<vtkImageData> iAMemoryMappedIO::MapRaw(QString const & fileName, unsigned long headerSize, int scalarType,
+	int const * extent, double const * spacing, double const * origin, int byteOrder)
+{
+	return MapFile(fileName, headerSize, scalarType, extent, spacing, origin, byteOrder);
+}
+
+vtkSmartPointer<vtkImageData> iAMemoryMappedIO::MapMetaImage(QString const & fileName)
+{
+	QFile headerFile(fileName);
+	if (!headerFile.open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		return vtkSmartPointer<vtkImageData>();
+	}
+	int extent[6] = { 0, 0, 0, 0, 0, 0 };
+	double spacing[3] = { 1.0, 1.0, 1.0 };
+	double origin[3] = { 0.0, 0.0, 0.0 };
+	int scalarType = -1;
+	int channels = 1;
+	int byteOrder = VTK_FILE_BYTE_ORDER_LITTLE_ENDIAN;
+	qint64 headerSize = 0;
+	QString dataFileName;
+	qint64 localDataOffset = 0;
+	QTextStream in(&headerFile);
+	while (!in.atEnd())
+	{
+		QString line = in.readLine();
+		int sepPos = line.indexOf("=");
+		if (sepPos < 0)
+		{
+			continue;
+		}
+		QString key = line.left(sepPos).trimmed();
+		QString value = line.mid(sepPos + 1).trimmed();
+		QStringList values = value.split(" ", QString::SkipEmptyParts);
+		if (key == "NDims")
+		{
+			if (value.toInt() > 3)
+			{
+				return vtkSmartPointer<vtkImageData>();
+			}
+		}
+		else if (key == "DimSize")
+		{
+			for (int i = 0; i < values.size() && i < 3; ++i)
+			{
+				extent[2 * i + 1] = values[i].toInt() - 1;
+			}
+		}
+		else if (key == "ElementSpacing")
+		{
+			for (int i = 0; i < values.size() && i < 3; ++i)
+			{
+				spacing[i] = values[i].toDouble();
+			}
+		}
+		else if (key == "Offset" || key == "Origin" || key == "Position")
+		{
+			for (int i = 0; i < values.size() && i < 3; ++i)
+			{
+				origin[i] = values[i].toDouble();
+			}
+		}
+		else if (key == "ElementType")
+		{
+			scalarType = MapMetaTypeToVTKType(value);
+		}
+		else if (key == "ElementNumberOfChannels")
+		{
+			channels = value.toInt();
+		}
+		else if (key == "BinaryDataByteOrderMSB" || key == "ElementByteOrderMSB")
+		{
+			byteOrder = IsTrue(value) ? VTK_FILE_BYTE_ORDER_BIG_ENDIAN : VTK_FILE_BYTE_ORDER_LITTLE_ENDIAN;
+		}
+		else if (key == "CompressedData")
+		{
+			if (IsTrue(value))
+			{
+				return vtkSmartPointer<vtkImageData>();
+			}
+		}
+		else if (key == "HeaderSize")
+		{
+			headerSize = value.toLongLong();
+		}
+		else if (key == "ElementDataFile")  // always the last entry of the header
+		{
+			dataFileName = value;
+			localDataOffset = in.pos();
+			break;
+		}
+	}
+	// lists of slice files (LIST or pattern) can't be mapped as one buffer:
+	if (scalarType < 0 || channels != 1 || dataFileName.isEmpty() ||
+		dataFileName.startsWith("LIST") || dataFileName.contains("%"))
+	{
+		return vtkSmartPointer<vtkImageData>();
+	}
+	qint64 offset = headerSize;
+	if (dataFileName == "LOCAL")
+	{
+		dataFileName = fileName;
+		offset += localDataOffset;
+	}
+	else
+	{
+		dataFileName = MakeAbsolute(QFileInfo(fileName).absolutePath(), dataFileName);
+	}
+	if (headerSize == -1)
+	{   // data is stored at the end of the file:
+		qint64 dataSize = static_cast<qint64>(extent[1] + 1) * (extent[3] + 1) * (extent[5] + 1) *
+			vtkDataArray::GetDataTypeSize(scalarType);
+		offset = QFileInfo(dataFileName).size() - dataSize;
+	}
+	return MapFile(dataFileName, offset, scalarType, extent, spacing, origin, byteOrder);
+}
@@ -0,0 +1,44 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#pragma once
+
+#include <vtkSmartPointer.h>
+
+class vtkImageData;
+
+class QString;
+
+//! Creates images whose scalar buffer is a (copy-on-write) memory mapping of the
+//! image file, instead of reading the whole file into memory. The operating system
+//! then only pages in those parts of the file which are actually accessed.
+//! Both methods return a null pointer if the given file cannot be mapped (compressed
+//! data, byte order different from the host, unaligned header, VTK < 8.1, ...);
+//! the caller should then fall back to reading the file regularly.
+class iAMemoryMappedIO
+{
+public:
+	//! map a raw file
+	//! \param byteOrder the byte order of the file (VTK_FILE_BYTE_ORDER_LITTLE_ENDIAN or VTK_FILE_BYTE_ORDER_BIG_ENDIAN)
+	static vtkSmartPointer<vtkImageData> MapRaw(QString const & fileName, unsigned long headerSize, int scalarType,
+		int const * extent, double const * spacing, double const * origin, int byteOrder);
+	//! map the data file referenced by a MetaImage (.mhd) header
+	static vtkSmartPointer<vtkImageData> MapMetaImage(QString const & fileName);
+};
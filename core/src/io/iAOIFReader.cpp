@@ -56,7 +56,7 @@ void Reader::read(QString const & filename, iAConnector* con, int channel,
 			vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
 			iAConnector con;
 			con.SetImage(reader->GetResult(i));
-			image->DeepCopy(con.GetVTKImage());
+			con.TransferVTKImage(image);
 			volumes->push_back(image);
 		}
 	}
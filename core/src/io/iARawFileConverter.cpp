@@ -0,0 +1,394 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#include "pch.h"
+#include "iARawFileConverter.h"
+
+#include "iAMathUtility.h"
+#include "iATypedCallHelper.h"
+
+#include <vtkDataArray.h>
+#include <vtkType.h>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+	//! number of values processed by one thread at a time
+	const qint64 ChunkSize = 1 << 16;
+	const qint64 DefaultSlabSize = 64 * 1024 * 1024;
+
+	int ChunkCount(qint64 valueCount)
+	{
+		return static_cast<int>((valueCount + ChunkSize - 1) / ChunkSize);
+	}
+
+	QString MapVTKTypeToMetaType(int vtkType)
+	{
+		switch (vtkType)
+		{
+		case VTK_CHAR:
+		case VTK_SIGNED_CHAR:    return "MET_CHAR";
+		case VTK_UNSIGNED_CHAR:  return "MET_UCHAR";
+		case VTK_SHORT:          return "MET_SHORT";
+		case VTK_UNSIGNED_SHORT: return "MET_USHORT";
+		case VTK_INT:            return "MET_INT";
+		case VTK_UNSIGNED_INT:   return "MET_UINT";
+		case VTK_LONG:           return (sizeof(long) == 8) ? "MET_LONG_LONG" : "MET_INT";
+		case VTK_UNSIGNED_LONG:  return (sizeof(long) == 8) ? "MET_ULONG_LONG" : "MET_UINT";
+		case VTK_FLOAT:          return "MET_FLOAT";
+		case VTK_DOUBLE:         return "MET_DOUBLE";
+		default:                 return QString();
+		}
+	}
+
+	template <typename T>
+	void SlabRange(void const * data, qint64 valueCount, double & min, double & max)
+	{
+		T const * values = static_cast<T const *>(data);
+		int const chunks = ChunkCount(valueCount);
+		std::vector<T> chunkMin(chunks), chunkMax(chunks);
+#pragma omp parallel for
+		for (int c = 0; c < chunks; ++c)
+		{
+			qint64 const start = c * ChunkSize;
+			qint64 const end = std::min(valueCount, start + ChunkSize);
+			T curMin = values[start];
+			T curMax = values[start];
+			for (qint64 i = start + 1; i < end; ++i)
+			{
+				curMin = (values[i] < curMin) ? values[i] : curMin;
+				curMax = (values[i] > curMax) ? values[i] : curMax;
+			}
+			chunkMin[c] = curMin;
+			chunkMax[c] = curMax;
+		}
+		for (int c = 0; c < chunks; ++c)
+		{
+			min = std::min(min, static_cast<double>(chunkMin[c]));
+			max = std::max(max, static_cast<double>(chunkMax[c]));
+		}
+	}
+
+	template <typename Out, typename In>
+	void ConvertSlab(In const * in, void * outData, qint64 valueCount, double scale, double shift, double outMin, double outMax)
+	{
+		Out * out = static_cast<Out *>(outData);
+		int const chunks = ChunkCount(valueCount);
+#pragma omp parallel for
+		for (int c = 0; c < chunks; ++c)
+		{
+			qint64 const start = c * ChunkSize;
+			qint64 const end = std::min(valueCount, start + ChunkSize);
+			// branch-free, so that the compiler can vectorize this loop
+			for (qint64 i = start; i < end; ++i)
+			{
+				double value = in[i] * scale + shift;
+				value = (value > outMax) ? outMax : value;
+				value = (value < outMin) ? outMin : value;
+				out[i] = static_cast<Out>(value);
+			}
+		}
+	}
+
+	template <typename In>
+	void ConvertSlabTyped(void const * in, void * out, qint64 valueCount, int outType, double scale, double shift, double outMin, double outMax)
+	{
+		VTK_TYPED_CALL(ConvertSlab, outType, static_cast<In const *>(in), out, valueCount, scale, shift, outMin, outMax);
+	}
+
+	//! whether the two names refer to the same file (also if one of them does not exist yet)
+	bool SameFile(QString const & fileName1, QString const & fileName2)
+	{
+		QFileInfo info1(fileName1), info2(fileName2);
+		if (info1.exists() && info2.exists())
+		{
+			return info1.canonicalFilePath() == info2.canonicalFilePath();
+		}
+		return info1.absoluteFilePath() == info2.absoluteFilePath();
+	}
+}
+
+
+iARawFileConverter::iARawFileConverter(QString const & fileName, int const * dim, int scalarType, qint64 headerSize) :
+	m_fileName(fileName),
+	m_scalarType(scalarType),
+	m_headerSize(headerSize),
+	m_slabSize(DefaultSlabSize)
+{
+	std::copy(dim, dim + 3, m_dim);
+}
+
+
+void iARawFileConverter::SetProgressCallback(std::function<void(int)> progress)
+{
+	m_progress = progress;
+}
+
+
+void iARawFileConverter::SetSlabSize(qint64 bytes)
+{
+	m_slabSize = bytes;
+}
+
+
+QString const & iARawFileConverter::ErrorMessage() const
+{
+	return m_errorMessage;
+}
+
+
+bool iARawFileConverter::CheckRegion(int const * region)
+{
+	for (int i = 0; i < 3; ++i)
+	{
+		if (region[2 * i] < 0 || region[2 * i + 1] < 1 || region[2 * i] + region[2 * i + 1] > m_dim[i])
+		{
+			m_errorMessage = QString("Invalid region: %1 %2 %3 %4 %5 %6 is not inside the image (size %7x%8x%9).")
+				.arg(region[0]).arg(region[1]).arg(region[2]).arg(region[3]).arg(region[4]).arg(region[5])
+				.arg(m_dim[0]).arg(m_dim[1]).arg(m_dim[2]);
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool iARawFileConverter::ReadSlabs(SlabCallback callback, int const * region, int sliceStep)
+{
+	m_errorMessage.clear();
+	int const fullRegion[6] = { 0, m_dim[0], 0, m_dim[1], 0, m_dim[2] };
+	if (!region)
+	{
+		region = fullRegion;
+	}
+	if (!CheckRegion(region))
+	{
+		return false;
+	}
+	sliceStep = std::max(1, sliceStep);
+	qint64 const typeSize = vtkDataArray::GetDataTypeSize(m_scalarType);
+	if (typeSize == 0)
+	{
+		m_errorMessage = QString("Unsupported data type %1.").arg(m_scalarType);
+		return false;
+	}
+	QFile file(m_fileName);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		m_errorMessage = QString("Could not open file %1: %2").arg(m_fileName).arg(file.errorString());
+		return false;
+	}
+	qint64 const rowBytes = m_dim[0] * typeSize;
+	qint64 const sliceBytes = rowBytes * m_dim[1];
+	if (file.size() < m_headerSize + sliceBytes * m_dim[2])
+	{
+		m_errorMessage = QString("File %1 is too small (%2 bytes) for the given size and data type (%3 bytes required).")
+			.arg(m_fileName).arg(file.size()).arg(m_headerSize + sliceBytes * m_dim[2]);
+		return false;
+	}
+	qint64 const regionRowBytes = region[1] * typeSize;
+	qint64 const regionSliceBytes = regionRowBytes * region[3];
+	bool const fullRows = region[0] == 0 && region[1] == m_dim[0];
+	// whole slices, each directly following the previous one: the complete slab can be read at once
+	bool const contiguous = fullRows && region[2] == 0 && region[3] == m_dim[1] && sliceStep == 1;
+	int const sliceCount = (region[5] + sliceStep - 1) / sliceStep;
+	int const slabSlices = static_cast<int>(clamp<qint64>(1, sliceCount, m_slabSize / regionSliceBytes));
+
+	std::vector<char> slab(slabSlices * regionSliceBytes);
+	std::vector<char> rowBlock(fullRows ? 0 : region[3] * rowBytes);
+	auto readAt = [&file](qint64 offset, char * dest, qint64 size) -> bool
+	{
+		return file.seek(offset) && file.read(dest, size) == size;
+	};
+	for (int s = 0; s < sliceCount; s += slabSlices)
+	{
+		int const curSlices = std::min(slabSlices, sliceCount - s);
+		bool ok = true;
+		if (contiguous)
+		{
+			ok = readAt(m_headerSize + (region[4] + s) * sliceBytes, slab.data(), curSlices * sliceBytes);
+		}
+		else
+		{
+			for (int i = 0; i < curSlices && ok; ++i)
+			{
+				qint64 const z = region[4] + static_cast<qint64>(s + i) * sliceStep;
+				qint64 const offset = m_headerSize + z * sliceBytes + region[2] * rowBytes;
+				char * dest = slab.data() + i * regionSliceBytes;
+				if (fullRows)
+				{
+					ok = readAt(offset, dest, regionSliceBytes);
+				}
+				else
+				{	// read all rows covered by the region at once, then crop them in memory
+					ok = readAt(offset, rowBlock.data(), rowBlock.size());
+					for (int y = 0; y < region[3]; ++y)
+					{
+						std::memcpy(dest + y * regionRowBytes, rowBlock.data() + y * rowBytes + region[0] * typeSize, regionRowBytes);
+					}
+				}
+			}
+		}
+		if (!ok)
+		{
+			m_errorMessage = QString("Reading from %1 failed: %2").arg(m_fileName).arg(file.errorString());
+			return false;
+		}
+		callback(slab.data(), s, curSlices);
+		if (m_progress)
+		{
+			m_progress(static_cast<int>(static_cast<qint64>(s + curSlices) * 100 / sliceCount));
+		}
+	}
+	return true;
+}
+
+
+bool iARawFileConverter::ComputeRange(double & min, double & max)
+{
+	min = std::numeric_limits<double>::max();
+	max = std::numeric_limits<double>::lowest();
+	qint64 const sliceValues = static_cast<qint64>(m_dim[0]) * m_dim[1];
+	int scalarType = m_scalarType;
+	try
+	{
+		return ReadSlabs([&](void const * data, int, int sliceCount)
+		{
+			VTK_TYPED_CALL(SlabRange, scalarType, data, sliceValues * sliceCount, min, max);
+		});
+	}
+	catch (std::exception & e)
+	{
+		m_errorMessage = e.what();
+		return false;
+	}
+}
+
+
+QString iARawFileConverter::OutputRawFileName(QString const & mhdFileName)
+{
+	QFileInfo mhdInfo(mhdFileName);
+	return mhdInfo.absolutePath() + "/" + mhdInfo.completeBaseName() + ".raw";
+}
+
+bool iARawFileConverter::Convert(QString const & mhdFileName, double const * spacing, int outType,
+	double rangeMin, double rangeMax, double outMin, double outMax, int const * region)
+{
+	int const fullRegion[6] = { 0, m_dim[0], 0, m_dim[1], 0, m_dim[2] };
+	if (!region)
+	{
+		region = fullRegion;
+	}
+	QString metaType = MapVTKTypeToMetaType(outType);
+	if (metaType.isEmpty())
+	{
+		m_errorMessage = QString("Unsupported output data type %1.").arg(outType);
+		return false;
+	}
+	if (!CheckRegion(region))
+	{
+		return false;
+	}
+	// values outside of the range of the output type would overflow in the cast
+	outMin = std::max(outMin, vtkDataArray::GetDataTypeMin(outType));
+	outMax = std::min(outMax, vtkDataArray::GetDataTypeMax(outType));
+	double const scale = (rangeMin != rangeMax) ? (outMax - outMin) / (rangeMax - rangeMin) : 0.0;
+	double const shift = outMin - rangeMin * scale;
+
+	QFileInfo mhdInfo(mhdFileName);
+	QString rawFileName = mhdInfo.completeBaseName() + ".raw";
+	QString const rawFilePath = OutputRawFileName(mhdFileName);
+	// the output files are truncated before the input is read:
+	if (SameFile(mhdFileName, m_fileName) || SameFile(rawFilePath, m_fileName))
+	{
+		m_errorMessage = QString("Output file %1 would overwrite the input file %2.")
+			.arg(SameFile(mhdFileName, m_fileName) ? mhdFileName : rawFilePath).arg(m_fileName);
+		return false;
+	}
+	if (SameFile(mhdFileName, rawFilePath))
+	{
+		m_errorMessage = QString("The header file name %1 must not be the name of the raw file (.raw).").arg(mhdFileName);
+		return false;
+	}
+	QFile mhdFile(mhdFileName);
+	if (!mhdFile.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		m_errorMessage = QString("Could not open file %1 for writing: %2").arg(mhdFileName).arg(mhdFile.errorString());
+		return false;
+	}
+	{
+		QTextStream mhd(&mhdFile);
+		mhd << "ObjectType = Image\n"
+			<< "NDims = 3\n"
+			<< "BinaryData = True\n"
+			<< "BinaryDataByteOrderMSB = False\n"
+			<< "CompressedData = False\n"
+			<< "Offset = 0 0 0\n"
+			<< "ElementSpacing = " << spacing[0] << " " << spacing[1] << " " << spacing[2] << "\n"
+			<< "DimSize = " << region[1] << " " << region[3] << " " << region[5] << "\n"
+			<< "ElementType = " << metaType << "\n"
+			<< "ElementDataFile = " << rawFileName << "\n";
+	}
+	mhdFile.close();
+
+	QFile rawFile(rawFilePath);
+	if (!rawFile.open(QIODevice::WriteOnly))
+	{
+		m_errorMessage = QString("Could not open file %1 for writing: %2").arg(rawFile.fileName()).arg(rawFile.errorString());
+		return false;
+	}
+	qint64 const sliceValues = static_cast<qint64>(region[1]) * region[3];
+	qint64 const outTypeSize = vtkDataArray::GetDataTypeSize(outType);
+	std::vector<char> outBuffer;
+	bool writeOk = true;
+	int scalarType = m_scalarType;
+	try
+	{
+		bool readOk = ReadSlabs([&](void const * data, int, int sliceCount)
+		{
+			if (!writeOk)
+			{
+				return;
+			}
+			qint64 const valueCount = sliceValues * sliceCount;
+			outBuffer.resize(valueCount * outTypeSize);
+			VTK_TYPED_CALL(ConvertSlabTyped, scalarType, data, outBuffer.data(), valueCount, outType, scale, shift, outMin, outMax);
+			writeOk = rawFile.write(outBuffer.data(), outBuffer.size()) == static_cast<qint64>(outBuffer.size());
+		}, region);
+		if (readOk && !writeOk)
+		{
+			m_errorMessage = QString("Writing to %1 failed: %2").arg(rawFile.fileName()).arg(rawFile.errorString());
+		}
+		return readOk && writeOk;
+	}
+	catch (std::exception & e)
+	{
+		m_errorMessage = e.what();
+		return false;
+	}
+}
@@ -0,0 +1,73 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#pragma once
+
+#include <QString>
+
+#include <functional>
+
+//! Streaming access to and data type conversion of raw image files.
+//! The file is processed in slabs of whole slices, each read with a single large read,
+//! so that neither the input nor the output image ever needs to be held in memory
+//! completely. The conversion kernel (rescale, clamp, cast) runs on several threads,
+//! the converted slabs are appended to the output file as soon as they are ready.
+//! Regions are given as { x origin, x size, y origin, y size, z origin, z size };
+//! only the slices overlapping a region (and within them, only the rows it covers) are read.
+class iARawFileConverter
+{
+public:
+	//! called for each slab with its voxels (cropped to the region, x fastest), the index of its
+	//! first slice (counted among the slices read) and the number of slices it contains
+	typedef std::function<void(void const * data, int firstSlice, int sliceCount)> SlabCallback;
+
+	//! \param dim the dimensions of the raw image (3 values)
+	//! \param scalarType the VTK type of the voxels (VTK_UNSIGNED_CHAR, VTK_FLOAT, ...)
+	//! \param headerSize number of bytes to skip at the beginning of the file
+	iARawFileConverter(QString const & fileName, int const * dim, int scalarType, qint64 headerSize = 0);
+	//! set a function which is called with the progress (0..100) of the current operation
+	void SetProgressCallback(std::function<void(int)> progress);
+	//! set the maximum number of bytes read at once (rounded down to whole slices, at least one slice); default 64 MB
+	void SetSlabSize(qint64 bytes);
+	//! read the given region (whole image if null) slab by slab
+	//! \param sliceStep only read every sliceStep'th slice of the region
+	bool ReadSlabs(SlabCallback callback, int const * region = nullptr, int sliceStep = 1);
+	//! determine the minimum and maximum voxel value in the file
+	bool ComputeRange(double & min, double & max);
+	//! linearly map [rangeMin, rangeMax] to [outMin, outMax], clamp to [outMin, outMax] and to the range
+	//! of outType, and write the result as MetaImage (mhd header plus raw file next to it)
+	//! \param region the region to convert (whole image if null)
+	//! fails if one of the output files is the input file
+	bool Convert(QString const & mhdFileName, double const * spacing, int outType,
+		double rangeMin, double rangeMax, double outMin, double outMax, int const * region = nullptr);
+	//! the name of the raw file written by Convert next to the given mhd file
+	static QString OutputRawFileName(QString const & mhdFileName);
+	//! description of the last error
+	QString const & ErrorMessage() const;
+private:
+	bool CheckRegion(int const * region);
+	QString m_fileName;
+	int m_dim[3];
+	int m_scalarType;
+	qint64 m_headerSize;
+	qint64 m_slabSize;
+	std::function<void(int)> m_progress;
+	QString m_errorMessage;
+};
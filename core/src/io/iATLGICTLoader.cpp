@@ -22,19 +22,13 @@
 
 #include "dlg_commoninput.h"
 #include "iAConsole.h"
+#include "iAImageStackReader.h"
 #include "iAModality.h"
 #include "iAModalityList.h"
-#include "iAMultiStepProgressObserver.h"
-#include "iAObserverProgress.h"
 #include "mdichild.h"
 
 #include <vtkImageData.h>
 #include <vtkImageReader2.h>
-#include <vtkTIFFReader.h>
-#include <vtkBMPReader.h>
-#include <vtkPNGReader.h>
-#include <vtkJPEGReader.h>
-#include <vtkStringArray.h>
 
 #include <QDateTime>
 #include <QDir>
@@ -54,8 +48,7 @@ namespace
 }
 
 
-iATLGICTLoader::iATLGICTLoader():
-	m_multiStepObserver(0)
+iATLGICTLoader::iATLGICTLoader()
 {}
 
 
@@ -110,13 +103,12 @@ bool iATLGICTLoader::setup(QString const & baseDirectory, QWidget* parent)
 
 void iATLGICTLoader::start(MdiChild* child)
 {
-	m_multiStepObserver = new iAMultiStepProgressObserver(m_subDirs.size());
 	m_child = child;
 	m_child->show();
 	m_child->addMsg(tr("%1  Loading TLGI-CT data, please wait...")
 		.arg(QLocale().toString(QDateTime::currentDateTime(), QLocale::ShortFormat)));
 
-	connect(m_multiStepObserver, SIGNAL(oprogress(int)), m_child, SLOT(updateProgressBar(int)));
+	connect(this, SIGNAL(progress(int)), m_child, SLOT(updateProgressBar(int)));
 	connect(this, SIGNAL(started()), m_child, SLOT(initProgressBar()));
 	connect(this, SIGNAL(finished()), m_child, SLOT(hideProgressBar()));
 	connect(this, SIGNAL(finished()), this, SLOT(finishUp()));		// this needs to be last, as it deletes this object!
@@ -125,9 +117,7 @@ void iATLGICTLoader::start(MdiChild* child)
 
 
 iATLGICTLoader::~iATLGICTLoader()
-{
-	delete m_multiStepObserver;
-}
+{}
 
 
 void iATLGICTLoader::run()
@@ -135,7 +125,8 @@ void iATLGICTLoader::run()
 	m_modList = QSharedPointer<iAModalityList>(new iAModalityList);
 	QStringList imgFilter;
 	imgFilter << "*.tif" << "*.bmp" << "*.jpg" << "*.png";
-	int completedDirs = 0;
+	// collect the slice files of all subdirectories first, so that they can all be read in one parallel pass
+	iAImageStackReader stackReader;
 	for (QFileInfo subDirFileInfo : m_subDirs)
 	{
 		QDir subDir(subDirFileInfo.absoluteFilePath());
@@ -214,50 +205,32 @@ void iATLGICTLoader::run()
 			return;
 		}
 
-		vtkSmartPointer<vtkStringArray> fileNames = vtkSmartPointer<vtkStringArray>::New();
+		if (!iAImageStackReader::CreateReader(ext))
+		{
+			DEBUG_LOG(QString("Unknown or undefined image extension (%1)!").arg(ext));
+			return;
+		}
+		QStringList fileNames;
 		for (int i = min; i <= max; i++)
 		{
 			QString temp = fileNameBase + QString("%1").arg(i, digits, 10, QChar('0')) + "." + ext;
 			temp = temp.replace("/", "\\");
-			fileNames->InsertNextValue(temp.toLatin1());
-		}
-
-		// load image stack // TODO: put to common location and use from iAIO!
-		ext = ext.toLower();
-		vtkSmartPointer<vtkImageReader2> reader;
-		if (ext == "jpg" || ext == "jpeg")
-		{
-			reader = vtkSmartPointer<vtkJPEGReader>::New();
-		}
-		else if (ext == "png")
-		{
-			reader = vtkSmartPointer<vtkPNGReader>::New();
-		}
-		else if (ext == "bmp")
-		{
-			reader = vtkSmartPointer<vtkBMPReader>::New();
-		}
-		else if (ext == "tif" || ext == "tiff")
-		{
-			reader = vtkSmartPointer<vtkTIFFReader>::New();
-		}
-		else
-		{
-			DEBUG_LOG(QString("Unknown or undefined image extension (%1)!").arg(ext));
-			return;
+			fileNames.append(temp);
 		}
-		reader->SetFileNames(fileNames);
-		reader->SetDataOrigin(m_origin);
-		reader->SetDataSpacing(m_spacing);
-		reader->AddObserver(vtkCommand::ProgressEvent, m_multiStepObserver);		// intercept progress and divide by number of images!
-		reader->Update();
-		vtkSmartPointer<vtkImageData> img = reader->GetOutput();
-
+		stackReader.AddStack(fileNames, m_origin, m_spacing);
+	}
+	stackReader.SetProgressCallback([this](int percent) { emit progress(percent); });
+	if (!stackReader.Read())
+	{
+		DEBUG_LOG(QString("Loading TLGI-CT image stacks failed: %1").arg(stackReader.ErrorMessage()));
+		return;
+	}
+	for (int i = 0; i < m_subDirs.size(); ++i)
+	{
 		// add modality
-		QString modName = subDirFileInfo.baseName();
+		QString modName = m_subDirs[i].baseName();
 		modName = modName.left(modName.length() - 4); // 4 => length of "_rec"
-		m_modList->Add(QSharedPointer<iAModality>(new iAModality(modName, subDirFileInfo.absoluteFilePath(), -1, img, 0)));
-		m_multiStepObserver->SetCompletedSteps(++completedDirs);
+		m_modList->Add(QSharedPointer<iAModality>(new iAModality(modName, m_subDirs[i].absoluteFilePath(), -1, stackReader.Image(i), 0)));
 	}
 	if (m_modList->size() == 0)
 	{
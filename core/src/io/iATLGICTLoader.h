@@ -25,7 +25,6 @@
 #include <QThread>
 
 class iAModalityList;
-class iAMultiStepProgressObserver;
 class MdiChild;
 
 class iATLGICTLoader : public QThread
@@ -47,9 +46,10 @@ private:
 	double m_spacing[3];
 	double m_origin[3];
 	QFileInfoList m_subDirs;
-	iAMultiStepProgressObserver* m_multiStepObserver;
 	
 	virtual void run();
+signals:
+	void progress(int percent);
 private slots:
 	void finishUp();
 };
@@ -872,6 +872,8 @@ void MainWindow::savePreferences(QDomDocument &doc)
 	preferencesElement.setAttribute("resultsInNewWindow", tr("%1").arg(defaultPreferences.ResultInNewWindow));
 	preferencesElement.setAttribute("magicLensSize", tr("%1").arg(defaultPreferences.MagicLensSize));
 	preferencesElement.setAttribute("magicLensFrameWidth", tr("%1").arg(defaultPreferences.MagicLensFrameWidth));
+	preferencesElement.setAttribute("memoryMappedLoading", tr("%1").arg(defaultPreferences.MemoryMappedLoading));
+	preferencesElement.setAttribute("imagePyramidCache", tr("%1").arg(defaultPreferences.ImagePyramidCache));
 	preferencesElement.setAttribute("logToFile", tr("%1").arg(iAConsole::GetInstance()->IsLogToFileOn()));
 
 	doc.documentElement().appendChild(preferencesElement);
@@ -887,6 +889,8 @@ void MainWindow::loadPreferences(QDomNode &preferencesNode)
 	defaultPreferences.ResultInNewWindow = attributes.namedItem("resultsInNewWindow").nodeValue() == "1";
 	defaultPreferences.MagicLensSize = attributes.namedItem("magicLensSize").nodeValue().toInt();
 	defaultPreferences.MagicLensFrameWidth = attributes.namedItem("magicLensFrameWidth").nodeValue().toInt();
+	defaultPreferences.MemoryMappedLoading = attributes.namedItem("memoryMappedLoading").nodeValue() == "1";
+	defaultPreferences.ImagePyramidCache = attributes.namedItem("imagePyramidCache").nodeValue() == "1";
 	bool prefLogToFile = attributes.namedItem("logToFile").nodeValue() == "1";
 	QString logFileName = attributes.namedItem("logFile").nodeValue();
 
@@ -1104,7 +1108,9 @@ void MainWindow::prefs()
 		<< tr("#Log File Name")
 		<< tr("+Looks")
 		<< tr("#Magic lens size")
-		<< tr("#Magic lens frame width"));
+		<< tr("#Magic lens frame width")
+		<< tr("$Memory-mapped loading (RAW/MHD)")
+		<< tr("$Cache downsampled images next to the data file"));
 	QStringList looks;
 	QMap<QString, QString> styleNames;
 	styleNames.insert(tr("Dark")      , ":/dark.qss");
@@ -1139,7 +1145,9 @@ void MainWindow::prefs()
 		<< iAConsole::GetInstance()->GetLogFileName()
 		<< looks
 		<< tr("%1").arg(p.MagicLensSize)
-		<< tr("%1").arg(p.MagicLensFrameWidth);
+		<< tr("%1").arg(p.MagicLensFrameWidth)
+		<< (p.MemoryMappedLoading ? tr("true") : tr("false"))
+		<< (p.ImagePyramidCache ? tr("true") : tr("false"));
 
 	dlg_commoninput dlg(this, "Preferences", inList, inPara, fDescr);
 
@@ -1158,6 +1166,8 @@ void MainWindow::prefs()
 		defaultPreferences.MagicLensSize = clamp(MinimumMagicLensSize, MaximumMagicLensSize,
 			static_cast<int>(dlg.getDblValue(7)));
 		defaultPreferences.MagicLensFrameWidth = std::max(0, static_cast<int>(dlg.getDblValue(8)));
+		defaultPreferences.MemoryMappedLoading = dlg.getCheckValue(9) != 0;
+		defaultPreferences.ImagePyramidCache = dlg.getCheckValue(10) != 0;
 
 		if (activeMdiChild() && activeMdiChild()->editPrefs(defaultPreferences))
 			statusBar()->showMessage(tr("Edit preferences"), 5000);
@@ -2433,6 +2443,10 @@ void MainWindow::OpenWithDataTypeConversion()
 			MapVTKTypeStringToInt(outDataType),
 			owdtcmin, owdtcmax, owdtcoutmin, owdtcoutmax, owdtcdov, roi  );
 	}
+	if (testfinalfilename.isEmpty())
+	{
+		return;
+	}
 	LoadFile(testfinalfilename, false);
 }
 
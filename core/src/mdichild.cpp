@@ -36,6 +36,7 @@
 #include "iAChildData.h"
 #include "iAConsole.h"
 #include "iADockWidgetWrapper.h"
+#include "iAImagePyramid.h"
 #include "iALogger.h"
 #include "iAMdiChildLogger.h"
 #include "iAModality.h"
@@ -54,6 +55,7 @@
 #include "iASlicerWidget.h"
 #include "iAToolsVTK.h"
 #include "iATransferFunction.h"
+#include "iAVolumeRenderer.h"
 #include "iAVolumeStack.h"
 #include "iAWidgetAddHelper.h"
 #include "io/extension2id.h"
@@ -512,6 +514,7 @@ bool MdiChild::loadRaw(const QString &f)
 	setCurrentFile(f);
 	waitForPreviousIO();
 	ioThread = new iAIO(imageData, nullptr, m_logger, this);
+	ioThread->setMemoryMappedLoading(preferences.MemoryMappedLoading);
 	connect(ioThread, SIGNAL(done(bool)), this, SLOT(setupView(bool)));
 	connectIOThreadSignals(ioThread);
 	connect(ioThread, SIGNAL(done()), this, SLOT(enableRenderWindows()));
@@ -536,6 +539,23 @@ namespace
 			f.endsWith("tiff", Qt::CaseInsensitive) ||
 			f.endsWith("jpg", Qt::CaseInsensitive);
 	}
+
+	//! number of upcoming time steps the volume player loads in the background
+	const int VolumePlayerPrefetchCount = 2;
+
+	bool SameGeometry(vtkImageData* img1, vtkImageData* img2)
+	{
+		for (int i = 0; i < 3; ++i)
+		{
+			if (img1->GetExtent()[2 * i] != img2->GetExtent()[2 * i] ||
+				img1->GetExtent()[2 * i + 1] != img2->GetExtent()[2 * i + 1] ||
+				img1->GetSpacing()[i] != img2->GetSpacing()[i] ||
+				img1->GetOrigin()[i] != img2->GetOrigin()[i])
+				return false;
+		}
+		return img1->GetScalarType() == img2->GetScalarType() &&
+			img1->GetNumberOfScalarComponents() == img2->GetNumberOfScalarComponents();
+	}
 }
 
 bool MdiChild::loadFile(const QString &f, bool isStack)
@@ -549,6 +569,9 @@ bool MdiChild::loadFile(const QString &f, bool isStack)
 	waitForPreviousIO();
 
 	ioThread = new iAIO(imageData, polyData, m_logger, this, volumeStack->GetVolumes(), volumeStack->GetFileNames());
+	ioThread->setMemoryMappedLoading(preferences.MemoryMappedLoading);
+	// for volume stacks, only the first volume is read now, the volume player loads the others when needed
+	ioThread->setLazyVolumeStackLoading(isStack);
 	if (!isStack || Is2DImageFile(f)) {
 		connect(ioThread, SIGNAL(done(bool)), this, SLOT(setupView(bool)));
 	}
@@ -594,6 +617,19 @@ vtkImageData* MdiChild::getImageData()
 
 bool MdiChild::updateVolumePlayerView(int updateIndex, bool isApplyForAll)
 {
+	vtkSmartPointer<vtkImageData> volume = volumeStack->getVolume(updateIndex);
+	if (!volume)
+	{
+		addMsg(tr("%1  Could not load volume %2 ('%3')!").arg(QLocale().toString(QDateTime::currentDateTime(), QLocale::ShortFormat))
+			.arg(updateIndex).arg(volumeStack->getFileName(updateIndex)));
+		return false;
+	}
+	int numberOfVolumes=volumeStack->getNumberOfVolumes();
+	for (int i = 1; i <= VolumePlayerPrefetchCount && i < numberOfVolumes; ++i)
+	{
+		volumeStack->prefetchVolume((updateIndex + i) % numberOfVolumes);
+	}
+
 	// TODO: VOLUME: Test!!! copy from currently selected instead of fixed 0 index?
 	vtkColorTransferFunction* colorTransferFunction = GetModality(0)->GetTransfer()->GetColorFunction();
 	vtkPiecewiseFunction* piecewiseFunction = GetModality(0)->GetTransfer()->GetOpacityFunction();
@@ -601,8 +637,11 @@ bool MdiChild::updateVolumePlayerView(int updateIndex, bool isApplyForAll)
 	volumeStack->getPiecewiseFunction(previousIndexOfVolume)->DeepCopy(piecewiseFunction);
 	previousIndexOfVolume = updateIndex;
 
-	int numberOfVolumes=volumeStack->getNumberOfVolumes();
-	imageData->DeepCopy(volumeStack->getVolume(updateIndex));
+	// imageData remains the object all views are connected to; it only references
+	// the scalars of the new time step instead of copying them:
+	bool geometryChanged = !SameGeometry(imageData, volume);
+	imageData->ShallowCopy(volume);
+	imageData->Modified();
 
 	if(isApplyForAll) {
 		for (int i=0; i<numberOfVolumes;i++) {
@@ -618,10 +657,15 @@ bool MdiChild::updateVolumePlayerView(int updateIndex, bool isApplyForAll)
 
 	SetHistogramModality(0);
 
-	Raycaster->reInitialize(imageData, polyData);
-	slicerXZ->reInitialize(imageData, slicerTransform, colorTransferFunction);
-	slicerXY->reInitialize(imageData, slicerTransform, colorTransferFunction);
-	slicerYZ->reInitialize(imageData, slicerTransform, colorTransferFunction);
+	// the pipelines pick up the modified image by themselves; only a different
+	// extent or spacing requires setting up renderer and slicers again:
+	if (geometryChanged)
+	{
+		Raycaster->reInitialize(imageData, polyData);
+		slicerXZ->reInitialize(imageData, slicerTransform, colorTransferFunction);
+		slicerXY->reInitialize(imageData, slicerTransform, colorTransferFunction);
+		slicerYZ->reInitialize(imageData, slicerTransform, colorTransferFunction);
+	}
 	updateViews();
 
 	if (CheckedList.at(updateIndex)!=0) {
@@ -645,9 +689,15 @@ bool MdiChild::setupStackView(bool active)
 		return false;
 	}
 
+	auto io = qobject_cast<iAIO*>(sender());
+	if (io && io->getVolumeLoader())
+	{
+		volumeStack->setVolumeLoader(io->getVolumeLoader());
+	}
+
 	int currentIndexOfVolume=0;
 
-	imageData->DeepCopy(volumeStack->getVolume(currentIndexOfVolume));
+	imageData->ShallowCopy(volumeStack->getVolume(currentIndexOfVolume));
 	setupViewInternal(active);
 	for (int i=0; i<numberOfVolumes; i++) {
 		vtkSmartPointer<vtkColorTransferFunction> cTF = GetDefaultColorTransferFunction(imageData->GetScalarRange());
@@ -726,10 +776,51 @@ bool MdiChild::setupView(bool active )
 
 	check2DMode();
 
+	BuildImagePyramid();
+
 	return true;
 }
 
 
+void MdiChild::BuildImagePyramid()
+{
+	m_imagePyramid.clear();
+	if (!imageData || imageData->GetNumberOfPoints() <= iAImagePyramid::InteractionVoxelCount)
+		return;
+	auto workerThread = new iAImagePyramidBuilder(QSharedPointer<iAImagePyramid>(
+		new iAImagePyramid(imageData, preferences.ImagePyramidCache ? curFile : QString())));
+	connect(workerThread, &iAImagePyramidBuilder::PyramidReady, this, &MdiChild::ImagePyramidAvailable);
+	connect(workerThread, &iAImagePyramidBuilder::finished, workerThread, &QObject::deleteLater);
+	workerThread->start();
+}
+
+
+void MdiChild::ImagePyramidAvailable()
+{
+	auto workerThread = qobject_cast<iAImagePyramidBuilder*>(sender());
+	if (!workerThread)
+		return;
+	m_imagePyramid = workerThread->Pyramid();
+	ApplyImagePyramid();
+}
+
+
+void MdiChild::ApplyImagePyramid()
+{
+	if (!m_imagePyramid || !m_imagePyramid->IsBuiltFrom(imageData))
+		return;
+	vtkSmartPointer<vtkImageData> coarse = m_imagePyramid->LevelForVoxelCount(iAImagePyramid::InteractionVoxelCount);
+	if (!coarse)
+		return;
+	if (GetModalities()->size() > 0 && GetModality(0)->GetImage() == imageData && GetModality(0)->GetRenderer())
+		GetModality(0)->GetRenderer()->SetInteractionImage(coarse);
+	iASlicer* slicers[3] = { slicerXY, slicerXZ, slicerYZ };
+	for (iASlicer* slicer : slicers)
+		if (slicer->GetSlicerData()->GetImageData() == imageData.GetPointer())
+			slicer->GetSlicerData()->setInteractionImage(coarse);
+}
+
+
 void MdiChild::updateSliceIndicators()
 {
 	int val;
@@ -2874,6 +2965,7 @@ void MdiChild::StatisticsAvailable(int modalityIdx)
 		slicerXY->reInitialize(GetModality(0)->GetImage(), slicerTransform, modTrans->GetColorFunction());
 		slicerYZ->reInitialize(GetModality(0)->GetImage(), slicerTransform, modTrans->GetColorFunction());
 	}
+	ApplyImagePyramid();
 	ModalityTFChanged();
 	updateViews();
 }
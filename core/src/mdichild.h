@@ -69,6 +69,7 @@ class dlg_volumePlayer;
 class iAAlgorithm;
 class iAChannelVisualizationData;
 class iADiagramFctWidget;
+class iAImagePyramid;
 class iAIO;
 class iALogger;
 class iAModality;
@@ -331,6 +332,7 @@ private slots:
 	void ModalityTFChanged();
 	void HistogramDataAvailable(int modalityIdx);
 	void StatisticsAvailable(int modalityIdx);
+	void ImagePyramidAvailable();
 
 public slots:
 	void updateProgressBar(int i);
@@ -446,6 +448,10 @@ private:
 	void updateSnakeSlicer(QSpinBox* spinBox, iASlicer* slicer, int ptIndex, int s);
 	void setupViewInternal(bool active);
 	bool IsVolumeDataLoaded() const;
+	//! start computing downsampled versions of the image in the background
+	void BuildImagePyramid();
+	//! hand the downsampled image to renderer and slicers, if it still matches the current image
+	void ApplyImagePyramid();
 
 	vtkSmartPointer<vtkImageData> imageData;		// TODO: remove - use modality data instead!
 	vtkPolyData* polyData;
@@ -456,6 +462,8 @@ private:
 	iASlicer * slicerYZ, * slicerXY, * slicerXZ;
 	QSharedPointer<iAProfileProbe> profileProbe;
 	QScopedPointer<iAVolumeStack> volumeStack;
+	//! downsampled versions of imageData, used while interacting with slicers and renderer
+	QSharedPointer<iAImagePyramid> m_imagePyramid;
 	iAIO* ioThread;
 
 	iADiagramFctWidget* m_histogram;
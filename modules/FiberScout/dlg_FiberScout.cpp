@@ -29,6 +29,8 @@
 #include "iABlobCluster.h"
 #include "iABlobManager.h"
 #include "iAFiberScoutScatterPlotMatrix.h"
+#include "iALabelColorTable.h"
+#include "iAMeanObject.h"
 #include "charts/iADiagramFctWidget.h"
 #include "iAMeanObjectTFView.h"
 #include "iAModalityTransfer.h"
@@ -38,21 +40,10 @@
 #include "iARenderer.h"
 #include "mdichild.h"
 
-#include <itkAddImageFilter.h>
-#include <itkBinaryThresholdImageFilter.h>
-#include <itkCastImageFilter.h>
-#include <itkImageRegionIterator.h>
-#include <itkImageToVTKImageFilter.h>
-#include <itkLabelImageToLabelMapFilter.h>
-#include <itkLabelMapMaskImageFilter.h>
-#include <itkPasteImageFilter.h>
-#include <itkVTKImageToImageFilter.h>
-
 #include <vtkActor.h>
 #include <vtkActor2D.h>
 #include <vtkAnnotationLink.h>
 #include <vtkAxis.h>
-#include <vtkImageCast.h>
 #include <vtkCamera.h>
 #include <vtkChart.h>
 #include <vtkChartParallelCoordinates.h>
@@ -68,6 +59,7 @@
 #include <vtkFixedPointVolumeRayCastMapper.h>
 #include <vtkFloatArray.h>
 #include <vtkIdTypeArray.h>
+#include <vtkImageData.h>
 #include <vtkIntArray.h>
 #include <vtkInteractorStyleTrackballCamera.h>
 #include <vtkLookupTable.h>
@@ -124,6 +116,7 @@
 #include <QTreeView>
 #include <QProgressBar>
 
+#include <algorithm>
 #include <cmath>
 
 //Global defines for initial layout
@@ -178,6 +171,7 @@ dlg_FiberScout::dlg_FiberScout( MdiChild *parent, iAObjectAnalysisType fid, vtkR
 	: QDockWidget( parent ),
 	oTF( parent->getPiecewiseFunction() ),
 	cTF( parent->getColorTransferFunction() ),
+	m_labelColors( new iALabelColorTable( parent->getPiecewiseFunction(), parent->getColorTransferFunction() ) ),
 	csvTable( csvtbl ),
 	raycaster( parent->getRenderer() ),
 	elementTableModel( 0 ),
@@ -198,6 +192,7 @@ dlg_FiberScout::dlg_FiberScout( MdiChild *parent, iAObjectAnalysisType fid, vtkR
 	this->draw3DPolarPlot = false;
 	this->enableRealTimeRendering = true;
 	this->classRendering = true;
+	m_labelColors->SetLabelCount( this->objectNr + 1 );	// label 0 is the background
 	this->setupPolarPlotResolution( 3.0 );
 
 	this->raycaster = raycaster;
@@ -826,104 +821,18 @@ void dlg_FiberScout::RenderingButton()
 
 	//double alpha = 1.0;
 	double alpha = this->calculateOpacity( rootItem );
-	double red = 0.0;
-	double green = 0.0;
-	double blue = 0.0;
-	int CID = 0;
-
-	// clear existing points
-	this->oTF->RemoveAllPoints();
-	this->cTF->RemoveAllPoints();
-
-	// set background opacity and color
-	this->oTF->ClampingOff();
-	this->cTF->ClampingOff();
 
 	// Iterate trough all classes to render, starting with 0 unclassified, 1 Class1,...
+	m_labelColors->Fill( backRGB, backAlpha );
 	for ( int i = 0; i < classCount; i++ )
 	{
 		// alpha = colorList.at(i).alpha()/255.0;
-		red = colorList.at( i ).redF();
-		green = colorList.at( i ).greenF();
-		blue = colorList.at( i ).blueF();
-
+		double rgb[3] = { colorList.at( i ).redF(), colorList.at( i ).greenF(), colorList.at( i ).blueF() };
 		QStandardItem *item = rootItem->child( i, 0 );
-		int itemL = item->rowCount();
-
-		// Class has no objects, proceed with next class
-		if ( !itemL )
-			continue;
-
-		int hid = 0, next_hid = 1;
-		bool starting = false;
-
-		for ( int j = 0; j < itemL; ++j )
-		{
-			hid = item->child( j, 0 )->text().toInt();
-
-			if ( ( j + 1 ) < itemL )
-			{
-				next_hid = item->child( j + 1, 0 )->text().toInt();
-			}
-			else
-			{
-				if ( starting )
-				{
-					oTF->AddPoint( hid, alpha, 0.5, 1.0 );
-					oTF->AddPoint( hid + 0.3, backAlpha, 0.5, 1.0 );
-					cTF->AddRGBPoint( hid, red, green, blue, 0.5, 1.0 );
-					cTF->AddRGBPoint( hid + 0.3, backRGB[0], backRGB[1], backRGB[2], 0.5, 1.0 );
-					break;
-				}
-				else
-				{
-					oTF->AddPoint( hid - 0.5, backAlpha, 0.5, 1.0 );
-					oTF->AddPoint( hid, alpha, 0.5, 1.0 );
-					cTF->AddRGBPoint( hid - 0.5, backRGB[0], backRGB[1], backRGB[2], 0.5, 1.0 );
-					cTF->AddRGBPoint( hid, red, green, blue, 0.5, 1.0 );
-					oTF->AddPoint( hid + 0.3, backAlpha, 0.5, 1.0 );
-					cTF->AddRGBPoint( hid + 0.3, backRGB[0], backRGB[1], backRGB[2], 0.5, 1.0 );
-					break;
-				}
-			}
-
-			//Create one single tooth
-			if ( next_hid > hid + 1 && !starting )
-			{
-				oTF->AddPoint( hid - 0.5, backAlpha, 0.5, 1.0 );
-				oTF->AddPoint( hid, alpha, 0.5, 1.0 );
-				oTF->AddPoint( hid + 0.3, backAlpha, 0.5, 1.0 );
-				cTF->AddRGBPoint( hid - 0.5, backRGB[0], backRGB[1], backRGB[2], 0.5, 1.0 );
-				cTF->AddRGBPoint( hid, red, green, blue, 0.5, 1.0 );
-				cTF->AddRGBPoint( hid + 0.3, backRGB[0], backRGB[1], backRGB[2], 0.5, 1.0 );
-			}
-			else if ( next_hid == hid + 1 && !starting )
-			{
-				starting = true;
-				oTF->AddPoint( hid - 0.5, backAlpha, 0.5, 1.0 );
-				oTF->AddPoint( hid, alpha, 0.5, 1.0 );
-				cTF->AddRGBPoint( hid - 0.5, backRGB[0], backRGB[1], backRGB[2], 0.5, 1.0 );
-				cTF->AddRGBPoint( hid, red, green, blue, 0.5, 1.0 );
-			}
-			else if ( next_hid == hid + 1 && starting )
-				continue;
-
-			else if ( next_hid > hid + 1 && starting )
-			{
-				starting = false;
-				oTF->AddPoint( hid, alpha, 0.5, 1.0 );
-				oTF->AddPoint( hid + 0.3, backAlpha, 0.5, 1.0 );
-				cTF->AddRGBPoint( hid, red, green, blue, 0.5, 1.0 );
-				cTF->AddRGBPoint( hid + 0.3, backRGB[0], backRGB[1], backRGB[2], 0.5, 1.0 );
-			}
-		}
-
-		if ( hid < objectNr )
-		{
-			this->oTF->AddPoint( objectNr + 0.3, backAlpha, 0.5, 1.0 );
-			this->cTF->AddRGBPoint( objectNr + 0.3, backRGB[0], backRGB[1], backRGB[2], 0.5, 1.0 );
-		}
+		for ( int j = 0; j < item->rowCount(); ++j )
+			m_labelColors->SetLabel( item->child( j, 0 )->text().toInt(), rgb, alpha );
 	}
+	m_labelColors->Update();
 
 	// update lookup table in PC View
 	this->updateLookupTable( alpha );
@@ -952,111 +861,18 @@ void dlg_FiberScout::SingleRendering( int idx )
 {
 	int cID = this->activeClassItem->index().row();
 	int itemL = this->activeClassItem->rowCount();
-	double red = colorList.at( cID ).redF(), 
-		   green = colorList.at( cID ).greenF(),
-		   blue = colorList.at( cID ).blueF(), 
+	double rgb[3] = { colorList.at( cID ).redF(), colorList.at( cID ).greenF(), colorList.at( cID ).blueF() },
 		   alpha = 0.5, 
 		   backAlpha = 0.0, 
 		   backRGB[3] = { 0.0, 0.0, 0.0 };
 
-	// clear existing points
-	this->oTF->RemoveAllPoints();
-	this->cTF->RemoveAllPoints();
-
-	// set background opacity and color with clamping off
-	this->oTF->ClampingOff();
-	this->cTF->ClampingOff();
-	this->oTF->AddPoint( 0, backAlpha );
-	this->cTF->AddRGBPoint( 0, backRGB[0], backRGB[1], backRGB[2] );
-
+	m_labelColors->Fill( backRGB, backAlpha );
 	if ( idx > 0 ) // for single object selection
-	{
-		if ( ( idx - 1 ) >= 0 )
-		{
-			this->oTF->AddPoint( idx - 0.5, backAlpha );
-			this->oTF->AddPoint( idx - 0.49, alpha );
-			this->cTF->AddRGBPoint( idx - 0.5, backRGB[0], backRGB[1], backRGB[2] );
-			this->cTF->AddRGBPoint( idx - 0.49, red, green, blue );
-		}
-		oTF->AddPoint( idx, alpha );
-		cTF->AddRGBPoint( idx, red, green, blue );
-		if ( ( idx + 1 ) <= objectNr )
-		{
-			this->oTF->AddPoint( idx + 0.3, backAlpha );
-			this->oTF->AddPoint( idx + 0.29, alpha );
-			this->cTF->AddRGBPoint( idx + 0.3, backRGB[0], backRGB[1], backRGB[2] );
-			this->cTF->AddRGBPoint( idx + 0.29, red, green, blue );
-		}
-	}
+		m_labelColors->SetLabel( idx, rgb, alpha );
 	else // for single class selection
-	{
-		int hid = 0, next_hid = 1;
-		bool starting = false;
-
 		for ( int j = 0; j < itemL; ++j )
-		{
-			hid = this->activeClassItem->child( j, 0 )->text().toInt();
-
-			if ( j + 1 < itemL )
-				next_hid = this->activeClassItem->child( j + 1, 0 )->text().toInt();
-			else
-			{
-				if ( starting )
-				{
-					oTF->AddPoint( hid, alpha, 0.5, 1.0 );
-					oTF->AddPoint( hid + 0.3, backAlpha, 0.5, 1.0 );
-					cTF->AddRGBPoint( hid, red, green, blue, 0.5, 1.0 );
-					cTF->AddRGBPoint( hid + 0.3, backRGB[0], backRGB[1], backRGB[2], 0.5, 1.0 );
-					break;
-				}
-				else
-				{
-					oTF->AddPoint( hid - 0.5, backAlpha, 0.5, 1.0 );
-					oTF->AddPoint( hid, alpha, 0.5, 1.0 );
-					cTF->AddRGBPoint( hid - 0.5, backRGB[0], backRGB[1], backRGB[2], 0.5, 1.0 );
-					cTF->AddRGBPoint( hid, red, green, blue, 0.5, 1.0 );
-					oTF->AddPoint( hid + 0.3, backAlpha, 0.5, 1.0 );
-					cTF->AddRGBPoint( hid + 0.3, backRGB[0], backRGB[1], backRGB[2], 0.5, 1.0 );
-					break;
-				}
-			}
-
-			//Create one single tooth
-			if ( next_hid > hid + 1 && !starting )
-			{
-				oTF->AddPoint( hid - 0.5, backAlpha, 0.5, 1.0 );
-				oTF->AddPoint( hid, alpha, 0.5, 1.0 );
-				oTF->AddPoint( hid + 0.3, backAlpha, 0.5, 1.0 );
-				cTF->AddRGBPoint( hid - 0.5, backRGB[0], backRGB[1], backRGB[2], 0.5, 1.0 );
-				cTF->AddRGBPoint( hid, red, green, blue, 0.5, 1.0 );
-				cTF->AddRGBPoint( hid + 0.3, backRGB[0], backRGB[1], backRGB[2], 0.5, 1.0 );
-			}
-			else if ( next_hid == hid + 1 && !starting )
-			{
-				starting = true;
-				oTF->AddPoint( hid - 0.5, backAlpha, 0.5, 1.0 );
-				oTF->AddPoint( hid, alpha, 0.5, 1.0 );
-				cTF->AddRGBPoint( hid - 0.5, backRGB[0], backRGB[1], backRGB[2], 0.5, 1.0 );
-				cTF->AddRGBPoint( hid, red, green, blue, 0.5, 1.0 );
-			}
-			else if ( next_hid == hid + 1 && starting )
-				continue;
-			else if ( next_hid > hid + 1 && starting )
-			{
-				starting = false;
-				oTF->AddPoint( hid, alpha, 0.5, 1.0 );
-				oTF->AddPoint( hid + 0.3, backAlpha, 0.5, 1.0 );
-				cTF->AddRGBPoint( hid, red, green, blue, 0.5, 1.0 );
-				cTF->AddRGBPoint( hid + 0.3, backRGB[0], backRGB[1], backRGB[2], 0.5, 1.0 );
-			}
-		}
-
-		if ( hid < objectNr )
-		{
-			this->oTF->AddPoint( objectNr + 0.3, backAlpha, 0.5, 1.0 );
-			this->cTF->AddRGBPoint( objectNr + 0.3, backRGB[0], backRGB[1], backRGB[2], 0.5, 1.0 );
-		}
-	}
+			m_labelColors->SetLabel( this->activeClassItem->child( j, 0 )->text().toInt(), rgb, alpha );
+	m_labelColors->Update();
 	raycaster->update();
 }
 
@@ -1079,175 +895,24 @@ void dlg_FiberScout::RealTimeRendering( vtkIdTypeArray *selection, bool enabled
 
 		if ( countClass > 0 )
 		{
-			double red = 0.0, green = 0.0, blue = 0.0, alpha = 0.5, backAlpha = 0.00, backRGB[3], classRGB[3], selRGB[3];
+			double alpha = 0.5, backAlpha = 0.00, backRGB[3], classRGB[3], selRGB[3];
 			backRGB[0] = 0.5; backRGB[1] = 0.5; backRGB[2] = 0.5;
 			selRGB[0] = 1.0; selRGB[1] = 0.0; selRGB[2] = 0.0;	//selection color
 			classRGB[0] = colorList.at( activeClassItem->index().row() ).redF();
 			classRGB[1] = colorList.at( activeClassItem->index().row() ).greenF();
 			classRGB[2] = colorList.at( activeClassItem->index().row() ).blueF();
 
-			// clear existing points
-			this->oTF->RemoveAllPoints();
-			this->cTF->RemoveAllPoints();
-
-			this->oTF->ClampingOff();
-			this->cTF->ClampingOff();
-
-			this->oTF->AddPoint( 0, backAlpha, 0.5, 1.0 );
-			this->cTF->AddRGBPoint( 0, backRGB[0], backRGB[1], backRGB[2], 0.5, 1.0 );
-
-			int hid = 0, next_hid = 1, selectionIndex = 0, previous_selectionIndex = 0;
-			bool starting = false, hid_isASelection = false, previous_hid_isASelection = false;
-
+			// only the labels which actually change color are updated in the transfer functions:
+			m_labelColors->Fill( backRGB, backAlpha );
 			for ( int j = 0; j < countClass; ++j )
+				m_labelColors->SetLabel( this->activeClassItem->child( j )->text().toInt(), classRGB, alpha );
+			for ( int s = 0; s < countSelection; ++s )
 			{
-				hid = this->activeClassItem->child( j )->text().toInt();
-
-				if ( countSelection > 0 )
-				{
-					if ( j == selection->GetVariantValue( selectionIndex ).ToInt() )
-					{
-						hid_isASelection = true;
-						red = selRGB[0], green = selRGB[1], blue = selRGB[2];
-
-						if ( selectionIndex + 1 < selection->GetNumberOfTuples() )
-							selectionIndex++;
-					}
-					else
-					{
-						hid_isASelection = false;
-						red = classRGB[0]; green = classRGB[1]; blue = classRGB[2];
-					}
-
-					if ( j > 0 )
-					{
-						if ( j - 1 == selection->GetVariantValue( previous_selectionIndex ).ToInt() )
-						{
-							previous_hid_isASelection = true;
-
-							if ( previous_selectionIndex + 1 < selection->GetNumberOfTuples() )
-								previous_selectionIndex++;
-						}
-						else
-							previous_hid_isASelection = false;
-					}
-				}
-				else
-				{
-					red = classRGB[0]; green = classRGB[1]; blue = classRGB[2];
-				}
-
-				// If we are not yet at the last object (of the class) get the next hid 
-				if ( ( j + 1 ) < countClass )
-				{
-					next_hid = this->activeClassItem->child( j + 1 )->text().toInt();
-				}
-				else	// If hid = the last object (of the class) we have to set the last object points
-				{
-					if ( starting )	// If we are in a sequence we have to set the ending (\)
-					{
-						oTF->AddPoint( hid - 1 + 0.3, alpha, 0.5, 1.0 );
-						oTF->AddPoint( hid - 0.5, alpha, 0.5, 1.0 );
-						oTF->AddPoint( hid, alpha, 0.5, 1.0 );
-						oTF->AddPoint( hid + 0.3, backAlpha, 0.5, 1.0 );
-
-						if ( hid_isASelection )
-						{
-							cTF->AddRGBPoint( hid - 0.5, 1.0, 0.0, 0.0, 0.5, 1.0 );
-							cTF->AddRGBPoint( hid, 1.0, 0.0, 0.0, 0.5, 1.0 );
-							cTF->AddRGBPoint( hid + 0.3, backRGB[0], backRGB[1], backRGB[2], 0.5, 1.0 );
-						}
-						else
-						{
-							cTF->AddRGBPoint( hid - 0.5, classRGB[0], classRGB[1], classRGB[2], 0.5, 1.0 );
-							cTF->AddRGBPoint( hid, classRGB[0], classRGB[1], classRGB[2], 0.5, 1.0 );
-							cTF->AddRGBPoint( hid + 0.3, backRGB[0], backRGB[1], backRGB[2], 0.5, 1.0 );
-						}
-
-						if ( previous_hid_isASelection )
-							cTF->AddRGBPoint( hid - 1 + 0.3, 1.0, 0.0, 0.0, 0.5, 1.0 );
-						else
-							cTF->AddRGBPoint( hid - 1 + 0.3, classRGB[0], classRGB[1], classRGB[2], 0.5, 1.0 );
-						break;
-					}
-					else	// if we are not in a sequence we have to create the last tooth (/\)
-					{
-						oTF->AddPoint( hid - 0.5, backAlpha, 0.5, 1.0 );
-						oTF->AddPoint( hid, alpha, 0.5, 1.0 );
-						oTF->AddPoint( hid + 0.3, backAlpha, 0.5, 1.0 );
-
-						cTF->AddRGBPoint( hid - 0.5, backRGB[0], backRGB[1], backRGB[2], 0.5, 1.0 );
-						cTF->AddRGBPoint( hid, red, green, blue, 0.5, 1.0 );
-						cTF->AddRGBPoint( hid + 0.3, backRGB[0], backRGB[1], backRGB[2], 0.5, 1.0 );
-						break;
-					}
-				}
-
-				if ( next_hid > hid + 1 && !starting )		//Create one single tooth
-				{
-					oTF->AddPoint( hid - 0.5, backAlpha, 0.5, 1.0 );
-					oTF->AddPoint( hid, alpha, 0.5, 1.0 );
-					oTF->AddPoint( hid + 0.3, backAlpha, 0.5, 1.0 );
-					cTF->AddRGBPoint( hid - 0.5, backRGB[0], backRGB[1], backRGB[2], 0.5, 1.0 );
-					cTF->AddRGBPoint( hid, red, green, blue, 0.5, 1.0 );
-					cTF->AddRGBPoint( hid + 0.3, backRGB[0], backRGB[1], backRGB[2], 0.5, 1.0 );
-				}
-				else if ( next_hid == hid + 1 && !starting )	//Creates the beginning of a sequence (/)
-				{
-					starting = true;
-					oTF->AddPoint( hid - 0.5, backAlpha, 0.5, 1.0 );
-					oTF->AddPoint( hid, alpha, 0.5, 1.0 );
-					cTF->AddRGBPoint( hid - 0.5, backRGB[0], backRGB[1], backRGB[2], 0.5, 1.0 );
-					cTF->AddRGBPoint( hid, red, green, blue, 0.5, 1.0 );
-				}
-				else if ( next_hid == hid + 1 && starting )	//Continous the started sequence (-)
-				{
-					if ( !hid_isASelection && previous_hid_isASelection )
-					{
-						cTF->AddRGBPoint( hid - 1 + 0.3, selRGB[0], selRGB[1], selRGB[2], 0.5, 1.0 );
-						cTF->AddRGBPoint( hid - 0.5, classRGB[0], classRGB[1], classRGB[2], 0.5, 1.0 );
-						cTF->AddRGBPoint( hid + 0.3, classRGB[0], classRGB[1], classRGB[2], 0.5, 1.0 );
-
-						oTF->AddPoint( hid - 1 + 0.3, alpha, 0.5, 1.0 );
-						oTF->AddPoint( hid - 0.5, alpha, 0.5, 1.0 );
-						oTF->AddPoint( hid + 0.3, alpha, 0.5, 1.0 );
-					}
-					else if ( hid_isASelection && !previous_hid_isASelection )
-					{
-						cTF->AddRGBPoint( hid - 0.5, selRGB[0], selRGB[1], selRGB[2], 0.5, 1.0 );
-						cTF->AddRGBPoint( hid + 0.3, selRGB[0], selRGB[1], selRGB[2], 0.5, 1.0 );
-						cTF->AddRGBPoint( hid - 1 + 0.3, classRGB[0], classRGB[1], classRGB[2], 0.5, 1.0 );
-
-						oTF->AddPoint( hid - 0.5, alpha, 0.5, 1.0 );
-						oTF->AddPoint( hid + 0.3, alpha, 0.5, 1.0 );
-						oTF->AddPoint( hid - 1 + 0.3, alpha, 0.5, 1.0 );
-					}
-				}
-				else if ( next_hid > hid + 1 && starting )	//  (\)
-				{
-					starting = false;
-
-					oTF->AddPoint( hid - 1 + 0.3, alpha, 0.5, 1.0 );
-					oTF->AddPoint( hid - 0.5, alpha, 0.5, 1.0 );
-					oTF->AddPoint( hid, alpha, 0.5, 1.0 );
-					oTF->AddPoint( hid + 0.3, backAlpha, 0.5, 1.0 );
-
-					if ( previous_hid_isASelection )
-						cTF->AddRGBPoint( hid - 1 + 0.3, selRGB[0], selRGB[1], selRGB[2], 0.5, 1.0 );
-					else
-						cTF->AddRGBPoint( hid - 1 + 0.3, classRGB[0], classRGB[1], classRGB[2], 0.5, 1.0 );
-
-					cTF->AddRGBPoint( hid - 0.5, red, green, blue, 0.5, 1.0 );
-					cTF->AddRGBPoint( hid, red, green, blue, 0.5, 1.0 );
-					cTF->AddRGBPoint( hid + 0.3, backRGB[0], backRGB[1], backRGB[2], 0.5, 1.0 );
-				}
-			}
-
-			if ( hid < objectNr )	// Creates the very last points (for all objects)  if it's not created yet
-			{
-				this->oTF->AddPoint( objectNr + 0.3, backAlpha, 0.5, 1.0 );
-				this->cTF->AddRGBPoint( objectNr + 0.3, backRGB[0], backRGB[1], backRGB[2], 0.5, 1.0 );
+				vtkIdType j = selection->GetValue( s );
+				if ( j >= 0 && j < countClass )
+					m_labelColors->SetLabel( this->activeClassItem->child( j )->text().toInt(), selRGB, alpha );
 			}
+			m_labelColors->Update();
 			MdiChild * mdiChild = static_cast<MdiChild*>(activeChild);
 			mdiChild->updateViews();
 			//raycaster->update();
@@ -1280,173 +945,29 @@ void dlg_FiberScout::RenderingFiberMeanObject()
 	m_MOData.moVolumePropertyList.clear();
 	m_MOData.moImageDataList.clear();
 
-	// Casts image to long (if necessary) and convert it to an ITK image
-	typedef itk::Image< long, DIM > IType;
-	typedef itk::VTKImageToImageFilter<IType> VTKToITKConnector;
-	VTKToITKConnector::Pointer vtkToItkConverter = VTKToITKConnector::New();
-	if ( static_cast<MdiChild*>( activeChild )->getImagePointer()->GetScalarType() != 8 )	// long type
-	{
-		vtkSmartPointer<vtkImageCast> cast = vtkSmartPointer<vtkImageCast>::New();
-		cast->SetInputData( static_cast<MdiChild*>( activeChild )->getImagePointer() );
-		cast->SetOutputScalarTypeToLong();
-		cast->Update();
-		vtkToItkConverter->SetInput( cast->GetOutput() );
-	}
-	else
-		vtkToItkConverter->SetInput( static_cast<MdiChild*>( activeChild )->getImagePointer() );
-	vtkToItkConverter->Update();
-
-	IType::Pointer itkImageData = vtkToItkConverter->GetOutput();
-	double spacing[3];
-	spacing[0] = static_cast<MdiChild*>( activeChild )->getImagePointer()->GetSpacing()[0];
-	spacing[1] = static_cast<MdiChild*>( activeChild )->getImagePointer()->GetSpacing()[1];
-	spacing[2] = static_cast<MdiChild*>( activeChild )->getImagePointer()->GetSpacing()[2];
-	itk::Size<DIM> itkImageDataSize = itkImageData->GetLargestPossibleRegion().GetSize();
-
-	typedef itk::BinaryThresholdImageFilter <IType, IType> BinaryThresholdImageFilterType;
-	BinaryThresholdImageFilterType::Pointer thresholdFilter = BinaryThresholdImageFilterType::New();
-	thresholdFilter->SetInput( itkImageData );
-	thresholdFilter->SetLowerThreshold( 0 );
-	thresholdFilter->SetUpperThreshold( 0 );
-	thresholdFilter->SetInsideValue( 0 );
-	thresholdFilter->SetOutsideValue( 1 );
-	thresholdFilter->Update();
-	typedef itk::LabelObject< long, DIM > LabelObjectType;
-	typedef itk::LabelMap< LabelObjectType > LabelMapType;
-	typedef itk::LabelImageToLabelMapFilter< IType, LabelMapType> I2LType;
-	I2LType::Pointer i2l = I2LType::New();
-	i2l->SetInput( itkImageData );
-
-	typedef itk::LabelMapMaskImageFilter< LabelMapType, IType > MaskType;
-	MaskType::Pointer mask = MaskType::New();
-	mask->SetInput( i2l->GetOutput() );
-	mask->SetFeatureImage( thresholdFilter->GetOutput() );
-	mask->SetBackgroundValue( 0 );
-	mask->SetCrop( true );
-
-	// Defines mean object output image
-	typedef long MObjectImagePixelType;
-	typedef itk::Image< MObjectImagePixelType, DIM > MObjectImageType;
-	MObjectImageType::RegionType outputRegion;
-	MObjectImageType::RegionType::IndexType outputStart;
-	outputStart[0] = 0; outputStart[1] = 0; outputStart[2] = 0;
-	itk::Size<DIM> moImgSize;
-	itk::Size<DIM> moImgCenter;
-	for ( int i = 0; i < DIM; ++i )
-	{
-		itkImageDataSize[i] % 2 == 0 ?
-			moImgSize[i] = itkImageDataSize[i] + 1 :
-			moImgSize[i] = itkImageDataSize[i];
-		moImgCenter[i] = std::round( moImgSize[i] / 2.0 );
-	}
-	outputRegion.SetSize( moImgSize );
-	outputRegion.SetIndex( outputStart );
-	MObjectImageType::Pointer mObjectITKImage = MObjectImageType::New();
-	mObjectITKImage->SetRegions( outputRegion );
-	const MObjectImageType::SpacingType& out_spacing = itkImageData->GetSpacing();
-	const MObjectImageType::PointType& inputOrigin = itkImageData->GetOrigin();
-	double outputOrigin[DIM];
-	for ( unsigned int i = 0; i < DIM; i++ )
-		outputOrigin[i] = inputOrigin[i];
-	mObjectITKImage->SetSpacing( out_spacing );
-	mObjectITKImage->SetOrigin( outputOrigin );
-	mObjectITKImage->Allocate();
-
-	// Defines add image
-	typedef long addImagePixelType;
-	typedef itk::Image< addImagePixelType, DIM > addImageType;
-	addImageType::RegionType addoutputRegion;
-	addImageType::RegionType::IndexType addoutputStart;
-	addoutputStart[0] = 0; addoutputStart[1] = 0; addoutputStart[2] = 0;
-	addoutputRegion.SetSize( moImgSize );
-	addoutputRegion.SetIndex( outputStart );
-	addImageType::Pointer addImage = addImageType::New();
-	addImage->SetRegions( addoutputRegion );
-	const addImageType::SpacingType& addout_spacing = itkImageData->GetSpacing();
-	const addImageType::PointType& addinputOrigin = itkImageData->GetOrigin();
-	double addoutputOrigin[DIM];
-	for ( unsigned int i = 0; i < DIM; i++ )
-		addoutputOrigin[i] = addinputOrigin[i];
-	addImage->SetSpacing( addout_spacing );
-	addImage->SetOrigin( addoutputOrigin );
-	addImage->Allocate();
+	// Mean object images have an odd size, so that there is a center voxel
+	vtkImageData * labelImage = mdiChild->getImagePointer();
+	int moImgSize[3];
+	for ( int i = 0; i < 3; ++i )
+		moImgSize[i] = labelImage->GetDimensions()[i] % 2 == 0 ?
+			labelImage->GetDimensions()[i] + 1 :
+			labelImage->GetDimensions()[i];
+
+	// Bounding boxes of all objects, determined in a single pass over the labelled image
+	std::vector<iALabelBoundingBox> objectBoxes = ComputeLabelBoundingBoxes( labelImage, objectNr );
 
 	for ( int currClass = 1; currClass < classCount; ++currClass )
 	{
-		std::map<int, int>* meanObjectIds = new std::map<int, int>();
+		std::vector<int> meanObjectIds;
 		for ( int j = 0; j < classTreeModel->invisibleRootItem()->child( currClass )->rowCount(); ++j )
-		{
-			if ( filterID == INDIVIDUAL_FIBRE_VISUALIZATION )
-				meanObjectIds->operator[]( tableList[currClass]->GetValue( j, 0 ).ToInt() ) =
-				tableList[currClass]->GetValue( j, 0 ).ToFloat();
-			else
-				meanObjectIds->operator[]( tableList[currClass]->GetValue( j, 0 ).ToInt() ) =
-				tableList[currClass]->GetValue( j, 0 ).ToFloat();
-		}
-
-		typedef itk::ImageRegionIterator< MObjectImageType> IteratorType;
-		IteratorType mOITKImgIt( mObjectITKImage, outputRegion );
-		for ( mOITKImgIt.GoToBegin(); !mOITKImgIt.IsAtEnd(); ++mOITKImgIt )
-			mOITKImgIt.Set( 0 );
-
-		typedef itk::ImageRegionIterator< addImageType> IteratorType;
-		IteratorType addImgIt( addImage, addoutputRegion );
-		for ( addImgIt.GoToBegin(); !addImgIt.IsAtEnd(); ++addImgIt )
-			addImgIt.Set( 0 );
+			meanObjectIds.push_back( tableList[currClass]->GetValue( j, 0 ).ToInt() );
+		std::sort( meanObjectIds.begin(), meanObjectIds.end() );
+		meanObjectIds.erase( std::unique( meanObjectIds.begin(), meanObjectIds.end() ), meanObjectIds.end() );
 
-		int progress = 0;
-		std::map<int, int>::const_iterator it;
-		for ( it = meanObjectIds->begin(); it != meanObjectIds->end(); ++it )
-		{
-			mask->SetLabel( it->first );
-			mask->Update();
-			itk::Size<DIM> maskSize;
-			maskSize = mask->GetOutput()->GetLargestPossibleRegion().GetSize();
-
-			IType::IndexType destinationIndex;
-			destinationIndex[0] = moImgCenter[0] - std::round( maskSize[0] / 2 );
-			destinationIndex[1] = moImgCenter[1] - std::round( maskSize[1] / 2 );
-			destinationIndex[2] = moImgCenter[2] - std::round( maskSize[2] / 2 );
-			typedef itk::PasteImageFilter <IType, MObjectImageType > PasteImageFilterType;
-			PasteImageFilterType::Pointer pasteFilter = PasteImageFilterType::New();
-			pasteFilter->SetSourceImage( mask->GetOutput() );
-			pasteFilter->SetDestinationImage( mObjectITKImage );
-			pasteFilter->SetSourceRegion( mask->GetOutput()->GetLargestPossibleRegion() );
-			pasteFilter->SetDestinationIndex( destinationIndex );
-
-			typedef itk::AddImageFilter <MObjectImageType, MObjectImageType > AddImageFilterType;
-			AddImageFilterType::Pointer addFilter = AddImageFilterType::New();
-			addFilter->SetInput1( addImage );
-			addFilter->SetInput2( pasteFilter->GetOutput() );
-			addFilter->Update();
-			addImage = addFilter->GetOutput();
-
-			double percentage = round( ( currClass - 1 ) * 100.0 / ( classCount - 1 ) +
-									   ( progress + 1.0 ) * ( 100.0 / ( classCount - 1 ) ) / meanObjectIds->size() );
-			mdiChild->updateProgressBar( percentage );
-			QCoreApplication::processEvents();
-			progress++;
-		}
-
-		// Normalize voxels values to 1
-		typedef itk::Image< float, DIM > moOutputImageType;
-		typedef itk::CastImageFilter< addImageType, moOutputImageType > CastFilterType;
-		CastFilterType::Pointer caster = CastFilterType::New();
-		caster->SetInput( addImage );
-		caster->Update();
-		typedef itk::ImageRegionIterator< moOutputImageType> casterIteratorType;
-		casterIteratorType casterImgIt( caster->GetOutput(), caster->GetOutput()->GetLargestPossibleRegion() );
-		for ( casterImgIt.GoToBegin(); !casterImgIt.IsAtEnd(); ++casterImgIt )
-			casterImgIt.Set( casterImgIt.Get() / meanObjectIds->size() );
-
-		// Convert resulting MObject ITK image to an VTK image
-		typedef itk::ImageToVTKImageFilter<moOutputImageType> ITKTOVTKConverterType;
-		ITKTOVTKConverterType::Pointer itkToVTKConverter = ITKTOVTKConverterType::New();
-		itkToVTKConverter->SetInput( caster->GetOutput() );
-		itkToVTKConverter->Update();
-		vtkSmartPointer<vtkImageData> meanObjectImage = vtkSmartPointer<vtkImageData>::New();
-		meanObjectImage->DeepCopy( itkToVTKConverter->GetOutput() );
-		m_MOData.moImageDataList.append( meanObjectImage );
+		// Average of the object masks, aligned at their bounding box centers
+		m_MOData.moImageDataList.append( ComputeMeanObject( labelImage, objectBoxes, meanObjectIds, moImgSize ) );
+		mdiChild->updateProgressBar( round( currClass * 100.0 / ( classCount - 1 ) ) );
+		QCoreApplication::processEvents();
 
 		// Create histogram and TFs for each MObject
 		QString moHistName = classTreeModel->invisibleRootItem()->child( currClass, 0 )->text();
@@ -31,6 +31,8 @@
 #include "ui_FiberScoutDistributionView.h"
 #include "ui_FiberScoutMeanObjectView.h"
 
+#include <QScopedPointer>
+
 typedef iAQTtoUIConnector<QDockWidget, Ui_FiberScoutPC> dlg_IOVPC;
 typedef iAQTtoUIConnector<QDockWidget, Ui_FiberScoutPP> dlg_IOVPP;
 typedef iAQTtoUIConnector<QDockWidget, Ui_FiberScoutSPM> dlg_IOVSPM;
@@ -39,6 +41,7 @@ typedef iAQTtoUIConnector<QDockWidget, Ui_FiberScoutMO> dlg_IOVMO;
 
 class iABlobCluster;
 class iABlobManager;
+class iALabelColorTable;
 class iAMeanObjectTFView;
 class iAModalityTransfer;
 class iARenderer;
@@ -193,6 +196,7 @@ private:
 	// members referencing MdiChild
 	vtkPiecewiseFunction     *oTF;
 	vtkColorTransferFunction *cTF;
+	QScopedPointer<iALabelColorTable> m_labelColors;	// direct label ID -> color/opacity mapping into oTF/cTF
 
 	// private members
 	int	width, height;
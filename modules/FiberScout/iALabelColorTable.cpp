@@ -0,0 +1,142 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#include "pch.h"
+#include "iALabelColorTable.h"
+
+#include <vtkColorTransferFunction.h>
+#include <vtkPiecewiseFunction.h>
+
+#include <algorithm>
+
+namespace
+{
+	//! if more than this fraction of labels changed, building the transfer functions
+	//! from scratch is cheaper than updating the nodes one by one
+	const double RebuildFraction = 0.25;
+}
+
+iALabelColorTable::iALabelColorTable( vtkPiecewiseFunction * opacityTF, vtkColorTransferFunction * colorTF ) :
+	m_opacityTF( opacityTF ),
+	m_colorTF( colorTF ),
+	m_opacityMTime( 0 ),
+	m_colorMTime( 0 )
+{}
+
+void iALabelColorTable::SetLabelCount( size_t labelCount )
+{
+	m_rgba.assign( labelCount * 4, 0.0 );
+	m_uploaded.clear();
+	m_changed.clear();
+	m_isChanged.assign( labelCount, false );
+}
+
+void iALabelColorTable::Fill( double const rgb[3], double alpha )
+{
+	for ( size_t label = 0; label < m_isChanged.size(); ++label )
+		SetLabel( label, rgb, alpha );
+}
+
+void iALabelColorTable::SetLabel( size_t label, double const rgb[3], double alpha )
+{
+	if ( label >= m_isChanged.size() )
+		return;
+	double * entry = &m_rgba[label * 4];
+	if ( entry[0] == rgb[0] && entry[1] == rgb[1] && entry[2] == rgb[2] && entry[3] == alpha )
+		return;
+	entry[0] = rgb[0];
+	entry[1] = rgb[1];
+	entry[2] = rgb[2];
+	entry[3] = alpha;
+	MarkChanged( label );
+}
+
+void iALabelColorTable::MarkChanged( size_t label )
+{
+	if ( m_isChanged[label] )
+		return;
+	m_isChanged[label] = true;
+	m_changed.push_back( label );
+}
+
+void iALabelColorTable::Update()
+{
+	size_t labelCount = m_isChanged.size();
+	if ( labelCount == 0 )
+		return;
+	// labels might have been set to another value and back since the last update:
+	std::vector<size_t> differing;
+	for ( size_t label : m_changed )
+	{
+		m_isChanged[label] = false;
+		if ( m_uploaded.size() == m_rgba.size() &&
+			!std::equal( &m_rgba[label * 4], &m_rgba[label * 4] + 4, &m_uploaded[label * 4] ) )
+			differing.push_back( label );
+	}
+	m_changed.clear();
+	if ( m_uploaded.size() != m_rgba.size() ||
+		m_opacityTF->GetMTime() != m_opacityMTime || m_colorTF->GetMTime() != m_colorMTime ||
+		m_opacityTF->GetSize() != static_cast<int>( labelCount ) || m_colorTF->GetSize() != static_cast<int>( labelCount ) ||
+		differing.size() > RebuildFraction * labelCount )
+	{
+		Rebuild();
+	}
+	else
+	{
+		for ( size_t label : differing )
+		{
+			double const * entry = &m_rgba[label * 4];
+			// keep position, midpoint and sharpness of the nodes, only exchange the values:
+			double colorNode[6];
+			m_colorTF->GetNodeValue( static_cast<int>( label ), colorNode );
+			colorNode[1] = entry[0];
+			colorNode[2] = entry[1];
+			colorNode[3] = entry[2];
+			m_colorTF->SetNodeValue( static_cast<int>( label ), colorNode );
+			double opacityNode[4];
+			m_opacityTF->GetNodeValue( static_cast<int>( label ), opacityNode );
+			opacityNode[1] = entry[3];
+			m_opacityTF->SetNodeValue( static_cast<int>( label ), opacityNode );
+			std::copy( entry, entry + 4, &m_uploaded[label * 4] );
+		}
+	}
+	m_opacityMTime = m_opacityTF->GetMTime();
+	m_colorMTime = m_colorTF->GetMTime();
+}
+
+void iALabelColorTable::Rebuild()
+{
+	size_t labelCount = m_isChanged.size();
+	std::vector<double> rgb( labelCount * 3 ), alpha( labelCount );
+	for ( size_t label = 0; label < labelCount; ++label )
+	{
+		rgb[label * 3 + 0] = m_rgba[label * 4 + 0];
+		rgb[label * 3 + 1] = m_rgba[label * 4 + 1];
+		rgb[label * 3 + 2] = m_rgba[label * 4 + 2];
+		alpha[label] = m_rgba[label * 4 + 3];
+	}
+	// one node per label, at the position of the label ID:
+	double maxLabel = static_cast<double>( labelCount - 1 );
+	m_colorTF->ClampingOff();
+	m_opacityTF->ClampingOff();
+	m_colorTF->BuildFunctionFromTable( 0, maxLabel, static_cast<int>( labelCount ), rgb.data() );
+	m_opacityTF->BuildFunctionFromTable( 0, maxLabel, static_cast<int>( labelCount ), alpha.data() );
+	m_uploaded = m_rgba;
+}
@@ -0,0 +1,64 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#pragma once
+
+#include <vtkVersion.h>
+
+#include <cstddef>
+#include <vector>
+
+class vtkColorTransferFunction;
+class vtkPiecewiseFunction;
+
+#if !(VTK_MAJOR_VERSION > 7 || (VTK_MAJOR_VERSION == 7 && VTK_MINOR_VERSION > 0))
+typedef unsigned long vtkMTimeType;
+#endif
+
+//! Direct mapping from label ID to color and opacity for rendering labelled volumes.
+//! Keeps one RGBA entry per label and maps it to one node per label in the given
+//! transfer functions. The transfer functions are built in one go from the whole table
+//! the first time, and afterwards only the nodes of labels whose color changed are updated,
+//! so that changing the color of a few objects does not require rebuilding all nodes.
+//! If the transfer functions are modified elsewhere, they are rebuilt on the next Update.
+class iALabelColorTable
+{
+public:
+	iALabelColorTable( vtkPiecewiseFunction * opacityTF, vtkColorTransferFunction * colorTF );
+	//! Set the number of labels (IDs 0 .. labelCount-1).
+	void SetLabelCount( size_t labelCount );
+	//! Set color and opacity of all labels.
+	void Fill( double const rgb[3], double alpha );
+	//! Set color and opacity of a single label.
+	void SetLabel( size_t label, double const rgb[3], double alpha );
+	//! Transfer the changes to the transfer functions.
+	void Update();
+private:
+	void MarkChanged( size_t label );
+	void Rebuild();
+
+	vtkPiecewiseFunction * m_opacityTF;
+	vtkColorTransferFunction * m_colorTF;
+	std::vector<double> m_rgba;          //!< the current color and opacity of each label
+	std::vector<double> m_uploaded;      //!< color and opacity of each label as currently set in the transfer functions
+	std::vector<size_t> m_changed;       //!< labels modified since the last Update
+	std::vector<char> m_isChanged;       //!< for each label, whether it is contained in m_changed
+	vtkMTimeType m_opacityMTime, m_colorMTime; //!< modification times of the transfer functions after the last Update
+};
@@ -0,0 +1,187 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#include "pch.h"
+#include "iAMeanObject.h"
+
+#include "iATypedCallHelper.h"
+
+#include <vtkImageData.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+iALabelBoundingBox::iALabelBoundingBox()
+{
+	for ( int i = 0; i < 3; ++i )
+	{
+		min[i] = std::numeric_limits<int>::max();
+		max[i] = std::numeric_limits<int>::min();
+	}
+}
+
+namespace
+{
+	template <typename T>
+	void LabelBoundingBoxes( vtkImageData * img, int maxLabel, std::vector<iALabelBoundingBox> & boxes )
+	{
+		int const * dim = img->GetDimensions();
+		T const * data = static_cast<T const *>( img->GetScalarPointer() );
+		size_t componentCount = img->GetNumberOfScalarComponents();
+		boxes.assign( maxLabel + 1, iALabelBoundingBox() );
+#pragma omp parallel
+		{
+			std::vector<iALabelBoundingBox> localBoxes( maxLabel + 1 );
+#pragma omp for
+			for ( int z = 0; z < dim[2]; ++z )
+			{
+				for ( int y = 0; y < dim[1]; ++y )
+				{
+					T const * row = data + ( static_cast<size_t>( z ) * dim[1] + y ) * dim[0] * componentCount;
+					for ( int x = 0; x < dim[0]; ++x )
+					{
+						double value = static_cast<double>( row[x * componentCount] );
+						if ( value < 1 || value > maxLabel )
+							continue;
+						iALabelBoundingBox & box = localBoxes[static_cast<int>( value )];
+						int coord[3] = { x, y, z };
+						for ( int i = 0; i < 3; ++i )
+						{
+							box.min[i] = std::min( box.min[i], coord[i] );
+							box.max[i] = std::max( box.max[i], coord[i] );
+						}
+					}
+				}
+			}
+#pragma omp critical
+			for ( int l = 1; l <= maxLabel; ++l )
+				for ( int i = 0; i < 3; ++i )
+				{
+					boxes[l].min[i] = std::min( boxes[l].min[i], localBoxes[l].min[i] );
+					boxes[l].max[i] = std::max( boxes[l].max[i], localBoxes[l].max[i] );
+				}
+		}
+	}
+
+	template <typename T>
+	void AccumulateObjects( vtkImageData * img, std::vector<iALabelBoundingBox> const & boxes,
+		std::vector<int> const & labels, int const accSize[3], std::vector<unsigned int> & acc )
+	{
+		int const * dim = img->GetDimensions();
+		T const * data = static_cast<T const *>( img->GetScalarPointer() );
+		size_t componentCount = img->GetNumberOfScalarComponents();
+		acc.assign( static_cast<size_t>( accSize[0] ) * accSize[1] * accSize[2], 0 );
+		int labelCount = static_cast<int>( labels.size() );
+#pragma omp parallel
+		{
+			std::vector<unsigned int> localAcc( acc.size(), 0 );
+#pragma omp for schedule(dynamic)
+			for ( int o = 0; o < labelCount; ++o )
+			{
+				int label = labels[o];
+				iALabelBoundingBox const & box = boxes[label];
+				// center the bounding box of the object in the accumulation buffer:
+				int offset[3];
+				for ( int i = 0; i < 3; ++i )
+					offset[i] = accSize[i] / 2 - box.Size( i ) / 2 - box.min[i];
+				for ( int z = box.min[2]; z <= box.max[2]; ++z )
+					for ( int y = box.min[1]; y <= box.max[1]; ++y )
+					{
+						T const * row = data + ( static_cast<size_t>( z ) * dim[1] + y ) * dim[0] * componentCount;
+						unsigned int * accRow = localAcc.data() +
+							( static_cast<size_t>( z + offset[2] ) * accSize[1] + y + offset[1] ) * accSize[0] + offset[0];
+						for ( int x = box.min[0]; x <= box.max[0]; ++x )
+							if ( static_cast<int>( row[x * componentCount] ) == label )
+								++accRow[x];
+					}
+			}
+#pragma omp critical
+			for ( size_t i = 0; i < acc.size(); ++i )
+				acc[i] += localAcc[i];
+		}
+	}
+}
+
+std::vector<iALabelBoundingBox> ComputeLabelBoundingBoxes( vtkImageData * labelImage, int maxLabel )
+{
+	std::vector<iALabelBoundingBox> boxes;
+	switch ( labelImage->GetScalarType() )	// 64 bit types are not covered by VTK_TYPED_CALL
+	{
+	case VTK_LONG_LONG:          LabelBoundingBoxes<long long>( labelImage, maxLabel, boxes ); break;
+	case VTK_UNSIGNED_LONG_LONG: LabelBoundingBoxes<unsigned long long>( labelImage, maxLabel, boxes ); break;
+	case VTK_ID_TYPE:            LabelBoundingBoxes<vtkIdType>( labelImage, maxLabel, boxes ); break;
+	default:
+		VTK_TYPED_CALL( LabelBoundingBoxes, labelImage->GetScalarType(), labelImage, maxLabel, boxes );
+	}
+	return boxes;
+}
+
+vtkSmartPointer<vtkImageData> ComputeMeanObject( vtkImageData * labelImage, std::vector<iALabelBoundingBox> const & boxes,
+	std::vector<int> const & labels, int const outputSize[3] )
+{
+	// only consider existing objects, and make the buffer large enough for the largest of them:
+	std::vector<int> objectLabels;
+	int accSize[3] = { 0, 0, 0 };
+	for ( int label : labels )
+	{
+		if ( label < 1 || label >= static_cast<int>( boxes.size() ) || boxes[label].IsEmpty() )
+			continue;
+		objectLabels.push_back( label );
+		for ( int i = 0; i < 3; ++i )
+			accSize[i] = std::max( accSize[i], boxes[label].Size( i ) );
+	}
+	std::vector<unsigned int> acc;
+	switch ( labelImage->GetScalarType() )
+	{
+	case VTK_LONG_LONG:          AccumulateObjects<long long>( labelImage, boxes, objectLabels, accSize, acc ); break;
+	case VTK_UNSIGNED_LONG_LONG: AccumulateObjects<unsigned long long>( labelImage, boxes, objectLabels, accSize, acc ); break;
+	case VTK_ID_TYPE:            AccumulateObjects<vtkIdType>( labelImage, boxes, objectLabels, accSize, acc ); break;
+	default:
+		VTK_TYPED_CALL( AccumulateObjects, labelImage->GetScalarType(), labelImage, boxes, objectLabels, accSize, acc );
+	}
+
+	auto result = vtkSmartPointer<vtkImageData>::New();
+	result->SetDimensions( outputSize[0], outputSize[1], outputSize[2] );
+	result->SetSpacing( labelImage->GetSpacing() );
+	result->SetOrigin( labelImage->GetOrigin() );
+	result->AllocateScalars( VTK_FLOAT, 1 );
+	float * out = static_cast<float *>( result->GetScalarPointer() );
+	std::fill( out, out + static_cast<size_t>( outputSize[0] ) * outputSize[1] * outputSize[2], 0.0f );
+	if ( objectLabels.empty() )
+		return result;
+	// place the accumulated masks in the center of the output image:
+	int start[3];
+	for ( int i = 0; i < 3; ++i )
+		start[i] = static_cast<int>( std::round( outputSize[i] / 2.0 ) ) - accSize[i] / 2;
+	float normalizer = static_cast<float>( labels.size() );
+	for ( int z = 0; z < accSize[2]; ++z )
+		for ( int y = 0; y < accSize[1]; ++y )
+			for ( int x = 0; x < accSize[0]; ++x )
+			{
+				int coord[3] = { x + start[0], y + start[1], z + start[2] };
+				if ( coord[0] < 0 || coord[1] < 0 || coord[2] < 0 ||
+					coord[0] >= outputSize[0] || coord[1] >= outputSize[1] || coord[2] >= outputSize[2] )
+					continue;
+				out[( static_cast<size_t>( coord[2] ) * outputSize[1] + coord[1] ) * outputSize[0] + coord[0]] =
+					acc[( static_cast<size_t>( z ) * accSize[1] + y ) * accSize[0] + x] / normalizer;
+			}
+	return result;
+}
@@ -0,0 +1,57 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#pragma once
+
+#include <vtkSmartPointer.h>
+
+#include <vector>
+
+class vtkImageData;
+
+//! Axis-aligned bounding box of a labelled object, in voxel coordinates (both bounds inclusive).
+struct iALabelBoundingBox
+{
+	iALabelBoundingBox();
+	bool IsEmpty() const { return min[0] > max[0]; }
+	int Size( int dim ) const { return max[dim] - min[dim] + 1; }
+	int min[3], max[3];
+};
+
+//! Computes the bounding boxes of all objects with labels 1..maxLabel in a labelled image,
+//! in one parallel pass over the image (with one set of boxes per thread, merged at the end).
+//! Works directly on the pixel type of the image, i.e. without converting it.
+//! @param labelImage the labelled image (only the first component is considered)
+//! @param maxLabel the largest label to consider; all values outside of [1, maxLabel] are ignored
+//! @return the bounding box of each label (indexed by label, entry 0 is unused)
+std::vector<iALabelBoundingBox> ComputeLabelBoundingBoxes( vtkImageData * labelImage, int maxLabel );
+
+//! Computes the mean object of a set of objects: the masks of the objects are aligned at the
+//! centers of their bounding boxes, summed up and divided by the number of objects, so that each
+//! voxel of the result contains the fraction of objects covering it.
+//! The objects are processed in parallel, each thread accumulates into its own buffer which only
+//! has the size of the largest bounding box of the given objects.
+//! @param labelImage the labelled image
+//! @param boxes the bounding boxes of all labels, as computed by ComputeLabelBoundingBoxes
+//! @param labels the labels of the objects to consider
+//! @param outputSize the size of the output image, the objects are centered in it
+//! @return a float image with the given size and the spacing and origin of labelImage
+vtkSmartPointer<vtkImageData> ComputeMeanObject( vtkImageData * labelImage, std::vector<iALabelBoundingBox> const & boxes,
+	std::vector<int> const & labels, int const outputSize[3] );
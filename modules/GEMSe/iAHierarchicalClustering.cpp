@@ -0,0 +1,262 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#include "pch.h"
+#include "iAHierarchicalClustering.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+iACondensedDistanceMatrix::iACondensedDistanceMatrix(int n):
+	m_n(n),
+	m_values(static_cast<size_t>(n) * (n > 0 ? n - 1 : 0) / 2, std::numeric_limits<float>::max())
+{}
+
+int iACondensedDistanceMatrix::Size() const
+{
+	return m_n;
+}
+
+size_t iACondensedDistanceMatrix::Index(int i, int j) const
+{
+	if (j < i)
+		std::swap(i, j);
+	return static_cast<size_t>(i) * (2 * static_cast<size_t>(m_n) - i - 1) / 2 + (j - i - 1);
+}
+
+float & iACondensedDistanceMatrix::operator()(int i, int j)
+{
+	return m_values[Index(i, j)];
+}
+
+float iACondensedDistanceMatrix::operator()(int i, int j) const
+{
+	return m_values[Index(i, j)];
+}
+
+namespace
+{
+	const float NoDistance = std::numeric_limits<float>::infinity();
+
+	//! whether merging a pair at distance d1 with cluster numbers (x1, y1), x1 < y1, comes before
+	//! merging the pair at distance d2 with numbers (x2, y2); ties are resolved by the lower numbers,
+	//! as the exhaustive search scanning all pairs in ascending order did
+	bool MergesBefore(float d1, int x1, int y1, float d2, int x2, int y2)
+	{
+		if (d1 != d2)
+			return d1 < d2;
+		if (x1 != x2)
+			return x1 < x2;
+		return y1 < y2;
+	}
+
+	//! cached nearest neighbour per cluster; reproduces the tie order of the exhaustive search,
+	//! but needs O(n^3) time in the worst case (if many nearest neighbours get merged away)
+	std::vector<iAClusterMerge> CachedNearestNeighbourClustering(iACondensedDistanceMatrix & d)
+	{
+		const int n = d.Size();
+		std::vector<iAClusterMerge> merges;
+		merges.reserve(n - 1);
+		// clusters are stored in matrix slots; label holds the cluster number of the cluster in a slot.
+		// For each slot x, nearest is the closest slot among those with a higher cluster number;
+		// the pair to merge next is then the minimum over all slots of (nearestDist, label, label of nearest)
+		std::vector<bool> active(n, true);
+		std::vector<int> label(n), nearest(n, -1);
+		std::vector<float> nearestDist(n, NoDistance);
+		for (int i = 0; i < n; ++i)
+			label[i] = i;
+		auto updateNearest = [&](int x)
+		{
+			nearest[x] = -1;
+			nearestDist[x] = NoDistance;
+			for (int y = 0; y < n; ++y)
+			{
+				if (!active[y] || label[y] <= label[x])
+					continue;
+				float dist = d(x, y);
+				if (nearest[x] == -1 || MergesBefore(dist, label[x], label[y], nearestDist[x], label[x], label[nearest[x]]))
+				{
+					nearest[x] = y;
+					nearestDist[x] = dist;
+				}
+			}
+		};
+		for (int x = 0; x < n; ++x)
+			updateNearest(x);
+		for (int k = 0; k < n - 1; ++k)
+		{
+			int x = -1;
+			for (int i = 0; i < n; ++i)
+			{
+				if (!active[i] || nearest[i] == -1)
+					continue;
+				if (x == -1 || MergesBefore(nearestDist[i], label[i], label[nearest[i]],
+						nearestDist[x], label[x], label[nearest[x]]))
+					x = i;
+			}
+			int y = nearest[x];
+			iAClusterMerge merge = { label[x], label[y], nearestDist[x] };
+			merges.push_back(merge);
+			// the merged cluster is stored in slot y and gets the next (so far highest) number;
+			// complete linkage: distance to it is the maximum of the distances to its parts
+			active[x] = false;
+			label[y] = n + k;
+			for (int i = 0; i < n; ++i)
+			{
+				if (!active[i] || i == y)
+					continue;
+				d(i, y) = std::max(d(i, x), d(i, y));
+			}
+			nearest[y] = -1;             // no cluster has a higher number
+			nearestDist[y] = NoDistance;
+			for (int i = 0; i < n; ++i)
+			{
+				if (!active[i] || i == y)
+					continue;
+				// distances between other clusters are unchanged, and the ones to the merged
+				// cluster are not smaller than those to its parts; so only a nearest neighbour
+				// that was one of the parts requires a full search:
+				if (nearest[i] == x || nearest[i] == y)
+					updateNearest(i);
+				else if (d(i, y) < nearestDist[i])   // on ties, the lower number of the current nearest wins
+				{
+					nearest[i] = y;
+					nearestDist[i] = d(i, y);
+				}
+			}
+		}
+		return merges;
+	}
+
+	//! whether two of the given distances are equal
+	bool HasTies(iACondensedDistanceMatrix const & d)
+	{
+		std::vector<float> values;
+		values.reserve(static_cast<size_t>(d.Size()) * (d.Size() - 1) / 2);
+		for (int i = 0; i < d.Size(); ++i)
+			for (int j = i + 1; j < d.Size(); ++j)
+				values.push_back(d(i, j));
+		std::sort(values.begin(), values.end());
+		return std::adjacent_find(values.begin(), values.end()) != values.end();
+	}
+
+	int FindRoot(std::vector<int> & parent, int i)
+	{
+		while (parent[i] != i)
+		{
+			parent[i] = parent[parent[i]];
+			i = parent[i];
+		}
+		return i;
+	}
+
+	//! nearest-neighbour chain: follow nearest neighbours until two clusters are each other's
+	//! nearest neighbour, and merge them; O(n^2) time. Since complete linkage is reducible, this
+	//! finds the same merges as the exhaustive search; they are just found in a different order
+	//! and are therefore sorted by distance and renumbered afterwards. Requires distinct distances,
+	//! otherwise the tree can depend on which of several equally close pairs is merged first.
+	std::vector<iAClusterMerge> NearestNeighbourChainClustering(iACondensedDistanceMatrix & d)
+	{
+		const int n = d.Size();
+		// merges as pairs of matrix slots; each slot keeps its cluster, so slot i always holds
+		// a cluster containing item i, and the merged cluster is stored in the second slot
+		std::vector<iAClusterMerge> slotMerges;
+		slotMerges.reserve(n - 1);
+		std::vector<bool> active(n, true);
+		std::vector<int> chain;
+		chain.reserve(n);
+		int remaining = n;
+		while (remaining > 1)
+		{
+			if (chain.empty())
+			{
+				int first = 0;
+				while (!active[first])
+					++first;
+				chain.push_back(first);
+			}
+			int x = chain.back();
+			int previous = chain.size() > 1 ? chain[chain.size() - 2] : -1;
+			int y = previous;
+			float minDist = previous == -1 ? NoDistance : d(x, previous);
+			for (int i = 0; i < n; ++i)
+			{
+				if (!active[i] || i == x)
+					continue;
+				if (d(x, i) < minDist)
+				{
+					minDist = d(x, i);
+					y = i;
+				}
+			}
+			if (y != previous)
+			{
+				chain.push_back(y);
+				continue;
+			}
+			// x and y are each other's nearest neighbours: merge them
+			chain.pop_back();
+			chain.pop_back();
+			iAClusterMerge merge = { x, y, minDist };
+			slotMerges.push_back(merge);
+			active[x] = false;
+			--remaining;
+			for (int i = 0; i < n; ++i)
+			{
+				if (!active[i] || i == y)
+					continue;
+				d(i, y) = std::max(d(i, x), d(i, y));
+			}
+		}
+		std::stable_sort(slotMerges.begin(), slotMerges.end(),
+			[](iAClusterMerge const & a, iAClusterMerge const & b) { return a.distance < b.distance; });
+		// renumber: the k-th merge creates cluster n+k, as in the exhaustive search
+		std::vector<int> parent(2 * n - 1), label(2 * n - 1);
+		for (int i = 0; i < 2 * n - 1; ++i)
+		{
+			parent[i] = i;
+			label[i] = i;
+		}
+		std::vector<iAClusterMerge> merges;
+		merges.reserve(n - 1);
+		for (int k = 0; k < n - 1; ++k)
+		{
+			int rootX = FindRoot(parent, slotMerges[k].first);
+			int rootY = FindRoot(parent, slotMerges[k].second);
+			iAClusterMerge merge = { std::min(label[rootX], label[rootY]), std::max(label[rootX], label[rootY]),
+				slotMerges[k].distance };
+			merges.push_back(merge);
+			parent[rootX] = rootY;
+			label[rootY] = n + k;
+		}
+		return merges;
+	}
+}
+
+std::vector<iAClusterMerge> CompleteLinkageClustering(iACondensedDistanceMatrix & d)
+{
+	if (d.Size() < 2)
+		return std::vector<iAClusterMerge>();
+	// with pairwise distinct item distances, the complete linkage distances between any two
+	// pairs of disjoint clusters are distinct as well (they are maxima over disjoint sets of
+	// item distances), so there is exactly one possible tree, found by the chain algorithm
+	return HasTies(d) ? CachedNearestNeighbourClustering(d) : NearestNeighbourChainClustering(d);
+}
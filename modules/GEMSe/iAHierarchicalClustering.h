@@ -0,0 +1,55 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+//! The distances between all pairs of n items, stored as upper triangle without diagonal.
+class iACondensedDistanceMatrix
+{
+public:
+	explicit iACondensedDistanceMatrix(int n);
+	int Size() const;
+	float & operator()(int i, int j);
+	float operator()(int i, int j) const;
+private:
+	size_t Index(int i, int j) const;
+	int m_n;
+	std::vector<float> m_values;
+};
+
+//! A merge step in a hierarchical clustering. Items are numbered 0..n-1, the cluster
+//! created by the k-th merge gets number n+k; first is always smaller than second.
+struct iAClusterMerge
+{
+	int first, second;
+	float distance;
+};
+
+//! Complete-linkage agglomerative clustering. The result is the same sequence as repeatedly
+//! merging the closest pair of clusters; of equally close pairs, the one with the lowest cluster
+//! numbers is merged first. If all item distances are distinct, the nearest-neighbour chain
+//! algorithm is used: O(n^2) time, plus O(n^2 log n) for sorting the distances to check for ties.
+//! Otherwise, the tie order requires a cached nearest neighbour per cluster instead, which takes
+//! O(n^2) time for typical inputs, but O(n^3) in the worst case.
+//! @param distances the pairwise item distances; it is overwritten during clustering
+std::vector<iAClusterMerge> CompleteLinkageClustering(iACondensedDistanceMatrix & distances);
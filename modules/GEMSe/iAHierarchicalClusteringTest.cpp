@@ -0,0 +1,191 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#include "iAHierarchicalClustering.h"
+
+#include "iASimpleTester.h"
+
+#include <algorithm>
+#include <limits>
+#include <random>
+
+// the clustering as previously done by iAImageClusterer: repeatedly search the
+// closest pair in the whole matrix, merge it into a new cluster with the next
+// free number, and set its distances to the maximum of the two parts
+std::vector<iAClusterMerge> ReferenceClustering(iACondensedDistanceMatrix const & items)
+{
+	const int n = items.Size();
+	const float Removed = std::numeric_limits<float>::max();
+	iACondensedDistanceMatrix d(2 * n - 1);
+	for (int i = 0; i < n; ++i)
+		for (int j = i + 1; j < n; ++j)
+			d(i, j) = items(i, j);
+	std::vector<iAClusterMerge> result;
+	for (int k = 0; k < n - 1; ++k)
+	{
+		iAClusterMerge merge = { 0, 0, Removed };
+		for (int x = 0; x < n + k - 1; ++x)
+			for (int y = x + 1; y < n + k; ++y)
+				if (d(x, y) < merge.distance)
+				{
+					merge.first = x;
+					merge.second = y;
+					merge.distance = d(x, y);
+				}
+		int newIdx = n + k;
+		for (int i = 0; i < newIdx; ++i)
+			if (i != merge.first && i != merge.second && d(i, merge.first) != Removed)
+				d(i, newIdx) = std::max(d(i, merge.first), d(i, merge.second));
+		for (int i = 0; i < 2 * n - 1; ++i)
+		{
+			if (i != merge.first)
+				d(i, merge.first) = Removed;
+			if (i != merge.second)
+				d(i, merge.second) = Removed;
+		}
+		result.push_back(merge);
+	}
+	return result;
+}
+
+// mean overlap distance between two label images, as computed by iALabelImageCache
+// (label images given as strings of label digits, label 0 is background)
+float OverlapDistance(char const * a, char const * b)
+{
+	unsigned long long intersection = 0, unionCount = 0;
+	for (size_t i = 0; a[i] && b[i]; ++i)
+	{
+		unsigned int equal = a[i] == b[i];
+		unsigned int labelA = a[i] != '0';
+		unsigned int labelB = b[i] != '0';
+		intersection += equal & labelA;
+		unionCount += labelA + ((1 - equal) & labelB);
+	}
+	if (unionCount == 0)
+		return 1.0f;
+	double unionOverlap = static_cast<double>(intersection) / unionCount;
+	return static_cast<float>(1.0 - 2.0 * unionOverlap / (1.0 + unionOverlap));
+}
+
+bool SameMerges(std::vector<iAClusterMerge> const & a, std::vector<iAClusterMerge> const & b)
+{
+	if (a.size() != b.size())
+		return false;
+	for (size_t i = 0; i < a.size(); ++i)
+		if (a[i].first != b[i].first || a[i].second != b[i].second || a[i].distance != b[i].distance)
+			return false;
+	return true;
+}
+
+BEGIN_TEST
+	// 4 items on a line: 0 - 1 ---- 2 - - 3
+	iACondensedDistanceMatrix line(4);
+	float pos[4] = { 0, 1, 5, 7 };
+	for (int i = 0; i < 4; ++i)
+		for (int j = i + 1; j < 4; ++j)
+			line(i, j) = pos[j] - pos[i];
+	std::vector<iAClusterMerge> lineMerges = CompleteLinkageClustering(line);
+	TestEqual(static_cast<size_t>(3), lineMerges.size());
+	TestEqual(0, lineMerges[0].first);  TestEqual(1, lineMerges[0].second); TestEqual(1.0f, lineMerges[0].distance);
+	TestEqual(2, lineMerges[1].first);  TestEqual(3, lineMerges[1].second); TestEqual(2.0f, lineMerges[1].distance);
+	TestEqual(4, lineMerges[2].first);  TestEqual(5, lineMerges[2].second); TestEqual(7.0f, lineMerges[2].distance);
+
+	// a small sampling (label images of 12 results) and the merges stored
+	// for it by the exhaustive search; contains identical results and ties
+	char const * sampling[] = {
+		"000111122220000111100000",
+		"000111122220000111100000",
+		"000011122220000011100000",
+		"001111122222000111110000",
+		"000111112220000111100000",
+		"000000122200000001100000",
+		"000000000000000000000000",
+		"000111122220000111100000",
+		"011111222222001111111000",
+		"000011112222000011110000",
+		"000111100000000111100000",
+		"000000022220000000000000"
+	};
+	iAClusterMerge storedMerges[] = {
+		{ 0, 1, 0.0f },
+		{ 7, 12, 0.0f },
+		{ 4, 13, 0.0833333358f },
+		{ 3, 8, 0.151515156f },
+		{ 2, 9, 0.181818187f },
+		{ 10, 14, 0.200000003f },
+		{ 15, 16, 0.357142866f },
+		{ 5, 11, 0.400000006f },
+		{ 17, 18, 0.461538464f },
+		{ 6, 19, 1.0f },
+		{ 20, 21, 1.0f }
+	};
+	const int samplingSize = sizeof(sampling) / sizeof(sampling[0]);
+	iACondensedDistanceMatrix samplingDist(samplingSize);
+	for (int i = 0; i < samplingSize; ++i)
+		for (int j = i + 1; j < samplingSize; ++j)
+			samplingDist(i, j) = OverlapDistance(sampling[i], sampling[j]);
+	std::vector<iAClusterMerge> samplingMerges = CompleteLinkageClustering(samplingDist);
+	TestAssert(SameMerges(std::vector<iAClusterMerge>(storedMerges, storedMerges + samplingSize - 1), samplingMerges));
+
+	// random distances: same tree as the exhaustive search
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+	int sizes[] = { 2, 3, 10, 57, 200 };
+	for (int n : sizes)
+	{
+		iACondensedDistanceMatrix d(n);
+		for (int i = 0; i < n; ++i)
+			for (int j = i + 1; j < n; ++j)
+				d(i, j) = dist(rng);
+		std::vector<iAClusterMerge> expected = ReferenceClustering(d);
+		std::vector<iAClusterMerge> actual = CompleteLinkageClustering(d);
+		TestAssert(SameMerges(expected, actual));
+	}
+
+	// all distances equal (e.g. identical segmentations): lowest numbers are merged first
+	iACondensedDistanceMatrix equal(4);
+	for (int i = 0; i < 4; ++i)
+		for (int j = i + 1; j < 4; ++j)
+			equal(i, j) = 0.0f;
+	std::vector<iAClusterMerge> equalMerges = CompleteLinkageClustering(equal);
+	TestEqual(0, equalMerges[0].first);  TestEqual(1, equalMerges[0].second);
+	TestEqual(2, equalMerges[1].first);  TestEqual(3, equalMerges[1].second);
+	TestEqual(4, equalMerges[2].first);  TestEqual(5, equalMerges[2].second);
+
+	// quantized distances, where ties are frequent: same tree as the exhaustive search
+	int levels[] = { 1, 2, 3, 5, 10 };
+	for (int levelCount : levels)
+	{
+		std::uniform_int_distribution<int> level(0, levelCount - 1);
+		for (int n : sizes)
+		{
+			for (int repeat = 0; repeat < 20; ++repeat)
+			{
+				iACondensedDistanceMatrix d(n);
+				for (int i = 0; i < n; ++i)
+					for (int j = i + 1; j < n; ++j)
+						d(i, j) = static_cast<float>(level(rng)) / levelCount;
+				std::vector<iAClusterMerge> expected = ReferenceClustering(d);
+				std::vector<iAClusterMerge> actual = CompleteLinkageClustering(d);
+				TestAssert(SameMerges(expected, actual));
+			}
+		}
+	}
+END_TEST
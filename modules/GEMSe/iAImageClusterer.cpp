@@ -26,25 +26,23 @@
 #include "iAGEMSeConstants.h" // for iARepresentativeType
 #include "iAImageTree.h"
 #include "iAImageTreeLeaf.h"
+#include "iAHierarchicalClustering.h"
 #include "iAImageTreeInternalNode.h"
+#include "iALabelImageCache.h"
 #include "iAMathUtility.h"
 #include "iARepresentative.h"
 #include "iASingleResult.h"
 
-#include "iAImageComparisonMetrics.h"
-
-#include <itkLabelOverlapMeasuresImageFilter.h>
-
-
 #include <QMap>
 
+#include <atomic>
 #include <utility>
 
 iAImageClusterer::iAImageClusterer(int labelCount, QString const & outputDirectory):
 	m_labelCount(labelCount),
 	m_aborted(false),
 	m_remainingNodes(0),
-	m_currImage(-1),
+	m_finishedPairs(0),
 	m_imageDistCalcDuration(0.0),
 	m_outputDirectory(outputDirectory)
 {
@@ -63,393 +61,151 @@ QSharedPointer<iAImageTree > iAImageClusterer::GetResult()
 }
 
 
-double CalcDistance(ClusterImageType img1, ClusterImageType img2)
-{
-	assert (img1);
-	assert (img2);
-	double meanOverlap = 0;
-	try
-	{
-		LabelImageType * img1t = dynamic_cast<LabelImageType*>(img1.GetPointer());
-		LabelImageType * img2t = dynamic_cast<LabelImageType*>(img2.GetPointer());
-		typedef itk::LabelOverlapMeasuresImageFilter<LabelImageType > FilterType;
-		FilterType::Pointer filter = FilterType::New();
-		filter->SetSourceImage(img1t);
-		filter->SetTargetImage(img2t);
-		filter->Update();
-		meanOverlap = filter->GetMeanOverlap();
-		/*
-		// not working at the moment for larger images:
-		iAImageComparisonResult r = CompareImages(img1, img2);
-		meanOverlap = r.equalPixelRate;
-		*/
-	}
-	catch (itk::ExceptionObject & e)
-	{
-		DEBUG_LOG(QString("itk Exception: %1\n").arg(e.GetDescription()));
-		return 0.0;
-	}
-	if (isNaN(meanOverlap))
+namespace {
+	const int FullProgress = 100;
+	const int SplitFactorDistanceCalc = 50;
+	//! maximum amount of memory used for keeping label images in memory during distance calculation
+	const size_t LabelCacheBudget = static_cast<size_t>(2048) * 1024 * 1024;
+
+	long sumUpTo(int n)
 	{
-		DEBUG_LOG("ERROR: CalcDistance -> NAN!");
-		return 1.0;
+		return static_cast<long>(n)*(n+1) / 2;
 	}
-	return 1-meanOverlap;
 }
 
-int triangularNumber(int num)
-{
-	return ((num-1)*num)/2;
-}
 
-// TODO: use better data structure?
-// or use SLINT or other hierarch. clustering
-template <typename ValueType>
-class DiagonalMatrix
+bool iAImageClusterer::LoadIntoCache(iALabelImageCache & cache, int first, int last)
 {
-public:
-	DiagonalMatrix(int side):
-		m_storageSize(triangularNumber(side)),
-		m_side(side),
-		m_values(new ValueType[m_storageSize])
+	for (int i = first; i < last && !m_aborted; ++i)
 	{
-		for (int i=0; i<m_storageSize; ++i)
-		{
-			m_values[i] = std::numeric_limits<ValueType>::max();
-		}
-	}
-	bool checkIndex(int x, int y)
-	{
-		if (x < 0 || x >= m_side || y < 0 || y > m_side)
-		{
-			DEBUG_LOG(QString("Clusterer::DiagonalMatrix: GetValue - index %1, %2  outside of valid range 0..%3\n")
-				.arg(x)
-				.arg(y)
-				.arg(m_side - 1) );
-			return false;
-		}
-		if (x == y)
+		if (cache.Contains(i))
+			continue;
+		ClusterImageType img = m_images[i]->GetRepresentativeImage(
+			iARepresentativeType::Difference, LabelImagePointer());
+		bool added = img && cache.Add(i, img);
+		m_images[i]->DiscardDetails();
+		if (!added)
 		{
-			DEBUG_LOG(QString("Clusterer::DiagonalMatrix: SetValue - Invalid access: diagonal! x==y==\n")
-				.arg(x));
+			DEBUG_LOG(QString("Could not load label image for result with id %1. Aborting clustering!").arg(i));
+			m_aborted = true;
 			return false;
 		}
-		return true;
-	}
-	void SetValue(int x, int y, ValueType value)
-	{
-		if (!checkIndex(x, y))
-		{
-			return;
-		}
-		assert(x >= 0 && y >= 0 && x < m_side && y < m_side);
-		m_values[translate(x, y)] = value;
-	}
-
-	ValueType GetValue(int x, int y)
-	{
-		if (!checkIndex(x, y))
-		{
-			return 0;
-		}
-		assert(x >= 0 && y >= 0 && x < m_side && y < m_side);
-		return m_values[translate(x, y)];
 	}
+	return !m_aborted;
+}
 
-	void Remove(int idx)
-	{
-		if (idx < 0 || idx >= m_side)
-		{
-			DEBUG_LOG(QString("Clusterer::DiagonalMatrix: Remove - index %1 outside of valid range 0..%2!\n")
-				.arg(idx)
-				.arg(m_side - 1));
-			return;
-		}
-		assert(idx >= 0 && idx < m_side);
-		//bool anyNotMax = false;
-		for (int i=0; i<m_side; ++i)
-		{
-			if (i == idx) continue;
-			int diagIdx = translate(idx, i);
-			//anyNotMax |= (m_values[diagIdx] != std::numeric_limits<ValueType>::max());
-			m_values[diagIdx] = std::numeric_limits<ValueType>::max();
-		}
-		/*
-		if (!anyNotMax)
-		{
-			DebugOut() << "Clusterer::DiagonalMatrix:: Remove - index "<<idx<<" seems to have been removed already before!" << std::endl;
-		}
-		*/
-	}
-	std::pair<int, int> GetMinimum()
-	{
-		std::pair<int, int> minIdx;
-		ValueType min1 = std::numeric_limits<ValueType>::max();
-		for (int x=0; x<m_side-1; ++x)
-		{
-			for (int y=x+1; y<m_side; ++y)
-			{
-				ValueType dist = GetValue(x, y);
-				if (dist < min1)
-				{
-					min1 = dist;
-					minIdx = std::make_pair(x, y);
-				}
-			}
-		}
-		if (minIdx.first == minIdx.second)
-		{
-			DEBUG_LOG(QString("Clusterer::DiagonalMatrix: GetMinimum - DiagonalMatrix seems to be empty already (m_side=%1)!\n")
-				.arg(m_side));
-		}
-		return minIdx;
-	}
 
-	void print()
+bool iAImageClusterer::CalculateDistances(iACondensedDistanceMatrix & distances)
+{
+	// The images are processed in blocks, such that two blocks fit into the cache;
+	// each image is read from disk once per block pair it takes part in,
+	// so if all images fit into the cache, each image is read exactly once.
+	const int imageCount = m_images.size();
+	iALabelImageCache cache(m_labelCount);
+	ClusterImageType firstImg = m_images[0]->GetRepresentativeImage(
+		iARepresentativeType::Difference, LabelImagePointer());
+	if (!firstImg)
 	{
-		for (int i=0; i<m_storageSize; ++i)
-		{
-			if (m_values[i] == std::numeric_limits<ValueType>::max())
-			{
-				std::cout << "* ";
-			}
-			else
-			{
-				std::cout << m_values[i] << " ";
-			}
-		}
-		std::cout << std::endl;
+		DEBUG_LOG("Could not load label image for result with id 0. Aborting clustering!");
+		m_aborted = true;
+		return false;
 	}
-	void prettyPrint()
+	itk::ImageRegion<DIM>::SizeType size = firstImg->GetLargestPossibleRegion().GetSize();
+	m_images[0]->DiscardDetails();
+	size_t imageBytes = std::max(cache.BytesPerImage(size[0] * size[1] * size[2]), static_cast<size_t>(1));
+	int blockSize = static_cast<int>(std::min(static_cast<size_t>(imageCount),
+		std::max(LabelCacheBudget / (2 * imageBytes), static_cast<size_t>(1))));
+	int blockCount = (imageCount + blockSize - 1) / blockSize;
+	const long long totalPairs = sumUpTo(imageCount - 1);
+	std::atomic<long long> finishedPairs(0);
+	std::atomic<int> lastProgress(0);
+	m_finishedPairs = 0;
+	for (int b1 = 0; b1 < blockCount && !m_aborted; ++b1)
 	{
-		for (int y=0; y<m_side; ++y)
+		int first1 = b1 * blockSize, last1 = std::min(first1 + blockSize, imageCount);
+		if (!LoadIntoCache(cache, first1, last1))
+			return false;
+		for (int b2 = b1; b2 < blockCount && !m_aborted; ++b2)
 		{
-			for (int x=0; x<m_side; ++x)
+			int first2 = b2 * blockSize, last2 = std::min(first2 + blockSize, imageCount);
+			emit Status(QString("Calculating distances for image pairs, images %1-%2 with %3-%4 of %5")
+				.arg(first1).arg(last1 - 1).arg(first2).arg(last2 - 1).arg(imageCount));
+			if (!LoadIntoCache(cache, first2, last2))
+				return false;
+			std::vector<std::pair<int, int> > pairs;
+			for (int i = first1; i < last1; ++i)
+				for (int j = std::max(i + 1, first2); j < last2; ++j)
+					pairs.push_back(std::make_pair(i, j));
+			const int pairCount = static_cast<int>(pairs.size());
+#pragma omp parallel for schedule(dynamic)
+			for (int p = 0; p < pairCount; ++p)
 			{
-				if (x == y)
-				{
-					std::cout << "- ";
-				}
-				else if (m_values[translate(x, y)] == std::numeric_limits<ValueType>::max())
-				{
-					std::cout << "* ";
-				}
-				else
-				{
-					std::cout << m_values[translate(x, y)] << " ";
-				}
+				if (m_aborted)
+					continue;
+				// distance metric is symmetric, only one direction required
+				distances(pairs[p].first, pairs[p].second) =
+					static_cast<float>(cache.Distance(pairs[p].first, pairs[p].second));
+				m_finishedPairs = ++finishedPairs;
+				int progress = static_cast<int>(SplitFactorDistanceCalc * finishedPairs / std::max(totalPairs, 1LL));
+				int previous = lastProgress.load();
+				if (progress > previous && lastProgress.compare_exchange_strong(previous, progress))
+					emit Progress(progress);
 			}
-			std::cout << std::endl;
+			if (b2 != b1)
+				for (int j = first2; j < last2; ++j)
+					cache.Remove(j);
 		}
+		for (int i = first1; i < last1; ++i)
+			cache.Remove(i);
 	}
-private:
-	DiagonalMatrix(const DiagonalMatrix& that) = delete;
-	// source: http://www.codeguru.com/cpp/cpp/algorithms/general/article.php/c11211/TIP-Half-Size-Triangular-Matrix.htm
-	int translate(int x, int y)
-	{
-		assert(x != y);
-		if (y<x)
-			std::swap(x, y);
-
-		int result = x*(m_side-1) - (x-1)*((x-1) + 1)/2 + y - x - 1;
-		return result;
-	}
-private:
-	int m_side;
-	int m_storageSize;
-	ValueType* m_values;
-};
-
-namespace {
-	const int FullProgress = 100;
-	const int SplitFactorDistanceCalc = 50;
-
-	long sumUpTo(int n)
-	{
-		return static_cast<long>(n)*(n+1) / 2;
-	}
-	long sumUpToDiff(int n1, int n2)
-	{
-		return sumUpTo(n1) - sumUpTo(n1-n2);
-	}
+	return !m_aborted;
 }
 
 
-bool IsEmpty(DiagonalMatrix<float> & distances, int idx, int cnt)
-{
-	bool result = true;
-	DEBUG_LOG(QString("%1 -> ").arg(idx));
-	for (int i=0; i<cnt; ++i)
-	{
-		if (i == idx) continue;
-		if (distances.GetValue(i, idx) != std::numeric_limits<float>::max())
-		{
-			DEBUG_LOG(QString("%1:%2 ")
-				.arg(i)
-				.arg(distances.GetValue(i, idx)));
-			result = false;
-			return false;
-		}
-	}
-	if (result)
-	{
-		DEBUG_LOG(QString("%1 is empty!").arg(idx));
-	}
-	return true;
-}
-
 void iAImageClusterer::run()
 {
-	m_remainingNodes = m_images.size();
+	const int imageCount = m_images.size();
+	m_remainingNodes = imageCount;
 	m_perfTimer.start();
 	emit Status("Calculating distances for all image pairs");
-	DiagonalMatrix<float> distances((m_images.size()*2)-1);
-#ifdef CLUSTER_DEBUGGING
-	std::ofstream distFile("cluster-debugging.txt");
-#endif
-	for (m_currImage=0; m_currImage<m_images.size() && !m_aborted; ++m_currImage)
-	{
-		emit Status(QString("Calculating distances for image pairs, image ")+QString::number(m_currImage) +" of " +QString::number(m_images.size()) );
-		// assuming here that the metric is symmetric
-#ifdef CLUSTER_DEBUGGING
-		std::ostringstream distFileLine;
-		distFileLine << m_currImage << ":";
-#endif
-		for (int j=m_currImage+1; j<m_images.size() && !m_aborted; ++j)
-		{
-			ClusterImageType img1 = m_images[m_currImage]->GetRepresentativeImage(
-				iARepresentativeType::Difference, LabelImagePointer()).GetPointer();
-			ClusterImageType img2 = m_images[j]->GetRepresentativeImage(
-				iARepresentativeType::Difference, LabelImagePointer()).GetPointer();
-			float distance = 1.0;
-			if (!img1 || !img2)
-			{
-				DEBUG_LOG(QString("Could not load label image for result with id %1 or %2. Aborting clustering!").arg(m_currImage).arg(j));
-				m_aborted = true;
-				return;
-			}
-			else
-			{
-				distance = CalcDistance(img1, img2);
-			}
-			if (isNaN(distance))
-			{
-				DEBUG_LOG(QString("ERROR: %1, %2 -> NAN!")
-					.arg(m_currImage)
-					.arg(j));
-				distance = 1.0;
-			}
-			// itk unloads images after filter is applied to them
-			// (which at the moment happens in CalcDistance)
-			// so we can just discard the smart pointers here,
-			// the images need to be reloaded anyway!
-			m_images[j]->DiscardDetails();
-			m_images[m_currImage]->DiscardDetails();
-			distances.SetValue(m_currImage, j, distance);
-#ifdef CLUSTER_DEBUGGING
-			distFileLine<<" "<<j<<":"<<distance;
-#endif
-		}
-#ifdef CLUSTER_DEBUGGING
-		distFile << distFileLine.str() << std::endl;
-#endif
-		emit Progress(SplitFactorDistanceCalc * 
-			(static_cast<double>(sumUpToDiff(m_images.size(), m_currImage))/ sumUpTo(m_images.size())) );
-	}
-	//distances.prettyPrint();
+	iACondensedDistanceMatrix distances(m_images.size());
+	if (!CalculateDistances(distances))
+		return;
 	m_imageDistCalcDuration = m_perfTimer.elapsed();
 	m_perfTimer.start();
 	emit Status("Hierarchical clustering.");
 	assert(m_images.size() > 0);
+	iAPerformanceTimer phaseTimer;
+	std::vector<iAClusterMerge> merges = CompleteLinkageClustering(distances);
+	iAPerformanceTimer::DurationType clusteringDuration = phaseTimer.elapsed();
+	phaseTimer.start();
 	QSharedPointer<iAImageTreeNode> lastNode = m_images[0];
 	int clusterID = m_remainingNodes;
-	while (m_remainingNodes > 1 && !m_aborted) // we need to do n-1 merges
+#ifdef CLUSTER_DEBUGGING
+	std::ofstream distFile("cluster-debugging.txt");
+#endif
+	for (size_t m = 0; m < merges.size() && !m_aborted; ++m)
 	{
 		emit Status(QString("Hierarchical clustering (")+QString::number(m_remainingNodes)+" remaining nodes)");
-		// get minimum distance pair:
-		std::pair<int, int> idx = distances.GetMinimum();
-		assert (idx.first != idx.second);
-
-		if (idx.first == idx.second)
-		{
-			if (idx.first == 0)
-			{
-				DEBUG_LOG(QString("Premature exit with %1 nodes remaining: ").arg(m_remainingNodes));
-				for (int i=0; i<m_images.size(); ++i)
-				{
-					if (!m_images[i].isNull())
-					{
-						IsEmpty(distances, i, m_images.size());
-					}
-				}
-				DEBUG_LOG("\n");
-				break;
-			}
-			DEBUG_LOG(QString("Clustering: Two times %1 is not a valid pair!").arg(idx.first));
-			distances.Remove(idx.first);
-			continue;
-		}
-
-		if (!m_images[idx.first] || !m_images[idx.second])
-		{
-			DEBUG_LOG(QString("Clustering: One or both of images to cluster already clustered (%1, %2)")
-				.arg(m_images[idx.first] ? "first set" : "!first NOT set!")
-				.arg(m_images[idx.second] ? "second set" : "!second NOT set!"));
-			DEBUG_LOG(QString("Premature exit with %1 nodes remaining!").arg(m_remainingNodes));
-			for (int i=0; i<m_images.size(); ++i)
-			{
-				if (!m_images[i].isNull())
-				{
-					IsEmpty(distances, i, m_images.size());
-				}
-			}
-			break;
-		}
+		iAClusterMerge const & merge = merges[m];
 		// create merged node:
 		lastNode = QSharedPointer<iAImageTreeInternalNode>(new iAImageTreeInternalNode(
-			m_images[idx.first], m_images[idx.second],
+			m_images[merge.first], m_images[merge.second],
 			m_labelCount,
 			m_outputDirectory,
 			clusterID++,
-			distances.GetValue(idx.first, idx.second)
+			merge.distance
 		));
-		m_images[idx.first ]->SetParent(lastNode);
-		m_images[idx.second]->SetParent(lastNode);
-		m_images[idx.first ]->DiscardDetails();
-		m_images[idx.second]->DiscardDetails();
-		
-		m_images.push_back(lastNode);
-		
-		// recalculate distances:
-		int newItemIdx = m_images.size()-1;
 #ifdef CLUSTER_DEBUGGING
-		std::ostringstream distFileLine;
-		distFileLine << newItemIdx << "("<<idx.first<<","<<idx.second<<"):";
+		distFile << (m_images.size()) << "(" << merge.first << "," << merge.second << "): " << merge.distance << std::endl;
 #endif
-		for (int i=0; i<m_images.size()-1 && !m_aborted; ++i) // last one is the just inserted one, skip that
-		{
-			if (i == idx.first || i == idx.second || !m_images[i]) // skip deleted ones
-				continue;
-			assert(m_images[idx.first]);
-			assert(m_images[idx.second]);
-			float distance = std::max(		// maximum-linkage
-				distances.GetValue(i, idx.first),
-				distances.GetValue(i, idx.second)
-			);
-			// index translation should take care that everything gets into the right place
-			distances.SetValue(i, newItemIdx, distance);
-#ifdef CLUSTER_DEBUGGING
-			distFileLine << " " << i << ":" << distance;
-#endif
-		}
-#ifdef CLUSTER_DEBUGGING
-		distFile << distFileLine.str() << std::endl;
-#endif
-		// remove from matrix & list:
-		distances.Remove(idx.first);
-		m_images[idx.first] = QSharedPointer<iAImageTreeNode>();
-		distances.Remove(idx.second);
-		m_images[idx.second] = QSharedPointer<iAImageTreeNode>();
+		m_images[merge.first ]->SetParent(lastNode);
+		m_images[merge.second]->SetParent(lastNode);
+		m_images[merge.first ]->DiscardDetails();
+		m_images[merge.second]->DiscardDetails();
+		m_images.push_back(lastNode);
+		m_images[merge.first ] = QSharedPointer<iAImageTreeNode>();
+		m_images[merge.second] = QSharedPointer<iAImageTreeNode>();
 
 		--m_remainingNodes;
 		emit Progress(
@@ -457,6 +213,11 @@ void iAImageClusterer::run()
 			(FullProgress-SplitFactorDistanceCalc) * (m_images.size()-m_remainingNodes)/m_images.size()
 		);
 	}
+	DEBUG_LOG(QString("Clustering of %1 images: distance calculation %2 s, merging %3 s, tree construction %4 s.")
+		.arg(imageCount)
+		.arg(m_imageDistCalcDuration)
+		.arg(clusteringDuration)
+		.arg(phaseTimer.elapsed()));
 	if (!m_aborted)
 	{
 		m_tree = QSharedPointer<iAImageTree>(new iAImageTree(lastNode, m_labelCount));
@@ -486,8 +247,11 @@ double iAImageClusterer::estimatedTimeRemaining() const
 	// estimated time given until current step (image distance calc / clustering) finished, not whole operation
 	if (m_imageDistCalcDuration == 0.0)
 	{
-		return (m_perfTimer.elapsed() / sumUpToDiff(m_images.size(), m_currImage)) // average duration of one image comparison
-			* sumUpTo(m_images.size()-m_currImage); // number of image comparisons still to do
+		long long finishedPairs = m_finishedPairs;
+		if (finishedPairs == 0)
+			return 0.0;
+		return (m_perfTimer.elapsed() / finishedPairs) // average duration of one image comparison
+			* (sumUpTo(m_images.size()-1) - finishedPairs); // number of image comparisons still to do
 	}
 	else
 	{
@@ -28,8 +28,12 @@
 #include <QVector>
 #include <QThread>
 
+#include <atomic>
+
+class iACondensedDistanceMatrix;
 class iAImageTree;
 class iAImageTreeNode;
+class iALabelImageCache;
 class iASingleResult;
 
 class iAImageClusterer: public QThread, public iADurationEstimator, public iAAbortListener
@@ -51,13 +55,17 @@ signals:
 	void Status(QString const &);
 private:
 	void run();
+	//! load the label images with indices first..last-1 into the cache, unless they are already there
+	bool LoadIntoCache(iALabelImageCache & cache, int first, int last);
+	//! calculate the distances between all pairs of images, in parallel
+	bool CalculateDistances(iACondensedDistanceMatrix & distances);
 	QVector<QSharedPointer<iAImageTreeNode> > m_images;
 	QSharedPointer<iAImageTree> m_tree;
 	int m_labelCount;
-	bool m_aborted;
+	std::atomic<bool> m_aborted;
 	iAPerformanceTimer m_perfTimer;
 	int m_remainingNodes;
-	int m_currImage;
+	std::atomic<long long> m_finishedPairs;
 	iAPerformanceTimer::DurationType m_imageDistCalcDuration;
 	QString m_outputDirectory;
 };
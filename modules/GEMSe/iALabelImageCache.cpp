@@ -0,0 +1,122 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#include "pch.h"
+#include "iALabelImageCache.h"
+
+#include "iAConsole.h"
+
+#include <cstdint>
+
+namespace
+{
+	template <typename T>
+	void compactCopy(LabelImageType const * img, unsigned char * dest, size_t voxelCount)
+	{
+		LabelPixelType const * src = img->GetBufferPointer();
+		T * out = reinterpret_cast<T*>(dest);
+		for (size_t i = 0; i < voxelCount; ++i)
+			out[i] = static_cast<T>(src[i]);
+	}
+
+	//! mean overlap as in itk::LabelOverlapMeasuresImageFilter: over all labels except 0,
+	//! voxels where both images agree count towards intersection and union of that label,
+	//! voxels where they disagree towards the union of both labels
+	template <typename T>
+	double overlapDistance(unsigned char const * img1, unsigned char const * img2, size_t voxelCount)
+	{
+		T const * a = reinterpret_cast<T const *>(img1);
+		T const * b = reinterpret_cast<T const *>(img2);
+		unsigned long long intersection = 0, unionCount = 0;
+		for (size_t i = 0; i < voxelCount; ++i)
+		{
+			unsigned int equal = a[i] == b[i];
+			unsigned int labelA = a[i] != 0;
+			unsigned int labelB = b[i] != 0;
+			intersection += equal & labelA;
+			unionCount += labelA + ((1 - equal) & labelB);
+		}
+		if (unionCount == 0)
+			return 1.0;
+		double unionOverlap = static_cast<double>(intersection) / unionCount;
+		double meanOverlap = 2.0 * unionOverlap / (1.0 + unionOverlap);
+		return 1.0 - meanOverlap;
+	}
+}
+
+iALabelImageCache::iALabelImageCache(int labelCount):
+	m_bytesPerVoxel(labelCount <= 256 ? 1 : (labelCount <= 65536 ? 2 : 4)),
+	m_voxelCount(0)
+{}
+
+size_t iALabelImageCache::BytesPerImage(size_t voxelCount) const
+{
+	return voxelCount * m_bytesPerVoxel;
+}
+
+bool iALabelImageCache::Add(int idx, ClusterImageType img)
+{
+	LabelImageType * labelImg = dynamic_cast<LabelImageType*>(img.GetPointer());
+	if (!labelImg)
+	{
+		DEBUG_LOG(QString("Label image %1 has an unexpected pixel type!").arg(idx));
+		return false;
+	}
+	LabelImageType::SizeType size = labelImg->GetBufferedRegion().GetSize();
+	size_t voxelCount = size[0] * size[1] * size[2];
+	if (m_images.isEmpty())
+		m_voxelCount = voxelCount;
+	else if (voxelCount != m_voxelCount)
+	{
+		DEBUG_LOG(QString("Label image %1 has a different size than the other label images!").arg(idx));
+		return false;
+	}
+	std::vector<unsigned char> & data = m_images[idx];
+	data.resize(BytesPerImage(voxelCount));
+	switch (m_bytesPerVoxel)
+	{
+		case 1:  compactCopy<std::uint8_t >(labelImg, data.data(), voxelCount); break;
+		case 2:  compactCopy<std::uint16_t>(labelImg, data.data(), voxelCount); break;
+		default: compactCopy<std::uint32_t>(labelImg, data.data(), voxelCount); break;
+	}
+	return true;
+}
+
+bool iALabelImageCache::Contains(int idx) const
+{
+	return m_images.contains(idx);
+}
+
+void iALabelImageCache::Remove(int idx)
+{
+	m_images.remove(idx);
+}
+
+double iALabelImageCache::Distance(int idx1, int idx2) const
+{
+	unsigned char const * img1 = m_images.find(idx1)->data();
+	unsigned char const * img2 = m_images.find(idx2)->data();
+	switch (m_bytesPerVoxel)
+	{
+		case 1:  return overlapDistance<std::uint8_t >(img1, img2, m_voxelCount);
+		case 2:  return overlapDistance<std::uint16_t>(img1, img2, m_voxelCount);
+		default: return overlapDistance<std::uint32_t>(img1, img2, m_voxelCount);
+	}
+}
@@ -0,0 +1,50 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#pragma once
+
+#include "iAImageTreeNode.h"
+
+#include <QMap>
+
+#include <vector>
+
+//! Keeps label images in memory in a compact representation (one byte per voxel
+//! for up to 256 labels, two bytes for up to 65536 labels, four otherwise),
+//! and computes label overlap distances between them.
+class iALabelImageCache
+{
+public:
+	iALabelImageCache(int labelCount);
+	//! number of bytes a cached image with the given number of voxels takes up
+	size_t BytesPerImage(size_t voxelCount) const;
+	//! store a compact copy of the given label image under the given index
+	//! @return false if the image is not a label image or its size differs from the images added before
+	bool Add(int idx, ClusterImageType img);
+	bool Contains(int idx) const;
+	void Remove(int idx);
+	//! distance between two cached images, defined as 1 - mean overlap, which is computed in
+	//! the same way as by itk::LabelOverlapMeasuresImageFilter (the label 0 is ignored)
+	double Distance(int idx1, int idx2) const;
+private:
+	size_t m_bytesPerVoxel;
+	size_t m_voxelCount;
+	QMap<int, std::vector<unsigned char> > m_images;
+};
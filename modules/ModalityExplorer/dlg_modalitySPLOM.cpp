@@ -26,6 +26,7 @@
 #include "iAModality.h"
 #include "iAModalityList.h"
 #include "charts/iAQSplom.h"
+#include "charts/iASPLOMData.h"
 
 #include <vtkColorTransferFunction.h>
 #include <vtkImageData.h>
@@ -33,14 +34,13 @@
 #include <vtkPiecewiseFunction.h>
 
 #include <QHBoxLayout>
-#include <QTableWidget>
 #include <mdichild.h>
 
 #include <functional>
 
 dlg_modalitySPLOM::dlg_modalitySPLOM():
 	m_splom(new iAQSplom(this)),
-	m_voxelData(new QTableWidget()),
+	m_voxelData(new iASPLOMData()),
 	m_selection_ctf(vtkSmartPointer<vtkColorTransferFunction>::New()),
 	m_selection_otf(vtkSmartPointer<vtkPiecewiseFunction>::New())
 {
@@ -88,9 +88,9 @@ void dlg_modalitySPLOM::SplomSelection(QVector<unsigned int> * selInds)
 	for (int i=0; i<selInds->size(); ++i)
 	{
 		int idx = selInds->at(i);
-		int x = m_voxelData->item(idx, 0)->text().toInt();
-		int y = m_voxelData->item(idx, 1)->text().toInt();
-		int z = m_voxelData->item(idx, 2)->text().toInt();
+		int x = static_cast<int>(m_voxelData->paramData(0)[idx]);
+		int y = static_cast<int>(m_voxelData->paramData(1)[idx]);
+		int z = static_cast<int>(m_voxelData->paramData(2)[idx]);
 		result->SetScalarComponentFromFloat(x, y, z, 0, 1);
 	}
 
@@ -120,7 +120,6 @@ void dlg_modalitySPLOM::SplomSelection(QVector<unsigned int> * selInds)
 
 dlg_modalitySPLOM::~dlg_modalitySPLOM()
 {
-	delete m_voxelData;
 }
 
 typedef unsigned short VoxelValueType;
@@ -165,12 +164,8 @@ void dlg_modalitySPLOM::SetData(QSharedPointer<iAModalityList> modalities)
 	m_lut->Build();
 
 
-	iATimeGuard timer("QTableWidget Conversion", false);
-	// fill QTableWidget
+	iATimeGuard timer("SPLOM data conversion", false);
 	// TODO: implement sampling - full calculation takes too long for larger datasets!
-	m_voxelData->clear();
-	m_voxelData->setColumnCount(3 + modalities->size()); // x,y,z coordinate + one value per modality
-
 	modalities->Get(0)->GetImage()->GetExtent(m_extent);
 	modalities->Get(0)->GetImage()->GetSpacing(m_spacing);
 	modalities->Get(0)->GetImage()->GetOrigin(m_origin);
@@ -183,49 +178,43 @@ void dlg_modalitySPLOM::SetData(QSharedPointer<iAModalityList> modalities)
 		(m_extent[3]-m_extent[2]+1) / std::min(m_extent[3]-m_extent[2]+1, maxNumSteps),
 		(m_extent[5]-m_extent[4]+1) / std::min(m_extent[5]-m_extent[4]+1, maxNumSteps)
 	};
-	int tableSize = (int)(((m_extent[1]-m_extent[0]+1) / step[0]) + 1) *
-	                (int)(((m_extent[3]-m_extent[2]+1) / step[1]) + 1) *
-	                (int)(((m_extent[5]-m_extent[4]+1) / step[2]) + 1);
-	
-	//std::cout << "Steps: " << step[0] << ", " << step[1] << ", " << step[2] << "; tableSize: " << tableSize;
-	
-	iATimeAdder adder;
-	adder.resume();
-	m_voxelData->setRowCount(1 + tableSize);
-	adder.pause();
-	m_voxelData->setItem(0, 0, new QTableWidgetItem("x"));
-	m_voxelData->setItem(0, 1, new QTableWidgetItem("y"));
-	m_voxelData->setItem(0, 2, new QTableWidgetItem("z"));
-
-	int voxelIdx;
+	size_t tableSize = static_cast<size_t>((m_extent[1] - m_extent[0]) / step[0] + 1) *
+	                   ((m_extent[3] - m_extent[2]) / step[1] + 1) *
+	                   ((m_extent[5] - m_extent[4]) / step[2] + 1);
+
+	// x,y,z coordinate + one value per modality, stored directly in the columnar SPLOM data:
+	QList<QString> paramNames;
+	paramNames << "x" << "y" << "z";
 	for (int imgIdx=0; imgIdx<modalities->size(); ++imgIdx)
 	{
-		m_voxelData->setItem(0, 3+imgIdx, new QTableWidgetItem(QString("Mod")+QString::number(imgIdx)));
-		voxelIdx = 1;
+		paramNames << QString("Mod")+QString::number(imgIdx);
+	}
+	m_voxelData->allocate(paramNames, tableSize);
+	size_t voxelIdx;
+	for (int imgIdx=0; imgIdx<modalities->size(); ++imgIdx)
+	{
+		voxelIdx = 0;
+		double * modalityValues = m_voxelData->paramData(3 + imgIdx);
 		vtkSmartPointer<vtkImageData> img = modalities->Get(imgIdx)->GetImage();
-		std::function<void (int[3], VoxelValueType)> pixelVisitor = [this, &imgIdx, &voxelIdx, &adder, &tableSize](int coord[3], VoxelValueType modalityValue)
+		std::function<void (int[3], VoxelValueType)> pixelVisitor = [this, &imgIdx, &voxelIdx, &tableSize, modalityValues](int coord[3], VoxelValueType modalityValue)
 		{
 			assert (voxelIdx < tableSize);
-			adder.resume();
 			if (imgIdx == 0)
 			{
-				m_voxelData->setItem(voxelIdx, 0, new QTableWidgetItem(QString::number(coord[0])));
-				m_voxelData->setItem(voxelIdx, 1, new QTableWidgetItem(QString::number(coord[1])));
-				m_voxelData->setItem(voxelIdx, 2, new QTableWidgetItem(QString::number(coord[2])));
+				for (int i = 0; i < 3; ++i)
+				{
+					m_voxelData->paramData(i)[voxelIdx] = coord[i];
+				}
 			}
-			m_voxelData->setItem(voxelIdx, 3+imgIdx, new QTableWidgetItem(QString::number(modalityValue)));
-			adder.pause();
+			modalityValues[voxelIdx] = modalityValue;
 			voxelIdx++;
 		};
 		IteratePixels(img, step, pixelVisitor);
 	}
-	m_voxelData->setRowCount(voxelIdx);
 	// pass to scatter plot matrix:
 	m_splom->setData(m_voxelData);
 	m_splom->setLookupTable(m_lut, QString("Mod0"));
 	m_splom->setParameterVisibility("x", false);
 	m_splom->setParameterVisibility("y", false);
 	m_splom->setParameterVisibility("z", false);
-
-	//std::cout << "Elapsed for adding to QTableWidget: " << adder.elapsed() << " seconds" << std::endl;
 }
\ No newline at end of file
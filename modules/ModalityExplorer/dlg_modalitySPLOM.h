@@ -29,7 +29,7 @@
 
 class iAModalityList;
 class iAQSplom;
-class QTableWidget;
+class iASPLOMData;
 
 class vtkColorTransferFunction;
 class vtkImageData;
@@ -47,7 +47,7 @@ private slots:
 	void SplomSelection(QVector<unsigned int> *);
 private:
 	iAQSplom* m_splom;
-	QTableWidget* m_voxelData;
+	QSharedPointer<iASPLOMData> m_voxelData;
 	vtkSmartPointer<vtkLookupTable> m_lut;
 	int m_extent[6];
 	double m_spacing[3];
@@ -0,0 +1,158 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+ 
+#include "pch.h"
+#include "iABatchScheduler.h"
+
+#include <QRunnable>
+#include <QThreadPool>
+
+class iABatchScheduler::Worker : public QRunnable
+{
+public:
+	Worker( iABatchScheduler * scheduler, int index ) : m_scheduler( scheduler ), m_index( index ) {}
+	virtual void run()
+	{
+		while ( iABatchJob * job = m_scheduler->takeJob( m_index ) )
+		{
+			unsigned long long memory = job->memoryEstimate();
+			m_scheduler->acquireMemory( memory );
+			job->run();
+			m_scheduler->releaseMemory( memory );
+			delete job;
+		}
+	}
+private:
+	iABatchScheduler * m_scheduler;
+	int m_index;
+};
+
+iABatchScheduler::iABatchScheduler( int workerCount, unsigned long long memoryBudget ) :
+	m_queues( qMax( 1, workerCount ) ),
+	m_memoryBudget( memoryBudget ),
+	m_memoryUsed( 0 ),
+	m_residentMemory( 0 ),
+	m_stolenJobs( 0 )
+{
+	for ( int i = 0; i < m_queues.size(); ++i )
+		m_queueMutexes.push_back( QSharedPointer<QMutex>( new QMutex() ) );
+}
+
+iABatchScheduler::~iABatchScheduler()
+{
+	for ( int i = 0; i < m_queues.size(); ++i )
+		qDeleteAll( m_queues[i] );
+}
+
+void iABatchScheduler::addJobs( QList<iABatchJob*> const & jobs )
+{
+	int workers = m_queues.size();
+	for ( int i = 0; i < jobs.size(); ++i )
+	{
+		int worker = static_cast<int>( static_cast<long long>( i ) * workers / jobs.size() );
+		QMutexLocker locker( m_queueMutexes[worker].data() );
+		m_queues[worker].append( jobs[i] );
+	}
+}
+
+void iABatchScheduler::run()
+{
+	m_stolenJobs.store( 0 );
+	QThreadPool pool;
+	pool.setMaxThreadCount( m_queues.size() );
+	for ( int i = 0; i < m_queues.size(); ++i )
+		pool.start( new Worker( this, i ) );
+	pool.waitForDone();
+}
+
+int iABatchScheduler::workerCount() const
+{
+	return m_queues.size();
+}
+
+int iABatchScheduler::stolenJobs() const
+{
+	return m_stolenJobs.load();
+}
+
+unsigned long long iABatchScheduler::memoryBudget() const
+{
+	return m_memoryBudget;
+}
+
+void iABatchScheduler::addResidentMemory( unsigned long long bytes )
+{
+	QMutexLocker locker( &m_memoryMutex );
+	m_residentMemory += bytes;
+}
+
+void iABatchScheduler::releaseResidentMemory( unsigned long long bytes )
+{
+	QMutexLocker locker( &m_memoryMutex );
+	m_residentMemory -= qMin( bytes, m_residentMemory );
+	m_memoryReleased.wakeAll();
+}
+
+iABatchJob * iABatchScheduler::takeJob( int worker )
+{
+	{
+		QMutexLocker locker( m_queueMutexes[worker].data() );
+		if ( !m_queues[worker].isEmpty() )
+			return m_queues[worker].takeFirst();
+	}
+	// steal from the far end of the fullest queue, where the jobs least related to the victim's current ones are
+	while ( true )
+	{
+		int victim = -1, victimSize = 0;
+		for ( int i = 0; i < m_queues.size(); ++i )
+		{
+			QMutexLocker locker( m_queueMutexes[i].data() );
+			if ( m_queues[i].size() > victimSize )
+			{
+				victim = i;
+				victimSize = m_queues[i].size();
+			}
+		}
+		if ( victim == -1 )
+			return 0;
+		QMutexLocker locker( m_queueMutexes[victim].data() );
+		if ( m_queues[victim].isEmpty() )
+			continue;	// emptied in the meantime, look again
+		m_stolenJobs.ref();
+		return m_queues[victim].takeLast();
+	}
+}
+
+void iABatchScheduler::acquireMemory( unsigned long long bytes )
+{
+	QMutexLocker locker( &m_memoryMutex );
+	// resident memory alone never blocks: it is only released by runs that have to start first
+	while ( m_memoryUsed > 0 && m_memoryUsed + m_residentMemory + bytes > m_memoryBudget )
+		m_memoryReleased.wait( &m_memoryMutex );
+	m_memoryUsed += bytes;
+}
+
+void iABatchScheduler::releaseMemory( unsigned long long bytes )
+{
+	QMutexLocker locker( &m_memoryMutex );
+	m_memoryUsed -= bytes;
+	m_memoryReleased.wakeAll();
+}
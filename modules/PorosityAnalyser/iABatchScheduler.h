@@ -0,0 +1,75 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#pragma once
+
+#include <QList>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QVector>
+#include <QWaitCondition>
+
+//! A unit of work executed by iABatchScheduler
+class iABatchJob
+{
+public:
+	virtual ~iABatchJob() {}
+	virtual void run() = 0;
+	//! Estimated peak memory in bytes the job needs while running
+	virtual unsigned long long memoryEstimate() const = 0;
+};
+
+//! Runs independent jobs on a fixed number of worker threads.
+//! Every worker owns a queue and works through it front to back; a worker whose queue is
+//! empty steals from the back of the fullest other queue. A job only starts when the
+//! memory estimates of all running jobs plus the resident memory reported by the jobs (data
+//! they keep loaded between runs) stay within the budget (a single job always runs).
+class iABatchScheduler
+{
+public:
+	iABatchScheduler( int workerCount, unsigned long long memoryBudget );
+	~iABatchScheduler();
+	//! Distributes the jobs in contiguous chunks over the worker queues, the scheduler takes ownership.
+	//! Jobs close to each other in the list therefore tend to run on the same worker one after another.
+	void addJobs( QList<iABatchJob*> const & jobs );
+	//! Executes all queued jobs, blocks until they are finished
+	void run();
+	int workerCount() const;
+	//! Number of jobs taken from the queue of another worker during the last run
+	int stolenJobs() const;
+	unsigned long long memoryBudget() const;
+	//! Registers memory held by jobs beyond their own run, e.g. loaded input data or cached results
+	void addResidentMemory( unsigned long long bytes );
+	void releaseResidentMemory( unsigned long long bytes );
+private:
+	class Worker;
+	iABatchJob * takeJob( int worker );
+	void acquireMemory( unsigned long long bytes );
+	void releaseMemory( unsigned long long bytes );
+
+	QVector<QList<iABatchJob*> > m_queues;
+	QVector<QSharedPointer<QMutex> > m_queueMutexes;
+	unsigned long long m_memoryBudget;
+	unsigned long long m_memoryUsed;
+	unsigned long long m_residentMemory;
+	QMutex m_memoryMutex;
+	QWaitCondition m_memoryReleased;
+	QAtomicInt m_stolenJobs;
+};
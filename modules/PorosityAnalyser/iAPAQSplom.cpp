@@ -55,37 +55,18 @@ iAPAQSplom::iAPAQSplom( QWidget * parent /*= 0*/, const QGLWidget * shareWidget
 	m_removeFixedAction->setVisible( false );
 }
 
-void iAPAQSplom::setData( const QTableWidget * data )
+void iAPAQSplom::setData( QSharedPointer<iASPLOMData> data, QStringList const & maskNames )
 {
-	QTableWidget newData;
-	newData.setRowCount( data->rowCount() );
-	int maskCol = data->columnCount() - 1;
-	newData.setColumnCount( maskCol );
-	m_maskNames.clear();
+	m_maskNames = maskNames;
 	m_datasetIndices.clear();
-	if( data->rowCount() )
+	int datasetIndexCol = data->paramNames().indexOf( "Dataset Index" );
+	if( datasetIndexCol >= 0 )
 	{
-		newData.setUpdatesEnabled( false );  //for faster processing of large lists
-		int datasetIndexCol = -1;
-		for( int c = 0; c < maskCol; ++c ) //header		
-		{
-			QString s = data->item( 0, c )->text();
-			if( s == "Dataset Index" )
-				datasetIndexCol = c;
-			newData.setItem( 0, c, new QTableWidgetItem( s ) );
-		}
-		for( int r = 1; r < data->rowCount(); ++r ) //points
-		{
-			for( int c = 0; c < maskCol; ++c )
-				newData.setItem( r, c, new QTableWidgetItem( data->item( r, c )->text() ) );
-			m_maskNames.push_back( data->item( r, maskCol )->text() );
-			if( datasetIndexCol >= 0 )
-				m_datasetIndices.push_back( data->item( r, datasetIndexCol )->text().toInt() );
-		}
-		newData.setUpdatesEnabled( true );  //done with load
+		const double * datasetIndices = data->paramData( datasetIndexCol );
+		for( unsigned long i = 0; i < data->numPoints(); ++i )
+			m_datasetIndices.push_back( static_cast<int>( datasetIndices[i] ) );
 	}
-
-	iAQSplom::setData( &newData );
+	iAQSplom::setData( data );
 }
 
 void iAPAQSplom::setPreviewSliceNumbers( QList<int> sliceNumberLst )
@@ -32,7 +32,8 @@ class iAPAQSplom : public iAQSplom
 public:
 	iAPAQSplom( QWidget * parent = 0, const QGLWidget * shareWidget = 0, Qt::WindowFlags f = 0 );
 public:
-	virtual void setData( const QTableWidget * data );
+	//! Show the given runs; maskNames holds the mask file of each run (data point)
+	void setData( QSharedPointer<iASPLOMData> data, QStringList const & maskNames );
 	void setPreviewSliceNumbers( QList<int> sliceNumber );
 	void setROIList( QList<QRectF> roi );
 	void setSliceCounts( QList<int> sliceCnts );
@@ -0,0 +1,200 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+ 
+#include "pch.h"
+#include "iAPipelineCache.h"
+
+#include "io/iAITKIO.h"
+#include "iATypedCallHelper.h"
+
+#include <QDir>
+
+namespace
+{
+	template<class T>
+	void componentSize( size_t & size )
+	{
+		size = sizeof( T );
+	}
+
+	//! stage outputs are either masks or of the pixel type of the input dataset
+	ScalarPixelType pixelTypeOf( ImagePointer const & image, ScalarPixelType inputPixelType )
+	{
+		return dynamic_cast<MaskImageType*>( image.GetPointer() ) ? itk::ImageIOBase::CHAR : inputPixelType;
+	}
+
+	unsigned long long imageBytes( ImagePointer const & image, ScalarPixelType pixelType )
+	{
+		if ( !image )
+			return 0;
+		size_t compSize = 0;
+		ITK_TYPED_CALL( componentSize, pixelType, compSize );
+		return static_cast<unsigned long long>( image->GetLargestPossibleRegion().GetNumberOfPixels() ) * compSize;
+	}
+}
+
+iAPipelineCache::iAPipelineCache( QString const & spillDir, ScalarPixelType inputPixelType, unsigned long long ramBudget,
+	std::function<void( long long )> ramUsageChanged ) :
+	m_spillDir( spillDir ),
+	m_inputPixelType( inputPixelType ),
+	m_ramBudget( ramBudget ),
+	m_ramUsed( 0 ),
+	m_ramUsageChanged( ramUsageChanged ),
+	m_spillCounter( 0 ),
+	m_hits( 0 )
+{}
+
+iAPipelineCache::~iAPipelineCache()
+{
+	clear();
+}
+
+QString iAPipelineCache::stageKey( PorosityFilterID fid, QStringList const & stageParams )
+{
+	return QString( "%1(%2)" ).arg( fid ).arg( stageParams.join( "," ) );
+}
+
+bool iAPipelineCache::lookup( QString const & key, iAPipelineStageResult & result )
+{
+	QMutexLocker locker( &m_mutex );
+	QMap<QString, Entry>::iterator it = m_entries.find( key );
+	if ( it == m_entries.end() )
+		return false;
+	if ( it->onDisk && !restore( *it ) )
+	{
+		m_entries.erase( it );
+		return false;
+	}
+	++m_hits;
+	result = it->result;
+	touch( key );
+	evict();
+	return true;
+}
+
+void iAPipelineCache::insert( QString const & key, iAPipelineStageResult const & result )
+{
+	QMutexLocker locker( &m_mutex );
+	if ( m_entries.contains( key ) )
+		return;
+	Entry entry;
+	entry.result = result;
+	entry.maskType = pixelTypeOf( result.maskImage, m_inputPixelType );
+	entry.surroundingType = pixelTypeOf( result.surroundingMaskImage, m_inputPixelType );
+	entry.bytes = imageBytes( result.maskImage, entry.maskType ) +
+		imageBytes( result.surroundingMaskImage, entry.surroundingType );
+	m_entries.insert( key, entry );
+	changeRamUsed( static_cast<long long>( entry.bytes ) );
+	m_lru.prepend( key );
+	evict();
+}
+
+void iAPipelineCache::clear()
+{
+	QMutexLocker locker( &m_mutex );
+	m_entries.clear();
+	m_lru.clear();
+	changeRamUsed( -static_cast<long long>( m_ramUsed ) );
+	if ( m_spillCounter > 0 )
+		QDir( m_spillDir ).removeRecursively();
+	m_spillCounter = 0;
+}
+
+int iAPipelineCache::hits() const
+{
+	QMutexLocker locker( &m_mutex );
+	return m_hits;
+}
+
+void iAPipelineCache::touch( QString const & key )
+{
+	m_lru.removeOne( key );
+	m_lru.prepend( key );
+}
+
+void iAPipelineCache::evict()
+{
+	// the most recently used entry is about to be used by the caller, so it always stays in memory
+	while ( m_ramUsed > m_ramBudget && m_lru.size() > 1 )
+	{
+		QString key = m_lru.takeLast();
+		Entry & entry = m_entries[key];
+		changeRamUsed( -static_cast<long long>( entry.bytes ) );
+		if ( !spill( entry ) )
+			m_entries.remove( key );
+	}
+}
+
+bool iAPipelineCache::spill( Entry & entry )
+{
+	if ( m_spillCounter == 0 && !QDir().mkpath( m_spillDir ) )
+		return false;
+	QString baseName = m_spillDir + QString( "/stage%1" ).arg( m_spillCounter++ );
+	try
+	{
+		if ( entry.result.maskImage )
+		{
+			entry.maskFile = baseName + "_mask.mhd";
+			iAITKIO::writeFile( entry.maskFile, entry.result.maskImage, entry.maskType );
+		}
+		if ( entry.result.surroundingMaskImage )
+		{
+			entry.surroundingFile = baseName + "_surrounding.mhd";
+			iAITKIO::writeFile( entry.surroundingFile, entry.result.surroundingMaskImage, entry.surroundingType );
+		}
+	}
+	catch ( itk::ExceptionObject & )
+	{
+		return false;
+	}
+	entry.result.maskImage = ImagePointer();
+	entry.result.surroundingMaskImage = ImagePointer();
+	entry.onDisk = true;
+	return true;
+}
+
+bool iAPipelineCache::restore( Entry & entry )
+{
+	try
+	{
+		ScalarPixelType pixelType;
+		if ( !entry.maskFile.isEmpty() )
+			entry.result.maskImage = iAITKIO::readFile( entry.maskFile, pixelType, false );
+		if ( !entry.surroundingFile.isEmpty() )
+			entry.result.surroundingMaskImage = iAITKIO::readFile( entry.surroundingFile, pixelType, false );
+	}
+	catch ( itk::ExceptionObject & )
+	{
+		return false;
+	}
+	entry.onDisk = false;
+	changeRamUsed( static_cast<long long>( entry.bytes ) );
+	return true;
+}
+
+void iAPipelineCache::changeRamUsed( long long bytes )
+{
+	if ( bytes == 0 )
+		return;
+	m_ramUsed += bytes;
+	if ( m_ramUsageChanged )
+		m_ramUsageChanged( bytes );
+}
@@ -0,0 +1,97 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#pragma once
+
+#include "PorosityAnalyserHelpers.h"
+
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+#include <functional>
+
+//! State of a RunInfo after a pipeline prefix has been executed.
+//! Parameter names/values only hold the entries appended by the stages of the prefix.
+struct iAPipelineStageResult
+{
+	iAPipelineStageResult() : surroundingVoxels( 0 ), threshold( -1 ), elapsedTime( 0 ) {}
+
+	ImagePointer maskImage;
+	ImagePointer surroundingMaskImage;
+	long surroundingVoxels;
+	int threshold;
+	long elapsedTime;
+	QStringList parameterNames;
+	QStringList parameters;
+};
+
+//! Memoizes intermediate results of the pipelines executed in one batch.
+//! Entries are keyed by the filter ids and parameter values of a pipeline prefix. Results
+//! are kept in memory up to the given byte budget; least recently used entries beyond
+//! that budget are written to the spill directory and read back on their next use.
+//! The cache may be shared by runs executing concurrently.
+class iAPipelineCache
+{
+public:
+	//! ramUsageChanged, if given, is called with the change in bytes whenever the memory held by the entries
+	//! changes, so that the owner can account for it; it is called while the cache is locked.
+	iAPipelineCache( QString const & spillDir, ScalarPixelType inputPixelType, unsigned long long ramBudget,
+		std::function<void( long long )> ramUsageChanged = std::function<void( long long )>() );
+	~iAPipelineCache();
+	//! Looks up the result stored for the given prefix key, returns false if there is none
+	bool lookup( QString const & key, iAPipelineStageResult & result );
+	void insert( QString const & key, iAPipelineStageResult const & result );
+	//! Removes all entries and the spilled files
+	void clear();
+	//! Number of successful lookups
+	int hits() const;
+
+	//! Key part describing a single stage; prefix keys are the concatenated stage keys
+	static QString stageKey( PorosityFilterID fid, QStringList const & stageParams );
+private:
+	struct Entry
+	{
+		Entry() : bytes( 0 ), onDisk( false ) {}
+		iAPipelineStageResult result;
+		unsigned long long bytes;
+		bool onDisk;
+		QString maskFile, surroundingFile;
+		ScalarPixelType maskType, surroundingType;
+	};
+	void touch( QString const & key );
+	void evict();
+	bool spill( Entry & entry );
+	bool restore( Entry & entry );
+	void changeRamUsed( long long bytes );
+
+	QString m_spillDir;
+	ScalarPixelType m_inputPixelType;
+	unsigned long long m_ramBudget;
+	unsigned long long m_ramUsed;
+	std::function<void( long long )> m_ramUsageChanged;
+	int m_spillCounter;
+	int m_hits;
+	mutable QMutex m_mutex;
+	QMap<QString, Entry> m_entries;
+	QList<QString> m_lru;	//!< keys of the entries held in memory, most recently used first
+};
@@ -77,6 +77,8 @@ void iAPorosityAnalyserModuleInterface::Initialize()
 	m_resultsFolder = settings.value( "PorosityAnalyser/Computation/resultsFolder", "" ).toString();
 	m_datasetsFolder = settings.value( "PorosityAnalyser/Computation/datasetsFolder", "" ).toString();
 	m_csvFile = settings.value( "PorosityAnalyser/Computation/csvFile", "" ).toString();
+	m_parallelRuns = settings.value( "PorosityAnalyser/Computation/parallelRuns", qMin( 4, QThread::idealThreadCount() ) ).toInt();
+	m_memoryBudgetMB = settings.value( "PorosityAnalyser/Computation/memoryBudgetMB", 8192 ).toInt();
 
 	//Initialize compute segmentation window
 	m_compSegmWidget = new QDialog(m_mainWnd);
@@ -84,6 +86,8 @@ void iAPorosityAnalyserModuleInterface::Initialize()
 	uiComputeSegm.setupUi( m_compSegmWidget );
 	uiComputeSegm.Logs->hide();
 	uiComputeSegm.csvFilename->setText( m_csvFile );
+	uiComputeSegm.sbParallelRuns->setValue( m_parallelRuns );
+	uiComputeSegm.sbMemoryBudget->setValue( m_memoryBudgetMB );
 	uiComputeSegm.computerName->setText( m_computerName );
 	uiComputeSegm.resultsFolder->setText( m_resultsFolder );
 	uiComputeSegm.datasetsFolder->setText( m_datasetsFolder );
@@ -329,6 +333,8 @@ void iAPorosityAnalyserModuleInterface::SaveSettings() const
 	settings.setValue( "PorosityAnalyser/Computation/resultsFolder", m_resultsFolder );
 	settings.setValue( "PorosityAnalyser/Computation/datasetsFolder", m_datasetsFolder );
 	settings.setValue( "PorosityAnalyser/Computation/csvFile", m_csvFile );
+	settings.setValue( "PorosityAnalyser/Computation/parallelRuns", m_parallelRuns );
+	settings.setValue( "PorosityAnalyser/Computation/memoryBudgetMB", m_memoryBudgetMB );
 }
 
 void iAPorosityAnalyserModuleInterface::updateFromGUI() const
@@ -337,6 +343,8 @@ void iAPorosityAnalyserModuleInterface::updateFromGUI() const
 	m_resultsFolder = uiComputeSegm.resultsFolder->text();
 	m_datasetsFolder = uiComputeSegm.datasetsFolder->text();
 	m_csvFile = uiComputeSegm.csvFilename->text();
+	m_parallelRuns = uiComputeSegm.sbParallelRuns->value();
+	m_memoryBudgetMB = uiComputeSegm.sbMemoryBudget->value();
 }
 
 void iAPorosityAnalyserModuleInterface::browserResultsFolder()
@@ -361,11 +369,16 @@ void iAPorosityAnalyserModuleInterface::runCalculations()
 	connect( rbt, SIGNAL( batchProgress( int ) ), this, SLOT( batchProgress( int ) ) );
 	connect( rbt, SIGNAL( totalProgress( int ) ), this, SLOT( totalProgress( int ) ) );
 	connect( rbt, SIGNAL( currentBatch( QString ) ), this, SLOT( currentBatch( QString ) ) );
+	connect( rbt, SIGNAL( message( QString ) ), this, SLOT( log( QString ) ), Qt::QueuedConnection );
+	connect( uiComputeSegm.rbPause, SIGNAL( toggled( bool ) ), rbt, SLOT( setPaused( bool ) ) );
+	rbt->setPaused( uiComputeSegm.rbPause->isChecked() );
 	rbt->Init( this, m_datasetsFolder,
 			   uiComputeSegm.rbNewPipelineDataNoPores->isChecked(), 
 			   uiComputeSegm.rbNewPipelineData->isChecked(), 
 			   uiComputeSegm.rbExistingPipelineData->isChecked(), 
-			   calcPoreProps );
+			   calcPoreProps,
+			   uiComputeSegm.sbParallelRuns->value(),
+			   uiComputeSegm.sbMemoryBudget->value() * 1024ull * 1024ull );
 	rbt->start();
 }
 
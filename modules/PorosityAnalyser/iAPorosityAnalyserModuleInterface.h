@@ -45,7 +45,6 @@ public:
 	void Initialize();
 	void SaveSettings() const;
 	Ui::ComputeSegmentations * ui();
-	void log( QString text, bool appendToPrev = false );
 	QString DatasetFolder() const;
 	QString ResultsFolder() const;
 	QString CSVFile() const;
@@ -53,6 +52,9 @@ public:
 	QString CpuBrand() const { return m_cpuBrand; }
 	QString ComputerName() const;
 
+public slots:
+	void log( QString text, bool appendToPrev = false );
+
 private slots:
 	void computeParameterSpace();
 	void launchPorosityAnalyser();
@@ -89,6 +91,8 @@ protected:
 	mutable QString m_resultsFolder;
 	mutable QString m_datasetsFolder;
 	mutable QString m_csvFile;
+	mutable int m_parallelRuns;
+	mutable int m_memoryBudgetMB;
 	QString m_cpuVendor;
 	QString m_cpuBrand;	
 	iAPorosityAnalyser * m_porosityAnalyser;
@@ -25,7 +25,10 @@
 #include "CPUID.h"
 #include "defines.h"
 #include "iACSVToQTableWidgetConverter.h"
+#include "iAImageComparisonMetrics.h"
 #include "io/iAITKIO.h"
+#include "iABatchScheduler.h"
+#include "iAPipelineCache.h"
 #include "iAPorosityAnalyserModuleInterface.h"
 #include "iATypedCallHelper.h"
 
@@ -76,8 +79,11 @@
 #include <QDir>
 #include <QDirIterator>
 #include <QMessageBox>
+#include <QScopedPointer>
 #include <QTime>
 
+#include <algorithm>
+
 //openMP
 #ifndef __APPLE__
 #ifndef __MACOSX
@@ -85,6 +91,10 @@
 #endif
 #endif
 
+//! Maximum memory for intermediate results shared between the runs of a batch; the rest is spilled to disk.
+//! The cache of a batch gets at most a quarter of the memory budget of the scheduler, and its usage is charged against that budget.
+const unsigned long long PipelineCacheRAMBudget = 4ull * 1024 * 1024 * 1024;
+
 struct RunInfo
 {
 	RunInfo() : 
@@ -112,6 +122,94 @@ struct RunInfo
 	float dice;
 	QStringList parameterNames;
 	QStringList parameters;
+	QMap<QString, long> filterTimes;	//!< time in ms spent in the filters computed by this run
+};
+
+//! Parameter values of one run, captured from the sampled parameter infos so that runs can be executed independently
+class RunParameters
+{
+public:
+	RunParameters( const QList<IParameterInfo*> & params, const QList<ParamNameType> & paramsNameType )
+	{
+		for ( int i = 0; i < params.size(); ++i )
+		{
+			m_types << paramsNameType[i].type();
+			switch ( paramsNameType[i].type() )
+			{
+				case PT_INT:   m_values << params[i]->asInt();    break;
+				case PT_FLOAT: m_values << params[i]->asFloat();  break;
+				default:       m_values << params[i]->asDouble(); break;
+			}
+			m_names << params[i]->name;
+			m_strings << params[i]->asString();
+		}
+	}
+	int asInt( int i ) const
+	{
+		if ( m_types[i] != PT_INT )
+			throw itk::ExceptionObject( __FILE__, __LINE__, "Error: wrong parameter type is used!" );
+		return static_cast<int>( m_values[i] );
+	}
+	float asFloat( int i ) const
+	{
+		if ( m_types[i] != PT_FLOAT )
+			throw itk::ExceptionObject( __FILE__, __LINE__, "Error: wrong parameter type is used!" );
+		return static_cast<float>( m_values[i] );
+	}
+	QString asString( int i ) const { return m_strings[i]; }
+	QStringList const & names() const { return m_names; }
+	QStringList const & strings() const { return m_strings; }
+private:
+	QList<ParamType> m_types;
+	QList<double> m_values;
+	QStringList m_names, m_strings;
+};
+
+//! State shared by all runs of one batch (one row of the settings table)
+struct BatchInfo
+{
+	BatchInfo() : pixelType( itk::ImageIOBase::UNKNOWNCOMPONENTTYPE ), runMemory( 0 ), dataMemory( 0 ), scheduler( 0 ), loaded( false ),
+		firstRow( 0 ), writtenRows( 0 ), totalRuns( 0 ), finishedRuns( 0 ), settingsRow( 0 )
+	{}
+
+	QList<PorosityFilterID> filterIds;
+	QList<ParamNameType> paramsNameType;
+	QString datasetName, gtMaskName, batchDir, batchesDir, masksDir;
+	ScalarPixelType pixelType;
+	unsigned long long runMemory;	//!< estimated peak memory of a single run
+	unsigned long long dataMemory;	//!< memory of the dataset and ground truth kept loaded while the batch runs
+	iABatchScheduler * scheduler;	//!< the loaded data and cached results are charged against its memory budget
+
+	QMutex loadMutex;	//!< guards loading the data, i.e. pixelType and the members up to cache
+	bool loaded;
+	ImagePointer image;
+	ImagePointer gtMask;
+	QScopedPointer<iAPipelineCache> cache;
+	QMutex mutex;	//!< guards everything below, and releasing the loaded data after the last run
+	int firstRow;	//!< index of the first runs.csv row written by this batch
+	int writtenRows;	//!< number of rows this batch has appended to runs.csv so far
+	int totalRuns, finishedRuns;
+	int settingsRow;
+};
+
+class RunJob : public iABatchJob
+{
+public:
+	RunJob( iARunBatchThread * thread, BatchInfo * batch, RunParameters const & params ) :
+		m_thread( thread ), m_batch( batch ), m_params( params )
+	{}
+	virtual void run()
+	{
+		m_thread->executeRun( *m_batch, m_params );
+	}
+	virtual unsigned long long memoryEstimate() const
+	{
+		return m_batch->runMemory;
+	}
+private:
+	iARunBatchThread * m_thread;
+	BatchInfo * m_batch;
+	RunParameters m_params;
 };
 
 static float calcPorosity( const MaskImageType::Pointer image, int surroundingVoxels )
@@ -973,29 +1071,68 @@ void computeFhwThreshold( ImagePointer & image, PorosityFilterID filterId, RunIn
 }
 
 template<class T>
-void runBatch( const QList<PorosityFilterID> & filterIds, ImagePointer & image, RunInfo & results, const QList<IParameterInfo*> & params )
+void runBatch( const QList<PorosityFilterID> & filterIds, ImagePointer & image, RunInfo & results, const RunParameters & params, iAPipelineCache * cache )
 {
 	ImagePointer curImage = image;
 	results.startTime = QLocale().toString( QDateTime::currentDateTime(), QLocale::ShortFormat );
+	int baseParamCount = results.parameters.size();
+
+	// keys of all pipeline prefixes; the prefix up to stage i is determined by the filters and parameters of stages 0..i
+	QStringList prefixKeys;
+	QList<int> prefixParamCount;
+	QString key;
 	int pind = 0;
 	foreach( PorosityFilterID fid, filterIds )
 	{
+		QStringList stageParams;
+		for ( int i = 0; i < FilterIdToParamList[fid].size(); ++i )
+			stageParams << params.asString( pind + i );
+		pind += FilterIdToParamList[fid].size();
+		key += "|" + iAPipelineCache::stageKey( fid, stageParams );
+		prefixKeys << key;
+		prefixParamCount << pind;
+	}
+
+	// continue from the longest prefix already computed in a previous run of this batch
+	int firstStage = 0;
+	pind = 0;
+	for ( int s = filterIds.size() - 2; cache && s >= 0; --s )
+	{
+		iAPipelineStageResult cached;
+		if ( !cache->lookup( prefixKeys[s], cached ) )
+			continue;
+		results.maskImage = cached.maskImage;
+		results.surroundingMaskImage = cached.surroundingMaskImage;
+		results.surroundingVoxels = cached.surroundingVoxels;
+		results.threshold = cached.threshold;
+		results.elapsedTime += cached.elapsedTime;	// report the runtime of the whole pipeline
+		results.parameterNames << cached.parameterNames;
+		results.parameters << cached.parameters;
+		curImage = results.maskImage;
+		firstStage = s + 1;
+		pind = prefixParamCount[s];
+		break;
+	}
+
+	for ( int s = firstStage; s < filterIds.size(); ++s )
+	{
+		PorosityFilterID fid = filterIds[s];
 		QTime t;
 		t.start();
 		bool releaseData = (fid != filterIds.last());
 		switch( fid )
 		{
 			case P_BINARY_THRESHOLD:
-				computeBinaryThreshold<T>( curImage, results, params[pind]->asFloat(), releaseData );
+				computeBinaryThreshold<T>( curImage, results, params.asFloat( pind ), releaseData );
 				break;
 			case P_RATS_THRESHOLD:
-				computeRatsThreshold<T>( curImage, results, params[pind]->asFloat(), releaseData );
+				computeRatsThreshold<T>( curImage, results, params.asFloat( pind ), releaseData );
 				break;
 			case P_MORPH_WATERSHED_MEYER:
-				computeMorphWatershed<T>( curImage, results, params[pind]->asFloat(), params[pind + 1]->asInt(), true, releaseData );
+				computeMorphWatershed<T>( curImage, results, params.asFloat( pind ), params.asInt( pind + 1 ), true, releaseData );
 				break;
 			case P_MORPH_WATERSHED_BEUCHER:
-				computeMorphWatershed<T>( curImage, results, params[pind]->asFloat(), params[pind + 1]->asInt(), false, releaseData );
+				computeMorphWatershed<T>( curImage, results, params.asFloat( pind ), params.asInt( pind + 1 ), false, releaseData );
 				break;
 			case P_OTSU_THRESHOLD:
 			case P_ISODATA_THRESHOLD:
@@ -1013,58 +1150,75 @@ void runBatch( const QList<PorosityFilterID> & filterIds, ImagePointer & image,
 				computeParamFree<T>( curImage, fid, results, releaseData );
 				break;
 			case P_CONNECTED_THRESHOLD:
-				computeConnThr<T>( image, curImage, results, params[pind]->asInt(), params[pind + 1]->asInt(), releaseData );
+				computeConnThr<T>( image, curImage, results, params.asInt( pind ), params.asInt( pind + 1 ), releaseData );
 				break;
 			case P_CONFIDENCE_CONNECTED:
-				computeConfiConn<T>( image, curImage, results, params[pind]->asInt(), params[pind + 1]->asFloat(), params[pind + 2]->asInt(), releaseData );
+				computeConfiConn<T>( image, curImage, results, params.asInt( pind ), params.asFloat( pind + 1 ), params.asInt( pind + 2 ), releaseData );
 				break;
 			case P_NEIGHBORHOOD_CONNECTED:
-				computeNeighbConn<T>( image, curImage, results, params[pind]->asInt(), params[pind + 1]->asInt(), params[pind + 2]->asInt(), releaseData );
+				computeNeighbConn<T>( image, curImage, results, params.asInt( pind ), params.asInt( pind + 1 ), params.asInt( pind + 2 ), releaseData );
 				break;
 			case P_MULTIPLE_OTSU:
-				computeMultiOtsu<T>( curImage, fid, results, params[pind]->asInt(), params[pind + 1]->asInt(), releaseData );
+				computeMultiOtsu<T>( curImage, fid, results, params.asInt( pind ), params.asInt( pind + 1 ), releaseData );
 				break;
 			case P_REMOVE_SURROUNDING:
 				computeRemoveSurrounding<T>( curImage, fid, results, releaseData );
 				break;
 			case P_GRAD_ANISO_DIFF_SMOOTH:
-				computeGradAnisoDiffSmooth<T>( curImage, fid, results, params[pind]->asInt(), params[pind + 1]->asFloat(), params[pind + 2]->asFloat(), releaseData );
+				computeGradAnisoDiffSmooth<T>( curImage, fid, results, params.asInt( pind ), params.asFloat( pind + 1 ), params.asFloat( pind + 2 ), releaseData );
 				break;
 			case P_CURV_ANISO_DIFF_SMOOTH:
-				computeCurvAnisoDiffSmooth<T>( curImage, fid, results, params[pind]->asInt(), params[pind + 1]->asFloat(), params[pind + 2]->asFloat(), releaseData );
+				computeCurvAnisoDiffSmooth<T>( curImage, fid, results, params.asInt( pind ), params.asFloat( pind + 1 ), params.asFloat( pind + 2 ), releaseData );
 				break;
 			case P_RECURSIVE_GAUSS_SMOOTH:
-				computeRecursiveGaussSmooth<T>( curImage, fid, results, params[pind]->asFloat(), releaseData );
+				computeRecursiveGaussSmooth<T>( curImage, fid, results, params.asFloat( pind ), releaseData );
 				break;
 			case P_BILATERAL_SMOOTH:
-				computeBilateralSmooth<T>( curImage, fid, results, params[pind]->asFloat(), params[pind + 1]->asFloat(), releaseData );
+				computeBilateralSmooth<T>( curImage, fid, results, params.asFloat( pind ), params.asFloat( pind + 1 ), releaseData );
 				break;
 			case P_CURV_FLOW_SMOOTH:
-				computeCurvFlowSmooth<T>( curImage, fid, results, params[pind]->asInt(), params[pind + 1]->asFloat(), releaseData );
+				computeCurvFlowSmooth<T>( curImage, fid, results, params.asInt( pind ), params.asFloat( pind + 1 ), releaseData );
 				break;
 			case P_MEDIAN_SMOOTH:
-				computeMedianSmooth<T>( curImage, fid, results, params[pind]->asInt(), releaseData );
+				computeMedianSmooth<T>( curImage, fid, results, params.asInt( pind ), releaseData );
 				break;
 			case P_ISOX_THRESHOLD:
-				computeIsoXThreshold<T>( curImage, fid, results, params[pind]->asInt(), releaseData );
+				computeIsoXThreshold<T>( curImage, fid, results, params.asInt( pind ), releaseData );
 				break;
 			case P_FHW_THRESHOLD:
-				computeFhwThreshold<T>( curImage, fid, results, params[pind]->asInt(), params[pind + 1]->asInt(), releaseData );
+				computeFhwThreshold<T>( curImage, fid, results, params.asInt( pind ), params.asInt( pind + 1 ), releaseData );
 				break;
 			case P_CREATE_SURROUNDING:
-				computeCreateSurrounding<T>( curImage, fid, results, params[pind]->asFloat(), releaseData );
+				computeCreateSurrounding<T>( curImage, fid, results, params.asFloat( pind ), releaseData );
 				break;
 		}
-		results.elapsedTime += t.elapsed();
+		long stageTime = t.elapsed();
+		results.elapsedTime += stageTime;
+		results.filterTimes[filterNames.at( fid )] += stageTime;
 		curImage = results.maskImage;
 		pind += FilterIdToParamList[fid].size();
+		if ( cache && s < filterIds.size() - 1 )
+		{
+			iAPipelineStageResult stageResult;
+			stageResult.maskImage = results.maskImage;
+			stageResult.surroundingMaskImage = results.surroundingMaskImage;
+			stageResult.surroundingVoxels = results.surroundingVoxels;
+			stageResult.threshold = results.threshold;
+			stageResult.elapsedTime = results.elapsedTime;
+			stageResult.parameterNames = results.parameterNames.mid( baseParamCount );
+			stageResult.parameters = results.parameters.mid( baseParamCount );
+			cache->insert( prefixKeys[s], stageResult );
+		}
 	}
 }
 
 void iARunBatchThread::Init( iAPorosityAnalyserModuleInterface * pmi, QString datasetFolder, bool rbNewPipelineDataNoPores, 
-							 bool rbNewPipelineData, bool rbExistingPipelineData, iACalculatePoreProperties* poreProps )
+							 bool rbNewPipelineData, bool rbExistingPipelineData, iACalculatePoreProperties* poreProps,
+							 int parallelRuns, unsigned long long memoryBudget )
 {
 	m_pmi = pmi;
+	m_parallelRuns = parallelRuns;
+	m_memoryBudget = memoryBudget;
 	m_datasetsDescrFile = datasetFolder + "/" + "DatasetDescription.csv";
 	m_poreProps = poreProps;
 	m_rbNewPipelineDataNoPores = rbNewPipelineDataNoPores;
@@ -1083,39 +1237,59 @@ void iARunBatchThread::executeNewBatches( QTableWidget & settingsCSV, QMap<int,
 {
 	if ( m_rbNewPipelineDataNoPores || m_rbNewPipelineData )
 	{
-		int batchesToCompute = 0;
-		for ( int row = 1; row < settingsCSV.rowCount(); ++row ) // 1 because we skip header
-			if ( isBatchNew[row] ) ++batchesToCompute;
-
 		emit totalProgress( 0 );
 		emit batchProgress( 0 );
 		emit currentBatch( "Batch Progress" );
 
+		// collect the runs of all new batches first, they are then computed concurrently
+		iABatchScheduler scheduler( m_parallelRuns, m_memoryBudget );
+		QList<BatchInfo*> batches;
+		m_totalRuns = m_finishedRuns = 0;
+		m_filterTimes.clear();
+		m_filterRuns.clear();
 		for ( int row = 1; row < settingsCSV.rowCount(); ++row ) // 1 because we skip header
 		{
-			if ( isBatchNew[row] )
-			{
-				emit currentBatch( QString("Batch %1 Progress").arg(row));
-				//get files and directory paths
-				QString algName, datasetName, batchesDir, batchDir;
-				getAlgorithmAndDatasetNames( &settingsCSV, row, &algName, &datasetName );
-				QList<PorosityFilterID> filterIds = parseFiltersFromString( algName );
-				datasetName = m_pmi->DatasetFolder() + "/" + datasetName;
-				batchesDir = m_pmi->ResultsFolder() + "/" + dirFromAlgAndDataset( &settingsCSV, row );
-				QDir bsDir( batchesDir );
-				bsDir.setFilter( QDir::AllDirs );
-				batchDir = "batch" + QString::number( bsDir.entryList().size() - 1 );
-				QDir( batchesDir ).mkdir( batchDir );
-				batchDir = batchesDir + "/" + batchDir;
-
-				//compute batch, mask.csv file, mask.mhd.csv (pore chars)
-				executeBatch( filterIds, datasetName, batchDir, &settingsCSV, row );
-				generateMasksCSVFile( batchDir, batchesDir );
-				if ( m_rbNewPipelineData )
-					calculatePoreChars( batchDir + "/" + "masks.csv" );
-			}
-			emit totalProgress( row * 100.0 / batchesToCompute );
+			if ( !isBatchNew[row] )
+				continue;
+			//get files and directory paths
+			QString algName, datasetName, batchesDir, batchDir;
+			getAlgorithmAndDatasetNames( &settingsCSV, row, &algName, &datasetName );
+			QList<PorosityFilterID> filterIds = parseFiltersFromString( algName );
+			datasetName = m_pmi->DatasetFolder() + "/" + datasetName;
+			batchesDir = m_pmi->ResultsFolder() + "/" + dirFromAlgAndDataset( &settingsCSV, row );
+			QDir bsDir( batchesDir );
+			bsDir.setFilter( QDir::AllDirs );
+			batchDir = "batch" + QString::number( bsDir.entryList().size() - 1 );
+			QDir( batchesDir ).mkdir( batchDir );
+			batchDir = batchesDir + "/" + batchDir;
+
+			BatchInfo * batch = new BatchInfo;
+			batch->filterIds = filterIds;
+			batch->datasetName = datasetName;
+			batch->batchDir = batchDir;
+			batch->batchesDir = batchesDir;
+			batch->settingsRow = row;
+			batch->scheduler = &scheduler;
+			QList<iABatchJob*> jobs = prepareBatch( *batch, &settingsCSV );
+			m_totalRuns += jobs.size();
+			scheduler.addJobs( jobs );
+			batches << batch;
 		}
+
+		// parallel runs share the cores instead of each using all of them in the ITK filters
+		int itkThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+		itk::MultiThreader::SetGlobalDefaultNumberOfThreads( qMax( 1, QThread::idealThreadCount() / scheduler.workerCount() ) );
+		QTime t;
+		t.start();
+		scheduler.run();
+		long elapsed = t.elapsed();
+		itk::MultiThreader::SetGlobalDefaultNumberOfThreads( itkThreads );
+
+		//write mask.csv file, mask.mhd.csv (pore chars); the rows of runs.csv are written as the runs finish
+		foreach( BatchInfo * batch, batches )
+			finishBatch( *batch );
+		logThroughput( elapsed, scheduler );
+		qDeleteAll( batches );
 	}
 	else if ( m_rbExistingPipelineData )
 	{
@@ -1181,25 +1355,36 @@ void iARunBatchThread::initRunsCSVFile( QTableWidget & runsCSV, QString batchDir
 	iACSVToQTableWidgetConverter::saveToCSVFile( runsCSV, runsCSVFile.fileName() );
 }
 
-void iARunBatchThread::saveResultsToRunsCSV( RunInfo & results, QString masksDir, QTableWidget & runsCSV, bool success /*= true */ )
+void iARunBatchThread::saveResultsToRunsCSV( RunInfo & results, BatchInfo & batch, bool success /*= true */ )
 {
-	int lastRow = runsCSV.rowCount(), col = 0;
-	runsCSV.insertRow( lastRow );
-	runsCSV.setItem( lastRow, col++, new QTableWidgetItem( results.startTime ) );
-	runsCSV.setItem( lastRow, col++, new QTableWidgetItem( QString::number( results.elapsedTime ) ) );
-	runsCSV.setItem( lastRow, col++, new QTableWidgetItem( QString::number( results.porosity ) ) );
-	runsCSV.setItem( lastRow, col++, new QTableWidgetItem( QString::number( results.threshold ) ) );
-	QString maskName = "mask" + QString::number( lastRow ) + ".mhd";
+	QStringList runRow;
+	runRow << results.startTime
+		<< QString::number( results.elapsedTime )
+		<< QString::number( results.porosity )
+		<< QString::number( results.threshold );
+	QString maskName;
+	{
+		// the row index determines the mask name, so reserving the row and appending it happen at once
+		QMutexLocker locker( &batch.mutex );
+		maskName = "mask" + QString::number( batch.firstRow + batch.writtenRows ) + ".mhd";
+		runRow << maskName
+			<< QString::number( results.falsePositiveError )	//dice metric
+			<< QString::number( results.falseNegativeError )
+			<< QString::number( results.dice )
+			<< results.parameters;
+		QFile runsCSVFile( batch.batchDir + "/runs.csv" );
+		if ( runsCSVFile.open( QIODevice::WriteOnly | QIODevice::Append ) )
+		{
+			QTextStream ts( &runsCSVFile );
+			ts << runRow.join( "," ) + "\n";
+		}
+		else
+			log( tr( "Could not append to %1." ).arg( runsCSVFile.fileName() ) );
+		++batch.writtenRows;
+	}
 	QString maskFilename = "";
 	if ( success )
-		maskFilename = masksDir + "/" + maskName;
-	runsCSV.setItem( lastRow, col++, new QTableWidgetItem( maskName ) );
-	//dice metric
-	runsCSV.setItem( lastRow, col++, new QTableWidgetItem( QString::number( results.falsePositiveError ) ) );
-	runsCSV.setItem( lastRow, col++, new QTableWidgetItem( QString::number( results.falseNegativeError ) ) );
-	runsCSV.setItem( lastRow, col++, new QTableWidgetItem( QString::number( results.dice ) ) );
-	for ( int i = 0; i < results.parameters.size(); ++i )
-		runsCSV.setItem( lastRow, col++, new QTableWidgetItem( results.parameters[i] ) );
+		maskFilename = batch.masksDir + "/" + maskName;
 
 	iAITKIO::writeFile( maskFilename, results.maskImage, itk::ImageIOBase::CHAR, true );
 
@@ -1237,31 +1422,31 @@ void iARunBatchThread::saveResultsToRunsCSV( RunInfo & results, QString masksDir
 			.arg( err.GetDescription() )
 			.arg( err.GetFile() )
 			.arg( err.GetLine() );
-		m_pmi->log( tolog );
+		log( tolog );
 	}
 	catch ( std::exception const & e )
 	{
-		m_pmi->log( e.what() );
+		log( e.what() );
 	}
 
 }
 
-void iARunBatchThread::executeBatch( const QList<PorosityFilterID> & filterIds, QString datasetName, QString batchDir, QTableWidget * settingsCSV, int row )
+QList<iABatchJob*> iARunBatchThread::prepareBatch( BatchInfo & batch, QTableWidget * settingsCSV )
 {
-	QList<ParamNameType> paramsNameType;
-	foreach( PorosityFilterID fid, filterIds )
-		paramsNameType.append( FilterIdToParamList[fid] );
-	int numParams = paramsNameType.size();
+	foreach( PorosityFilterID fid, batch.filterIds )
+		batch.paramsNameType.append( FilterIdToParamList[fid] );
+	int numParams = batch.paramsNameType.size();
 
 	QString masksDir = "masks";
-	QDir( batchDir ).mkdir( masksDir );
-	masksDir = batchDir + "/" + masksDir;
+	QDir( batch.batchDir ).mkdir( masksDir );
+	batch.masksDir = batch.batchDir + "/" + masksDir;
 
+	int row = batch.settingsRow;
 	bool randSampling = isRandomSampling( settingsCSV, row );
 
 	QList<IParameterInfo*> params;
 	for( int i = 0; i < numParams; i++ )
-		params.push_back( getParameterInfo( paramsNameType.at( i ), settingsCSV, row, 3 + i ) );
+		params.push_back( getParameterInfo( batch.paramsNameType.at( i ), settingsCSV, row, 3 + i ) );
 
 	double totalNumSamples = 1.0;
 	if( randSampling )
@@ -1275,107 +1460,227 @@ void iARunBatchThread::executeBatch( const QList<PorosityFilterID> & filterIds,
 			totalNumSamples *= params[i]->numSamples;
 	}
 
-	// initialize runsCSV data
+	// runs sharing a pipeline prefix reuse its intermediate result; on a regular grid, the
+	// parameters of the last stages are varied fastest so that shared prefixes follow each other
+	QList<IParameterInfo*> incrementOrder;
+	foreach( IParameterInfo * p, params )
+		incrementOrder.prepend( p );
+
+	QList<iABatchJob*> jobs;
+	for( int sampleNo = 0; sampleNo < totalNumSamples; ++sampleNo ) //iterate over parameters
+	{
+		jobs << new RunJob( this, &batch, RunParameters( params, batch.paramsNameType ) );
+		if( randSampling )
+			randomlySampleParameters( params );
+		else
+			incrementParameterSet( incrementOrder );
+	}
+	qDeleteAll( params );
+	batch.totalRuns = jobs.size();
+
+	// initialize runsCSV data; the runs of this batch are appended after the existing rows
 	m_runsCSV.clear();
-	initRunsCSVFile( m_runsCSV, batchDir, paramsNameType );
-	// inintialize input datset
-	ScalarPixelType pixelType;
-	ImagePointer image = iAITKIO::readFile( datasetName, pixelType, true);
+	initRunsCSVFile( m_runsCSV, batch.batchDir, batch.paramsNameType );
+	batch.firstRow = m_runsCSV.rowCount();
 
 	//GT image (make sure it is the same likne MaskImageType (CHAR))
-	ImagePointer gtMask;
-	QString dsFN = QFileInfo( datasetName ).fileName();
-	QString dsPath = QFileInfo( datasetName ).absolutePath();
+	QString dsFN = QFileInfo( batch.datasetName ).fileName();
 	if( m_datasetGTs[dsFN] != "" )
+		batch.gtMaskName = QFileInfo( batch.datasetName ).absolutePath() + "/" + m_datasetGTs[dsFN];
+
+	// a run holds duplicates of its input, the float output of the smoothing filters and a few masks
+	try
+	{
+		itk::ImageIOBase::Pointer imageIO = itk::ImageIOFactory::CreateImageIO( batch.datasetName.toLatin1(), itk::ImageIOFactory::ReadMode );
+		if ( imageIO )
+		{
+			imageIO->SetFileName( batch.datasetName.toLatin1() );
+			imageIO->ReadImageInformation();
+			batch.pixelType = imageIO->GetComponentType();
+			batch.runMemory = static_cast<unsigned long long>( imageIO->GetImageSizeInPixels() ) *
+				( 3 * imageIO->GetComponentSize() + 2 * sizeof( float ) + 3 * sizeof( MaskImageType::PixelType ) );
+			batch.dataMemory = static_cast<unsigned long long>( imageIO->GetImageSizeInBytes() );
+			if ( !batch.gtMaskName.isEmpty() )
+				batch.dataMemory += static_cast<unsigned long long>( imageIO->GetImageSizeInPixels() ) * sizeof( MaskImageType::PixelType );
+		}
+	}
+	catch( itk::ExceptionObject & excep )
 	{
-		ScalarPixelType maskPixType;
-		QString gtMaskFile = dsPath + "/" + m_datasetGTs[dsFN];
-		gtMask = iAITKIO::readFile( gtMaskFile, maskPixType, true);
+		log( tr( "Could not read the header of %1: %2" ).arg( batch.datasetName ).arg( excep.GetDescription() ) );
 	}
+	return jobs;
+}
 
-	emit batchProgress( 0 );
+//! Loads the dataset of a batch when its first run starts
+void iARunBatchThread::setPaused( bool paused )
+{
+	m_paused = paused;
+}
 
-	for( int sampleNo = 0; sampleNo < totalNumSamples; ++sampleNo ) //iterate over parameters
+static bool loadBatchData( BatchInfo & batch )
+{
+	// the other runs of the batch have to wait for the data anyway, but saving results
+	// and counting finished runs (under batch.mutex) can continue meanwhile
+	QMutexLocker locker( &batch.loadMutex );
+	if( !batch.loaded )
 	{
-		while( m_pmi->ui()->rbPause->isChecked() )
-			QCoreApplication::processEvents();
-
-		RunInfo results;
-		//fill in parameters info
-		for( int i = 0; i < numParams; ++i )
+		batch.loaded = true;
+		// charged until the last run of the batch has finished, even if loading fails
+		batch.scheduler->addResidentMemory( batch.dataMemory );
+		ScalarPixelType pixelType;
+		batch.image = iAITKIO::readFile( batch.datasetName, pixelType, true );
+		batch.pixelType = pixelType;
+		if( !batch.gtMaskName.isEmpty() )
 		{
-			results.parameters.push_back( params[i]->asString() );
-			results.parameterNames << params[i]->name;
+			ScalarPixelType maskPixType;
+			batch.gtMask = iAITKIO::readFile( batch.gtMaskName, maskPixType, true );
 		}
-		bool success = true;
-		results.elapsedTime = 0;	// reset elapsed time 
-		try
-		{
-			ITK_TYPED_CALL(runBatch, pixelType,
-				filterIds, image, results, params);
-			//calculate porosity
-			MaskImageType * mask = dynamic_cast<MaskImageType*>(results.maskImage.GetPointer());
-			MaskImageType * gtImage = dynamic_cast<MaskImageType*>(gtMask.GetPointer());
-			results.porosity = calcPorosity( mask, results.surroundingVoxels );
-			//Dice metric, false positve error, false negative error
-			if ( m_datasetGTs[dsFN] != "" )
+		iABatchScheduler * scheduler = batch.scheduler;
+		batch.cache.reset( new iAPipelineCache( batch.batchDir + "/cache", batch.pixelType,
+			qMin( PipelineCacheRAMBudget, scheduler->memoryBudget() / 4 ),
+			[scheduler]( long long bytes )
 			{
-				MaskImageType::RegionType reg = mask->GetLargestPossibleRegion();
-				int size = reg.GetSize()[0] * reg.GetSize()[1] * reg.GetSize()[2];
-				float fpe = 0.0f, fne = 0.0f, totalGT = 0.0f, its = 0.0f, dice = 0.0f;
-#pragma omp parallel for reduction(+:fpe,fne,totalGT, its)
-				for ( int i = 0; i < size; ++i )
-				{
-					if ( gtImage->GetBufferPointer()[i] )
-						++totalGT;
-					if ( !gtImage->GetBufferPointer()[i] && mask->GetBufferPointer()[i] )
-						++fpe;
-					if ( gtImage->GetBufferPointer()[i] && !mask->GetBufferPointer()[i] )
-						++fne;
-					if ( ( gtImage->GetBufferPointer()[i] && mask->GetBufferPointer()[i] ) ||
-						 ( !gtImage->GetBufferPointer()[i] && !mask->GetBufferPointer()[i] ) )
-						 ++its;
-				}
-				fpe /= totalGT;
-				fne /= totalGT;
-				dice = 2 * its / ( size + size );
-				results.falseNegativeError = fne;
-				results.falsePositiveError = fpe;
-				results.dice = dice;
-				emit batchProgress( ( sampleNo + 1 ) * 100 / totalNumSamples );
-			}
-		}
-		catch( itk::ExceptionObject &excep )
-		{
-			m_pmi->log( tr( "Filter run terminated unexpectedly." ) );
-			m_pmi->log( tr( "  %1 in File %2, Line %3" ).arg( excep.GetDescription() )
-				.arg( excep.GetFile() )
-				.arg( excep.GetLine() ) );
-			success = false;
-		}
-		catch( ... )
+				if ( bytes > 0 )
+					scheduler->addResidentMemory( bytes );
+				else
+					scheduler->releaseResidentMemory( -bytes );
+			} ) );
+	}
+	return batch.image.IsNotNull();
+}
+
+void iARunBatchThread::executeRun( BatchInfo & batch, const RunParameters & params )
+{
+	while( m_paused )
+		QThread::msleep( 100 );
+
+	RunInfo results;
+	//fill in parameters info
+	results.parameters = params.strings();
+	results.parameterNames = params.names();
+	bool success = true;
+	results.elapsedTime = 0;	// reset elapsed time 
+	try
+	{
+		if( !loadBatchData( batch ) )
+			throw itk::ExceptionObject( __FILE__, __LINE__, "Input dataset is not loaded." );
+		ITK_TYPED_CALL(runBatch, batch.pixelType,
+			batch.filterIds, batch.image, results, params, batch.cache.data());
+		QTime t;
+		t.start();
+		//calculate porosity
+		MaskImageType * mask = dynamic_cast<MaskImageType*>(results.maskImage.GetPointer());
+		MaskImageType * gtImage = dynamic_cast<MaskImageType*>(batch.gtMask.GetPointer());
+		results.porosity = calcPorosity( mask, results.surroundingVoxels );
+		//Dice metric, false positve error, false negative error
+		if ( gtImage )
 		{
-			m_pmi->log( tr( "Filter run terminated unexpectedly with unknown exception." ) );
-			success = false;
+			iAConfusionMatrix errorMatrix = ComputeBinaryConfusionMatrix( results.maskImage, batch.gtMask );
+			results.falseNegativeError = errorMatrix.FalseNegativeError( 1 );
+			results.falsePositiveError = errorMatrix.FalsePositiveError( 1 );
+			// as before, the ratio of voxels classified the same way as in the ground truth
+			results.dice = errorMatrix.EqualPixelRate();
 		}
+		results.filterTimes[tr( "Porosity and error metrics" )] += t.elapsed();
+	}
+	catch( itk::ExceptionObject &excep )
+	{
+		log( tr( "Filter run terminated unexpectedly." ) );
+		log( tr( "  %1 in File %2, Line %3" ).arg( excep.GetDescription() )
+			.arg( excep.GetFile() )
+			.arg( excep.GetLine() ) );
+		success = false;
+	}
+	catch( ... )
+	{
+		log( tr( "Filter run terminated unexpectedly with unknown exception." ) );
+		success = false;
+	}
 
-		try
-		{
-			saveResultsToRunsCSV( results, masksDir, m_runsCSV, success );
+	QTime t;
+	t.start();
+	try
+	{
+		saveResultsToRunsCSV( results, batch, success );
+	}
+	catch( itk::ExceptionObject &excep )
+	{
+		log( tr( "Writing the mask terminated unexpectedly." ) );
+		log( tr( "  %1 in File %2, Line %3" ).arg( excep.GetDescription() )
+			.arg( excep.GetFile() )
+			.arg( excep.GetLine() ) );
+	}
+	results.filterTimes[tr( "Writing results" )] += t.elapsed();
+
+	int batchProgressValue;
+	{
+		QMutexLocker locker( &batch.mutex );
+		++batch.finishedRuns;
+		batchProgressValue = batch.finishedRuns * 100 / batch.totalRuns;
+		if( batch.finishedRuns == batch.totalRuns )
+		{	// last run of the batch, its input and intermediate results are not needed anymore
+			batch.image = ImagePointer();
+			batch.gtMask = ImagePointer();
+			batch.scheduler->releaseResidentMemory( batch.dataMemory );
+			if( batch.cache )
+				batch.cache->clear();
 		}
-		catch( itk::ExceptionObject &excep )
+	}
+	int totalProgressValue;
+	{
+		QMutexLocker locker( &m_statsMutex );
+		for( QMap<QString, long>::const_iterator it = results.filterTimes.constBegin(); it != results.filterTimes.constEnd(); ++it )
 		{
-			m_pmi->log( tr( "Writing the mask terminated unexpectedly." ) );
-			m_pmi->log( tr( "  %1 in File %2, Line %3" ).arg( excep.GetDescription() )
-				.arg( excep.GetFile() )
-				.arg( excep.GetLine() ) );
+			m_filterTimes[it.key()] += it.value();
+			++m_filterRuns[it.key()];
 		}
-		if( randSampling )
-			randomlySampleParameters( params );
-		else
-			incrementParameterSet( params );
+		++m_finishedRuns;
+		totalProgressValue = m_finishedRuns * 100 / m_totalRuns;
 	}
-	iACSVToQTableWidgetConverter::saveToCSVFile( m_runsCSV, batchDir + "/runs.csv" );
+	emit currentBatch( QString( "Batch %1 Progress" ).arg( batch.settingsRow ) );
+	emit batchProgress( batchProgressValue );
+	emit totalProgress( totalProgressValue );
+}
+
+void iARunBatchThread::finishBatch( BatchInfo & batch )
+{
+	if ( batch.cache && batch.cache->hits() > 0 )
+		log( tr( "Reused cached intermediate results in %1 of %2 runs of %3." ).arg( batch.cache->hits() ).arg( batch.totalRuns ).arg( batch.batchDir ) );
+
+	generateMasksCSVFile( batch.batchDir, batch.batchesDir );
+	if ( m_rbNewPipelineData )
+		calculatePoreChars( batch.batchDir + "/" + "masks.csv" );
+}
+
+void iARunBatchThread::logThroughput( long elapsedMs, const iABatchScheduler & scheduler )
+{
+	double hours = elapsedMs / 3600000.0;
+	log( tr( "Computed %1 runs in %2 s with %3 parallel runs (%4 runs/hour, %5 runs taken over by idle workers)." )
+		.arg( m_finishedRuns )
+		.arg( elapsedMs / 1000.0 )
+		.arg( scheduler.workerCount() )
+		.arg( hours > 0 ? m_finishedRuns / hours : 0.0, 0, 'f', 1 )
+		.arg( scheduler.stolenJobs() ) );
+	// time per filter, most expensive first
+	QList<QPair<long long, QString> > filterTimes;
+	for( QMap<QString, long long>::const_iterator it = m_filterTimes.constBegin(); it != m_filterTimes.constEnd(); ++it )
+		filterTimes << qMakePair( it.value(), it.key() );
+	std::sort( filterTimes.begin(), filterTimes.end() );
+	for( int i = filterTimes.size() - 1; i >= 0; --i )
+	{
+		QString name = filterTimes[i].second;
+		log( tr( "  %1: %2 s in %3 runs (%4 ms per run)" )
+			.arg( name )
+			.arg( filterTimes[i].first / 1000.0 )
+			.arg( m_filterRuns[name] )
+			.arg( filterTimes[i].first / m_filterRuns[name] ) );
+	}
+}
+
+void iARunBatchThread::log( QString const & text )
+{
+	// the log list is a widget, so the text is handed to the GUI thread
+	emit message( text );
 }
 
 void iARunBatchThread::updateComputerCSVFile( QTableWidget & settingsCSV )
@@ -1388,7 +1693,7 @@ void iARunBatchThread::updateComputerCSVFile( QTableWidget & settingsCSV )
 		iACSVToQTableWidgetConverter::loadCSVFile( computerCSVFile.fileName(), &m_computerCSVData );
 	else
 	{
-		m_pmi->log( "\tCreating new computer CSV file" );
+		log( "\tCreating new computer CSV file" );
 		//Insert a header
 		m_computerCSVData.setRowCount( 1 );
 		m_computerCSVData.setColumnCount( computerCSVHeader.size() );
@@ -1406,7 +1711,7 @@ void iARunBatchThread::updateComputerCSVFile( QTableWidget & settingsCSV )
 
 		if( existsBatchesRecord( &m_computerCSVData, algName, datasetName ) )
 			continue;
-		m_pmi->log( "\tAdding batches for " + dirName );
+		log( "\tAdding batches for " + dirName );
 		QDir( m_pmi->ResultsFolder() ).mkdir( dirName );
 		int lastRow = m_computerCSVData.rowCount();
 		m_computerCSVData.insertRow( lastRow );
@@ -1430,7 +1735,7 @@ void iARunBatchThread::updateBatchesCSVFiles( QTableWidget & settingsCSV, QMap<i
 		//fill in batches.csv
 		isBatchNew[row] = updateBatchesCSVFile( settingsCSV, row, batchesFile );
 		if( isBatchNew[row] )
-			m_pmi->log( "\tAdded new batch in " + dirName );
+			log( "\tAdded new batch in " + dirName );
 	}
 }
 
@@ -1447,7 +1752,7 @@ bool iARunBatchThread::updateBatchesCSVFile( QTableWidget & settingsCSV, int row
 	}
 	else
 	{
-		m_pmi->log( "\tCreated new batches CSV file" );
+		log( "\tCreated new batches CSV file" );
 		//Insert a header
 		m_batchesData.setRowCount( 1 );
 		m_batchesData.setColumnCount( settingsCSV.columnCount() - 2 );
@@ -1496,14 +1801,14 @@ void iARunBatchThread::generateMasksCSVFile( QString batchDir, QString batchesDi
 			}
 	}
 	iACSVToQTableWidgetConverter::saveToCSVFile( m_masksData, batchDir + "/" + "masks.csv" );
-	m_pmi->log( tr( "File masks.csv created in %1" ).arg(batchDir) );
+	log( tr( "File masks.csv created in %1" ).arg(batchDir) );
 }
 
 void iARunBatchThread::calculatePoreChars(QString masksCSVPath)
 {
 	m_poreProps->SetMasksCSVPath( masksCSVPath );
 	m_poreProps->CalculatePoreProperties();
-	m_pmi->log( tr( "Pore characteristics calculated for %1" ).arg( masksCSVPath.section( '/', -3, -3 ) ) );
+	log( tr( "Pore characteristics calculated for %1" ).arg( masksCSVPath.section( '/', -3, -3 ) ) );
 }
 
 void iARunBatchThread::run()
@@ -1515,13 +1820,13 @@ void iARunBatchThread::run()
 		return;
 	QMap<int, bool> isBatchNew;
 
-	m_pmi->log( "Updating computer CSV file" );
+	log( "Updating computer CSV file" );
 	updateComputerCSVFile( m_settingsCSV );
 
-	m_pmi->log( "Updating batches CSV files" );
+	log( "Updating batches CSV files" );
 	updateBatchesCSVFiles( m_settingsCSV, isBatchNew );
 
-	m_pmi->log( "Executing new batches" );
+	log( "Executing new batches" );
 	executeNewBatches( m_settingsCSV, isBatchNew );
 }
 
@@ -21,6 +21,8 @@
 #pragma once
 
 #include <QList>
+#include <QMap>
+#include <QMutex>
 #include <QString>
 #include <QTableWidget>
 #include <QThread>
@@ -28,22 +30,37 @@
 #include "PorosityAnalyserHelpers.h"
 #include "iACalculatePoreProperties.h"
 
+#include <atomic>
+
+class iABatchJob;
+class iABatchScheduler;
 class iAPorosityAnalyserModuleInterface;
+class RunParameters;
+struct BatchInfo;
 struct RunInfo;
 
 class iARunBatchThread : public QThread
 {
 	Q_OBJECT
+	friend class RunJob;
 public:
-	iARunBatchThread( QObject * parent = 0 ) : QThread( parent ) {};
+	iARunBatchThread( QObject * parent = 0 ) : QThread( parent ), m_paused( false ) {};
 	void Init( iAPorosityAnalyserModuleInterface *pmi, QString datasetsDescriptionFile, bool rbNewPipelineDataNoPores,
-			   bool rbNewPipelineData, bool rbExistingPipelineData, iACalculatePoreProperties * poreProps );
+			   bool rbNewPipelineData, bool rbExistingPipelineData, iACalculatePoreProperties * poreProps,
+			   int parallelRuns, unsigned long long memoryBudget );
 protected:
 	virtual void run();
 	void executeNewBatches( QTableWidget & settingsCSV, QMap<int, bool> & isBatchNew );
-	void executeBatch( const QList<PorosityFilterID> & filterIds, QString datasetName, QString batchDir, QTableWidget * settingsCSV, int row );
+	//! Samples the parameters of a batch and creates one job per run
+	QList<iABatchJob*> prepareBatch( BatchInfo & batch, QTableWidget * settingsCSV );
+	//! Computes a single run; called concurrently from the scheduler's worker threads
+	void executeRun( BatchInfo & batch, const RunParameters & params );
+	//! Writes masks.csv of a batch after all its runs are finished
+	void finishBatch( BatchInfo & batch );
+	void logThroughput( long elapsedMs, const iABatchScheduler & scheduler );
+	void log( QString const & text );
 	void initRunsCSVFile( QTableWidget & runsCSV, QString batchDir, const QList<ParamNameType> & paramNames );
-	void saveResultsToRunsCSV( RunInfo & results, QString masksDir, QTableWidget & runsCSV, bool success = true );
+	void saveResultsToRunsCSV( RunInfo & results, BatchInfo & batch, bool success = true );
 	void updateComputerCSVFile( QTableWidget & settingsCSV );
 	void updateBatchesCSVFiles( QTableWidget & settingsCSV, QMap<int, bool> & isBatchNew );
 	bool updateBatchesCSVFile( QTableWidget & settingsCSV, int row, QString batchesFile );
@@ -65,8 +82,21 @@ protected:
 
 	iACalculatePoreProperties* m_poreProps;
 
+	int m_parallelRuns;
+	unsigned long long m_memoryBudget;
+	QMutex m_statsMutex;
+	int m_totalRuns, m_finishedRuns;
+	QMap<QString, long long> m_filterTimes;	//!< accumulated time in ms per filter over all runs
+	QMap<QString, int> m_filterRuns;		//!< number of runs which computed the filter
+	std::atomic<bool> m_paused;				//!< mirrors the pause button, polled by the worker threads
+
+public slots:
+	//! pauses or resumes starting new runs; called from the GUI thread
+	void setPaused( bool paused );
+
 signals:
 	void batchProgress( int progress );
 	void totalProgress( int progress );
 	void currentBatch( QString str );
+	void message( QString text );
 };
@@ -28,6 +28,7 @@
 #include "iASPMSettings.h"
 #include "iAPerceptuallyUniformLUT.h"
 #include "iAPAQSplom.h"
+#include "charts/iASPLOMData.h"
 
 #include <QVTKWidget.h>
 #include <vtkAnnotationLink.h>
@@ -138,20 +139,17 @@ void iASPMView::InitLUT()
 iASPMView::~iASPMView()
 {}
 
-void iASPMView::SetData( const QTableWidget * data )
+void iASPMView::SetData( QSharedPointer<iASPLOMData> data, QStringList maskNames )
 {
 	//Init SPLOM
-	m_splom->setData( data );
+	m_splom->setData( data, maskNames );
 	
 	m_SPMSettings->parametersList->clear();
 	m_SPMSettings->colorCodingParameter->clear();
 	QString colorArName = defaultColorParam;
 	m_updateColumnVisibility = false;
-	for( int i = 0; i < data->columnCount(); ++i )
+	foreach( const QString & columnName, data->paramNames() )
 	{
-		QString columnName = data->item( 0, i )->text();
-		if ( columnName == "Mask Path" )	// No mask path option in settings dialog
-			continue;
 		QCheckBox * checkBox = new QCheckBox( columnName );
 		QListWidgetItem * item = new QListWidgetItem( columnName, m_SPMSettings->parametersList );
 		item->setFlags( item->flags() | Qt::ItemIsUserCheckable ); // set checkable flag
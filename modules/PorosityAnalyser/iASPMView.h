@@ -21,6 +21,7 @@
 #pragma once
 
 #include <QDockWidget>
+#include <QSharedPointer>
 #include <vtkSmartPointer.h>
 #include <vtkVector.h>
 
@@ -48,6 +49,7 @@ class vtkScalarBarActor;
 class vtkRenderer;
 class vtkSelection;
 struct iASelection;
+class iASPLOMData;
 class iASPMSettings;
 class iAPAQSplom;
 
@@ -64,7 +66,7 @@ public:
 	void setDatasetsDir( QString datasetsDir );
 
 public slots:
-	void SetData( const QTableWidget * data );
+	void SetData( QSharedPointer<iASPLOMData> data, QStringList maskNames );
 	void showSettings();
 	void setRSDSelection( vtkIdTypeArray * );
 	void setSPLOMPreviewSliceNumbers( QList<int> sliceNumberLst );
@@ -24,6 +24,7 @@
 
 #include "iACSVToQTableWidgetConverter.h"
 #include "iASelection.h"
+#include "charts/iASPLOMData.h"
 
 #include <vtkIdTypeArray.h>
 
@@ -36,7 +37,7 @@
 iATreeView::iATreeView( QWidget * parent /*= 0*/, Qt::WindowFlags f /*= 0 */ ) 
     : TreeViewConnector( parent, f ),
     m_contextMenu( new QMenu( this ) ),
-    m_selectedRunsData( new QTableWidget() ),
+    m_selectedRunsData( new iASPLOMData() ),
     m_selectedPCData( new QTableWidget() ),
     m_selectedRSDData( new QTableWidget() ),
     m_selectedSSData( new QTableWidget() ),
@@ -67,7 +68,6 @@ iATreeView::iATreeView( QWidget * parent /*= 0*/, Qt::WindowFlags f /*= 0 */ )
 iATreeView::~iATreeView()
 {
     delete m_selectedPCData;
-    delete m_selectedRunsData;
 }
 
 void iATreeView::SetData( QTableWidget * const data, const QMap<QString, double> * gtPorosityMap, int runsOffset )
@@ -141,30 +141,26 @@ bool iATreeView::calculatedSelectedRunsData( QList<QTreeWidgetItem*> selectedIte
 	//aggregate all runs
 	QList<QTreeWidgetItem *> finalItems = aggregateRuns( m_lastSelectedItems );
 
-	//insert header
-	m_selectedRunsData->clear();
-	m_selectedRunsData->setColumnCount( inParCnt + outputSPMParamNum + outParCnt + 2 + 3 + 1);//+deviation from rererence+dataset index +3dice errors + mask path
-	m_selectedRunsData->setRowCount( 1 );
-	int headerOffset = 0;
+	//header: the numeric columns shown in the scatter plot matrix
+	QList<QString> paramNames;
 	for( int i = 0; i < inParCnt; ++i )
-		m_selectedRunsData->setItem( 0, headerOffset++, new QTableWidgetItem( inParamNames[i] ) );
-	m_selectedRunsData->setItem( 0, headerOffset++, new QTableWidgetItem( "Elapsed Time" ) );
-	m_selectedRunsData->setItem( 0, headerOffset++, new QTableWidgetItem( "Porosity" ) );
-	m_selectedRunsData->setItem( 0, headerOffset++, new QTableWidgetItem( "Deviat. from Ref." ) );
-	m_selectedRunsData->setItem( 0, headerOffset++, new QTableWidgetItem( "Dataset Index" ) );
-	m_selectedRunsData->setItem( 0, headerOffset++, new QTableWidgetItem( "False Positive Error" ) );
-	m_selectedRunsData->setItem( 0, headerOffset++, new QTableWidgetItem( "False Negative Error" ) );
-	m_selectedRunsData->setItem( 0, headerOffset++, new QTableWidgetItem( "Dice" ) );
+		paramNames << inParamNames[i];
+	paramNames << "Elapsed Time" << "Porosity" << "Deviat. from Ref." << "Dataset Index"
+		<< "False Positive Error" << "False Negative Error" << "Dice";
 	for( int i = 0; i < outParCnt; ++i )
-		m_selectedRunsData->setItem( 0, headerOffset++, new QTableWidgetItem( outParamNames[i] ) );
-	m_selectedRunsData->setItem( 0, headerOffset++, new QTableWidgetItem( "Mask Path" ) );
+		paramNames << outParamNames[i];
+
+	// a new data object each time, the scatter plot matrix may still show the previous one
+	m_selectedRunsData = QSharedPointer<iASPLOMData>( new iASPLOMData() );
+	m_selectedRunsData->allocate( paramNames, finalItems.size() );
+	m_selectedMaskNames.clear();
 
 	//go through items and parse them
 	m_selectedDatasets.clear();
 	m_selDatasetsInds.clear();
-	foreach( const QTreeWidgetItem * item, finalItems )
+	for( int row = 0; row < finalItems.size(); ++row )
 	{
-		double porosity, devRefPorosity;
+		const QTreeWidgetItem * item = finalItems[row];
 		QString datasetName = getDatasetName( item );	
 		if( !m_selectedDatasets.contains( datasetName ) )			
 		{
@@ -172,38 +168,28 @@ bool iATreeView::calculatedSelectedRunsData( QList<QTreeWidgetItem*> selectedIte
 			m_selDatasetsInds.push_back( m_datasets.indexOf( datasetName ) );
 		}
 		int paramOffset = 0;
-		int lastRow = m_selectedRunsData->rowCount();
-		m_selectedRunsData->insertRow( lastRow );
 		//parse input parameter values
 		for( int i = 0; i < inParCnt; ++i )
-		{
-			QString s = item->text( m_runsOffset + paramsOffsetInRunsCSV + i);
-			m_selectedRunsData->setItem( lastRow, paramOffset++, new QTableWidgetItem( item->text( m_runsOffset + paramsOffsetInRunsCSV + i ) ) );
-		}
+			m_selectedRunsData->paramData( paramOffset++ )[row] = item->text( m_runsOffset + paramsOffsetInRunsCSV + i ).toDouble();
 		//add runtime and porosity
 		int itemOffset = m_runsOffset + 1;
-		m_selectedRunsData->setItem( lastRow, paramOffset++, new QTableWidgetItem( item->text( itemOffset++ ) ) );
-		porosity = item->text( itemOffset ).toDouble();
-		m_selectedRunsData->setItem( lastRow, paramOffset++, new QTableWidgetItem( item->text( itemOffset++ ) ) );
+		m_selectedRunsData->paramData( paramOffset++ )[row] = item->text( itemOffset++ ).toDouble();
+		double porosity = item->text( itemOffset++ ).toDouble();
+		m_selectedRunsData->paramData( paramOffset++ )[row] = porosity;
 		//insert deviation from the reference porosity
-		devRefPorosity = porosity - (*m_gtPorosityMap)[datasetName];
-		m_selectedRunsData->setItem( lastRow, paramOffset++, new QTableWidgetItem( QString::number( devRefPorosity ) ) );
+		m_selectedRunsData->paramData( paramOffset++ )[row] = porosity - (*m_gtPorosityMap)[datasetName];
 		//insert dataset index
-		m_selectedRunsData->setItem( lastRow, paramOffset++, new QTableWidgetItem( QString::number( m_datasets.indexOf( datasetName ) ) ) );
+		m_selectedRunsData->paramData( paramOffset++ )[row] = m_datasets.indexOf( datasetName );
 		//insert dice errors
 		int errorInd = m_runsOffset + paramsOffsetInRunsCSV - 3;
-		QString fpe = item->text( errorInd );
-		QString fne = item->text( errorInd + 1 );
-		QString dice = item->text( errorInd + 2 );
-		m_selectedRunsData->setItem( lastRow, paramOffset++, new QTableWidgetItem( item->text( errorInd++ ) ) );
-		m_selectedRunsData->setItem( lastRow, paramOffset++, new QTableWidgetItem( item->text( errorInd++) ) );
-		m_selectedRunsData->setItem( lastRow, paramOffset++, new QTableWidgetItem( item->text( errorInd ) ) );
+		for( int i = 0; i < 3; ++i )
+			m_selectedRunsData->paramData( paramOffset++ )[row] = item->text( errorInd++ ).toDouble();
 		//parse output parameter values
 		for( int i = 0; i < outParCnt; ++i )
-			m_selectedRunsData->setItem( lastRow, paramOffset++, new QTableWidgetItem( item->text( itemOffset++ ) ) );
+			m_selectedRunsData->paramData( paramOffset++ )[row] = item->text( itemOffset++ ).toDouble();
 		//mask path
 		int maskPathInd =  m_runsOffset + paramsOffsetInRunsCSV - 4;
-		m_selectedRunsData->setItem( lastRow, paramOffset, new QTableWidgetItem( item->text( maskPathInd ) ) );
+		m_selectedMaskNames << item->text( maskPathInd );
 	}
 
 	return true;
@@ -238,15 +224,15 @@ bool iATreeView::updateSelectedSSData( QList<QTreeWidgetItem*> items )
 void iATreeView::loadSelectionToSPM()
 {
     if( !updateSelectedRunsData() ) return;
-    emit loadSelectionToSPMSignal( m_selectedRunsData );
+    emit loadSelectionToSPMSignal( m_selectedRunsData, m_selectedMaskNames );
 	emit loadDatasetsToPreviewSignal( m_selectedDatasets );
 	emit loadAllDatasetsByIndicesSignal( m_selectedDatasets, m_selDatasetsInds );
 	emit selectionModified( &m_lastSelectedItems );
 }
 
-const QTableWidget * iATreeView::GetSPMData()
+QSharedPointer<iASPLOMData> iATreeView::GetSPMData()
 {
-	if( !updateSelectedRunsData() ) return 0;
+	if( !updateSelectedRunsData() ) return QSharedPointer<iASPLOMData>();
 	return m_selectedRunsData;
 }
 
@@ -839,14 +825,13 @@ void iATreeView::loadFilteredItemsToWidget()
 
 void iATreeView::loadOverviewSelectionToSPM( QModelIndexList indices )
 {
-	m_selectedRunsData->clear();
-	m_selectedRunsData->setRowCount( 0 );
-	m_selectedRunsData->setColumnCount( 0 );
+	m_selectedRunsData = QSharedPointer<iASPLOMData>( new iASPLOMData() );
+	m_selectedMaskNames.clear();
 	m_selectedDatasets.clear();
 	m_selDatasetsInds.clear();
 	filteredItemsForSelection( indices );
 	loadSelectionToRSD( m_filteredPipeDsetItems );
-	emit loadSelectionToSPMSignal( m_selectedRunsData );
+	emit loadSelectionToSPMSignal( m_selectedRunsData, m_selectedMaskNames );
 	emit loadDatasetsToPreviewSignal( m_selectedDatasets );
 	emit loadAllDatasetsByIndicesSignal( m_selectedDatasets, m_selDatasetsInds );
 }
@@ -23,6 +23,7 @@
 #include <QWidget>
 #include <QTableWidget>
 #include <QModelIndex>
+#include <QSharedPointer>
 
 #include "iAQTtoUIConnector.h"
 #include "ui_TreeView.h"
@@ -35,6 +36,7 @@ class QMenu;
 class QStringList;
 class QTableWidget;
 
+class iASPLOMData;
 struct iASelection;
 
 typedef iAQTtoUIConnector<QWidget, Ui_treeView> TreeViewConnector;
@@ -49,7 +51,7 @@ public:
 	void SetData( QTableWidget * const data, const QMap<QString, double> * gtPorosityMap, int runsOffset );
 	QList<QTreeWidgetItem *> * getLastSelectedItems();
 	void setSelection( QList<QTreeWidgetItem *> * selItems );
-	const QTableWidget * GetSPMData();
+	QSharedPointer<iASPLOMData> GetSPMData();
 
 protected:
 	QList<PorosityFilterID> getAlgorithmsInfo( const QList<QTreeWidgetItem *> & selectedItems ) const;
@@ -79,7 +81,7 @@ protected:
 	void loadFilteredItemsToWidget();	//add filtered items with grouping
 
 signals:
-	void loadSelectionToSPMSignal( const QTableWidget * );
+	void loadSelectionToSPMSignal( QSharedPointer<iASPLOMData> data, QStringList maskNames );
 	void loadSelectionToPCSignal( const QTableWidget * );
 	void loadSelectionToPDMSignal( const iABPMData *, const iAHMData * );
 	void loadSelectionToRSDSignal( const QTableWidget * );
@@ -111,7 +113,8 @@ protected slots:
 protected:
 	const QMap<QString, double> * m_gtPorosityMap;
 	QMenu * m_contextMenu;
-	QTableWidget * m_selectedRunsData;
+	QSharedPointer<iASPLOMData> m_selectedRunsData;	//!< numeric values of the selected runs, shown in the scatter plot matrix
+	QStringList m_selectedMaskNames;	//!< mask file of each selected run
 	QTableWidget * m_selectedPCData;
 	QTableWidget * m_selectedRSDData;
 	QTableWidget * m_selectedSSData;
@@ -24,11 +24,12 @@
 
 #include "iANormalizer.h"
 #include "iAImageGraph.h"
-#include "iAVectorArray.h"
+#include "iAVectorArrayImpl.h"
 #include "iAVectorDistance.h"
 
 #include <algorithm>
 #include <cassert>
+#include <vector>
 
 iAGraphWeights::iAGraphWeights(iAEdgeIndexType edgeCount):
 m_weights(edgeCount)
@@ -54,6 +55,7 @@ void iAGraphWeights::Normalize(QSharedPointer<iANormalizer> normalizeFunc)
 {
 	iAEdgeWeightType max = GetMaxWeight();
 	normalizeFunc->SetMaxValue(max);
+#pragma omp parallel for
 	for (int i=0; i<m_weights.size(); ++i)
 	{
 					// 1-x - because we need "resistance" for RW, not "conductance"
@@ -72,11 +74,46 @@ QSharedPointer<iAGraphWeights> CalculateGraphWeights(
 	iAVectorDistance const & distanceFunc)
 {
 	QSharedPointer<iAGraphWeights> result(new iAGraphWeights(graph.GetEdgeCount()));
-	for (int i=0; i<graph.GetEdgeCount(); ++i)
+	// the edges are processed in batches; the vectors of the two end points of all edges
+	// in a batch are gathered channel by channel, so that the distance kernel can run over
+	// all edges of the batch in its inner loop:
+	size_t const batchSize = iAVectorDistance::MaxBatchSize;
+	size_t const channelCount = voxelData.channelCount();
+	size_t const edgeCount = graph.GetEdgeCount();
+	long long const batchCount = static_cast<long long>((edgeCount + batchSize - 1) / batchSize);
+	auto contiguousData = dynamic_cast<iAContiguousVectorArray const *>(&voxelData);
+#pragma omp parallel
 	{
-		iAEdgeType edge = graph.GetEdge(i);
-		iADistanceType dist = distanceFunc.GetDistance(voxelData.get(edge.first), voxelData.get(edge.second));
-		result->SetWeight(i, dist);
+		std::vector<iAVectorDataType> values1(channelCount * batchSize), values2(channelCount * batchSize);
+		std::vector<double> distances(batchSize);
+#pragma omp for schedule(static)
+		for (long long batch = 0; batch < batchCount; ++batch)
+		{
+			size_t firstEdge = batch * batchSize;
+			size_t count = std::min(batchSize, edgeCount - firstEdge);
+			for (size_t e = 0; e < count; ++e)
+			{
+				iAEdgeType edge = graph.GetEdge(static_cast<iAEdgeIndexType>(firstEdge + e));
+				for (size_t c = 0; c < channelCount; ++c)
+				{
+					if (contiguousData)
+					{
+						values1[c * batchSize + e] = contiguousData->channel(c)[edge.first];
+						values2[c * batchSize + e] = contiguousData->channel(c)[edge.second];
+					}
+					else
+					{
+						values1[c * batchSize + e] = voxelData.get(edge.first, c);
+						values2[c * batchSize + e] = voxelData.get(edge.second, c);
+					}
+				}
+			}
+			distanceFunc.GetDistances(values1.data(), values2.data(), channelCount, batchSize, count, distances.data());
+			for (size_t e = 0; e < count; ++e)
+			{
+				result->SetWeight(static_cast<iAEdgeIndexType>(firstEdge + e), distances[e]);
+			}
+		}
 	}
 	return result;
 }
@@ -90,6 +127,7 @@ QSharedPointer<iAGraphWeights const> CombineGraphWeights(
 	assert(graphWeights.size() == weight.size());
 	int edgeCount = graphWeights[0]->GetEdgeCount();
 	QSharedPointer<iAGraphWeights> result(new iAGraphWeights(edgeCount));
+#pragma omp parallel for
 	for (int edgeIdx=0; edgeIdx<edgeCount; ++edgeIdx)
 	{
 		double combinedWeight = 0;
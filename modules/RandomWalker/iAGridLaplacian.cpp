@@ -0,0 +1,224 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#include "pch.h"
+#include "iAGridLaplacian.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+iAGridLaplacian::iAGridLaplacian(size_t vertexCount, std::vector<size_t> const & offsets) :
+	m_vertexCount(vertexCount),
+	m_offsets(offsets),
+	m_weights(vertexCount * offsets.size(), 0.0),
+	m_diagonal(vertexCount, 0.0),
+	m_fixed(vertexCount, 0)
+{}
+
+size_t iAGridLaplacian::VertexCount() const
+{
+	return m_vertexCount;
+}
+
+void iAGridLaplacian::AddEdgeWeight(size_t v1, size_t v2, double weight)
+{
+	if (v2 < v1)
+		std::swap(v1, v2);
+	size_t k = std::find(m_offsets.begin(), m_offsets.end(), v2 - v1) - m_offsets.begin();
+	if (k >= m_offsets.size() || v2 >= m_vertexCount)
+		throw std::invalid_argument("Edge does not connect two grid vertices at one of the offsets!");
+	m_weights[k * m_vertexCount + v1] += weight;
+	m_diagonal[v1] += weight;
+	m_diagonal[v2] += weight;
+}
+
+void iAGridLaplacian::AddDiagonal(size_t v, double value)
+{
+	m_diagonal[v] += value;
+}
+
+void iAGridLaplacian::SetFixed(size_t v)
+{
+	m_fixed[v] = 1;
+}
+
+bool iAGridLaplacian::IsFixed(size_t v) const
+{
+	return m_fixed[v] != 0;
+}
+
+double iAGridLaplacian::Diagonal(size_t v) const
+{
+	return m_diagonal[v];
+}
+
+void iAGridLaplacian::Apply(double const * x, double * y, int rhsCount) const
+{
+	long long const n = static_cast<long long>(m_vertexCount);
+#pragma omp parallel for schedule(static)
+	for (long long v = 0; v < n; ++v)
+	{
+		double * yv = y + v * rhsCount;
+		if (m_fixed[v])
+		{
+			std::fill(yv, yv + rhsCount, 0.0);
+			continue;
+		}
+		double const * xv = x + v * rhsCount;
+		for (int r = 0; r < rhsCount; ++r)
+			yv[r] = m_diagonal[v] * xv[r];
+		for (size_t k = 0; k < m_offsets.size(); ++k)
+		{
+			long long const o = static_cast<long long>(m_offsets[k]);
+			double const * w = m_weights.data() + k * m_vertexCount;
+			if (v + o < n && w[v] != 0 && !m_fixed[v + o])
+			{
+				double const * xn = x + (v + o) * rhsCount;
+				for (int r = 0; r < rhsCount; ++r)
+					yv[r] -= w[v] * xn[r];
+			}
+			if (v >= o && w[v - o] != 0 && !m_fixed[v - o])
+			{
+				double const * xn = x + (v - o) * rhsCount;
+				for (int r = 0; r < rhsCount; ++r)
+					yv[r] -= w[v - o] * xn[r];
+			}
+		}
+	}
+}
+
+namespace
+{
+	//! adds up the values of the thread-local per-column sums into result
+	void MergeSums(std::vector<double> const & local, std::vector<double> & result)
+	{
+#pragma omp critical
+		for (size_t c = 0; c < local.size(); ++c)
+			result[c] += local[c];
+	}
+}
+
+iAPCGResult SolvePCG(iAGridLaplacian const & A, std::vector<double> const & b,
+	std::vector<double> & x, int rhsCount, int maxIterations, double tolerance)
+{
+	long long const n = static_cast<long long>(A.VertexCount());
+	size_t const R = static_cast<size_t>(rhsCount);
+	std::vector<double> invDiag(n, 0.0);
+	std::vector<double> r(b.size()), p(b.size()), q(b.size());
+	x.assign(b.size(), 0.0);
+	std::vector<double> bNorm(R, 0.0), rz(R, 0.0);
+	// initial residual r = b (since x = 0), initial search direction p = M^-1 r:
+#pragma omp parallel
+	{
+		std::vector<double> localBB(R, 0.0), localRZ(R, 0.0);
+#pragma omp for schedule(static)
+		for (long long v = 0; v < n; ++v)
+		{
+			double d = A.Diagonal(v);
+			invDiag[v] = (A.IsFixed(v) || d <= 0) ? 0.0 : 1.0 / d;
+			for (size_t c = 0; c < R; ++c)
+			{
+				size_t i = v * R + c;
+				r[i] = A.IsFixed(v) ? 0.0 : b[i];
+				p[i] = invDiag[v] * r[i];
+				localBB[c] += r[i] * r[i];
+				localRZ[c] += r[i] * p[i];
+			}
+		}
+		MergeSums(localBB, bNorm);
+		MergeSums(localRZ, rz);
+	}
+	std::vector<char> active(R);
+	std::vector<double> residual(R, 0.0);
+	for (size_t c = 0; c < R; ++c)
+	{
+		bNorm[c] = std::sqrt(bNorm[c]);
+		active[c] = bNorm[c] > 0;
+	}
+	int iteration = 0;
+	std::vector<double> pq(R), rr(R), rzNew(R), alpha(R), beta(R);
+	while (iteration < maxIterations && std::find(active.begin(), active.end(), 1) != active.end())
+	{
+		++iteration;
+		A.Apply(p.data(), q.data(), rhsCount);
+		std::fill(pq.begin(), pq.end(), 0.0);
+#pragma omp parallel
+		{
+			std::vector<double> localPQ(R, 0.0);
+#pragma omp for schedule(static)
+			for (long long v = 0; v < n; ++v)
+				for (size_t c = 0; c < R; ++c)
+					localPQ[c] += p[v * R + c] * q[v * R + c];
+			MergeSums(localPQ, pq);
+		}
+		for (size_t c = 0; c < R; ++c)
+			alpha[c] = (active[c] && pq[c] > 0) ? rz[c] / pq[c] : 0.0;
+		std::fill(rr.begin(), rr.end(), 0.0);
+		std::fill(rzNew.begin(), rzNew.end(), 0.0);
+#pragma omp parallel
+		{
+			std::vector<double> localRR(R, 0.0), localRZ(R, 0.0);
+#pragma omp for schedule(static)
+			for (long long v = 0; v < n; ++v)
+			{
+				for (size_t c = 0; c < R; ++c)
+				{
+					size_t i = v * R + c;
+					x[i] += alpha[c] * p[i];
+					r[i] -= alpha[c] * q[i];
+					localRR[c] += r[i] * r[i];
+					localRZ[c] += r[i] * r[i] * invDiag[v];
+				}
+			}
+			MergeSums(localRR, rr);
+			MergeSums(localRZ, rzNew);
+		}
+		for (size_t c = 0; c < R; ++c)
+		{
+			if (!active[c])
+			{
+				beta[c] = 0;
+				continue;
+			}
+			residual[c] = std::sqrt(rr[c]) / bNorm[c];
+			// a vanishing curvature means that no further progress is possible for this column
+			if (residual[c] < tolerance || pq[c] <= 0)
+			{
+				active[c] = 0;
+				beta[c] = 0;
+				continue;
+			}
+			beta[c] = rzNew[c] / rz[c];
+			rz[c] = rzNew[c];
+		}
+#pragma omp parallel for schedule(static)
+		for (long long v = 0; v < n; ++v)
+			for (size_t c = 0; c < R; ++c)
+			{
+				size_t i = v * R + c;
+				p[i] = active[c] ? invDiag[v] * r[i] + beta[c] * p[i] : 0.0;
+			}
+	}
+	iAPCGResult result;
+	result.iterations = iteration;
+	result.maxResidual = R > 0 ? *std::max_element(residual.begin(), residual.end()) : 0.0;
+	return result;
+}
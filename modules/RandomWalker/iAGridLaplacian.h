@@ -0,0 +1,74 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+//! Matrix-free graph Laplacian (plus additional diagonal terms) of a regular grid.
+//! Each vertex is connected to the vertices at a fixed set of positive index offsets
+//! (e.g. 1, height and width*height for a 6-neighbourhood), so only one weight per
+//! vertex and offset needs to be stored instead of an assembled sparse matrix.
+//! Vertices can be marked as fixed (e.g. the seeds of the Random Walker); fixed
+//! vertices are excluded from the system, i.e. the operator acts on the free vertices only.
+class iAGridLaplacian
+{
+public:
+	iAGridLaplacian(size_t vertexCount, std::vector<size_t> const & offsets);
+	size_t VertexCount() const;
+	//! adds weight to the edge between vertices v1 and v2 = v1 + one of the offsets;
+	//! also adds weight to the diagonal entries of both vertices;
+	//! throws std::invalid_argument for any other pair of vertices
+	void AddEdgeWeight(size_t v1, size_t v2, double weight);
+	//! adds value to the diagonal entry of vertex v
+	void AddDiagonal(size_t v, double value);
+	//! excludes vertex v from the system
+	void SetFixed(size_t v);
+	bool IsFixed(size_t v) const;
+	double Diagonal(size_t v) const;
+	//! computes y = A * x for rhsCount vectors at once; vectors are stored interleaved,
+	//! i.e. the value of vector r at vertex v is stored at v * rhsCount + r
+	void Apply(double const * x, double * y, int rhsCount) const;
+private:
+	size_t m_vertexCount;
+	std::vector<size_t> m_offsets;
+	//! edge weights, one block of vertexCount weights per offset
+	std::vector<double> m_weights;
+	std::vector<double> m_diagonal;
+	std::vector<char> m_fixed;
+};
+
+struct iAPCGResult
+{
+	int iterations;         //!< number of iterations performed
+	double maxResidual;     //!< largest relative residual norm over all right-hand sides
+};
+
+//! Solves A * x = b for rhsCount right-hand sides at once with a Jacobi-preconditioned
+//! conjugate gradient method, running one operator application per iteration for all of them.
+//! @param A the system matrix (needs to be symmetric positive definite on the free vertices)
+//! @param b the right-hand sides, interleaved as described in iAGridLaplacian::Apply
+//! @param x receives the solutions (same layout as b); entries of fixed vertices are 0
+//! @param rhsCount the number of right-hand sides
+//! @param maxIterations the maximum number of iterations
+//! @param tolerance the relative residual norm at which a right-hand side is considered solved
+iAPCGResult SolvePCG(iAGridLaplacian const & A, std::vector<double> const & b,
+	std::vector<double> & x, int rhsCount, int maxIterations, double tolerance);
@@ -0,0 +1,154 @@
+/*************************************  open_iA  ************************************ *
+* **********  A tool for scientific visualisation and 3D image processing  ********** *
+* *********************************************************************************** *
+* Copyright (C) 2016-2017  C. Heinzl, M. Reiter, A. Reh, W. Li, M. Arikan,            *
+*                          J. Weissenböck, Artem & Alexander Amirkhanov, B. Fröhler   *
+* *********************************************************************************** *
+* This program is free software: you can redistribute it and/or modify it under the   *
+* terms of the GNU General Public License as published by the Free Software           *
+* Foundation, either version 3 of the License, or (at your option) any later version. *
+*                                                                                     *
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY     *
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+* PARTICULAR PURPOSE.  See the GNU General Public License for more details.           *
+*                                                                                     *
+* You should have received a copy of the GNU General Public License along with this   *
+* program.  If not, see http://www.gnu.org/licenses/                                  *
+* *********************************************************************************** *
+* Contact: FH OÖ Forschungs & Entwicklungs GmbH, Campus Wels, CT-Gruppe,              *
+*          Stelzhamerstraße 23, 4600 Wels / Austria, Email: c.heinzl@fh-wels.at       *
+* ************************************************************************************/
+#include "iAGridLaplacian.h"
+
+#include "iASimpleTester.h"
+
+#include <random>
+#include <stdexcept>
+
+// solves the dense system a * x = b via Gaussian elimination with partial pivoting
+std::vector<double> DenseSolve(std::vector<std::vector<double> > a, std::vector<double> b)
+{
+	size_t n = b.size();
+	for (size_t col = 0; col < n; ++col)
+	{
+		size_t pivot = col;
+		for (size_t row = col + 1; row < n; ++row)
+			if (std::abs(a[row][col]) > std::abs(a[pivot][col]))
+				pivot = row;
+		std::swap(a[col], a[pivot]);
+		std::swap(b[col], b[pivot]);
+		for (size_t row = col + 1; row < n; ++row)
+		{
+			double f = a[row][col] / a[col][col];
+			for (size_t k = col; k < n; ++k)
+				a[row][k] -= f * a[col][k];
+			b[row] -= f * b[col];
+		}
+	}
+	std::vector<double> x(n);
+	for (size_t i = n; i-- > 0; )
+	{
+		double sum = b[i];
+		for (size_t k = i + 1; k < n; ++k)
+			sum -= a[i][k] * x[k];
+		x[i] = sum / a[i][i];
+	}
+	return x;
+}
+
+BEGIN_TEST
+	// 4x3x2 grid (y fastest), 6-neighbourhood, two fixed "seed" vertices, three right-hand sides:
+	const size_t w = 4, h = 3, d = 2, n = w * h * d;
+	const int rhsCount = 3;
+	std::vector<size_t> offsets = { 1, h, w * h };
+	iAGridLaplacian lap(n, offsets);
+	std::vector<std::vector<double> > dense(n, std::vector<double>(n, 0.0));
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<double> dist(0.01, 1.0);
+	for (size_t z = 0; z < d; ++z)
+		for (size_t x = 0; x < w; ++x)
+			for (size_t y = 0; y < h; ++y)
+			{
+				size_t v = z * w * h + x * h + y;
+				bool hasNeighbour[3] = { y < h - 1, x < w - 1, z < d - 1 };
+				for (int k = 0; k < 3; ++k)
+				{
+					if (!hasNeighbour[k])
+						continue;
+					double weight = dist(rng);
+					size_t u = v + offsets[k];
+					lap.AddEdgeWeight(v, u, weight);
+					dense[v][u] -= weight;
+					dense[u][v] -= weight;
+					dense[v][v] += weight;
+					dense[u][u] += weight;
+				}
+			}
+	lap.AddDiagonal(5, 0.5);
+	dense[5][5] += 0.5;
+	const size_t fixed[2] = { 0, n - 1 };
+	for (size_t f : fixed)
+		lap.SetFixed(f);
+
+	std::vector<double> b(n * rhsCount);
+	for (double & value : b)
+		value = dist(rng);
+	std::vector<double> x;
+	iAPCGResult pcg = SolvePCG(lap, b, x, rhsCount, 1000, 1e-12);
+	TestAssert(pcg.iterations < 1000);
+	TestAssert(pcg.maxResidual < 1e-12);
+
+	// reference: dense solve of the system reduced to the free vertices
+	std::vector<size_t> freeVertices;
+	for (size_t v = 0; v < n; ++v)
+		if (!lap.IsFixed(v))
+			freeVertices.push_back(v);
+	std::vector<std::vector<double> > reduced(freeVertices.size(), std::vector<double>(freeVertices.size()));
+	for (size_t i = 0; i < freeVertices.size(); ++i)
+		for (size_t j = 0; j < freeVertices.size(); ++j)
+			reduced[i][j] = dense[freeVertices[i]][freeVertices[j]];
+	double maxError = 0;
+	for (int r = 0; r < rhsCount; ++r)
+	{
+		std::vector<double> rhs(freeVertices.size());
+		for (size_t i = 0; i < freeVertices.size(); ++i)
+			rhs[i] = b[freeVertices[i] * rhsCount + r];
+		std::vector<double> expected = DenseSolve(reduced, rhs);
+		for (size_t i = 0; i < freeVertices.size(); ++i)
+			maxError = std::max(maxError, std::abs(expected[i] - x[freeVertices[i] * rhsCount + r]));
+		for (size_t f : fixed)
+			TestEqualFloatingPoint(0.0, x[f * rhsCount + r]);
+	}
+	TestEqualFloatingPoint(0.0, maxError);
+
+	// operator application matches the dense matrix product on the free vertices:
+	std::vector<double> y(n * rhsCount);
+	lap.Apply(x.data(), y.data(), rhsCount);
+	double maxApplyError = 0;
+	for (size_t i = 0; i < freeVertices.size(); ++i)
+		for (int r = 0; r < rhsCount; ++r)
+			maxApplyError = std::max(maxApplyError, std::abs(y[freeVertices[i] * rhsCount + r] - b[freeVertices[i] * rhsCount + r]));
+	TestEqualFloatingPoint(0.0, maxApplyError);
+
+	// edges which are not at one of the offsets, or outside of the grid, are rejected:
+	bool rejected = false;
+	try
+	{
+		lap.AddEdgeWeight(0, 2, 1.0);
+	}
+	catch (std::invalid_argument const &)
+	{
+		rejected = true;
+	}
+	TestAssert(rejected);
+	rejected = false;
+	try
+	{
+		lap.AddEdgeWeight(n - 1, n, 1.0);
+	}
+	catch (std::invalid_argument const &)
+	{
+		rejected = true;
+	}
+	TestAssert(rejected);
+END_TEST
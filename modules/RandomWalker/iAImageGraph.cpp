@@ -22,20 +22,28 @@
 #include "pch.h"
 #include "iAImageGraph.h"
 
+#include <algorithm>
+
 namespace
 {
-	iAEdgeIndexType GetNumberOfEdges(iAVoxelIndexType width, iAVoxelIndexType height, iAVoxelIndexType depth,
-		iAImageGraph::NeighbourhoodType neighbourhoodType)
+	iAImageCoordinate Coord(iAVoxelIndexType x, iAVoxelIndexType y, iAVoxelIndexType z)
 	{
-		switch (neighbourhoodType)
-		{
-			case iAImageGraph::nbhMoore:
-				return 13*width*height*depth - 9*(depth*height+depth*width+height*width) + 6*(depth+height+width) - 4;
-			default:
-			case iAImageGraph::nbhVonNeumann:
-				return 3*width*height*depth - height*width - height*depth - width*depth;
+		return iAImageCoordinate(x, y, z);
+	}
 
-		}
+	iAImageCoordinate operator+(iAImageCoordinate const & a, iAImageCoordinate const & b)
+	{
+		return iAImageCoordinate(a.x + b.x, a.y + b.y, a.z + b.z);
+	}
+
+	iAImageCoordinate operator-(iAImageCoordinate const & a, iAImageCoordinate const & b)
+	{
+		return iAImageCoordinate(a.x - b.x, a.y - b.y, a.z - b.z);
+	}
+
+	bool IsInside(iAImageCoordinate const & c, iAImageCoordinate const & size)
+	{
+		return c.x >= 0 && c.y >= 0 && c.z >= 0 && c.x < size.x && c.y < size.y && c.z < size.z;
 	}
 }
 
@@ -45,124 +53,69 @@ iAImageGraph::iAImageGraph(iAVoxelIndexType width, iAVoxelIndexType height, iAVo
 		iAImageCoordinate::IndexOrdering indexOrdering,
 		NeighbourhoodType neighbourhoodType
 	):
-		m_converter(width, height, depth, indexOrdering)
+		m_converter(width, height, depth, indexOrdering),
+		m_indexOrdering(indexOrdering),
+		m_edgeCount(0)
 {
-	m_edges.reserve(GetNumberOfEdges(width, height, depth, neighbourhoodType));
-	iAVoxelIndexType N=width*height*depth;
-
 	// edges are bi-directional; here we will always consider only one "working direction";
 	// i.e. we connect vertices only downward (bidirectionality automatically connects the
 	// lower vertex up!)
 
-	for (iAVoxelIndexType i=0; i<N-1; ++i)
+	AddDirection(Coord(0, 0, 0), Coord(1, 0, 0)); // right neighbour
+	AddDirection(Coord(0, 0, 0), Coord(0, 1, 0)); // lower neighbour
+	AddDirection(Coord(0, 0, 0), Coord(0, 0, 1)); // front/back neighbour (none if depth == 1)
+	if (neighbourhoodType == nbhMoore)
 	{
-		iAImageCoordinate coord1 = m_converter.GetCoordinatesFromIndex(i);
-
-		// connect to right neighbour
-		if (coord1.x < width-1)
-		{
-			iAImageCoordinate coord2(coord1);
-			coord2.x += 1;
-			AddEdge(coord1, coord2);
-		}
-
-		// connect to lower neighbour
-		if (coord1.y < height-1)
-		{
-			iAImageCoordinate coord2(coord1);
-			coord2.y += 1;
-			AddEdge(coord1, coord2);
-		}
-		// connect to front/back neighbour (if depth == 1, then nothing will be added here)
-		if (coord1.z < depth-1)
-		{
-			iAImageCoordinate coord2(coord1);
-			coord2.z += 1;
-			AddEdge(coord1, coord2);
-		}
-		if (neighbourhoodType == nbhMoore)
-		{
-			// add diagonal edges:
-			if (coord1.x < width-1 && coord1.y < height-1)
-			{
-				iAImageCoordinate coord2_1(coord1);
-				coord2_1.x += 1;
-				coord2_1.y += 1;
-				AddEdge(coord1, coord2_1);
-
-				iAImageCoordinate coord1_2(coord1);
-				coord1_2.x += 1;
-				iAImageCoordinate coord2_2(coord1);
-				coord2_2.y += 1;
-				AddEdge(coord1_2, coord2_2);
-			}
-			if (coord1.x < width-1 && coord1.z < depth-1)
-			{
-				iAImageCoordinate coord2_1(coord1);
-				coord2_1.x += 1;
-				coord2_1.z += 1;
-				AddEdge(coord1, coord2_1);
-
-				iAImageCoordinate coord1_2(coord1);
-				coord1_2.x += 1;
-				iAImageCoordinate coord2_2(coord1);
-				coord2_2.z += 1;
-				AddEdge(coord1_2, coord2_2);
-			}
-			if (coord1.y < height-1 && coord1.z < depth-1)
-			{
-				iAImageCoordinate coord2_1(coord1);
-				coord2_1.y += 1;
-				coord2_1.z += 1;
-				AddEdge(coord1, coord2_1);
-
-				iAImageCoordinate coord1_2(coord1);
-				coord1_2.y += 1;
-				iAImageCoordinate coord2_2(coord1);
-				coord2_2.z += 1;
-				AddEdge(coord1_2, coord2_2);
-			}
-
-			if (coord1.x < width-1 && coord1.y < height-1 && coord1.z < depth-1)
-			{
-				iAImageCoordinate coord2_1(coord1);
-				coord2_1.x += 1;
-				coord2_1.y += 1;
-				coord2_1.z += 1;
-				AddEdge(coord1, coord2_1);
-
-				iAImageCoordinate coord1_2(coord1);
-				coord1_2.x += 1;
-				iAImageCoordinate coord2_2(coord1);
-				coord2_2.y += 1;
-				coord2_2.z += 1;
-				AddEdge(coord1_2, coord2_2);
+		// diagonal edges:
+		AddDirection(Coord(0, 0, 0), Coord(1, 1, 0));
+		AddDirection(Coord(1, 0, 0), Coord(0, 1, 0));
+		AddDirection(Coord(0, 0, 0), Coord(1, 0, 1));
+		AddDirection(Coord(1, 0, 0), Coord(0, 0, 1));
+		AddDirection(Coord(0, 0, 0), Coord(0, 1, 1));
+		AddDirection(Coord(0, 1, 0), Coord(0, 0, 1));
+		AddDirection(Coord(0, 0, 0), Coord(1, 1, 1));
+		AddDirection(Coord(1, 0, 0), Coord(0, 1, 1));
+		AddDirection(Coord(0, 1, 0), Coord(1, 0, 1));
+		AddDirection(Coord(0, 0, 1), Coord(1, 1, 0));
+	}
+}
 
-				iAImageCoordinate coord1_3(coord1);
-				coord1_3.y += 1;
-				iAImageCoordinate coord2_3(coord1);
-				coord2_3.x += 1;
-				coord2_3.z += 1;
-				AddEdge(coord1_3, coord2_3);
+void iAImageGraph::AddDirection(iAImageCoordinate from, iAImageCoordinate to)
+{
+	iAEdgeDirection dir;
+	dir.from = from;
+	dir.to = to;
+	// an axis along which the edge spans two voxels leaves one less possible base coordinate:
+	dir.boxSize = Coord(
+		m_converter.GetWidth()  - std::max(from.x, to.x),
+		m_converter.GetHeight() - std::max(from.y, to.y),
+		m_converter.GetDepth()  - std::max(from.z, to.z));
+	if (dir.boxSize.x <= 0 || dir.boxSize.y <= 0 || dir.boxSize.z <= 0)
+	{
+		return;
+	}
+	dir.firstEdge = m_edgeCount;
+	m_edgeCount += static_cast<iAEdgeIndexType>(dir.boxSize.x) * dir.boxSize.y * dir.boxSize.z;
+	m_directions.push_back(dir);
+}
 
-				iAImageCoordinate coord1_4(coord1);
-				coord1_4.z += 1;
-				iAImageCoordinate coord2_4(coord1);
-				coord2_4.x += 1;
-				coord2_4.y += 1;
-				AddEdge(coord1_4, coord2_4);
-			}
-		}
+bool iAImageGraph::ContainsEdge(iAVoxelIndexType voxel1, iAVoxelIndexType voxel2) const
+{
+	if (voxel1 < 0 || voxel2 < 0 || voxel1 >= m_converter.GetVertexCount() || voxel2 >= m_converter.GetVertexCount())
+	{
+		return false;
 	}
+	return ContainsEdge(m_converter.GetCoordinatesFromIndex(voxel1), m_converter.GetCoordinatesFromIndex(voxel2));
 }
 
-bool iAImageGraph::ContainsEdge(iAVoxelIndexType voxel1, iAVoxelIndexType voxel2)
+bool iAImageGraph::ContainsEdge(iAImageCoordinate voxel1, iAImageCoordinate voxel2) const
 {
-	for (iAEdgeIndexType i=0; i<m_edges.size(); ++i)
+	for (auto const & dir : m_directions)
 	{
 		// edges are bi-directional
-		if ( (m_edges[i].first == voxel1 && m_edges[i].second == voxel2) ||
-			 (m_edges[i].second == voxel1 && m_edges[i].first == voxel2))
+		iAImageCoordinate diff = dir.to - dir.from;
+		if ((voxel2 - voxel1 == diff && IsInside(voxel1 - dir.from, dir.boxSize)) ||
+			(voxel1 - voxel2 == diff && IsInside(voxel2 - dir.from, dir.boxSize)))
 		{
 			return true;
 		}
@@ -170,37 +123,27 @@ bool iAImageGraph::ContainsEdge(iAVoxelIndexType voxel1, iAVoxelIndexType voxel2
 	return false;
 }
 
-bool iAImageGraph::ContainsEdge(iAImageCoordinate voxel1, iAImageCoordinate voxel2)
-{
-	iAVoxelIndexType idx1 = m_converter.GetIndexFromCoordinates(voxel1);
-	iAVoxelIndexType idx2 = m_converter.GetIndexFromCoordinates(voxel2);
-	return ContainsEdge(idx1, idx2);
-}
-
 iAEdgeIndexType iAImageGraph::GetEdgeCount() const
 {
-	return m_edges.size();
+	return m_edgeCount;
 }
 
-iAEdgeType const & iAImageGraph::GetEdge(iAEdgeIndexType idx) const
+iAEdgeType iAImageGraph::GetEdge(iAEdgeIndexType idx) const
 {
-	return m_edges[idx];
-}
-
-void iAImageGraph::AddEdge(iAImageCoordinate voxel1, iAImageCoordinate voxel2)
-{
-	iAVoxelIndexType idx1 = m_converter.GetIndexFromCoordinates(voxel1);
-	iAVoxelIndexType idx2 = m_converter.GetIndexFromCoordinates(voxel2);
-	/*
-	assert (!ContainsEdge(idx1, idx2));
-	assert (!ContainsEdge(idx2, idx1));
-	*/
-	//DebugOut() << "Adding edge #"<<idx1<<"(x="<<voxel1.x<<",y="<<voxel1.y<<",z="<<voxel1.z<<") -> #"<<
-	//	                           idx2<<"(x="<<voxel2.x<<",y="<<voxel2.y<<",z="<<voxel2.z<<")" << std::endl;
-	m_edges.push_back(std::make_pair(idx1, idx2));
+	size_t d = m_directions.size() - 1;
+	while (m_directions[d].firstEdge > idx)
+	{
+		--d;
+	}
+	iAEdgeDirection const & dir = m_directions[d];
+	iAImageCoordinate base = iAImageCoordConverter::GetCoordinatesFromIndex(idx - dir.firstEdge,
+		dir.boxSize.x, dir.boxSize.y, dir.boxSize.z, m_indexOrdering);
+	return std::make_pair(
+		m_converter.GetIndexFromCoordinates(base + dir.from),
+		m_converter.GetIndexFromCoordinates(base + dir.to));
 }
 
 iAImageCoordConverter const & iAImageGraph::GetConverter() const
 {
 	return m_converter;
-}
\ No newline at end of file
+}
@@ -36,7 +36,9 @@ public:
  * builds a graph for an image with the given dimensions, where each pixel/voxel is
  * representing a vertex, and neighbouring pixels / voxels are connected via edges
  * (where neighbouring is at the moment defined as von-Neumann-neighbourhood, i.e.
- * those pixels with a Manhattan distance of 1)
+ * those pixels with a Manhattan distance of 1).
+ * The edges are not stored, but computed from their index: they are grouped by
+ * direction, and within one direction, ordered the same way as the voxels
  */
 class iAImageGraph
 {
@@ -54,12 +56,22 @@ public:
 	);
 
 	iAEdgeIndexType GetEdgeCount() const;
-	iAEdgeType const & GetEdge(iAEdgeIndexType idx) const;
-	bool ContainsEdge(iAVoxelIndexType voxel1, iAVoxelIndexType voxel2);
-	bool ContainsEdge(iAImageCoordinate voxel1, iAImageCoordinate voxel2);
+	iAEdgeType GetEdge(iAEdgeIndexType idx) const;
+	bool ContainsEdge(iAVoxelIndexType voxel1, iAVoxelIndexType voxel2) const;
+	bool ContainsEdge(iAImageCoordinate voxel1, iAImageCoordinate voxel2) const;
 	iAImageCoordConverter const & GetConverter() const;
 private:
-	void AddEdge(iAImageCoordinate voxel1, iAImageCoordinate voxel2);
+	//! all edges sharing one direction; they connect the voxels at base+from and base+to,
+	//! for all base coordinates within [0..boxSize)
+	struct iAEdgeDirection
+	{
+		iAImageCoordinate from, to;
+		iAImageCoordinate boxSize;
+		iAEdgeIndexType firstEdge;
+	};
+	void AddDirection(iAImageCoordinate from, iAImageCoordinate to);
 	iAImageCoordConverter m_converter;
-	QVector<iAEdgeType> m_edges;
+	iAImageCoordinate::IndexOrdering m_indexOrdering;
+	std::vector<iAEdgeDirection> m_directions;
+	iAEdgeIndexType m_edgeCount;
 };
@@ -23,6 +23,9 @@
 
 #include "iASimpleTester.h"
 
+#include <algorithm>
+#include <set>
+
 std::ostream& operator<<(std::ostream& out, iAImageCoordinate const & c)
 {
 	out << "(x="<<c.x<<", y="<<c.y<<", z="<<c.z<<")";
@@ -154,6 +157,23 @@ BEGIN_TEST
 	iAImageGraph test2x3x4Graph(2, 3, 4);
 	TestEqual(static_cast<iAEdgeIndexType>(46), test2x3x4Graph.GetEdgeCount());
 
+	// edges computed from their index: all distinct, all contained, all between Moore neighbours
+	iAImageGraph test3x4x2MooreGraph(3, 4, 2, iAImageCoordinate::ColRowDepMajor, iAImageGraph::nbhMoore);
+	TestEqual(static_cast<iAEdgeIndexType>(128), test3x4x2MooreGraph.GetEdgeCount());
+	std::set<iAEdgeType> mooreEdges;
+	bool allMooreEdgesValid = true;
+	for (iAEdgeIndexType e = 0; e < test3x4x2MooreGraph.GetEdgeCount(); ++e)
+	{
+		iAEdgeType edge = test3x4x2MooreGraph.GetEdge(e);
+		iAImageCoordinate c1 = test3x4x2MooreGraph.GetConverter().GetCoordinatesFromIndex(edge.first);
+		iAImageCoordinate c2 = test3x4x2MooreGraph.GetConverter().GetCoordinatesFromIndex(edge.second);
+		allMooreEdgesValid = allMooreEdgesValid && test3x4x2MooreGraph.ContainsEdge(edge.first, edge.second) &&
+			std::abs(c1.x - c2.x) <= 1 && std::abs(c1.y - c2.y) <= 1 && std::abs(c1.z - c2.z) <= 1 && !(c1 == c2);
+		mooreEdges.insert(std::make_pair(std::min(edge.first, edge.second), std::max(edge.first, edge.second)));
+	}
+	TestAssert(allMooreEdgesValid);
+	TestEqual(static_cast<size_t>(128), mooreEdges.size());
+
 	iAVoxelIndexType
 		width = 2,
 		height = 3,
@@ -24,6 +24,7 @@
 #include "defines.h"     // for DIM
 #include "iAConnector.h"
 #include "iAGraphWeights.h"
+#include "iAGridLaplacian.h"
 #include "iAImageGraph.h"
 #include "iAMathUtility.h"
 #include "iANormalizerImpl.h"
@@ -37,6 +38,8 @@
 
 #include <QSet>
 
+#include <vector>
+
 #ifdef USE_EIGEN
 
 #include <Eigen/Core>
@@ -48,11 +51,7 @@ typedef Eigen::VectorXd VectorType;
 
 #include <vnl/vnl_vector.h>
 #include <vnl/vnl_sparse_matrix.h>
-#include <vnl/vnl_sparse_matrix_linear_system.h>
 #include <vnl/algo/vnl_sparse_lu.h>
-#include <vnl/algo/vnl_lsqr.h>
-#include <vnl/algo/vnl_conjugate_gradient.h>
-//<vnl/vnl_conjugate_gradient.h>
 typedef vnl_sparse_matrix<double> MatrixType;
 typedef vnl_vector<double> VectorType;
 
@@ -138,6 +137,49 @@ namespace
 		}
 	}
 
+	void SetInterleavedValues(iAITKIO::ImagePointer image,
+		std::vector<double> const & values,
+		int label, int labelCount,
+		iAImageCoordConverter const & conv)
+	{
+		ProbImageType* pImg = dynamic_cast<ProbImageType*>(image.GetPointer());
+		long long vertexCount = conv.GetVertexCount();
+#pragma omp parallel for
+		for (long long vertexIdx = 0; vertexIdx < vertexCount; ++vertexIdx)
+		{
+			double imgVal = values[vertexIdx * labelCount + label];
+			iAImageCoordinate coord = conv.GetCoordinatesFromIndex(vertexIdx);
+			ProbImageType::IndexType pixelIndex;
+			pixelIndex[0] = coord.x;
+			pixelIndex[1] = coord.y;
+			pixelIndex[2] = coord.z;
+			if (imgVal < 0 || imgVal > 1 || isInf(imgVal) || isNaN(imgVal))
+			{
+				imgVal = 0;
+			}
+			pImg->SetPixel(pixelIndex, imgVal);
+		}
+	}
+
+	//! creates the matrix-free Laplacian of the given graph, which needs to be
+	//! a 6-neighbourhood graph with ColRowDepMajor index ordering
+	QSharedPointer<iAGridLaplacian> CreateGridLaplacian(iAImageGraph const & imageGraph,
+		iAGraphWeights const & weights)
+	{
+		iAImageCoordConverter const & conv = imageGraph.GetConverter();
+		size_t height = conv.GetHeight();
+		std::vector<size_t> offsets = { 1, height, height * conv.GetWidth() };
+		auto result = QSharedPointer<iAGridLaplacian>(new iAGridLaplacian(conv.GetVertexCount(), offsets));
+		for (iAEdgeIndexType edgeIdx = 0; edgeIdx < imageGraph.GetEdgeCount(); ++edgeIdx)
+		{
+			iAEdgeType edge = imageGraph.GetEdge(edgeIdx);
+			result->AddEdgeWeight(edge.first, edge.second, weights.GetWeight(edgeIdx));
+		}
+		return result;
+	}
+
+	const double SolverTolerance = 1e-6;
+
 	void CreateLaplacianPart(MatrixType & output,
 		IndexMap const & rowIndices,
 		IndexMap const & colIndices,
@@ -153,7 +195,7 @@ namespace
 		// edge weights:
 		for (iAEdgeIndexType edgeIdx = 0; edgeIdx < imageGraph.GetEdgeCount(); ++edgeIdx)
 		{
-			iAEdgeType const & edge = imageGraph.GetEdge(edgeIdx);
+			iAEdgeType edge = imageGraph.GetEdge(edgeIdx);
 			if (rowIndices.contains(edge.first) && colIndices.contains(edge.second))
 			{
 				iAVertexIndexType newRowIdx = rowIndices[edge.first];
@@ -215,6 +257,8 @@ namespace
 		filter->AddParameter("Distance Function", Categorical, distanceFunctions);
 		filter->AddParameter("Normalizer", Categorical, normalizeFunctions);
 	}
+	QString const SolverSparseLU("Sparse LU");
+	QString const SolverMatrixFreeCG("Matrix-free conjugate gradient");
 	QString CommonRWParameterDescription("The <em>Distance Function</em> "
 		"determines how the distance between two data points is calculated."
 		"The <em>Normalizer</em> determines how these distances (used as weights "
@@ -231,12 +275,21 @@ iARandomWalker::iARandomWalker() :
 		"where x, y and z are the coordinates (set z = 0 for 2D images) and label is the index of the label "
 		"for this seed point. Label indices should start at 0 and be contiguous (so if you have N different "
 		"labels, you should use label indices 0..N - 1 and make sure that there is at least one seed per label).<br/>"
+		"The <em>Solver</em> determines how the linear equation system is solved: <em>Sparse LU</em> "
+		"factorizes the system matrix, which is exact but requires large amounts of memory for big images; "
+		"the <em>Matrix-free conjugate gradient</em> solver never assembles the matrix and solves for all "
+		"labels at once in a multi-threaded, Jacobi-preconditioned iteration, which is limited by "
+		"<em>Maximum Iterations</em>.<br/>"
 		"For more information see "
 		"<a href=\"http://leogrady.net/publications/\">Leo Grady's website "
 		"(inventor of the algorithm)</a>")
 {
 	AddCommonRWParameters(this);
 	AddParameter("Seeds", Text, "");
+	QStringList solvers;
+	solvers << SolverSparseLU << SolverMatrixFreeCG;
+	AddParameter("Solver", Categorical, solvers);
+	AddParameter("Maximum Iterations", Discrete, 1000, 1);
 }
 
 IAFILTER_CREATE(iARandomWalker)
@@ -245,20 +298,20 @@ void iARandomWalker::Run(QMap<QString, QVariant> const & parameters)
 {
 	int const * dim = m_cons[0]->GetVTKImage()->GetDimensions();
 	double const * spc = m_cons[0]->GetVTKImage()->GetSpacing();
+	iAVertexIndexType vertexCount = static_cast<iAVertexIndexType>(dim[0]) * dim[1] * dim[2];
+	iAImageGraph imageGraph(dim[0], dim[1], dim[2], iAImageCoordinate::ColRowDepMajor);
 	QVector<iARWInputChannel> inputChannels;
 	iARWInputChannel input;
-	auto vtkPixelAccess = QSharedPointer<iAvtkPixelVectorArray>(new iAvtkPixelVectorArray(dim));
+	auto voxelData = QSharedPointer<iAContiguousVectorArray>(new iAContiguousVectorArray(vertexCount, m_cons.size()));
 	for (int i = 0; i < m_cons.size(); ++i)
 	{
-		vtkPixelAccess->AddImage(m_cons[i]->GetVTKImage());
+		voxelData->setChannel(i, m_cons[i]->GetVTKImage(), imageGraph.GetConverter());
 	}
-	input.image = vtkPixelAccess;
+	input.image = voxelData;
 	input.distanceFunc = GetDistanceMeasure(parameters["Distance Function"].toString());
 	input.normalizeFunc = CreateNormalizer(parameters["Normalizer"].toString(), parameters["Beta"].toDouble());
 	input.weight = 1.0;
 	inputChannels.push_back(input);
-	iAVertexIndexType vertexCount = static_cast<iAVertexIndexType>(dim[0]) * dim[1] * dim[2];
-	iAImageGraph imageGraph(dim[0], dim[1], dim[2], iAImageCoordinate::ColRowDepMajor);
 	iASeedsPointer seeds = ExtractSeedVector(parameters["Seeds"].toString(), dim[0], dim[1], dim[2]);
 	int minLabel = std::numeric_limits<int>::max(),
 		maxLabel = std::numeric_limits<int>::lowest();
@@ -322,99 +375,143 @@ void iARandomWalker::Run(QMap<QString, QVariant> const & parameters)
 	QSharedPointer<const iAGraphWeights > finalWeight =
 		CombineGraphWeights(graphWeights, weightsForChannels);
 
-	QVector<double> vertexWeightSum(vertexCount);
-	for (iAEdgeIndexType edgeIdx = 0; edgeIdx < imageGraph.GetEdgeCount(); ++edgeIdx)
+	for (int l = m_cons.size(); l<labelCount+1; ++l)
 	{
-		iAEdgeType const & edge = imageGraph.GetEdge(edgeIdx);
-		vertexWeightSum[edge.first] += finalWeight->GetWeight(edgeIdx);
-		vertexWeightSum[edge.second] += finalWeight->GetWeight(edgeIdx);
+		m_cons.push_back(new iAConnector);
 	}
-
-	IndexMap unlabeledMap;
-	for (iAVertexIndexType vertexIdx = 0, newIdx = 0;
-		vertexIdx < vertexCount; ++vertexIdx)
+	QVector<iAITKIO::ImagePointer> probImgs;
+	if (parameters["Solver"].toString() == SolverMatrixFreeCG)
 	{
-		if (!seedMap.contains(vertexIdx)) {
-			unlabeledMap.insert(vertexIdx, newIdx);
-			++newIdx;
+		auto laplacian = CreateGridLaplacian(imageGraph, *finalWeight);
+		std::vector<int> seedLabel(vertexCount, -1);
+		for (iAVertexIndexType seedIdx = 0; seedIdx < seeds->size(); ++seedIdx)
+		{
+			iAVertexIndexType vertexIdx = imageGraph.GetConverter().GetIndexFromCoordinates(seeds->at(seedIdx).first);
+			seedLabel[vertexIdx] = seeds->at(seedIdx).second;
+			laplacian->SetFixed(vertexIdx);
+		}
+		// right-hand sides -B^T * boundary for all labels: the weights of edges from
+		// unlabeled vertices to the seeds of the respective label
+		std::vector<double> b(static_cast<size_t>(vertexCount) * labelCount, 0.0);
+		for (iAEdgeIndexType edgeIdx = 0; edgeIdx < imageGraph.GetEdgeCount(); ++edgeIdx)
+		{
+			iAEdgeType edge = imageGraph.GetEdge(edgeIdx);
+			if (seedLabel[edge.first] >= 0 && seedLabel[edge.second] < 0)
+			{
+				b[static_cast<size_t>(edge.second) * labelCount + seedLabel[edge.first]] += finalWeight->GetWeight(edgeIdx);
+			}
+			else if (seedLabel[edge.second] >= 0 && seedLabel[edge.first] < 0)
+			{
+				b[static_cast<size_t>(edge.first) * labelCount + seedLabel[edge.second]] += finalWeight->GetWeight(edgeIdx);
+			}
+		}
+		std::vector<double> x;
+		iAPCGResult result = SolvePCG(*laplacian, b, x, labelCount,
+			parameters["Maximum Iterations"].toInt(), SolverTolerance);
+		AddMsg(QString("Conjugate gradient solver: %1 iterations, relative residual %2.")
+			.arg(result.iterations).arg(result.maxResidual));
+		for (iAVertexIndexType vertexIdx = 0; vertexIdx < vertexCount; ++vertexIdx)
+		{
+			if (seedLabel[vertexIdx] >= 0)
+			{
+				for (int l = 0; l < labelCount; ++l)
+				{
+					x[static_cast<size_t>(vertexIdx) * labelCount + l] = seedLabel[vertexIdx] == l;
+				}
+			}
+		}
+		for (int i = 0; i < labelCount; ++i)
+		{
+			iAITKIO::ImagePointer pImg = AllocateImage(dim, spc, itk::ImageIOBase::DOUBLE);
+			SetInterleavedValues(pImg, x, i, labelCount, imageGraph.GetConverter());
+			probImgs.push_back(pImg);
 		}
 	}
-	int seedCount = seedMap.size();
+	else
+	{
+		QVector<double> vertexWeightSum(vertexCount);
+		for (iAEdgeIndexType edgeIdx = 0; edgeIdx < imageGraph.GetEdgeCount(); ++edgeIdx)
+		{
+			iAEdgeType edge = imageGraph.GetEdge(edgeIdx);
+			vertexWeightSum[edge.first] += finalWeight->GetWeight(edgeIdx);
+			vertexWeightSum[edge.second] += finalWeight->GetWeight(edgeIdx);
+		}
 
-	MatrixType A(vertexCount - seedCount, vertexCount - seedCount);
-	CreateLaplacianPart(A, unlabeledMap, unlabeledMap, imageGraph, finalWeight, vertexWeightSum, vertexCount);
+		IndexMap unlabeledMap;
+		for (iAVertexIndexType vertexIdx = 0, newIdx = 0;
+			vertexIdx < vertexCount; ++vertexIdx)
+		{
+			if (!seedMap.contains(vertexIdx)) {
+				unlabeledMap.insert(vertexIdx, newIdx);
+				++newIdx;
+			}
+		}
+		int seedCount = seedMap.size();
+
+		MatrixType A(vertexCount - seedCount, vertexCount - seedCount);
+		CreateLaplacianPart(A, unlabeledMap, unlabeledMap, imageGraph, finalWeight, vertexWeightSum, vertexCount);
 #ifdef USE_EIGEN
-	A.makeCompressed();
+		A.makeCompressed();
 #endif
 
-	MatrixType BT(vertexCount - seedCount, seedCount);
-	CreateLaplacianPart(BT, unlabeledMap, seedMap, imageGraph, finalWeight, vertexWeightSum, vertexCount, true);
-	BT = -BT;
+		MatrixType BT(vertexCount - seedCount, seedCount);
+		CreateLaplacianPart(BT, unlabeledMap, seedMap, imageGraph, finalWeight, vertexWeightSum, vertexCount, true);
+		BT = -BT;
 #ifdef USE_EIGEN
-	BT.makeCompressed();
+		BT.makeCompressed();
 #endif
 
-	// Conjugate Gradient: very fast and small memory usage,
-	// but apparently not ideal for Random Walker (just for Extended RW)!
-	// Eigen::ConjugateGradient<Eigen::SparseMatrix<double, Eigen::ColMajor> > solver;
-	// solver.setMaxIterations(parameters["Maximum Iterations"].toUInt());
-
 #ifdef USE_EIGEN
-	Eigen::SparseLU<Eigen::SparseMatrix<double, Eigen::ColMajor>, Eigen::COLAMDOrdering<int> > solver;
-	solver.analyzePattern(A);
-	std::string error = solver.lastErrorMessage();
-	if (error != "")
-	{
-		AddMsg(QString(error.c_str()));
-		return;
-	}
-	solver.factorize(A);
-	error = solver.lastErrorMessage();
-	if (error != "")
-	{
-		AddMsg(QString(error.c_str()));
-		return;
-	}
+		Eigen::SparseLU<Eigen::SparseMatrix<double, Eigen::ColMajor>, Eigen::COLAMDOrdering<int> > solver;
+		solver.analyzePattern(A);
+		std::string error = solver.lastErrorMessage();
+		if (error != "")
+		{
+			AddMsg(QString(error.c_str()));
+			return;
+		}
+		solver.factorize(A);
+		error = solver.lastErrorMessage();
+		if (error != "")
+		{
+			AddMsg(QString(error.c_str()));
+			return;
+		}
 #else
-	vnl_sparse_lu linear_solver(A, vnl_sparse_lu::quiet);
+		vnl_sparse_lu linear_solver(A, vnl_sparse_lu::quiet);
 #endif
 
-	// BiCGSTAB: uses a bit more memory, but is a bit faster!
-	// Eigen::BiCGSTAB<Eigen::SparseMatrix<double, Eigen::ColMajor> > solver;
-	// solver.compute(A);
-
-	for (int l = m_cons.size(); l<labelCount+1; ++l)
-	{
-		m_cons.push_back(new iAConnector);
-	}
-	QVector<iAITKIO::ImagePointer> probImgs;
-	for (int i = 0; i<labelCount; ++i)
-	{
-		VectorType boundary(seedCount);
-		for (iAVertexIndexType seedIdx = 0; seedIdx < seeds->size(); ++seedIdx)
+		for (int i = 0; i<labelCount; ++i)
 		{
-			boundary[seedIdx] = seeds->at(seedIdx).second == i;
-		}
-		VectorType b(vertexCount - seedCount);
+			VectorType boundary(seedCount);
+			for (iAVertexIndexType seedIdx = 0; seedIdx < seeds->size(); ++seedIdx)
+			{
+				boundary[seedIdx] = seeds->at(seedIdx).second == i;
+			}
+			VectorType b(vertexCount - seedCount);
 #ifdef USE_EIGEN
-		b = BT * boundary;
+			b = BT * boundary;
 #else
-		BT.mult(boundary, b);
+			BT.mult(boundary, b);
 #endif
-		VectorType x(vertexCount - seedCount);
+			VectorType x(vertexCount - seedCount);
 #ifdef USE_EIGEN
 
-		x = solver.solve(b);
+			x = solver.solve(b);
 #else
-		linear_solver.solve(b, &x);
+			linear_solver.solve(b, &x);
 #endif
-		// put values into probability image
-		iAITKIO::ImagePointer pImg = AllocateImage(dim, spc, itk::ImageIOBase::DOUBLE);
-		SetIndexMapValues(pImg, x, unlabeledMap, imageGraph.GetConverter());
-		SetIndexMapValues(pImg, boundary, seedMap, imageGraph.GetConverter());
-		probImgs.push_back(pImg);
-		m_cons[i+1]->SetImage(pImg);
-		m_cons[i+1]->Modified();
+			// put values into probability image
+			iAITKIO::ImagePointer pImg = AllocateImage(dim, spc, itk::ImageIOBase::DOUBLE);
+			SetIndexMapValues(pImg, x, unlabeledMap, imageGraph.GetConverter());
+			SetIndexMapValues(pImg, boundary, seedMap, imageGraph.GetConverter());
+			probImgs.push_back(pImg);
+		}
+	}
+	for (int i = 0; i < labelCount; ++i)
+	{
+		m_cons[i + 1]->SetImage(probImgs[i]);
+		m_cons[i + 1]->Modified();
 	}
 	auto labelImg = CreateLabelImage(dim, spc, probImgs, labelCount);
 	m_cons[0]->SetImage(labelImg);
@@ -458,20 +555,20 @@ void iAExtendedRandomWalker::Run(QMap<QString, QVariant> const & parameters)
 {
 	int const * dim = m_cons[0]->GetVTKImage()->GetDimensions();
 	double const * spc = m_cons[0]->GetVTKImage()->GetSpacing();
+	iAVertexIndexType vertexCount = static_cast<iAVertexIndexType>(dim[0]) * dim[1] * dim[2];
+	iAImageGraph imageGraph(dim[0], dim[1], dim[2], iAImageCoordinate::ColRowDepMajor);
 	QVector<iARWInputChannel> inputChannels;
 	iARWInputChannel input;
-	auto vtkPixelAccess = QSharedPointer<iAvtkPixelVectorArray>(new iAvtkPixelVectorArray(dim));
+	auto voxelData = QSharedPointer<iAContiguousVectorArray>(new iAContiguousVectorArray(vertexCount, FirstInputChannels()));
 	for (int i = 0; i < FirstInputChannels(); ++i)
 	{
-		vtkPixelAccess->AddImage(m_cons[i]->GetVTKImage());
+		voxelData->setChannel(i, m_cons[i]->GetVTKImage(), imageGraph.GetConverter());
 	}
-	input.image = vtkPixelAccess;
+	input.image = voxelData;
 	input.distanceFunc = GetDistanceMeasure(parameters["Distance Function"].toString());
 	input.normalizeFunc = CreateNormalizer(parameters["Normalizer"].toString(), parameters["Beta"].toDouble());
 	input.weight = 1.0;
 	inputChannels.push_back(input);
-	iAVertexIndexType vertexCount = static_cast<iAVertexIndexType>(dim[0]) * dim[1] * dim[2];
-	iAImageGraph imageGraph(dim[0], dim[1], dim[2], iAImageCoordinate::ColRowDepMajor);
 
 	QVector<iAConnector*> priorModel;
 	for (int p = FirstInputChannels(); p < m_cons.size(); ++p)
@@ -502,115 +599,43 @@ void iAExtendedRandomWalker::Run(QMap<QString, QVariant> const & parameters)
 
 	auto finalWeight =
 		CombineGraphWeights(graphWeights, weightsForChannels);
+	auto laplacian = CreateGridLaplacian(imageGraph, *finalWeight);
+	// perf.time("ERW: laplacian");
 
-	QVector<double> vertexWeightSum(vertexCount);
-	for (iAEdgeIndexType edgeIdx = 0; edgeIdx < imageGraph.GetEdgeCount(); ++edgeIdx)
-	{
-		iAEdgeType const & edge = imageGraph.GetEdge(edgeIdx);
-		vertexWeightSum[edge.first] += finalWeight->GetWeight(edgeIdx);
-		vertexWeightSum[edge.second] += finalWeight->GetWeight(edgeIdx);
-	}
-	// perf.time("ERW: vertex weight sums");
-
-	//bool priorNormalized = true;
-	// add priors into vertexWeightSum:
+	// add priors into diagonal, and use them as right-hand sides (one per label):
 	// if my thinking is correct it should be enough to add the weight factor to each entry,
 	// since for one voxel, the probabilities for all labels should add up to 1!
 	int labelCount = priorModel.size();
+	double gamma = parameters["Gamma"].toDouble();
+	std::vector<double> priors(static_cast<size_t>(vertexCount) * labelCount);
 	for (iAVoxelIndexType voxelIdx = 0; voxelIdx < vertexCount; ++voxelIdx)
 	{
 		double sum = 0;
-
-		//PriorModelImageType::IndexType idx;
 		iAImageCoordinate coord = imageGraph.GetConverter().GetCoordinatesFromIndex(voxelIdx);
-		/*
-		idx[0] = coord.x;
-		idx[1] = coord.y;
-		idx[2] = coord.z;
-		*/
 		for (int labelIdx = 0; labelIdx < labelCount; ++labelIdx)
 		{
-			//sum += (*m_priorModel)[labelIdx]->GetPixel(idx);
 			double value = priorModel[labelIdx]->GetVTKImage()->GetScalarComponentAsDouble(coord.x, coord.y, coord.z, 0);
+			priors[static_cast<size_t>(voxelIdx) * labelCount + labelIdx] = value;
 			sum += value;
 		}
 		assert (std::abs(sum-1.0) < EPSILON);
-		//if (std::abs(sum-1.0) >= EPSILON)
-		//{
-		//priorNormalized = false;
-		//DebugOut() << "Prior Model not normalized at (x="<<coord.x<<", y="<<coord.y<<", z="<<coord.z<<"): "<< sum << std::endl;
-		//}
-		vertexWeightSum[voxelIdx] += (parameters["Gamma"].toDouble() * sum);
-	}
-	//if (!priorNormalized)
-	//{
-	//	DebugOut() << "Prior Model not normalized." << std::endl;
-	//}
-
-	IndexMap fullMap;
-	for(iAVertexIndexType vertexIdx=0, newIdx=0;
-	vertexIdx < vertexCount; ++vertexIdx)
-	{
-		fullMap.insert(vertexIdx, vertexIdx);
+		laplacian->AddDiagonal(voxelIdx, gamma * sum);
 	}
 
-	MatrixType A(vertexCount,  vertexCount);
-	CreateLaplacianPart(A, fullMap, fullMap, imageGraph, finalWeight, vertexWeightSum, vertexCount);
-#ifdef USE_EIGEN
-	A.makeCompressed();
-	/*
-	Sparse LU (with both eigen and VNL):
-	- very slow
-	- uses lots and lots of memory!
-	*/
-	// Conjugate Gradient: very fast and small memory usage!
-	Eigen::ConjugateGradient<Eigen::SparseMatrix<double, Eigen::ColMajor> > solver;
-
-	// TODO:
-	//    - check if matrix is positive-definite
-	//    - find a good maximum number of iterations!
-	solver.setMaxIterations(parameters["Maximum Iterations"].toUInt());
-
-	// BiCGSTAB seems to be a bit faster than Conjugate Gradient, but using more memory
-	//Eigen::BiCGSTAB<Eigen::SparseMatrix<double, Eigen::ColMajor> > solver;
-	solver.compute(A);
-	//#else
-	// in case sparse LU should be used, do this:
-	//	vnl_sparse_lu linear_solver(A, vnl_sparse_lu::quiet);
-#endif
-
-	// perf.time("ERW: solver compute done");
+	// matrix-free, Jacobi-preconditioned conjugate gradient, solving for all labels at once:
+	std::vector<double> x;
+	iAPCGResult result = SolvePCG(*laplacian, priors, x, labelCount,
+		parameters["Maximum Iterations"].toInt(), SolverTolerance);
+	AddMsg(QString("Conjugate gradient solver: %1 iterations, relative residual %2.")
+		.arg(result.iterations).arg(result.maxResidual));
+	// perf.time("ERW: solver done");
 
 	QVector<iAITKIO::ImagePointer> probImgs;
 	for (int i=0; i<labelCount; ++i)
 	{
-		VectorType priorForLabel(vertexCount);
-		// fill from image
-		for (iAVoxelIndexType voxelIdx = 0; voxelIdx < vertexCount; ++ voxelIdx)
-		{
-			//PriorModelImageType::IndexType idx;
-			iAImageCoordinate coord = imageGraph.GetConverter().GetCoordinatesFromIndex(voxelIdx);
-			/*
-			idx[0] = coord.x;
-			idx[1] = coord.y;
-			idx[2] = coord.z;
-			*/
-			priorForLabel[voxelIdx] = priorModel[i]->GetVTKImage()->GetScalarComponentAsDouble(coord.x, coord.y, coord.z, 0);
-		}
-
-		VectorType x(vertexCount);
-#ifdef USE_EIGEN
-		x = solver.solve(priorForLabel);
-#else
-		vnl_sparse_matrix_linear_system<double> problem(A, priorForLabel);
-		vnl_lsqr solver(problem);
-		int returnCode = solver.minimize(x);
-		// in case sparse LU should be used, do this instead:
-		//linear_solver.solve(priorForLabel, &x);
-#endif
 		// put values into probability image
 		iAITKIO::ImagePointer pImg = AllocateImage(dim, spc, itk::ImageIOBase::DOUBLE);
-		SetIndexMapValues(pImg, x, fullMap, imageGraph.GetConverter());
+		SetInterleavedValues(pImg, x, i, labelCount, imageGraph.GetConverter());
 		probImgs.push_back(pImg);
 		m_cons[i + 1]->SetImage(pImg);
 		m_cons[i + 1]->Modified();
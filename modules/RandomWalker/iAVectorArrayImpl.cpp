@@ -21,6 +21,27 @@
 #include "pch.h"
 #include "iAVectorArrayImpl.h"
 
+#include "iATypedCallHelper.h"
+
+namespace
+{
+	template <typename T>
+	void CopyFirstComponent(vtkImageData* img, iAVectorDataType* dest, iAImageCoordConverter const & coordConv)
+	{
+		T const * src = static_cast<T const *>(img->GetScalarPointer());
+		int const * dim = img->GetDimensions();
+		size_t componentCount = img->GetNumberOfScalarComponents();
+		long long voxelCount = coordConv.GetVertexCount();
+#pragma omp parallel for
+		for (long long voxelIdx = 0; voxelIdx < voxelCount; ++voxelIdx)
+		{
+			iAImageCoordinate coords = coordConv.GetCoordinatesFromIndex(voxelIdx);
+			size_t imgIdx = (static_cast<size_t>(coords.z) * dim[1] + coords.y) * dim[0] + coords.x;
+			dest[voxelIdx] = src[imgIdx * componentCount];
+		}
+	}
+}
+
 
 iAVectorArray::~iAVectorArray()
 {}
@@ -68,3 +89,42 @@ iAVectorDataType iAvtkPixelVectorArray::get(size_t voxelIdx, size_t channelIdx)
 	iAVectorDataType value = m_images[channelIdx]->GetScalarComponentAsDouble(coords.x, coords.y, coords.z, 0);
 	return value;
 }
+
+
+iAContiguousVectorArray::iAContiguousVectorArray(size_t voxelCount, size_t channelCount):
+	m_voxelCount(voxelCount),
+	m_channelCount(channelCount),
+	m_data(voxelCount * channelCount)
+{
+}
+
+size_t iAContiguousVectorArray::size() const
+{
+	return m_voxelCount;
+}
+
+size_t iAContiguousVectorArray::channelCount() const
+{
+	return m_channelCount;
+}
+
+QSharedPointer<iAVectorType const> iAContiguousVectorArray::get(size_t voxelIdx) const
+{
+	return QSharedPointer<iAVectorType const>(new iAPixelVector(*this, voxelIdx));
+}
+
+iAVectorDataType iAContiguousVectorArray::get(size_t voxelIdx, size_t channelIdx) const
+{
+	return m_data[channelIdx * m_voxelCount + voxelIdx];
+}
+
+iAVectorDataType const * iAContiguousVectorArray::channel(size_t channelIdx) const
+{
+	return m_data.data() + channelIdx * m_voxelCount;
+}
+
+void iAContiguousVectorArray::setChannel(size_t channelIdx, vtkSmartPointer<vtkImageData> img, iAImageCoordConverter const & coordConv)
+{
+	assert(static_cast<size_t>(coordConv.GetVertexCount()) == m_voxelCount && channelIdx < m_channelCount);
+	VTK_TYPED_CALL(CopyFirstComponent, img->GetScalarType(), img, m_data.data() + channelIdx * m_voxelCount, coordConv);
+}
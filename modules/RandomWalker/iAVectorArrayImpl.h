@@ -32,6 +32,8 @@
 
 #include <QSharedPointer>
 
+#include <vector>
+
 class iAvtkPixelVectorArray: public iAVectorArray
 {
 public:
@@ -47,6 +49,26 @@ private:
 	iAImageCoordConverter m_coordConv;
 };
 
+//! vector array holding all values in one contiguous block, stored channel by channel
+//! (structure of arrays), i.e. the value of channel c at voxel v is at channel(c)[v]
+class iAContiguousVectorArray : public iAVectorArray
+{
+public:
+	iAContiguousVectorArray(size_t voxelCount, size_t channelCount);
+	virtual size_t size() const;
+	virtual size_t channelCount() const;
+	virtual QSharedPointer<iAVectorType const> get(size_t voxelIdx) const;
+	virtual iAVectorDataType get(size_t voxelIdx, size_t channelIdx) const;
+	iAVectorDataType const * channel(size_t channelIdx) const;
+	//! copies the first component of the given image into the given channel,
+	//! with the voxels ordered as determined by the given coordinate converter
+	void setChannel(size_t channelIdx, vtkSmartPointer<vtkImageData> img, iAImageCoordConverter const & coordConv);
+private:
+	size_t m_voxelCount;
+	size_t m_channelCount;
+	std::vector<iAVectorDataType> m_data;
+};
+
 template <typename ImageType>
 class iAitkPixelVectorArray : public iAVectorArray
 {
@@ -24,14 +24,25 @@
 
 #include <QSharedPointer>
 
+#include <cstddef> // for size_t
+
 //! abstract base class for the distance between two vectors of same length
 class iAVectorDistance
 {
 public:
 	static double EPSILON;
+	//! maximum number of vector pairs processed in one call to GetDistances
+	static const size_t MaxBatchSize = 256;
 	virtual ~iAVectorDistance();
 	virtual char const * GetShortName() const =0;
 	virtual char const * GetName() const =0;
-	virtual double GetDistance(QSharedPointer<iAVectorType const> spec1, QSharedPointer<iAVectorType const> spec2) const = 0;
+	double GetDistance(QSharedPointer<iAVectorType const> spec1, QSharedPointer<iAVectorType const> spec2) const;
+	//! computes the distances between count pairs of vectors at once, without any memory allocation.
+	//! The vectors are stored channel by channel: channel c of the e-th vector of the first set
+	//! is at values1[c * stride + e], the one of its partner in the second set at values2[c * stride + e].
+	//! @param count the number of vector pairs, at most MaxBatchSize
+	//! @param result receives the count distances
+	virtual void GetDistances(iAVectorDataType const * values1, iAVectorDataType const * values2,
+		size_t channelCount, size_t stride, size_t count, double * result) const = 0;
 	virtual bool isSymmetric() const;
 };
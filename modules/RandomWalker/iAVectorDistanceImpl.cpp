@@ -25,19 +25,55 @@
 
 #include <QVector>
 
-#include <numeric>
+#include <algorithm>
 #include <cmath>
+#include <numeric>
+#include <vector>
 
 namespace
 {
-	double VectorLength(QSharedPointer<iAVectorType const> spec)
+	//! sums of the values of each of the count vectors (see iAVectorDistance::GetDistances for the layout)
+	void VectorSums(iAVectorDataType const * values, size_t channelCount, size_t stride, size_t count, double * sums)
+	{
+		std::fill(sums, sums + count, 0.0);
+		for (size_t c = 0; c < channelCount; ++c)
+		{
+			iAVectorDataType const * v = values + c * stride;
+			for (size_t e = 0; e < count; ++e)
+			{
+				sums[e] += v[e];
+			}
+		}
+	}
+
+	//! Kullback-Leibler divergence between the normalized vectors; shared by KL and Jensen-Shannon
+	void KullbackLeibler(iAVectorDataType const * values1, iAVectorDataType const * values2,
+		size_t channelCount, size_t stride, size_t count, double * result)
 	{
-		double sum = 0.0;
-		for(iAVectorType::IndexType i = 0; i<spec->size(); ++i)
+		double sum1[iAVectorDistance::MaxBatchSize], sum2[iAVectorDistance::MaxBatchSize];
+		VectorSums(values1, channelCount, stride, count, sum1);
+		VectorSums(values2, channelCount, stride, count, sum2);
+		std::fill(result, result + count, 0.0);
+		for (size_t c = 0; c < channelCount; ++c)
 		{
-			sum += static_cast<double>(spec->get(i)) * spec->get(i);
+			iAVectorDataType const * v1 = values1 + c * stride;
+			iAVectorDataType const * v2 = values2 + c * stride;
+			for (size_t e = 0; e < count; ++e)
+			{
+				double s1 = v1[e] / sum1[e];
+				double s2 = v2[e] / sum2[e];
+				double logTerm = (s2 == 0) ? 0 : (s1 / s2);
+				if (isInf(logTerm) || isNaN(logTerm))
+				{
+					logTerm = 0;
+				}
+				result[e] += (logTerm == 0) ? 0 : (std::log(logTerm) * s1);
+				if (isInf(result[e]) || isNaN(result[e]))
+				{
+					result[e] = 0;
+				}
+			}
 		}
-		return sqrt(sum);
 	}
 
 	const char * const MeasureNames[dmCount+1] =
@@ -150,6 +186,20 @@ QSharedPointer<iAVectorDistance> GetDistanceMeasureFromShortName(QString const &
 iAVectorDistance::~iAVectorDistance()
 {}
 
+double iAVectorDistance::GetDistance(QSharedPointer<iAVectorType const> spec1, QSharedPointer<iAVectorType const> spec2) const
+{
+	assert(spec1->size() == spec2->size());
+	std::vector<iAVectorDataType> values1(spec1->size()), values2(spec2->size());
+	for (iAVectorType::IndexType i = 0; i < spec1->size(); ++i)
+	{
+		values1[i] = spec1->get(i);
+		values2[i] = spec2->get(i);
+	}
+	double result;
+	GetDistances(values1.data(), values2.data(), values1.size(), 1, 1, &result);
+	return result;
+}
+
 bool iAVectorDistance::isSymmetric() const
 {
 	return true;
@@ -168,25 +218,34 @@ char const * iASpectralAngularDistance::GetName() const
 	return MeasureNames[dmCosine];
 }
 
-double iASpectralAngularDistance::GetDistance(QSharedPointer<iAVectorType const> spec1, QSharedPointer<iAVectorType const> spec2) const
+void iASpectralAngularDistance::GetDistances(iAVectorDataType const * values1, iAVectorDataType const * values2,
+	size_t channelCount, size_t stride, size_t count, double * result) const
 {
-	assert(spec1->size() == spec2->size());
-	double prod = 0;
-	for(iAVectorType::IndexType i = 0; i<spec1->size(); ++i)
+	double prod[MaxBatchSize], len1[MaxBatchSize], len2[MaxBatchSize];
+	std::fill(prod, prod + count, 0.0);
+	std::fill(len1, len1 + count, 0.0);
+	std::fill(len2, len2 + count, 0.0);
+	for (size_t c = 0; c < channelCount; ++c)
 	{
-		prod += static_cast<double>(spec1->get(i)) * spec2->get(i);
+		iAVectorDataType const * v1 = values1 + c * stride;
+		iAVectorDataType const * v2 = values2 + c * stride;
+		for (size_t e = 0; e < count; ++e)
+		{
+			prod[e] += v1[e] * v2[e];
+			len1[e] += v1[e] * v1[e];
+			len2[e] += v2[e] * v2[e];
+		}
 	}
-	//double prod = std::inner_product(&spec1[0], spec1+spec1->size(), spec2, 0.0);
-	double len1 = VectorLength(spec1);
-	double len2 = VectorLength(spec2);
-	//assert (len1 != 0 && len2 != 0);
-	if (len1 == 0 || len2 == 0)
+	for (size_t e = 0; e < count; ++e)
 	{
-		return 0;
+		if (len1[e] == 0 || len2[e] == 0)
+		{
+			result[e] = 0;
+			continue;
+		}
+		double cosAngle = prod[e] / (std::sqrt(len1[e]) * std::sqrt(len2[e]));
+		result[e] = clamp(-1.0, 1.0, cosAngle);
 	}
-	double cosAngle = prod / (len1*len2);
-//	assert ( cosAngle >= -1 && cosAngle <= 1 );
-	return clamp(-1.0, 1.0, cosAngle);
 }
 
 char const * iAL1NormDistance::GetShortName() const
@@ -199,15 +258,19 @@ char const * iAL1NormDistance::GetName() const
 	return MeasureNames[dmL1];
 }
 
-double iAL1NormDistance::GetDistance(QSharedPointer<iAVectorType const> spec1, QSharedPointer<iAVectorType const> spec2) const
+void iAL1NormDistance::GetDistances(iAVectorDataType const * values1, iAVectorDataType const * values2,
+	size_t channelCount, size_t stride, size_t count, double * result) const
 {
-	assert(spec1->size() == spec2->size());
-	double sum = 0;
-	for(iAVectorType::IndexType i = 0; i<spec1->size(); ++i)
+	std::fill(result, result + count, 0.0);
+	for (size_t c = 0; c < channelCount; ++c)
 	{
-		sum += std::abs(static_cast<double>(spec1->get(i)) - spec2->get(i));
+		iAVectorDataType const * v1 = values1 + c * stride;
+		iAVectorDataType const * v2 = values2 + c * stride;
+		for (size_t e = 0; e < count; ++e)
+		{
+			result[e] += std::abs(v1[e] - v2[e]);
+		}
 	}
-	return sum;
 }
 
 char const * iAL2NormDistance::GetShortName() const
@@ -220,16 +283,24 @@ char const * iAL2NormDistance::GetName() const
 	return MeasureNames[dmL2];
 }
 
-double iAL2NormDistance::GetDistance(QSharedPointer<iAVectorType const> spec1, QSharedPointer<iAVectorType const> spec2) const
+void iAL2NormDistance::GetDistances(iAVectorDataType const * values1, iAVectorDataType const * values2,
+	size_t channelCount, size_t stride, size_t count, double * result) const
 {
-	assert(spec1->size() == spec2->size());
-	double sum = 0;
-	for(iAVectorType::IndexType i = 0; i<spec1->size(); ++i)
+	std::fill(result, result + count, 0.0);
+	for (size_t c = 0; c < channelCount; ++c)
+	{
+		iAVectorDataType const * v1 = values1 + c * stride;
+		iAVectorDataType const * v2 = values2 + c * stride;
+		for (size_t e = 0; e < count; ++e)
+		{
+			double a = v1[e] - v2[e];
+			result[e] += a * a;
+		}
+	}
+	for (size_t e = 0; e < count; ++e)
 	{
-		double a = static_cast<double>(spec1->get(i)) - spec2->get(i);
-		sum += std::pow(a, 2);
+		result[e] = std::sqrt(result[e]);
 	}
-	return std::sqrt(sum);
 }
 
 char const * iALInfNormDistance::GetShortName() const
@@ -242,19 +313,19 @@ char const * iALInfNormDistance::GetName() const
 	return MeasureNames[dmLinf];
 }
 
-double iALInfNormDistance::GetDistance(QSharedPointer<iAVectorType const> spec1, QSharedPointer<iAVectorType const> spec2) const
+void iALInfNormDistance::GetDistances(iAVectorDataType const * values1, iAVectorDataType const * values2,
+	size_t channelCount, size_t stride, size_t count, double * result) const
 {
-	assert(spec1->size() == spec2->size());
-	double maxDist=0;
-	for(iAVectorType::IndexType i = 0; i<spec1->size(); ++i)
+	std::fill(result, result + count, 0.0);
+	for (size_t c = 0; c < channelCount; ++c)
 	{
-		double dist = std::abs(static_cast<double>(spec1->get(i)) - spec2->get(i));
-		if (dist > maxDist)
+		iAVectorDataType const * v1 = values1 + c * stride;
+		iAVectorDataType const * v2 = values2 + c * stride;
+		for (size_t e = 0; e < count; ++e)
 		{
-			maxDist = dist;
+			result[e] = std::max(result[e], std::abs(v1[e] - v2[e]));
 		}
 	}
-	return maxDist;
 }
 
 char const * iAJensenShannonDistance::GetShortName() const
@@ -267,10 +338,16 @@ char const * iAJensenShannonDistance::GetName() const
 	return MeasureNames[dmJensenShannon];
 }
 
-double iAJensenShannonDistance::GetDistance(QSharedPointer<iAVectorType const> spec1, QSharedPointer<iAVectorType const> spec2) const
+void iAJensenShannonDistance::GetDistances(iAVectorDataType const * values1, iAVectorDataType const * values2,
+	size_t channelCount, size_t stride, size_t count, double * result) const
 {
-	iAKullbackLeiblerDivergence kld;
-	return std::sqrt(0.5 * kld.GetDistance(spec1, spec2) + 0.5 * kld.GetDistance(spec2, spec1));
+	double kld12[MaxBatchSize], kld21[MaxBatchSize];
+	KullbackLeibler(values1, values2, channelCount, stride, count, kld12);
+	KullbackLeibler(values2, values1, channelCount, stride, count, kld21);
+	for (size_t e = 0; e < count; ++e)
+	{
+		result[e] = std::sqrt(0.5 * kld12[e] + 0.5 * kld21[e]);
+	}
 }
 
 char const * iAKullbackLeiblerDivergence::GetShortName() const
@@ -283,26 +360,10 @@ char const * iAKullbackLeiblerDivergence::GetName() const
 	return MeasureNames[dmKullbackLeibler];
 }
 
-double iAKullbackLeiblerDivergence::GetDistance(QSharedPointer<iAVectorType const> spec1, QSharedPointer<iAVectorType const> spec2) const
+void iAKullbackLeiblerDivergence::GetDistances(iAVectorDataType const * values1, iAVectorDataType const * values2,
+	size_t channelCount, size_t stride, size_t count, double * result) const
 {
-	assert(spec1->size() == spec2->size());
-	double kldiv = 0;
-	QSharedPointer<iAVectorType const> s1 = spec1->normalized();
-	QSharedPointer<iAVectorType const> s2 = spec2->normalized();
-	for(iAVectorType::IndexType i = 0; i<s1->size(); ++i)
-	{
-		double logTerm = (s2->get(i) == 0)? 0 : (s1->get(i) / s2->get(i));
-		if (isInf(logTerm) || isNaN(logTerm))
-		{
-			logTerm = 0;
-		}
-		kldiv += (logTerm == 0)? 0 : (std::log(logTerm) * (s1->get(i)));
-		if (isInf(kldiv) || isNaN(kldiv))
-		{
-			kldiv = 0;
-		}
-	}
-	return kldiv;
+	KullbackLeibler(values1, values2, channelCount, stride, count, result);
 }
 
 char const * iAChiSquareDistance::GetShortName() const
@@ -315,17 +376,28 @@ char const * iAChiSquareDistance::GetName() const
 	return MeasureNames[dmChiSquare];
 }
 
-double iAChiSquareDistance::GetDistance(QSharedPointer<iAVectorType const> spec1, QSharedPointer<iAVectorType const> spec2) const
+void iAChiSquareDistance::GetDistances(iAVectorDataType const * values1, iAVectorDataType const * values2,
+	size_t channelCount, size_t stride, size_t count, double * result) const
 {
-	assert(spec1->size() == spec2->size());
-	double chiSquare = 0;
-	QSharedPointer<iAVectorType const> s1 = spec1->normalized();
-	QSharedPointer<iAVectorType const> s2 = spec2->normalized();
-	for(iAVectorType::IndexType i = 0; i<s1->size(); ++i)
+	double sum1[MaxBatchSize], sum2[MaxBatchSize];
+	VectorSums(values1, channelCount, stride, count, sum1);
+	VectorSums(values2, channelCount, stride, count, sum2);
+	std::fill(result, result + count, 0.0);
+	for (size_t c = 0; c < channelCount; ++c)
+	{
+		iAVectorDataType const * v1 = values1 + c * stride;
+		iAVectorDataType const * v2 = values2 + c * stride;
+		for (size_t e = 0; e < count; ++e)
+		{
+			double s1 = v1[e] / sum1[e];
+			double s2 = v2[e] / sum2[e];
+			result[e] += (s1 - s2) * (s1 - s2) / (s1 + s2);
+		}
+	}
+	for (size_t e = 0; e < count; ++e)
 	{
-		chiSquare += std::pow(s1->get(i) - s2->get(i), 2) / (s1->get(i) + s2->get(i));
+		result[e] /= 2.0;
 	}
-	return chiSquare / 2.0;
 }
 
 char const * iAEarthMoversDistance::GetShortName() const
@@ -339,20 +411,25 @@ char const * iAEarthMoversDistance::GetName() const
 }
 
 
-double iAEarthMoversDistance::GetDistance(QSharedPointer<iAVectorType const> spec1, QSharedPointer<iAVectorType const> spec2) const
+void iAEarthMoversDistance::GetDistances(iAVectorDataType const * values1, iAVectorDataType const * values2,
+	size_t channelCount, size_t stride, size_t count, double * result) const
 {
-	assert(spec1->size() == spec2->size());
-	double emd = 0;
-	double lastEmd = 0;
-	QSharedPointer<iAVectorType const> s1 = spec1->normalized();
-	QSharedPointer<iAVectorType const> s2 = spec2->normalized();
-	for(iAVectorType::IndexType i = 0; i<s1->size(); ++i)
+	double sum1[MaxBatchSize], sum2[MaxBatchSize], lastEmd[MaxBatchSize];
+	VectorSums(values1, channelCount, stride, count, sum1);
+	VectorSums(values2, channelCount, stride, count, sum2);
+	std::fill(result, result + count, 0.0);
+	std::fill(lastEmd, lastEmd + count, 0.0);
+	for (size_t c = 0; c < channelCount; ++c)
 	{
-		double newEmd = s1->get(i) + lastEmd - s2->get(i);
-		emd += std::abs(newEmd);
-		lastEmd = newEmd;
+		iAVectorDataType const * v1 = values1 + c * stride;
+		iAVectorDataType const * v2 = values2 + c * stride;
+		for (size_t e = 0; e < count; ++e)
+		{
+			double newEmd = v1[e] / sum1[e] + lastEmd[e] - v2[e] / sum2[e];
+			result[e] += std::abs(newEmd);
+			lastEmd[e] = newEmd;
+		}
 	}
-	return emd;
 }
 
 char const * iASquaredDistance::GetShortName() const
@@ -365,15 +442,20 @@ char const * iASquaredDistance::GetName() const
 	return MeasureNames[dmSquared];
 }
 
-double iASquaredDistance::GetDistance(QSharedPointer<iAVectorType const> spec1, QSharedPointer<iAVectorType const> spec2) const
+void iASquaredDistance::GetDistances(iAVectorDataType const * values1, iAVectorDataType const * values2,
+	size_t channelCount, size_t stride, size_t count, double * result) const
 {
-	double sum = 0;
-	for(iAVectorType::IndexType i = 0; i<spec1->size(); ++i)
+	std::fill(result, result + count, 0.0);
+	for (size_t c = 0; c < channelCount; ++c)
 	{
-		double a = static_cast<double>(spec1->get(i)) - spec2->get(i);
-		sum += std::pow(a, 2);
+		iAVectorDataType const * v1 = values1 + c * stride;
+		iAVectorDataType const * v2 = values2 + c * stride;
+		for (size_t e = 0; e < count; ++e)
+		{
+			double a = v1[e] - v2[e];
+			result[e] += a * a;
+		}
 	}
-	return sum;
 }
 
 
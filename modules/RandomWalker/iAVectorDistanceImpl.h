@@ -24,6 +24,8 @@
 
 #include <QString>
 
+#include <algorithm>
+
 enum MeasureIndices
 {
 	dmL1,
@@ -51,7 +53,8 @@ class iASpectralAngularDistance: public iAVectorDistance
 public:
 	virtual char const * GetName() const;
 	virtual char const * GetShortName() const;
-	virtual double GetDistance(QSharedPointer<iAVectorType const> spec1, QSharedPointer<iAVectorType const> spec2) const;
+	virtual void GetDistances(iAVectorDataType const * values1, iAVectorDataType const * values2,
+		size_t channelCount, size_t stride, size_t count, double * result) const;
 };
 
 class iAL1NormDistance: public iAVectorDistance
@@ -59,7 +62,8 @@ class iAL1NormDistance: public iAVectorDistance
 public:
 	virtual char const * GetName() const;
 	virtual char const * GetShortName() const;
-	virtual double GetDistance(QSharedPointer<iAVectorType const> spec1, QSharedPointer<iAVectorType const> spec2) const;
+	virtual void GetDistances(iAVectorDataType const * values1, iAVectorDataType const * values2,
+		size_t channelCount, size_t stride, size_t count, double * result) const;
 };
 
 class iAL2NormDistance: public iAVectorDistance
@@ -67,7 +71,8 @@ class iAL2NormDistance: public iAVectorDistance
 public:
 	virtual char const * GetName() const;
 	virtual char const * GetShortName() const;
-	virtual double GetDistance(QSharedPointer<iAVectorType const> spec1, QSharedPointer<iAVectorType const> spec2) const;
+	virtual void GetDistances(iAVectorDataType const * values1, iAVectorDataType const * values2,
+		size_t channelCount, size_t stride, size_t count, double * result) const;
 };
 
 class iALInfNormDistance: public iAVectorDistance
@@ -75,7 +80,8 @@ class iALInfNormDistance: public iAVectorDistance
 public:
 	virtual char const * GetName() const;
 	virtual char const * GetShortName() const;
-	virtual double GetDistance(QSharedPointer<iAVectorType const> spec1, QSharedPointer<iAVectorType const> spec2) const;
+	virtual void GetDistances(iAVectorDataType const * values1, iAVectorDataType const * values2,
+		size_t channelCount, size_t stride, size_t count, double * result) const;
 };
 
 class iAJensenShannonDistance : public iAVectorDistance
@@ -83,7 +89,8 @@ class iAJensenShannonDistance : public iAVectorDistance
 public:
 	virtual char const * GetName() const;
 	virtual char const * GetShortName() const;
-	virtual double GetDistance(QSharedPointer<iAVectorType const> spec1, QSharedPointer<iAVectorType const> spec2) const;
+	virtual void GetDistances(iAVectorDataType const * values1, iAVectorDataType const * values2,
+		size_t channelCount, size_t stride, size_t count, double * result) const;
 };
 
 class iAKullbackLeiblerDivergence : public iAVectorDistance
@@ -91,7 +98,8 @@ class iAKullbackLeiblerDivergence : public iAVectorDistance
 public:
 	virtual char const * GetName() const;
 	virtual char const * GetShortName() const;
-	virtual double GetDistance(QSharedPointer<iAVectorType const> spec1, QSharedPointer<iAVectorType const> spec2) const;
+	virtual void GetDistances(iAVectorDataType const * values1, iAVectorDataType const * values2,
+		size_t channelCount, size_t stride, size_t count, double * result) const;
 	virtual bool isSymmetric() const {return false; }
 };
 
@@ -100,7 +108,8 @@ class iAChiSquareDistance: public iAVectorDistance
 public:
 	virtual char const * GetName() const;
 	virtual char const * GetShortName() const;
-	virtual double GetDistance(QSharedPointer<iAVectorType const> spec1, QSharedPointer<iAVectorType const> spec2) const;
+	virtual void GetDistances(iAVectorDataType const * values1, iAVectorDataType const * values2,
+		size_t channelCount, size_t stride, size_t count, double * result) const;
 };
 
 class iAEarthMoversDistance: public iAVectorDistance
@@ -108,7 +117,8 @@ class iAEarthMoversDistance: public iAVectorDistance
 public:
 	virtual char const * GetName() const;
 	virtual char const * GetShortName() const;
-	virtual double GetDistance(QSharedPointer<iAVectorType const> spec1, QSharedPointer<iAVectorType const> spec2) const;
+	virtual void GetDistances(iAVectorDataType const * values1, iAVectorDataType const * values2,
+		size_t channelCount, size_t stride, size_t count, double * result) const;
 };
 
 class iASquaredDistance: public iAVectorDistance
@@ -116,7 +126,8 @@ class iASquaredDistance: public iAVectorDistance
 public:
 	virtual char const * GetName() const;
 	virtual char const * GetShortName() const;
-	virtual double GetDistance(QSharedPointer<iAVectorType const> spec1, QSharedPointer<iAVectorType const> spec2) const;
+	virtual void GetDistances(iAVectorDataType const * values1, iAVectorDataType const * values2,
+		size_t channelCount, size_t stride, size_t count, double * result) const;
 };
 
 class iANullDistance: public iAVectorDistance
@@ -124,7 +135,11 @@ class iANullDistance: public iAVectorDistance
 public:
 	virtual char const * GetName() const { return "Null Dist."; }
 	virtual char const * GetShortName() const { return "null"; }
-	virtual double GetDistance(QSharedPointer<iAVectorType const> spec1, QSharedPointer<iAVectorType const> spec2) const { return 0; }
+	virtual void GetDistances(iAVectorDataType const * values1, iAVectorDataType const * values2,
+		size_t channelCount, size_t stride, size_t count, double * result) const
+	{
+		std::fill(result, result + count, 0.0);
+	}
 };
 
 /*
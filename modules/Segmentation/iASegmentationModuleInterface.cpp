@@ -30,11 +30,10 @@
 #include "iAConnector.h"
 #include "iAConsole.h"
 #include "iAFilterRegistry.h"
+#include "iAImageComparisonMetrics.h"
 #include "mainwindow.h"
 #include "mdichild.h"
 
-#include <itkLabelOverlapMeasuresImageFilter.h>
-
 #include <vtkImageData.h>
 
 #include <QFileDialog>
@@ -73,51 +72,36 @@ void iASegmentationModuleInterface::Initialize()
 }
 
 
-template <typename ImagePixelType>
-void CalculateSegmentationMetrics_template(iAConnector & groundTruthCon, iAConnector & segmentedCon, ImagePixelType)
+namespace
 {
-	typedef itk::Image<ImagePixelType, 3> ImageType;
-	typedef typename ImageType::Pointer ImagePointer;
-	typedef itk::LabelOverlapMeasuresImageFilter<ImageType > FilterType;
-	typename FilterType::Pointer filter = FilterType::New();
-	ImagePointer groundTruthPtr = dynamic_cast<ImageType*>(groundTruthCon.GetITKImage());
-	ImagePointer segmentedPtr = dynamic_cast<ImageType*>(segmentedCon.GetITKImage());
-	assert(groundTruthPtr);
-	assert(segmentedPtr);
-	filter->SetSourceImage(groundTruthPtr);
-	filter->SetTargetImage(segmentedPtr);
-	filter->Update();
-
-	DEBUG_LOG("************ All Labels *************");
-	DEBUG_LOG(" \t Total \t Union (jaccard) \t Mean (dice) \t Volume sim. \t False negative \t False positive");
-	DEBUG_LOG(QString(" \t %1 \t %2 \t  %3 \t  %4 \t  %5 \t  %6")
-		.arg(filter->GetTotalOverlap())
-		.arg(filter->GetUnionOverlap())
-		.arg(filter->GetMeanOverlap())
-		.arg(filter->GetVolumeSimilarity())
-		.arg(filter->GetFalseNegativeError())
-		.arg(filter->GetFalsePositiveError()));
-
-	DEBUG_LOG("************ Individual Labels *************");
-	DEBUG_LOG("Label \t Target \t Union (jaccard) \t Mean (dice) \t Volume sim. \t False negative \t False positive");
-
-	typename FilterType::MapType labelMap = filter->GetLabelSetMeasures();
-	typename FilterType::MapType::const_iterator it;
-	for (it = labelMap.begin(); it != labelMap.end(); ++it)
+	void PrintSegmentationMetrics(iAConfusionMatrix const & m)
 	{
-		if ((*it).first == 0)
+		DEBUG_LOG("************ All Labels *************");
+		DEBUG_LOG(" \t Jaccard \t Dice \t Kappa \t Equal pixel rate \t Invalid labels");
+		DEBUG_LOG(QString(" \t %1 \t %2 \t  %3 \t  %4 \t  %5")
+			.arg(m.Jaccard())
+			.arg(m.Dice())
+			.arg(m.Kappa())
+			.arg(m.EqualPixelRate())
+			.arg(m.OutsideCount()));
+
+		DEBUG_LOG("************ Individual Labels *************");
+		DEBUG_LOG("Label \t Jaccard \t Dice \t Precision \t Recall \t False negative \t False positive");
+		for (int l = 0; l < m.LabelCount(); ++l)
 		{
-			continue;
+			if (m.Label(l) == 0 || (m.RefTotal(l) == 0 && m.LabelTotal(l) == 0))
+			{
+				continue;
+			}
+			DEBUG_LOG(QString(" \t %1 \t %2 \t  %3 \t  %4 \t  %5 \t  %6 \t  %7")
+				.arg(m.Label(l))
+				.arg(m.Jaccard(l))
+				.arg(m.Dice(l))
+				.arg(m.Precision(l))
+				.arg(m.Recall(l))
+				.arg(m.FalseNegativeError(l))
+				.arg(m.FalsePositiveError(l)));
 		}
-		int label = (*it).first;
-		DEBUG_LOG(QString(" \t %1 \t %2 \t  %3 \t  %4 \t  %5 \t  %6")
-			.arg(label)
-			.arg(filter->GetTargetOverlap(label))
-			.arg(filter->GetUnionOverlap(label))
-			.arg(filter->GetMeanOverlap(label))
-			.arg(filter->GetVolumeSimilarity(label))
-			.arg(filter->GetFalseNegativeError(label))
-			.arg(filter->GetFalsePositiveError(label)));
 	}
 }
 
@@ -183,24 +167,12 @@ bool iASegmentationModuleInterface::CalculateSegmentationMetrics()
 	}
 	try
 	{
-		switch (groundTruthCon.GetITKScalarPixelType()) // This filter handles all types
+		iAConfusionMatrix matrix = ComputeConfusionMatrix(segmentedCon.GetITKImage(), groundTruthCon.GetITKImage());
+		if (matrix.LabelCount() == 0)
 		{
-
-		case itk::ImageIOBase::UCHAR:  CalculateSegmentationMetrics_template(groundTruthCon, segmentedCon, static_cast<unsigned char>(0)); break;
-		case itk::ImageIOBase::CHAR:   CalculateSegmentationMetrics_template(groundTruthCon, segmentedCon, static_cast<char>(0)); break;
-		case itk::ImageIOBase::USHORT: CalculateSegmentationMetrics_template(groundTruthCon, segmentedCon, static_cast<unsigned short>(0)); break;
-		case itk::ImageIOBase::SHORT:  CalculateSegmentationMetrics_template(groundTruthCon, segmentedCon, static_cast<short>(0)); break;
-		case itk::ImageIOBase::UINT:   CalculateSegmentationMetrics_template(groundTruthCon, segmentedCon, static_cast<unsigned int>(0)); break;
-		case itk::ImageIOBase::INT:    CalculateSegmentationMetrics_template(groundTruthCon, segmentedCon, static_cast<int>(0)); break;
-		case itk::ImageIOBase::ULONG:  CalculateSegmentationMetrics_template(groundTruthCon, segmentedCon, static_cast<unsigned long>(0)); break;
-		case itk::ImageIOBase::LONG:   CalculateSegmentationMetrics_template(groundTruthCon, segmentedCon, static_cast<long>(0)); break;
-		case itk::ImageIOBase::FLOAT:
-		case itk::ImageIOBase::DOUBLE:
-		case itk::ImageIOBase::UNKNOWNCOMPONENTTYPE:
-		default:
-			DEBUG_LOG("Unknown/Invalid component type.");
 			return false;
 		}
+		PrintSegmentationMetrics(matrix);
 	}
 	catch (itk::ExceptionObject &e)
 	{
@@ -38,6 +38,8 @@
 
 #include <vtkImageData.h>
 
+#include <algorithm>
+
 #include <QVTKWidget.h>
 #include <vtkAxis.h>
 #include <vtkChartXY.h>
@@ -100,17 +102,11 @@ void iAScatterPlotView::AddPlot(vtkImagePointer imgX, vtkImagePointer imgY, QStr
 	double* bufX = static_cast<double*>(imgX->GetScalarPointer());
 	double* bufY = static_cast<double*>(imgY->GetScalarPointer());
 	auto splomData = QSharedPointer<iASPLOMData>(new iASPLOMData());
-	splomData->paramNames().push_back(captionX);
-	splomData->paramNames().push_back(captionY);
-	QList<double> values0;
-	splomData->data().push_back(values0);
-	QList<double> values1;
-	splomData->data().push_back(values1);
-	for (size_t i = 0; i < m_voxelCount; ++i)
-	{
-		splomData->data()[0].push_back(bufX[i]);
-		splomData->data()[1].push_back(bufY[i]);
-	}
+	QList<QString> paramNames;
+	paramNames << captionX << captionY;
+	splomData->allocate(paramNames, m_voxelCount);
+	std::copy(bufX, bufX + m_voxelCount, splomData->paramData(0));
+	std::copy(bufY, bufY + m_voxelCount, splomData->paramData(1));
 
 	// setup scatterplot:
 	m_scatterPlotWidget = new iAScatterPlotWidget(splomData);
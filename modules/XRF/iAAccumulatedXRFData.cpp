@@ -31,6 +31,7 @@
 
 #include <cassert>
 #include <limits>
+#include <vector>
 
 iAAccumulatedXRFData::iAAccumulatedXRFData(QSharedPointer<iAXRFData> data, double minEnergy, double maxEnergy) :
 	m_xrfData(data),
@@ -115,9 +116,11 @@ namespace
 	iASpectrumFunction * createSpectrumFunction(QSharedPointer<iAXRFData const> xrfData, int x, int y, int z)
 	{
 		iASpectrumFunction *result = new iASpectrumFunction(xrfData->size());
-		for (size_t i=0; i<xrfData->size(); ++i)
+		std::vector<unsigned int> spectrum(xrfData->size());
+		xrfData->GetSpectrum(x, y, z, spectrum.data());
+		for (size_t i=0; i<spectrum.size(); ++i)
 		{
-			result->set(i, static_cast<unsigned int>(xrfData->GetImage(i)->GetScalarComponentAsFloat(x, y, z, 0)));
+			result->set(i, spectrum[i]);
 		}
 		return result;
 	}
@@ -27,8 +27,21 @@
 #include "iAElementalDecomposition.h"
 #include "iAXRFData.h"
 
+#include "iAConsole.h"
+
 #include <vtkImageData.h>
 
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+	//! number of consecutive voxels processed as one unit of work
+	const long long TileSize = 256;
+}
+
 iADecompositionCalculator::iADecompositionCalculator(
 	QSharedPointer<iAElementConcentrations> data,
 	QSharedPointer<iAXRFData const> xrfData,
@@ -81,37 +94,57 @@ void iADecompositionCalculator::run()
 	
 	m_data->initImages(m_elements.size(), extent, spacing, origin);
 
-	iAElementConcentrations::VoxelConcentrationType concentration;
-	concentration.reserve(m_elements.size());
-	int width = extent[1]-extent[0]+1;
-	int height = extent[3]-extent[2]+1;
-	int depth = extent[5]-extent[4]+1;
-	int pixelCount = width * height * depth;
-	for (int x=extent[0]; x<=extent[1] && !m_stopped; ++x)
+	const int elementCount = m_elements.size();
+	std::vector<float*> output(elementCount);
+	for (int i = 0; i < elementCount; ++i)
+		output[i] = static_cast<float*>(m_data->m_ElementConcentration[i]->GetScalarPointer());
+	const long long width = extent[1] - extent[0] + 1;
+	const long long height = extent[3] - extent[2] + 1;
+	const long long depth = extent[5] - extent[4] + 1;
+	const long long voxelCount = width * height * depth;
+	const long long tileCount = (voxelCount + TileSize - 1) / TileSize;
+	std::atomic<long long> finishedTiles(0);
+	std::atomic<int> lastPercent(0);
+	QElapsedTimer timer;
+	timer.start();
+	// work is distributed in tiles of consecutive voxels, so that also 2D maps
+	// (with a z extent of 1) are processed in parallel:
+#pragma omp parallel
 	{
-		for (int y=extent[2]; y<=extent[3] && !m_stopped; ++y)
+		iAEnergySpectrum unknownSpectrum(static_cast<int>(m_xrfData->size()));
+		iAElementConcentrations::VoxelConcentrationType concentration;
+		concentration.reserve(elementCount);
+#pragma omp for schedule(dynamic)
+		for (long long tile = 0; tile < tileCount; ++tile)
 		{
-#pragma omp parallel for private (concentration)
-			for (int z=extent[4]; z<=extent[5]; ++z)
+			if (m_stopped)
+				continue;	// a worksharing loop cannot be left early; skip the remaining tiles
+			const long long tileEnd = std::min((tile + 1) * TileSize, voxelCount);
+			for (long long v = tile * TileSize; v < tileEnd; ++v)
 			{
-				iAEnergySpectrum unknownSpectrum;
-				iAXRFData::Iterator it= m_xrfData->begin();
-				while (it != m_xrfData->end())
-				{
-					unknownSpectrum.push_back(static_cast<unsigned int>((*it)->GetScalarComponentAsFloat(x, y, z, 0)));
-					++it;
-				}
+				int x = extent[0] + static_cast<int>(v % width);
+				int y = extent[2] + static_cast<int>((v / width) % height);
+				int z = extent[4] + static_cast<int>(v / (width * height));
+				m_xrfData->GetSpectrum(x, y, z, unknownSpectrum.data());
+				for (int i = 0; i < unknownSpectrum.size(); ++i)
+					unknownSpectrum[i] = static_cast<unsigned int>(unknownSpectrum[i]);
 				concentration.clear();
 				fitSpectrum(unknownSpectrum, adaptedElementSpectra, threshold, concentration);
-				for (int i=0; i<concentration.size() && !m_stopped; ++i)
-				{
-					m_data->m_ElementConcentration[i]->SetScalarComponentFromDouble(x, y, z, 0, concentration[i]);
-				}
+				for (int i = 0; i < concentration.size(); ++i)
+					output[i][v] = static_cast<float>(concentration[i]);
 			}
-			int percent = static_cast<int>(static_cast<double>(x*height*depth + y*depth)/pixelCount*100);
-			progress(percent);
+			int percent = static_cast<int>(100 * (++finishedTiles) / tileCount);
+			int previous = lastPercent.load();
+			if (percent > previous && lastPercent.compare_exchange_strong(previous, percent))
+				emit progress(percent);
 		}
 	}
+	double seconds = timer.elapsed() / 1000.0;
+	if (seconds > 0)
+		DEBUG_LOG(QString("Elemental decomposition: %1 voxels in %2 s (%3 voxels/s)")
+			.arg(voxelCount).arg(seconds).arg(voxelCount / seconds, 0, 'f', 0));
+	for (int i = 0; i < elementCount; ++i)
+		m_data->m_ElementConcentration[i]->Modified();
 	if (!m_stopped)
 	{
 		emit success();
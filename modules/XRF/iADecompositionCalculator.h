@@ -24,6 +24,8 @@
 #include <QThread>
 #include <QVector>
 
+#include <atomic>
+
 class iAAccumulatedXRFData;
 class iAElementSpectralInfo;
 class iAElementConcentrations;
@@ -46,7 +48,7 @@ private:
 	QSharedPointer<iAXRFData const> m_xrfData;
 	QSharedPointer<iAAccumulatedXRFData const> m_accumulatedXRF;
 	QVector<iAElementSpectralInfo*> m_elements;
-	bool m_stopped;
+	std::atomic<bool> m_stopped;
 signals:
 	void success();
 	void progress(int percent);
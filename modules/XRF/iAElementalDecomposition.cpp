@@ -71,7 +71,7 @@ bool anyElementAboveThreshold(QSharedPointer<QVector<QSharedPointer<iAEnergySpec
 
 bool fitSpectrum(
 	iAEnergySpectrum const & unknownSpectrum,
-	QSharedPointer<QVector<QSharedPointer<iAEnergySpectrum> > > elements,
+	QSharedPointer<QVector<QSharedPointer<iAEnergySpectrum> > > const & elements,
 	CountType threshold,
 	QVector<double> & result)
 {
@@ -39,6 +39,6 @@ class iAElementSpectralInfo;
  */
 bool fitSpectrum(
 	iAEnergySpectrum const & unknownSpectrum,
-	QSharedPointer<QVector<QSharedPointer<iAEnergySpectrum> > > elements,
+	QSharedPointer<QVector<QSharedPointer<iAEnergySpectrum> > > const & elements,
 	CountType threshold,
 	QVector<double> & result);
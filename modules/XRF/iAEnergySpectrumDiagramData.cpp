@@ -52,14 +52,7 @@ void iAEnergySpectrumDiagramData::updateEnergyFunction(int x, int y, int z)
 		std::fill_n(m_energyFunction, m_xrfData_ext->size(), 0);
 		return;
 	}
-	iAXRFData::Iterator it= m_xrfData_ext->begin();
-	int idx = 0;
-	while (it != m_xrfData_ext->end())
-	{
-		m_energyFunction[idx] = static_cast<DataType>((*it)->GetScalarComponentAsFloat(x, y, z, 0));
-		++it;
-		++idx;
-	}
+	m_xrfData_ext->GetSpectrum(x, y, z, m_energyFunction);
 }
 
 iAPlotData::DataType const * iAEnergySpectrumDiagramData::GetRawData() const
@@ -23,160 +23,86 @@
 #include "iASpectraHistograms.h"
 #include "iAXRFData.h"
 
+#include "charts/iAHistogramComputation.h"
+#include "iATypedCallHelper.h"
+
 #include <vtkImageData.h>
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 
 
 iASpectraHistograms::iASpectraHistograms(QSharedPointer<iAXRFData> xrfData, long numBins, double minCount, double maxCount ) :
 		m_xrfData(xrfData),
 		m_numBins(numBins),
-		m_histData(0),
-		m_maxValue(0)
+		m_current(nullptr)
 {
 	m_countRange[0] = minCount; m_countRange[1] = maxCount;
 	m_numHistograms = m_xrfData->size();
-	size_t count = m_numHistograms*m_numBins; 
-	m_histData = new CountType[count];
-	std::fill_n(m_histData, count, CountTypeNull);
 	m_binWidth = (m_countRange[1] - m_countRange[0]) / m_numBins;
 }
 
 iASpectraHistograms::~iASpectraHistograms()
-{
-	delete [] m_histData;
-	m_histData = 0;
-}
+{}
 
-template <typename T>
-void computeHistogram(T* data, long & count, double & binWidth, CountType * histData_out, double * range)
+namespace
 {
-	for (long i=0; i<count; ++i)
+	//! bins are left-open intervals (a, b], except for the first bin which also contains its lower bound
+	template <typename T>
+	void computeImageHistogram(vtkImageData* img, double binWidth, long numBins, double minCount, CountType * histData_out)
 	{
-		double bin = ( (double)data[i] - range[0] ) / binWidth;
-		if ( bin > 0.0 && fmod(bin, 1.0) == 0.0 )
-			--bin;
-		size_t binInd = bin;
-		histData_out[binInd]++;
+		AddToHistogram(static_cast<T const *>(img->GetScalarPointer()), static_cast<size_t>(img->GetNumberOfPoints()), 1,
+			minCount, binWidth, static_cast<size_t>(numBins), histData_out, true);
 	}
 }
 
-void iASpectraHistograms::computeHistograms( )
+void iASpectraHistograms::computeHistograms(Histograms & histograms)
 {
-	iAXRFData::Iterator it = m_xrfData->begin();
-	if (it == m_xrfData->end())
+	histograms.data.assign(m_numHistograms*m_numBins, CountTypeNull);
+	histograms.maxValue = 0;
+	if (m_numHistograms == 0 || m_binWidth <= 0)
 		return;
-
-	std::fill_n(m_histData, m_numHistograms*m_numBins, CountTypeNull);
-
-	size_t i = 0;
-	int extent[6];
-	(*it)->GetExtent(extent);
-	int xrange = extent[1]-extent[0]+1;
-	int yrange = extent[3]-extent[2]+1;
-	int zrange = extent[5]-extent[4]+1;
-	long count = xrange*yrange*zrange;
-	CountType * curHistPtr = m_histData;
-	while (it != m_xrfData->end())
+	CountType * histData = histograms.data.data();
+	const int numHistograms = static_cast<int>(m_numHistograms);
+#pragma omp parallel for schedule(dynamic)
+	for (int h = 0; h < numHistograms; ++h)
 	{
-		vtkSmartPointer<vtkImageData> curImg = *it;
-		// just checks: begin
+		vtkImageData* curImg = m_xrfData->GetImage(h).GetPointer();
 		assert (curImg->GetNumberOfScalarComponents() == 1);
-		int extent[6];
-		curImg->GetExtent(extent);
-		assert( ((extent[1]-extent[0]+1) * (extent[3]-extent[2]+1) * (extent[5]-extent[4]+1)) == count );
-		// end checks
-		void * scalarPtr = curImg->GetScalarPointer();
-		int type = curImg->GetScalarType();
-		switch (type)
-		{
-		case VTK_CHAR:
-			computeHistogram<char>(static_cast<char*>(scalarPtr), count, m_binWidth, curHistPtr, m_countRange);
-			break;
-		case VTK_SIGNED_CHAR:
-			computeHistogram<char>(static_cast<char*>(scalarPtr), count, m_binWidth, curHistPtr, m_countRange);
-			break;
-		case VTK_UNSIGNED_CHAR:
-			computeHistogram<unsigned char>(static_cast<unsigned char*>(scalarPtr), count, m_binWidth, curHistPtr, m_countRange);
-			break;
-		case VTK_SHORT:
-			computeHistogram<short>(static_cast<short*>(scalarPtr), count, m_binWidth, curHistPtr, m_countRange);
-			break;
-		case VTK_UNSIGNED_SHORT:
-			computeHistogram<unsigned short>(static_cast<unsigned short*>(scalarPtr), count, m_binWidth, curHistPtr, m_countRange);
-			break;
-		case VTK_INT:
-			computeHistogram<int>(static_cast<int*>(scalarPtr), count, m_binWidth, curHistPtr, m_countRange);
-			break;
-		case VTK_UNSIGNED_INT:
-			computeHistogram<unsigned int>(static_cast<unsigned int*>(scalarPtr), count, m_binWidth, curHistPtr, m_countRange);
-			break;
-		case VTK_LONG:
-			computeHistogram<long>(static_cast<long*>(scalarPtr), count, m_binWidth, curHistPtr, m_countRange);
-			break;
-		case VTK_UNSIGNED_LONG:
-			computeHistogram<unsigned long>(static_cast<unsigned long*>(scalarPtr), count, m_binWidth, curHistPtr, m_countRange);
-			break;
-		case VTK_FLOAT:
-			computeHistogram<float>(static_cast<float*>(scalarPtr), count, m_binWidth, curHistPtr, m_countRange);
-			break;
-		case VTK_DOUBLE:
-			computeHistogram<double>(static_cast<double*>(scalarPtr), count, m_binWidth, curHistPtr, m_countRange);
-			break;
-		default:
-			// TODO: LOG ERROR!
-			break;
-		}
-		curHistPtr += m_numBins;
-		++it;
-		++i;	
-	}
-	computeMaximumVal();
-}
-
-void iASpectraHistograms::computeMaximumVal()
-{
-	m_maxValue = 0;
-	size_t count = m_numHistograms*m_numBins;
-	for (size_t i = 0; i < count; ++i)
-	{
-		if(m_histData[i] > m_maxValue)
-			m_maxValue = m_histData[i];
+		VTK_TYPED_CALL(computeImageHistogram, curImg->GetScalarType(), curImg,
+			m_binWidth, m_numBins, m_countRange[0], histData + static_cast<size_t>(h) * m_numBins);
 	}
+	histograms.maxValue = *std::max_element(histograms.data.begin(), histograms.data.end());
 }
 
 void iASpectraHistograms::compute( long numBins, double maxCount, double minCount )
 {
-	bool doReallocate = false;
-	bool doRecompute = false;
-	if(m_numBins != numBins)
-	{
-		m_numBins = numBins;
-		doReallocate = doRecompute = true;
-	}
-	if(m_countRange[0] != minCount || m_countRange[1] != maxCount)
+	if(m_countRange[0] != minCount || m_countRange[1] != maxCount ||
+		m_numHistograms != m_xrfData->size())
 	{
 		m_countRange[0] = minCount; m_countRange[1] = maxCount;
-		doRecompute = true;
-	}
-
-	if(doReallocate)
-	{
 		m_numHistograms = m_xrfData->size();
-		delete [] m_histData; m_histData = 0;
-		m_histData = new CountType[m_numHistograms*m_numBins];
+		m_cache.clear();
+		m_cacheOrder.clear();
+		m_current = nullptr;
 	}
-
-	if(doRecompute)
+	m_numBins = numBins;
+	m_binWidth = (m_countRange[1] - m_countRange[0]) / m_numBins;
+	m_cacheOrder.removeOne(numBins);
+	m_cacheOrder.append(numBins);
+	if (!m_cache.contains(numBins))
 	{
-		m_binWidth = (m_countRange[1] - m_countRange[0]) / m_numBins;
-		computeHistograms();
+		if (m_cacheOrder.size() > MaxCachedBinCounts)
+			m_cache.remove(m_cacheOrder.takeFirst());
+		computeHistograms(m_cache[numBins]);
 	}
+	m_current = &m_cache[numBins];
 }
 
 CountType * iASpectraHistograms::histData() const
 {
-	return m_histData;
+	return m_current ? m_current->data.data() : nullptr;
 }
 
 long iASpectraHistograms::numBins() const
@@ -191,5 +117,5 @@ size_t iASpectraHistograms::numHist() const
 
 CountType iASpectraHistograms::maxValue() const
 {
-	return m_maxValue;
+	return m_current ? m_current->maxValue : 0;
 }
@@ -24,21 +24,35 @@ class iAXRFData;
 
 #include "iAEnergySpectrum.h"
 
+#include <QList>
+#include <QMap>
 #include <QSharedPointer>
 
+#include <vector>
+
 class iASpectraHistograms
 {
 public:
+	//! maximum number of different bin counts for which the histograms are kept
+	static const int MaxCachedBinCounts = 4;
 	iASpectraHistograms(QSharedPointer<iAXRFData> xrfData, long numBins = 1, double minCount = 0, double maxCount = 0);
 	~iASpectraHistograms();
+	//! compute the histograms for the given number of bins and count range;
+	//! histograms computed before for the same count range are reused
+	//! (for the MaxCachedBinCounts most recently used numbers of bins)
 	void compute(long numBins, double maxCount, double minCount);
 	CountType * histData() const;
 	long numBins() const;
 	size_t numHist() const;
 	CountType maxValue() const;
 private:
-	void computeHistograms();
-	void computeMaximumVal();
+	struct Histograms
+	{
+		Histograms(): maxValue(0) {}
+		std::vector<CountType> data;	///< 2D array, first dimension - histograms, second - bins
+		CountType maxValue;				///< maximum value of all histograms' bins
+	};
+	void computeHistograms(Histograms & histograms);
 
 private:
 	long	m_numBins;			///< number of bins in a histogram
@@ -46,8 +60,9 @@ private:
 	double	m_countRange[2];	///< range of XRF 
 
 	double			m_binWidth;			///< width of a histogram bin
-	CountType	*	m_histData;			///< raw data containing a 2D array, first dimension - histograms, second - bins
+	QMap<long, Histograms> m_cache;		///< histograms computed for the current count range, by number of bins
+	QList<long>		m_cacheOrder;		///< numbers of bins in m_cache, least recently used first
+	Histograms * m_current;				///< the histograms for m_numBins
 	
 	QSharedPointer<iAXRFData> m_xrfData;	///< pointer to the input xrf data set
-	CountType	m_maxValue;			///< maximum value of all histograms' bins
 };
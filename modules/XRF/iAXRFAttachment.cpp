@@ -31,6 +31,7 @@
 
 #include "iAChannelVisualizationData.h"
 #include "iAObserverProgress.h"
+#include "iAPerformanceHelper.h"
 #include "iASlicer.h"
 #include "iASlicerData.h"
 #include "iAWidgetAddHelper.h"
@@ -46,6 +47,20 @@
 #include <QFileDialog>
 #include <qmath.h>
 
+namespace
+{
+	//! limit for the voxel-interleaved copy of the spectral data (see iAXRFData::CreateVoxelInterleavedData)
+	//! if the available memory cannot be determined
+	const size_t DefaultVoxelInterleavedBytes = static_cast<size_t>(1024) * 1024 * 1024;
+
+	//! the copy may take up half of the memory still available after loading the energy images
+	size_t MaxVoxelInterleavedBytes()
+	{
+		size_t available = getAvailablePhysicalMemory();
+		return available > 0 ? available / 2 : DefaultVoxelInterleavedBytes;
+	}
+}
+
 iAXRFAttachment::iAXRFAttachment( MainWindow * mainWnd, iAChildData childData ) : iAModuleAttachmentToChild( mainWnd, childData ), 
 	dlgPeriodicTable(0), dlgXRF(0), dlgSimilarityMap(0), ioThread(0), slicerXZ(0), slicerXY(0),	slicerYZ(0)
 {
@@ -88,6 +103,9 @@ iAXRFAttachment::iAXRFAttachment( MainWindow * mainWnd, iAChildData childData )
 	connect( ioThread, SIGNAL( done() ), this, SLOT( xrfLoadingDone() ) );
 	connect( ioThread, SIGNAL( failed() ), this, SLOT( xrfLoadingFailed() ) );
 	connect( ioThread, SIGNAL( finished() ), this, SLOT( ioFinished() ) );
+	// build the copy for fast spectrum access in the loader thread; it duplicates the data, so only if it fits in memory
+	QSharedPointer<iAXRFData> xrfData = dlgXRF->GetXRFData();
+	ioThread->setPostReadAction([xrfData]() { xrfData->CreateVoxelInterleavedData(MaxVoxelInterleavedBytes()); });
 
 	QString extension = QFileInfo( f ).suffix();
 	extension = extension.toUpper();
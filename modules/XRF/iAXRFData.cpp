@@ -22,8 +22,10 @@
 #include "pch.h"
 #include "iAXRFData.h"
 
+#include "iAConsole.h"
 #include "iASpectrumFilter.h"
 #include "iAMathUtility.h"
+#include "iATypedCallHelper.h"
 
 #include <vtkDiscretizableColorTransferFunction.h>
 #include <vtkImageData.h>
@@ -31,8 +33,14 @@
 #include <QThread>
 
 #include <map>
+#include <new>
 #include <cassert>
 
+iAXRFData::iAXRFData():
+	m_spectraType(VTK_VOID),
+	m_spectraValueSize(0)
+{}
+
 iAXRFData::Iterator iAXRFData::begin() const
 {
 	return m_data.begin();
@@ -58,6 +66,98 @@ void iAXRFData::GetExtent(int extent[6]) const
 	m_data[0]->GetExtent(extent);
 }
 
+namespace
+{
+	//! number of voxels which are transposed together; chosen such that the
+	//! destination block for typical spectrum lengths stays in the cache
+	const long long InterleaveBlockSize = 1024;
+
+	template <typename T>
+	void interleaveBin(vtkImageData* img, size_t bin, size_t binCount, size_t start, size_t end, char* spectra)
+	{
+		T const * src = static_cast<T const *>(img->GetScalarPointer());
+		T * result = reinterpret_cast<T *>(spectra);
+		for (size_t v = start; v < end; ++v)
+			result[v * binCount + bin] = src[v];
+	}
+}
+
+bool iAXRFData::CreateVoxelInterleavedData(size_t maxBytes)
+{
+	m_spectra.clear();
+	m_spectra.shrink_to_fit();
+	if (m_data.empty())
+		return false;
+	m_data[0]->GetExtent(m_spectraExtent);
+	m_spectraType = m_data[0]->GetScalarType();
+	for (auto img : m_data)
+	{
+		int extent[6];
+		img->GetExtent(extent);
+		if (img->GetNumberOfScalarComponents() != 1 || img->GetScalarType() != m_spectraType ||
+			!std::equal(extent, extent + 6, m_spectraExtent))
+		{
+			DEBUG_LOG("Energy bin images differ in extent or scalar type, or have more than one component; "
+				"voxel-interleaved spectral data not created.");
+			return false;
+		}
+	}
+	if (m_spectraType == VTK_LONG_LONG || m_spectraType == VTK_UNSIGNED_LONG_LONG || m_spectraType == VTK_ID_TYPE)
+	{
+		DEBUG_LOG("Unsupported scalar type; voxel-interleaved spectral data not created.");
+		return false;
+	}
+	const size_t binCount = m_data.size();
+	const long long voxelCount = m_data[0]->GetNumberOfPoints();
+	m_spectraValueSize = m_data[0]->GetScalarSize();
+	const size_t byteCount = voxelCount * binCount * m_spectraValueSize;
+	if (byteCount > maxBytes)
+	{
+		DEBUG_LOG(QString("Voxel-interleaved spectral data would require %1 MB, more than the limit of %2 MB; "
+			"spectra will be read from the energy images.")
+			.arg(byteCount / (1024 * 1024)).arg(maxBytes / (1024 * 1024)));
+		return false;
+	}
+	try
+	{
+		m_spectra.resize(byteCount);
+	}
+	catch (std::bad_alloc &)
+	{
+		DEBUG_LOG("Not enough memory for voxel-interleaved spectral data; spectra will be read from the energy images.");
+		return false;
+	}
+	char* spectra = m_spectra.data();
+	const long long blockCount = (voxelCount + InterleaveBlockSize - 1) / InterleaveBlockSize;
+#pragma omp parallel for
+	for (long long block = 0; block < blockCount; ++block)
+	{
+		size_t start = block * InterleaveBlockSize;
+		size_t end = std::min(start + InterleaveBlockSize, static_cast<size_t>(voxelCount));
+		for (size_t bin = 0; bin < binCount; ++bin)
+		{
+			vtkImageData* img = m_data[bin].GetPointer();
+			VTK_TYPED_CALL(interleaveBin, m_spectraType, img, bin, binCount, start, end, spectra);
+		}
+	}
+	return true;
+}
+
+void const * iAXRFData::GetSpectrum(int x, int y, int z) const
+{
+	if (m_spectra.empty())
+		return nullptr;
+	size_t width  = m_spectraExtent[1] - m_spectraExtent[0] + 1;
+	size_t height = m_spectraExtent[3] - m_spectraExtent[2] + 1;
+	size_t voxelIdx = (static_cast<size_t>(z - m_spectraExtent[4]) * height + (y - m_spectraExtent[2])) * width + (x - m_spectraExtent[0]);
+	return m_spectra.data() + voxelIdx * m_data.size() * m_spectraValueSize;
+}
+
+int iAXRFData::GetSpectrumScalarType() const
+{
+	return m_spectraType;
+}
+
 namespace
 {
 	const size_t COLOR_COMPONENTS = 3;		// number of components for each color (e.g. 3 -> r,g,b or 4 -> r,g,b,a)
@@ -296,9 +396,12 @@ bool isInRange(vtkSmartPointer<vtkImageData> const & img, int x, int y, int z, d
 
 bool iAXRFData::CheckFilters(int x, int y, int z, QVector<iASpectrumFilter> const & filter, iAFilterMode mode) const
 {
+	float const * spectrum = GetSpectrum(x, y, z);
 	for (QVector<iASpectrumFilter>::const_iterator it = filter.begin(); it != filter.end(); ++it)
 	{
-		bool inRange = isInRange(m_data[it->binIdx], x, y, z, it->minVal, it->maxVal);
+		bool inRange = spectrum ?
+			isInRange(spectrum[it->binIdx], it->minVal, it->maxVal) :
+			isInRange(m_data[it->binIdx], x, y, z, it->minVal, it->maxVal);
 		switch (mode)
 		{
 			case filter_AND: if (!inRange) { return 0; } break;
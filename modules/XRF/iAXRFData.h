@@ -25,11 +25,11 @@
 #include <QObject>
 #include <QVector>
 
+#include <vtkImageData.h>
 #include <vtkSmartPointer.h>
 
 class vtkColorTransferFunction;
 class vtkDiscretizableColorTransferFunction;
-class vtkImageData;
 
 struct iASpectrumFilter;
 
@@ -43,6 +43,7 @@ class iAXRFData {
 public:
 	typedef std::vector<vtkSmartPointer<vtkImageData> >	Container;
 	typedef Container::const_iterator	Iterator;
+	iAXRFData();
 	Iterator begin() const;
 	Iterator end() const;
 
@@ -60,6 +61,44 @@ public:
 
 	void GetExtent(int extent[6]) const;
 
+	//! Create a copy of the data in which the counts of all energy bins of a voxel are
+	//! stored contiguously, so that spectra can be read without touching every energy image.
+	//! The copy keeps the scalar type of the energy images, i.e. it takes as much memory as the
+	//! loaded data; if that is more than maxBytes or cannot be allocated, spectra are read from
+	//! the energy images as before.
+	//! @return true if the voxel-interleaved copy is available
+	bool CreateVoxelInterleavedData(size_t maxBytes);
+	//! the spectrum at the given voxel (size() consecutive values of type GetSpectrumScalarType()),
+	//! or nullptr if no voxel-interleaved copy was created (see CreateVoxelInterleavedData)
+	void const * GetSpectrum(int x, int y, int z) const;
+	//! VTK scalar type of the values returned by GetSpectrum
+	int GetSpectrumScalarType() const;
+	//! copy the spectrum at the given voxel into result (which needs room for size() values)
+	template <typename T>
+	void GetSpectrum(int x, int y, int z, T * result) const
+	{
+		void const * spectrum = GetSpectrum(x, y, z);
+		if (spectrum)
+		{
+			switch (m_spectraType)
+			{
+			case VTK_UNSIGNED_CHAR:  CopySpectrum(static_cast<unsigned char const *>(spectrum), result); return;
+			case VTK_SIGNED_CHAR:
+			case VTK_CHAR:           CopySpectrum(static_cast<char const *>(spectrum), result); return;
+			case VTK_SHORT:          CopySpectrum(static_cast<short const *>(spectrum), result); return;
+			case VTK_UNSIGNED_SHORT: CopySpectrum(static_cast<unsigned short const *>(spectrum), result); return;
+			case VTK_INT:            CopySpectrum(static_cast<int const *>(spectrum), result); return;
+			case VTK_UNSIGNED_INT:   CopySpectrum(static_cast<unsigned int const *>(spectrum), result); return;
+			case VTK_LONG:           CopySpectrum(static_cast<long const *>(spectrum), result); return;
+			case VTK_UNSIGNED_LONG:  CopySpectrum(static_cast<unsigned long const *>(spectrum), result); return;
+			case VTK_FLOAT:          CopySpectrum(static_cast<float const *>(spectrum), result); return;
+			case VTK_DOUBLE:         CopySpectrum(static_cast<double const *>(spectrum), result); return;
+			}
+		}
+		for (size_t i = 0; i < m_data.size(); ++i)
+			result[i] = static_cast<T>(m_data[i]->GetScalarComponentAsFloat(x, y, z, 0));
+	}
+
 	QObject* UpdateCombinedVolume(vtkSmartPointer<vtkColorTransferFunction> colorTransferEnergies);
 
 	vtkSmartPointer<vtkImageData> GetCombinedVolume();
@@ -77,8 +116,19 @@ public:
 	double GetMinEnergy() const;
 	double GetMaxEnergy() const;
 private:
+	template <typename S, typename T>
+	void CopySpectrum(S const * spectrum, T * result) const
+	{
+		for (size_t i = 0; i < m_data.size(); ++i)
+			result[i] = static_cast<T>(spectrum[i]);
+	}
 
 	Container m_data;
+	//! voxel-interleaved copy of m_data (energy bin index running fastest), values of type m_spectraType
+	std::vector<char> m_spectra;
+	int m_spectraType;
+	size_t m_spectraValueSize;
+	int m_spectraExtent[6];
 	
 	vtkSmartPointer<vtkImageData> m_combinedVolume;
 	vtkSmartPointer<vtkDiscretizableColorTransferFunction> m_colorTransfer;